@@ -31,6 +31,7 @@ LOCAL_SRC_FILES :=      am_map.c \
 						m_textinput.c \
                         m_misc.c \
                         m_queue.c \
+                        m_compress.c \
                         m_random.c \
                         md5.c \
                         mserv.c \
@@ -47,6 +48,7 @@ LOCAL_SRC_FILES :=      am_map.c \
                         p_saveg.c \
                         p_setup.c \
                         p_sight.c \
+                        p_reject.c \
                         p_spec.c \
                         p_telept.c \
                         p_tick.c \
@@ -34,6 +34,7 @@
 #include "p_setup.h"
 #include "lua_script.h"
 #include "d_netfil.h" // findfile
+#include "qs22j.h"
 
 //========
 // protos.
@@ -63,6 +64,26 @@ static const char *CV_StringValue(const char *var_name);
 static consvar_t *consvar_vars; // list of registered console variables
 static UINT16     consvar_number_of_netids = 0;
 
+// Name lookups go through small case-insensitive hash tables instead of
+// walking consvar_vars/com_commands, and netvars are indexed by netid.
+#define CV_HASHSIZE 1024
+#define COM_HASHSIZE 512
+
+typedef struct cvhash_s
+{
+	consvar_t *var;
+	struct cvhash_s *next;
+} cvhash_t;
+
+static cvhash_t   *consvar_hash[CV_HASHSIZE];
+static consvar_t **consvar_netids = NULL; // indexed by netid, [0] unused
+static size_t      consvar_netids_size = 0;
+
+// Sorted by name for completion, rebuilt lazily when something is registered
+static consvar_t **consvar_sorted = NULL;
+static size_t      consvar_sorted_count = 0;
+static boolean     consvar_sorted_dirty = true;
+
 
 static char com_token[1024];
 static char *COM_Parse(char *data);
@@ -276,10 +297,97 @@ typedef struct xcommand_s
 {
 	const char *name;
 	struct xcommand_s *next;
+	struct xcommand_s *hashnext; // next in the same com_hash bucket
 	com_func_t function;
 } xcommand_t;
 
 static xcommand_t *com_commands = NULL; // current commands
+static xcommand_t *com_hash[COM_HASHSIZE];
+
+// Sorted by name for completion, rebuilt lazily when something is added
+static xcommand_t **com_sorted = NULL;
+static size_t       com_sorted_count = 0;
+static boolean      com_sorted_dirty = true;
+
+/** Hashes a command or variable name, ignoring case.
+  *
+  * \param name The name to hash.
+  * \return A hash value; mask it with the table size.
+  */
+static UINT32 COM_HashName(const char *name)
+{
+	UINT32 hash = 2166136261u;
+
+	for (; *name; name++)
+	{
+		hash ^= (UINT8)tolower((unsigned char)*name);
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
+/** Finds a command by name, ignoring case.
+  *
+  * \param name The name to search for.
+  * \return The command, or NULL if there is none.
+  */
+static xcommand_t *COM_FindCommand(const char *name)
+{
+	xcommand_t *cmd;
+
+	for (cmd = com_hash[COM_HashName(name) & (COM_HASHSIZE - 1)]; cmd; cmd = cmd->hashnext)
+		if (!stricmp(name, cmd->name))
+			return cmd;
+
+	return NULL;
+}
+
+/** Links a new command into the command list and the lookup tables.
+  *
+  * \param name Name of the command.
+  * \param func Function called when the command is run.
+  */
+static void COM_LinkCommand(const char *name, com_func_t func)
+{
+	xcommand_t *cmd = ZZ_Alloc(sizeof *cmd);
+	UINT32 bucket = COM_HashName(name) & (COM_HASHSIZE - 1);
+
+	cmd->name = name;
+	cmd->function = func;
+	cmd->next = com_commands;
+	com_commands = cmd;
+	cmd->hashnext = com_hash[bucket];
+	com_hash[bucket] = cmd;
+	com_sorted_dirty = true;
+}
+
+static int COM_SortedCompare(const void *a, const void *b)
+{
+	return strcmp((*(const xcommand_t *const *)a)->name, (*(const xcommand_t *const *)b)->name);
+}
+
+/** Rebuilds the sorted command index, if needed.
+  */
+static void COM_UpdateSorted(void)
+{
+	xcommand_t *cmd;
+	size_t count = 0;
+
+	if (!com_sorted_dirty)
+		return;
+
+	for (cmd = com_commands; cmd; cmd = cmd->next)
+		count++;
+
+	com_sorted = Z_Realloc(com_sorted, count * sizeof *com_sorted, PU_STATIC, NULL);
+	com_sorted_count = 0;
+	for (cmd = com_commands; cmd; cmd = cmd->next)
+		com_sorted[com_sorted_count++] = cmd;
+
+	qs22j(com_sorted, com_sorted_count, sizeof *com_sorted, COM_SortedCompare);
+	com_sorted_dirty = false;
+}
 
 #define MAX_ARGS 80
 static size_t com_argc;
@@ -460,26 +568,20 @@ void COM_AddCommand(const char *name, com_func_t func)
 	}
 
 	// fail if the command already exists
-	for (cmd = com_commands; cmd; cmd = cmd->next)
+	cmd = COM_FindCommand(name); //case insensitive now that we have lower and uppercase!
+	if (cmd)
 	{
-		if (!stricmp(name, cmd->name)) //case insensitive now that we have lower and uppercase!
-		{
-			// don't I_Error for Lua commands
-			// Lua commands can replace game commands, and they have priority.
-			// BUT, if for some reason we screwed up and made two console commands with the same name,
-			// it's good to have this here so we find out.
-			if (cmd->function != COM_Lua_f)
-				I_Error("Command %s already exists\n", name);
+		// don't I_Error for Lua commands
+		// Lua commands can replace game commands, and they have priority.
+		// BUT, if for some reason we screwed up and made two console commands with the same name,
+		// it's good to have this here so we find out.
+		if (cmd->function != COM_Lua_f)
+			I_Error("Command %s already exists\n", name);
 
-			return;
-		}
+		return;
 	}
 
-	cmd = ZZ_Alloc(sizeof *cmd);
-	cmd->name = name;
-	cmd->function = func;
-	cmd->next = com_commands;
-	com_commands = cmd;
+	COM_LinkCommand(name, func);
 }
 
 /** Adds a console command for Lua.
@@ -496,22 +598,16 @@ int COM_AddLuaCommand(const char *name)
 		return -1;
 
 	// command already exists
-	for (cmd = com_commands; cmd; cmd = cmd->next)
+	cmd = COM_FindCommand(name); //case insensitive now that we have lower and uppercase!
+	if (cmd)
 	{
-		if (!stricmp(name, cmd->name)) //case insensitive now that we have lower and uppercase!
-		{
-			// replace the built in command.
-			cmd->function = COM_Lua_f;
-			return 1;
-		}
+		// replace the built in command.
+		cmd->function = COM_Lua_f;
+		return 1;
 	}
 
 	// Add a new command.
-	cmd = ZZ_Alloc(sizeof *cmd);
-	cmd->name = name;
-	cmd->function = COM_Lua_f;
-	cmd->next = com_commands;
-	com_commands = cmd;
+	COM_LinkCommand(name, COM_Lua_f);
 	return 0;
 }
 
@@ -522,13 +618,7 @@ int COM_AddLuaCommand(const char *name)
   */
 static boolean COM_Exists(const char *com_name)
 {
-	xcommand_t *cmd;
-
-	for (cmd = com_commands; cmd; cmd = cmd->next)
-		if (!stricmp(com_name, cmd->name))
-			return true;
-
-	return false;
+	return (COM_FindCommand(com_name) != NULL);
 }
 
 /** Does command completion for the console.
@@ -540,19 +630,31 @@ static boolean COM_Exists(const char *com_name)
   */
 const char *COM_CompleteCommand(const char *partial, INT32 skips)
 {
-	xcommand_t *cmd;
-	size_t len;
+	size_t len, lo, hi;
 
 	len = strlen(partial);
 
 	if (!len)
 		return NULL;
 
+	COM_UpdateSorted();
+
+	// find the first name not below the partial one; every match follows it
+	lo = 0;
+	hi = com_sorted_count;
+	while (lo < hi)
+	{
+		size_t mid = lo + (hi - lo) / 2;
+		if (strcmp(com_sorted[mid]->name, partial) < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
 	// check functions
-	for (cmd = com_commands; cmd; cmd = cmd->next)
-		if (!strncmp(partial, cmd->name, len))
-			if (!skips--)
-				return cmd->name;
+	for (; lo < com_sorted_count && !strncmp(partial, com_sorted[lo]->name, len); lo++)
+		if (!skips--)
+			return com_sorted[lo]->name;
 
 	return NULL;
 }
@@ -575,13 +677,11 @@ static void COM_ExecuteString(char *ptext)
 		return; // no tokens
 
 	// check functions
-	for (cmd = com_commands; cmd; cmd = cmd->next)
+	cmd = COM_FindCommand(com_argv[0]); //case insensitive now that we have lower and uppercase!
+	if (cmd)
 	{
-		if (!stricmp(com_argv[0], cmd->name)) //case insensitive now that we have lower and uppercase!
-		{
-			cmd->function();
-			return;
-		}
+		cmd->function();
+		return;
 	}
 
 	// check aliases
@@ -1157,11 +1257,11 @@ static const char *cv_null_string = "";
   */
 consvar_t *CV_FindVar(const char *name)
 {
-	consvar_t *cvar;
+	cvhash_t *entry;
 
-	for (cvar = consvar_vars; cvar; cvar = cvar->next)
-		if (!stricmp(name,cvar->name))
-			return cvar;
+	for (entry = consvar_hash[COM_HashName(name) & (CV_HASHSIZE - 1)]; entry; entry = entry->next)
+		if (!stricmp(name, entry->var->name))
+			return entry->var;
 
 	return NULL;
 }
@@ -1174,18 +1274,37 @@ consvar_t *CV_FindVar(const char *name)
 */
 static consvar_t *CV_FindNetVar(UINT16 netid)
 {
-	consvar_t *cvar;
-	
-	if (netid > consvar_number_of_netids)
+	if (netid > consvar_number_of_netids || netid >= consvar_netids_size)
 		return NULL;
 
+	return consvar_netids[netid];
+}
+
+static int CV_SortedCompare(const void *a, const void *b)
+{
+	return strcmp((*(const consvar_t *const *)a)->name, (*(const consvar_t *const *)b)->name);
+}
+
+/** Rebuilds the sorted variable index, if needed.
+  */
+static void CV_UpdateSorted(void)
+{
+	consvar_t *cvar;
+	size_t count = 0;
+
+	if (!consvar_sorted_dirty)
+		return;
 
 	for (cvar = consvar_vars; cvar; cvar = cvar->next)
-		if (cvar->netid == netid)
-			return cvar;
+		count++;
 
+	consvar_sorted = Z_Realloc(consvar_sorted, count * sizeof *consvar_sorted, PU_STATIC, NULL);
+	consvar_sorted_count = 0;
+	for (cvar = consvar_vars; cvar; cvar = cvar->next)
+		consvar_sorted[consvar_sorted_count++] = cvar;
 
-	return NULL;
+	qs22j(consvar_sorted, consvar_sorted_count, sizeof *consvar_sorted, CV_SortedCompare);
+	consvar_sorted_dirty = false;
 }
 
 static void Setvalue(consvar_t *var, const char *valstr, boolean stealth);
@@ -1224,8 +1343,36 @@ void CV_RegisterVar(consvar_t *variable)
 	// link the variable in
 	if (!(variable->flags & CV_HIDEN))
 	{
+		cvhash_t *entry = ZZ_Alloc(sizeof *entry);
+		UINT32 bucket = COM_HashName(variable->name) & (CV_HASHSIZE - 1);
+
 		variable->next = consvar_vars;
 		consvar_vars = variable;
+
+		entry->var = variable;
+		entry->next = consvar_hash[bucket];
+		consvar_hash[bucket] = entry;
+		consvar_sorted_dirty = true;
+
+		if (variable->flags & CV_NETVAR)
+		{
+			if (variable->netid >= consvar_netids_size)
+			{
+				size_t oldsize = consvar_netids_size;
+				size_t newsize = max(64, oldsize);
+
+				// netids skipped by hidden netvars can leave us more than one doubling short
+				while (newsize <= variable->netid)
+					newsize *= 2;
+				if (newsize > SIZE_MAX / sizeof *consvar_netids)
+					I_Error("Way too many netvars");
+
+				consvar_netids = Z_Realloc(consvar_netids, newsize * sizeof *consvar_netids, PU_STATIC, NULL);
+				memset(consvar_netids + oldsize, 0, (newsize - oldsize) * sizeof *consvar_netids);
+				consvar_netids_size = newsize;
+			}
+			consvar_netids[variable->netid] = variable;
+		}
 	}
 	variable->string = variable->zstring = NULL;
 	variable->changed = 0; // new variable has not been modified by the user
@@ -1274,19 +1421,34 @@ static const char *CV_StringValue(const char *var_name)
 const char *CV_CompleteVar(char *partial, INT32 skips)
 {
 	consvar_t *cvar;
-	size_t len;
+	size_t len, lo, hi;
 
 	len = strlen(partial);
 
 	if (!len)
 		return NULL;
 
+	CV_UpdateSorted();
+
+	// find the first name not below the partial one; every match follows it
+	lo = 0;
+	hi = consvar_sorted_count;
+	while (lo < hi)
+	{
+		size_t mid = lo + (hi - lo) / 2;
+		if (strcmp(consvar_sorted[mid]->name, partial) < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
 	// check variables
-	for (cvar = consvar_vars; cvar; cvar = cvar->next)
+	for (; lo < consvar_sorted_count; lo++)
 	{
-		if (cvar->flags & CV_NOSHOWHELP)
-			continue;
+		cvar = consvar_sorted[lo];
 		if (strncmp(partial, cvar->name, len))
+			break;
+		if (cvar->flags & CV_NOSHOWHELP)
 			continue;
 		if (skips--)
 			continue;
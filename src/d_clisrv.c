@@ -43,7 +43,7 @@
 #include "r_local.h"
 #include "m_argv.h"
 #include "p_setup.h"
-#include "lzf.h"
+#include "m_compress.h"
 #include "lua_script.h"
 #include "lua_hook.h"
 #include "k_kart.h"
@@ -61,6 +61,10 @@
 #include "discord.h"
 #endif
 
+#ifdef USE_STUN
+#include "stun.h"
+#endif
+
 //
 // NETWORKING
 //
@@ -97,6 +101,56 @@ static boolean resendingsavegame[MAXNETNODES]; // Are we resending the savegame?
 static tic_t savegameresendcooldown[MAXNETNODES]; // How long before we can resend again?
 static tic_t freezetimeout[MAXNETNODES]; // Until when can this node freeze the server before getting a timeout?
 
+// An uncompressed gamestate archive, without the length header
+typedef struct
+{
+	UINT8 *data; // SF_SHAREDRAM block, or NULL if there's none
+	size_t length;
+	UINT32 checksum;
+} savegamearchive_t;
+
+// Gamestate snapshot shared by every node joining on the same tic, see SV_SendSaveGame
+static struct
+{
+	UINT8 *data; // SF_SHAREDRAM block, or NULL if there's no snapshot
+	size_t length;
+	savegamearchive_t archive; // what data decompresses to
+	tic_t tic;
+	boolean resending;
+} savegamecache;
+static UINT32 savegamesnapshots = 0; // How many snapshots have been serialized
+static UINT32 savegamereuses = 0; // How many times a snapshot was sent to another node
+static precise_t savegamesavetime = 0; // Total time spent serializing and compressing them
+
+// Resyncs are sent as a delta against the archive the node last acknowledged
+static savegamearchive_t savegamebase[MAXNETNODES]; // What the node has loaded
+static savegamearchive_t savegamepending[MAXNETNODES]; // What the node is downloading
+static UINT32 savegamedeltas = 0; // How many resyncs were sent as deltas
+static UINT64 savegamedeltabytes = 0; // How big those deltas were
+static UINT64 savegamedeltafullbytes = 0; // How big they would have been as full snapshots
+
+// Client side copy of the archive we loaded last, for applying deltas to
+static UINT8 *cl_savegamebase = NULL;
+static size_t cl_savegamebaselength = 0;
+static UINT32 cl_savegamebasechecksum = 0;
+
+static void SetSaveGameArchive(savegamearchive_t *dest, const savegamearchive_t *src)
+{
+	if (src->data)
+		SV_HoldSharedRam(src->data);
+	if (dest->data)
+		SV_ReleaseSharedRam(dest->data);
+	*dest = *src;
+}
+
+static void ClearSaveGameArchive(savegamearchive_t *archive)
+{
+	if (archive->data)
+		SV_ReleaseSharedRam(archive->data);
+	archive->data = NULL;
+	archive->length = 0;
+}
+
 UINT16 pingmeasurecount = 1;
 UINT32 realpingtable[MAXPLAYERS]; //the base table of ping where an average will be sent to everyone.
 UINT32 playerpingtable[MAXPLAYERS]; //table of player latency values.
@@ -1150,6 +1204,12 @@ static boolean SV_SendServerConfig(INT32 node)
 #ifdef JOININGAME
 #define SAVEGAMESIZE (768*3072)
 
+// Length header in front of a sent savegame
+#define SAVEGAMEDELTA 0x80000000 // It's a delta, see SV_MakeSaveGameDelta
+#define SAVEGAMECOMPRESSORSHIFT 24 // compressor_t it was packed with
+#define SAVEGAMECOMPRESSORMASK 0x7F
+#define SAVEGAMELENGTHMASK 0x00FFFFFF // Decompressed length, 0 if not compressed
+
 static boolean SV_ResendingSavegameToAnyone(void)
 {
 	INT32 i;
@@ -1160,19 +1220,46 @@ static boolean SV_ResendingSavegameToAnyone(void)
 	return false;
 }
 
-static void SV_SendSaveGame(INT32 node, boolean resending)
+// Drops the server's reference to the cached gamestate snapshot.
+// Nodes that are still downloading it keep their own.
+static void SV_ClearSaveGameCache(void)
+{
+	if (savegamecache.data)
+		SV_ReleaseSharedRam(savegamecache.data);
+	savegamecache.data = NULL;
+	ClearSaveGameArchive(&savegamecache.archive);
+}
+
+// Checksum identifying an archive on both ends of a delta, FNV-1a
+static UINT32 SaveGameChecksum(const UINT8 *p, size_t length)
+{
+	UINT32 hash = 2166136261u;
+
+	while (length--)
+	{
+		hash ^= *p++;
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
+// Serializes and compresses the gamestate into the snapshot cache.
+static boolean SV_BuildSaveGame(boolean resending)
 {
 	size_t length, compressedlen;
 	savebuffer_t save;
 	UINT8 *compressedsave;
-	UINT8 *buffertosend;
+	precise_t starttime = I_GetPreciseTime();
+
+	SV_ClearSaveGameCache();
 
 	// first save it in a malloced buffer
 	save.buffer = (UINT8 *)malloc(SAVEGAMESIZE);
 	if (!save.buffer)
 	{
 		CONS_Alert(CONS_ERROR, M_GetText("No more free memory for savegame\n"));
-		return;
+		return false;
 	}
 
 	// Leave room for the uncompressed length.
@@ -1188,45 +1275,337 @@ static void SV_SendSaveGame(INT32 node, boolean resending)
 		I_Error("Savegame buffer overrun");
 	}
 
+	// Keep the plain archive around to make deltas from
+	savegamecache.archive.length = length - sizeof(UINT32);
+	savegamecache.archive.data = SV_NewSharedRam(savegamecache.archive.length);
+	M_Memcpy(savegamecache.archive.data, save.buffer + sizeof(UINT32), savegamecache.archive.length);
+	savegamecache.archive.checksum = SaveGameChecksum(savegamecache.archive.data, savegamecache.archive.length);
+
 	// Allocate space for compressed save: one byte fewer than for the
 	// uncompressed data to ensure that the compression is worthwhile.
-	compressedsave = Z_Malloc(length - 1, PU_STATIC, NULL);
-	if (!compressedsave)
-	{
-		CONS_Alert(CONS_ERROR, M_GetText("No more free memory for savegame\n"));
-		return;
-	}
+	compressedsave = SV_NewSharedRam(length - 1);
 
 	// Attempt to compress it.
-	if ((compressedlen = lzf_compress(save.buffer + sizeof(UINT32), length - sizeof(UINT32), compressedsave + sizeof(UINT32), length - sizeof(UINT32) - 1)))
+	if ((compressedlen = M_Compress(cv_savegamecompression.value, save.buffer + sizeof(UINT32), length - sizeof(UINT32), compressedsave + sizeof(UINT32), length - sizeof(UINT32) - 1)))
 	{
 		// Compressing succeeded; send compressed data
 
-		free(save.buffer);
-
-		// State that we're compressed.
-		buffertosend = compressedsave;
-		WRITEUINT32(compressedsave, length - sizeof(UINT32));
+		// State that we're compressed, and how.
+		WRITEUINT32(compressedsave, (cv_savegamecompression.value << SAVEGAMECOMPRESSORSHIFT) | (length - sizeof(UINT32)));
+		compressedsave -= sizeof(UINT32);
 		length = compressedlen + sizeof(UINT32);
 	}
 	else
 	{
 		// Compression failed to make it smaller; send original
-		Z_Free(compressedsave);
+		SV_ReleaseSharedRam(compressedsave);
+		compressedsave = SV_NewSharedRam(length);
 
 		// State that we're not compressed
-		buffertosend = save.buffer;
 		WRITEUINT32(save.buffer, 0);
+		M_Memcpy(compressedsave, save.buffer, length);
 	}
 
-	SV_SendRam(node, buffertosend, length, SF_Z_RAM, 0);
+	free(save.buffer);
 	save.p = NULL;
 
+	savegamecache.data = compressedsave;
+	savegamecache.length = length;
+	savegamecache.tic = gametic;
+	savegamecache.resending = resending;
+
+	savegamesnapshots++;
+	savegamesavetime += I_GetPreciseTime() - starttime;
+	return true;
+}
+
+// Delta operations
+#define SAVEGAMEDELTA_LITERAL 0 // UINT32 length, then that many bytes
+#define SAVEGAMEDELTA_COPY 1 // UINT32 offset and length in the base archive
+
+#define DELTABLOCKSIZE 64 // Granularity of matches against the base
+#define DELTAHASHSIZE 65536
+#define DELTAMAXCHAIN 16 // Candidate blocks checked per position
+
+// rsync style rolling checksum of a block
+static UINT32 DeltaBlockSum(const UINT8 *p, UINT32 *a, UINT32 *b)
+{
+	INT32 i;
+
+	*a = *b = 0;
+	for (i = 0; i < DELTABLOCKSIZE; i++)
+	{
+		*a += p[i];
+		*b += *a;
+	}
+
+	return (*a & 0xFFFF) | (*b << 16);
+}
+
+#define DELTAHASH(sum) (((sum) * 2654435761u) >> 16)
+
+static UINT8 *WriteDeltaLiteral(UINT8 *p, const UINT8 *data, size_t length)
+{
+	WRITEUINT8(p, SAVEGAMEDELTA_LITERAL);
+	WRITEUINT32(p, length);
+	M_Memcpy(p, data, length);
+	return p + length;
+}
+
+//
+// SV_EncodeSaveGameDelta
+//
+// Describes target as runs copied from base and literal bytes.
+// Blocks of base are indexed at fixed offsets, and target is scanned
+// with a rolling checksum, so matches survive inserted or removed data.
+// out needs room for the result, which is never larger than
+// targetlength + targetlength / 4 + 64 bytes.
+//
+static size_t SV_EncodeSaveGameDelta(const UINT8 *base, size_t baselength, const UINT8 *target, size_t targetlength, UINT8 *out)
+{
+	const size_t numblocks = baselength / DELTABLOCKSIZE;
+	INT32 *head = Z_Malloc(DELTAHASHSIZE * sizeof (INT32), PU_STATIC, NULL);
+	INT32 *next = Z_Malloc((numblocks + 1) * sizeof (INT32), PU_STATIC, NULL);
+	size_t pos = 0, literal = 0;
+	UINT32 a = 0, b = 0, sum = 0;
+	boolean summed = false;
+	UINT8 *p = out;
+	INT32 i;
+
+	memset(head, 0xFF, DELTAHASHSIZE * sizeof (INT32));
+
+	// Chains run in ascending order, so earlier blocks are tried first
+	for (i = (INT32)numblocks; i-- > 0;)
+	{
+		UINT32 h = DELTAHASH(DeltaBlockSum(base + i * DELTABLOCKSIZE, &a, &b));
+		next[i] = head[h];
+		head[h] = i;
+	}
+
+	while (pos + DELTABLOCKSIZE <= targetlength)
+	{
+		size_t offset = 0, length = 0;
+		INT32 chain = 0;
+
+		if (!summed)
+		{
+			sum = DeltaBlockSum(target + pos, &a, &b);
+			summed = true;
+		}
+
+		for (i = head[DELTAHASH(sum)]; i != -1 && chain < DELTAMAXCHAIN; i = next[i], chain++)
+		{
+			offset = (size_t)i * DELTABLOCKSIZE;
+			if (memcmp(base + offset, target + pos, DELTABLOCKSIZE))
+				continue;
+
+			// Grow the match both ways as far as it goes
+			length = DELTABLOCKSIZE;
+			while (pos + length < targetlength && offset + length < baselength
+				&& base[offset + length] == target[pos + length])
+				length++;
+			while (pos > literal && offset > 0 && base[offset - 1] == target[pos - 1])
+			{
+				pos--;
+				offset--;
+				length++;
+			}
+			break;
+		}
+
+		if (length)
+		{
+			if (pos > literal)
+				p = WriteDeltaLiteral(p, target + literal, pos - literal);
+
+			WRITEUINT8(p, SAVEGAMEDELTA_COPY);
+			WRITEUINT32(p, offset);
+			WRITEUINT32(p, length);
+
+			pos += length;
+			literal = pos;
+			summed = false;
+			continue;
+		}
+
+		// No match here, roll the checksum on by a byte
+		if (pos + DELTABLOCKSIZE < targetlength)
+		{
+			a = a - target[pos] + target[pos + DELTABLOCKSIZE];
+			b = b - DELTABLOCKSIZE * target[pos] + a;
+			sum = (a & 0xFFFF) | (b << 16);
+		}
+		pos++;
+	}
+
+	if (targetlength > literal)
+		p = WriteDeltaLiteral(p, target + literal, targetlength - literal);
+
+	Z_Free(head);
+	Z_Free(next);
+
+	return p - out;
+}
+
+//
+// SV_MakeSaveGameDelta
+//
+// Builds a resync for a node out of the difference between the cached
+// snapshot and the archive the node last acknowledged. Returns NULL if
+// the delta wouldn't be any smaller than the full snapshot.
+//
+static UINT8 *SV_MakeSaveGameDelta(INT32 node, size_t *length)
+{
+	const savegamearchive_t *base = &savegamebase[node];
+	const savegamearchive_t *target = &savegamecache.archive;
+	size_t deltalength, compressedlen;
+	UINT8 *delta, *compressed, *p;
+
+	delta = Z_Malloc(4 * sizeof (UINT32) + target->length + target->length / 4 + 64, PU_STATIC, NULL);
+
+	p = delta;
+	WRITEUINT32(p, base->length);
+	WRITEUINT32(p, base->checksum);
+	WRITEUINT32(p, target->length);
+	WRITEUINT32(p, target->checksum);
+	deltalength = p - delta + SV_EncodeSaveGameDelta(base->data, base->length, target->data, target->length, p);
+
+	if (deltalength + sizeof(UINT32) >= savegamecache.length)
+	{
+		Z_Free(delta);
+		return NULL;
+	}
+
+	compressed = SV_NewSharedRam(deltalength + sizeof(UINT32));
+	p = compressed;
+
+	// Attempt to compress it, like a full snapshot.
+	if ((compressedlen = M_Compress(cv_savegamecompression.value, delta, deltalength, compressed + sizeof(UINT32), deltalength - 1)))
+	{
+		WRITEUINT32(p, SAVEGAMEDELTA | (cv_savegamecompression.value << SAVEGAMECOMPRESSORSHIFT) | deltalength);
+		*length = compressedlen + sizeof(UINT32);
+	}
+	else
+	{
+		WRITEUINT32(p, SAVEGAMEDELTA);
+		M_Memcpy(p, delta, deltalength);
+		*length = deltalength + sizeof(UINT32);
+	}
+
+	Z_Free(delta);
+	return compressed;
+}
+
+//
+// SV_SendSaveGame
+//
+// Sends the gamestate to a joining (or resynching) node. Every node asking
+// on the same tic gets the same snapshot, so a burst of joiners at the start
+// of a round only costs one serialization. A resync can be sent as a delta
+// against what the node has, if its archive matches the one we last sent it.
+//
+static void SV_SendSaveGame(INT32 node, boolean resending, boolean delta)
+{
+	UINT8 *data = NULL;
+	size_t length;
+
+	if (savegamecache.data && savegamecache.tic == gametic && savegamecache.resending == resending)
+		savegamereuses++;
+	else if (!SV_BuildSaveGame(resending))
+		return;
+
+	if (delta && cv_gamestatedeltas.value && savegamebase[node].data)
+		data = SV_MakeSaveGameDelta(node, &length);
+
+	if (data)
+	{
+		SV_SendRam(node, data, length, SF_SHAREDRAM, 0);
+		SV_ReleaseSharedRam(data); // the transfer holds it now
+
+		savegamedeltas++;
+		savegamedeltabytes += length;
+		savegamedeltafullbytes += savegamecache.length;
+	}
+	else
+	{
+		length = savegamecache.length;
+		SV_SendRam(node, savegamecache.data, length, SF_SHAREDRAM, 0);
+	}
+
+	// This becomes the node's base once it tells us it loaded it
+	SetSaveGameArchive(&savegamepending[node], &savegamecache.archive);
+
 	// Remember when we started sending the savegame so we can handle timeouts
 	sendingsavegame[node] = true;
 	freezetimeout[node] = I_GetTime() + jointimeout + length / 1024; // 1 extra tic for each kilobyte
 }
 
+//
+// Command_CompressBench_f
+//
+// Packs the current gamestate archive with every compressor, and reports
+// how small and how fast each one gets it.
+//
+static void Command_CompressBench_f(void)
+{
+	const INT32 runs = (COM_Argc() > 1) ? max(1, atoi(COM_Argv(1))) : 10;
+	savebuffer_t save;
+	UINT8 *packed, *unpacked;
+	size_t length, packedmax;
+	INT32 i, j;
+
+	save.p = save.buffer = (UINT8 *)malloc(SAVEGAMESIZE);
+	if (!save.buffer)
+	{
+		CONS_Alert(CONS_ERROR, M_GetText("No more free memory for savegame\n"));
+		return;
+	}
+
+	P_SaveNetGame(&save, false);
+	length = save.p - save.buffer;
+	if (length > SAVEGAMESIZE)
+		I_Error("Savegame buffer overrun");
+
+	packedmax = length + length / 4 + 1024;
+	packed = Z_Malloc(packedmax, PU_STATIC, NULL);
+	unpacked = Z_Malloc(length, PU_STATIC, NULL);
+
+	CONS_Printf(M_GetText("Gamestate archive is %s bytes, packing it %d times:\n"), sizeu1(length), runs);
+
+	for (i = COMP_NONE + 1; i < NUMCOMPRESSORS; i++)
+	{
+		size_t packedlength = 0, unpackedlength = 0;
+		precise_t packtime, unpacktime;
+		double packsecs, unpacksecs;
+
+		packtime = I_GetPreciseTime();
+		for (j = 0; j < runs; j++)
+			packedlength = M_Compress(i, save.buffer, length, packed, packedmax);
+		packtime = I_GetPreciseTime() - packtime;
+
+		unpacktime = I_GetPreciseTime();
+		for (j = 0; j < runs; j++)
+			unpackedlength = M_Decompress(i, packed, packedlength, unpacked, length);
+		unpacktime = I_GetPreciseTime() - unpacktime;
+
+		if (!packedlength || unpackedlength != length || memcmp(unpacked, save.buffer, length))
+		{
+			CONS_Printf(M_GetText("%-5s didn't survive a round trip!\n"), compressors[i].name);
+			continue;
+		}
+
+		packsecs = (double)packtime / I_GetPrecisePrecision() / runs;
+		unpacksecs = (double)unpacktime / I_GetPrecisePrecision() / runs;
+		CONS_Printf(M_GetText("%-5s %9s bytes (%5.1f%%), packs at %7.1f MB/s, unpacks at %7.1f MB/s\n"),
+			compressors[i].name, sizeu1(packedlength), 100.0 * packedlength / length,
+			length / 1048576.0 / max(packsecs, 1e-9), length / 1048576.0 / max(unpacksecs, 1e-9));
+	}
+
+	Z_Free(packed);
+	Z_Free(unpacked);
+	free(save.buffer);
+}
+
 #ifdef DUMPCONSISTENCY
 #define TMPSAVENAME "badmath.sav"
 static consvar_t cv_dumpconsistency = {"dumpconsistency", "Off", CV_NETVAR, CV_OnOff, NULL, 0, NULL, NULL, 0, 0, NULL};
@@ -1272,10 +1651,121 @@ static void SV_SavedGame(void)
 #endif
 #define TMPSAVENAME "$$$.sav"
 
-static void CL_LoadReceivedSavegame(boolean reloading)
+//
+// CL_ApplySaveGameDelta
+//
+// Rebuilds an archive from a delta against the one we loaded last.
+// Returns NULL if the delta wasn't made from that archive, or doesn't
+// produce what the server meant it to.
+//
+static UINT8 *CL_ApplySaveGameDelta(UINT8 *delta, size_t length, size_t *archivelength)
+{
+	UINT8 *end = delta + length;
+	UINT8 *archive, *q;
+	UINT32 baselength, basechecksum, targetlength, targetchecksum;
+
+	if (length < 4 * sizeof (UINT32))
+		return NULL;
+
+	baselength = READUINT32(delta);
+	basechecksum = READUINT32(delta);
+	targetlength = READUINT32(delta);
+	targetchecksum = READUINT32(delta);
+
+	if (!cl_savegamebase || baselength != cl_savegamebaselength || basechecksum != cl_savegamebasechecksum)
+		return NULL;
+
+	q = archive = Z_Malloc(targetlength, PU_STATIC, NULL);
+
+	while (delta < end)
+	{
+		UINT8 op = READUINT8(delta);
+		UINT32 offset = 0, runlength;
+		const UINT8 *source;
+
+		if (op == SAVEGAMEDELTA_COPY)
+		{
+			if (end - delta < 2 * (ptrdiff_t)sizeof (UINT32))
+				break;
+			offset = READUINT32(delta);
+			runlength = READUINT32(delta);
+			if (offset > baselength || runlength > baselength - offset)
+				break;
+			source = cl_savegamebase + offset;
+		}
+		else if (op == SAVEGAMEDELTA_LITERAL)
+		{
+			if (end - delta < (ptrdiff_t)sizeof (UINT32))
+				break;
+			runlength = READUINT32(delta);
+			if (runlength > (size_t)(end - delta))
+				break;
+			source = delta;
+			delta += runlength;
+		}
+		else
+			break;
+
+		if (runlength > targetlength - (size_t)(q - archive))
+			break;
+
+		M_Memcpy(q, source, runlength);
+		q += runlength;
+	}
+
+	if (delta != end || q != archive + targetlength || SaveGameChecksum(archive, targetlength) != targetchecksum)
+	{
+		Z_Free(archive);
+		return NULL;
+	}
+
+	*archivelength = targetlength;
+	return archive;
+}
+
+//
+// CL_AskForGamestate
+//
+// Gets ready to download the gamestate again, and tells the server
+// which archive we have so it can send just what changed.
+//
+static boolean CL_AskForGamestate(void)
+{
+	char tmpsave[264];
+
+	netbuffer->packettype = PT_CANRECEIVEGAMESTATE;
+	netbuffer->u.gamestatebase.length = LONG((UINT32)(cl_savegamebase ? cl_savegamebaselength : 0));
+	netbuffer->u.gamestatebase.checksum = LONG(cl_savegamebasechecksum);
+	if (!HSendPacket(servernode, true, 0, sizeof (gamestatebase_pak)))
+		return false;
+
+	sprintf(tmpsave, "%s" PATHSEP TMPSAVENAME, srb2home);
+
+	// Don't get a corrupt savegame error because tmpsave already exists
+	if (FIL_FileExists(tmpsave) && unlink(tmpsave) == -1)
+		I_Error("Can't delete %s\n", tmpsave);
+
+	CL_PrepareDownloadSaveGame(tmpsave);
+	return true;
+}
+
+static void CL_ClearSaveGameBase(void)
+{
+	if (cl_savegamebase)
+		Z_Free(cl_savegamebase);
+	cl_savegamebase = NULL;
+	cl_savegamebaselength = 0;
+	cl_savegamebasechecksum = 0;
+}
+
+// Returns false if the savegame couldn't be used, and a new one was asked for
+static boolean CL_LoadReceivedSavegame(boolean reloading)
 {
 	savebuffer_t save;
 	size_t length, decompressedlen;
+	UINT32 header;
+	boolean delta;
+	UINT8 *archive;
 	char tmpsave[264];
 
 	sprintf(tmpsave, "%s" PATHSEP TMPSAVENAME, srb2home);
@@ -1286,22 +1776,54 @@ static void CL_LoadReceivedSavegame(boolean reloading)
 	if (!length)
 	{
 		I_Error("Can't read savegame sent");
-		return;
+		return false;
 	}
 
 	save.p = save.buffer;
 
 	// Decompress saved game if necessary.
-	decompressedlen = READUINT32(save.p);
+	header = READUINT32(save.p);
+	length -= sizeof(UINT32);
+	delta = (header & SAVEGAMEDELTA) != 0;
+	decompressedlen = header & SAVEGAMELENGTHMASK;
 
 	if (decompressedlen > 0)
 	{
-		UINT8 *decompressedbuffer = Z_Malloc(decompressedlen, PU_STATIC, NULL);
-		lzf_decompress(save.p, length - sizeof(UINT32), decompressedbuffer, decompressedlen);
-		Z_Free(save.buffer);
-		save.p = save.buffer = decompressedbuffer;
+		archive = Z_Malloc(decompressedlen, PU_STATIC, NULL);
+		if (M_Decompress((header >> SAVEGAMECOMPRESSORSHIFT) & SAVEGAMECOMPRESSORMASK, save.p, length, archive, decompressedlen) != decompressedlen)
+			I_Error("Can't read savegame sent");
+		length = decompressedlen;
+	}
+	else
+	{
+		archive = Z_Malloc(length, PU_STATIC, NULL);
+		M_Memcpy(archive, save.p, length);
+	}
+	Z_Free(save.buffer);
+
+	if (delta)
+	{
+		UINT8 *deltabuffer = archive;
+		archive = CL_ApplySaveGameDelta(deltabuffer, length, &length);
+		Z_Free(deltabuffer);
+
+		if (!archive)
+		{
+			if (!reloading)
+				I_Error("Can't read savegame sent");
+
+			// Our archive doesn't match the server's anymore, get all of it
+			CONS_Alert(CONS_WARNING, M_GetText("Couldn't apply gamestate delta, asking for a full one\n"));
+			CL_ClearSaveGameBase();
+			if (unlink(tmpsave) == -1)
+				CONS_Alert(CONS_ERROR, M_GetText("Can't delete %s\n"), tmpsave);
+			CL_AskForGamestate();
+			return false;
+		}
 	}
 
+	save.p = save.buffer = archive;
+
 	paused = false;
 	demo.playback = false;
 	demo.title = false;
@@ -1327,8 +1849,11 @@ static void CL_LoadReceivedSavegame(boolean reloading)
 		}
 	}
 
-	// done
-	Z_Free(save.buffer);
+	// done, but keep the archive so the next resync can be a delta
+	CL_ClearSaveGameBase();
+	cl_savegamebase = save.buffer;
+	cl_savegamebaselength = length;
+	cl_savegamebasechecksum = SaveGameChecksum(save.buffer, length);
 	save.p = NULL;
 	if (unlink(tmpsave) == -1)
 		CONS_Alert(CONS_ERROR, M_GetText("Can't delete %s\n"), tmpsave);
@@ -1339,6 +1864,7 @@ static void CL_LoadReceivedSavegame(boolean reloading)
 	// so they know they can resume the game
 	netbuffer->packettype = PT_RECEIVEDGAMESTATE;
 	HSendPacket(servernode, true, 0, 0);
+	return true;
 }
 
 static void CL_ReloadReceivedSavegame(void)
@@ -1351,7 +1877,8 @@ static void CL_ReloadReceivedSavegame(void)
 		sprintf(player_names[i], "Player %d", i + 1);
 	}
 
-	CL_LoadReceivedSavegame(true);
+	if (!CL_LoadReceivedSavegame(true))
+		return; // still redownloading
 
 	if (neededtic < gametic)
 		neededtic = gametic;
@@ -2317,7 +2844,9 @@ static void Command_ClearBans(void)
 	if (!I_ClearBans)
 		return;
 
+	Net_LockDriver();
 	I_ClearBans();
+	Net_UnlockDriver();
 	D_SaveBan();
 }
 
@@ -2461,7 +2990,9 @@ void D_LoadBan(boolean warning)
 
 static void Command_ReloadBan(void)  //recheck ban.txt
 {
+	Net_LockDriver();
 	D_LoadBan(true);
+	Net_UnlockDriver();
 }
 
 static void Command_connect(void)
@@ -2555,6 +3086,17 @@ static void Command_Packetstat(void)
 	{
 		CONS_Printf("%16s: %llu%s", Net_GetPacketName(i), packetstat[i], (i % 2 == 1) ? "\n" : "\t|\t");
 	}
+
+	CONS_Printf(M_GetText("\nGamestate snapshots: %u serialized, %u reused"), savegamesnapshots, savegamereuses);
+	if (savegamesnapshots)
+		CONS_Printf(M_GetText(", %.2f ms average to serialize"), (double)savegamesavetime * 1000.0 / I_GetPrecisePrecision() / savegamesnapshots);
+	CONS_Printf("\n");
+	if (savegamedeltas)
+		CONS_Printf(M_GetText("Gamestate resyncs sent as deltas: %u, %s bytes instead of %s\n"), savegamedeltas,
+			sizeu1((size_t)savegamedeltabytes), sizeu2((size_t)savegamedeltafullbytes));
+	CONS_Printf(M_GetText("Datagrams received: %u in %u reads, sent: %u in %u writes\n"),
+		netdriverstats.recvpackets, netdriverstats.recvcalls,
+		netdriverstats.sendpackets, netdriverstats.sendcalls);
 }
 
 #endif
@@ -2729,6 +3271,7 @@ void CL_Reset(void)
 	fileneedednum = 0;
 	memset(fileneeded, 0, sizeof(fileneeded));
 	memset(packetstat, 0, sizeof(packetstat));
+	memset(&netdriverstats, 0, sizeof(netdriverstats));
 
 #ifndef NONET
 	totalfilesrequestednum = 0;
@@ -2986,6 +3529,7 @@ static void Command_BanIP(void)
 
 		const char *address = NULL;
 		const char *mask = NULL;
+		boolean added;
 
 		const char *reason = NULL;
 
@@ -2997,7 +3541,11 @@ static void Command_BanIP(void)
 			reason = COM_Argv(2);
 		}
 
-		if (I_SetBanAddress && I_SetBanAddress(address, mask))
+		Net_LockDriver();
+		added = (I_SetBanAddress && I_SetBanAddress(address, mask));
+		Net_UnlockDriver();
+
+		if (added)
 		{
 			if (reason)
 			{
@@ -3185,7 +3733,13 @@ static void Got_KickCmd(UINT8 **p, INT32 playernum)
 
 		if (msg == KICK_MSG_BANNED || msg == KICK_MSG_CUSTOM_BAN || banMinutes)
 		{
-			if (I_Ban && !I_Ban(playernode[(INT32)pnum]))
+			boolean added;
+
+			Net_LockDriver();
+			added = (!I_Ban || I_Ban(playernode[(INT32)pnum]));
+			Net_UnlockDriver();
+
+			if (!added)
 			{
 				CONS_Alert(CONS_WARNING, M_GetText("Ban failed. Invalid node?\n"));
 			}
@@ -3441,6 +3995,10 @@ static void Command_ResendGamestate(void)
 static CV_PossibleValue_t netticbuffer_cons_t[] = {{0, "MIN"}, {3, "MAX"}, {0, NULL}};
 consvar_t cv_netticbuffer = {"netticbuffer", "1", CV_SAVE, netticbuffer_cons_t, NULL, 0, NULL, NULL, 0, 0, NULL};
 
+#ifdef NETTHREAD
+consvar_t cv_netthread = {"netthread", "Off", CV_SAVE, CV_OnOff, NULL, 0, NULL, NULL, 0, 0, NULL};
+#endif
+
 static void Joinable_OnChange(void);
 
 consvar_t cv_joinrefusemessage = {"joinrefusemessage", "The server is not accepting joins for the moment.", CV_SAVE, NULL, NULL, 0, NULL, NULL, 0, 0, NULL};
@@ -3464,6 +4022,11 @@ consvar_t cv_gamestateattempts = {"gamestateresendattempts", "10", CV_SAVE, game
 static CV_PossibleValue_t resynchcooldown_cons_t[] = {{0, "MIN"}, {20, "MAX"}, {0, NULL}};
 consvar_t cv_resynchcooldown = {"gamestatecooldown", "5", CV_SAVE, resynchcooldown_cons_t, NULL, 0, NULL, NULL, 0, 0, NULL};
 
+consvar_t cv_gamestatedeltas = {"gamestatedeltas", "On", CV_SAVE, CV_OnOff, NULL, 0, NULL, NULL, 0, 0, NULL};
+
+static CV_PossibleValue_t savegamecompression_cons_t[] = {{COMP_LZF, "LZF"}, {COMP_LZ4, "Fast"}, {COMP_LZ4H, "Max"}, {0, NULL}};
+consvar_t cv_savegamecompression = {"gamestatecompression", "Fast", CV_SAVE, savegamecompression_cons_t, NULL, 0, NULL, NULL, 0, 0, NULL};
+
 consvar_t cv_blamecfail = {"blamecfail", "Off", CV_SAVE, CV_OnOff, NULL, 0, NULL, NULL, 0, 0, NULL	};
 
 // max file size to send to a player (in kilobytes)
@@ -3475,6 +4038,9 @@ consvar_t cv_noticedownload = {"noticedownload", "Off", CV_SAVE, CV_OnOff, NULL,
 static CV_PossibleValue_t downloadspeed_cons_t[] = {{1, "MIN"}, {300, "MAX"}, {0, NULL}};
 consvar_t cv_downloadspeed = {"downloadspeed", "300", CV_SAVE, downloadspeed_cons_t, NULL, 0, NULL, NULL, 0, 0, NULL};
 
+// Compress file fragments when it makes them smaller
+consvar_t cv_compressdownloads = {"compressdownloads", "On", CV_SAVE, CV_OnOff, NULL, 0, NULL, NULL, 0, 0, NULL};
+
 static CV_PossibleValue_t connectawaittime_cons_t[] = {{1, "MIN"}, {60, "MAX"}, {0, "Inf"}, {0, NULL}};
 consvar_t cv_connectawaittime = {"connectawaittime", "5", CV_SAVE, connectawaittime_cons_t, NULL, 0, NULL, NULL, 0, 0, NULL};
 
@@ -3529,6 +4095,9 @@ void D_ClientServerInit(void)
 #ifdef _DEBUG
 	COM_AddCommand("numnodes", Command_Numnodes);
 #endif
+#endif
+#ifdef JOININGAME
+	COM_AddCommand("compressbench", Command_CompressBench_f);
 #endif
 
 	RegisterNetXCmd(XD_KICK, Got_KickCmd);
@@ -3547,7 +4116,7 @@ void D_ClientServerInit(void)
 	// do not send anything before the real begin
 	SV_StopServer();
 	SV_ResetServer();
-	if (dedicated)
+	if (dedicated && !demo.simulating)
 		SV_SpawnServer();
 }
 
@@ -3569,6 +4138,8 @@ static void ResetNode(INT32 node)
 	resendingsavegame[node] = false;
 	savegameresendcooldown[node] = 0;
 	gamestate_resend_counter[node] = 0;
+	ClearSaveGameArchive(&savegamebase[node]);
+	ClearSaveGameArchive(&savegamepending[node]);
 
 	bannednode[node].banid = SIZE_MAX;
 	bannednode[node].timeleft = NO_BAN_TIME;
@@ -3622,6 +4193,20 @@ void SV_ResetServer(void)
 	// clear server_context
 	memset(server_context, '-', 8);
 	memset(packetstat, 0, sizeof(packetstat));
+	memset(&netdriverstats, 0, sizeof(netdriverstats));
+
+	if (savegamecache.data)
+		SV_ReleaseSharedRam(savegamecache.data);
+	savegamecache.data = NULL;
+	ClearSaveGameArchive(&savegamecache.archive);
+	savegamesnapshots = savegamereuses = savegamedeltas = 0;
+	savegamesavetime = 0;
+	savegamedeltabytes = savegamedeltafullbytes = 0;
+	if (cl_savegamebase)
+		Z_Free(cl_savegamebase);
+	cl_savegamebase = NULL;
+	cl_savegamebaselength = 0;
+	cl_savegamebasechecksum = 0;
 
 	DEBFILE("\n-=-=-=-=-=-=-= Server Reset =-=-=-=-=-=-=-\n\n");
 }
@@ -4143,7 +4728,7 @@ static void HandleConnect(SINT8 node)
 		{
 			if (node && newnode)
 			{
-				SV_SendSaveGame(node, false); // send a complete game state
+				SV_SendSaveGame(node, false, false); // send a complete game state
 				DEBFILE("send savegame\n");
 			}
 			SV_AddWaitingPlayers();
@@ -4217,37 +4802,39 @@ static void HandleServerInfo(SINT8 node)
 
 static void PT_WillResendGamestate(void)
 {
-	char tmpsave[264];
-
 	if (server || cl_redownloadinggamestate)
 		return;
 
 	// Send back a PT_CANRECEIVEGAMESTATE packet to the server
 	// so they know they can start sending the game state
-	netbuffer->packettype = PT_CANRECEIVEGAMESTATE;
-	if (!HSendPacket(servernode, true, 0, 0))
+	if (!CL_AskForGamestate())
 		return;
 
 	CONS_Printf(M_GetText("Reloading game state...\n"));
 
-	sprintf(tmpsave, "%s" PATHSEP TMPSAVENAME, srb2home);
-
-	// Don't get a corrupt savegame error because tmpsave already exists
-	if (FIL_FileExists(tmpsave) && unlink(tmpsave) == -1)
-		I_Error("Can't delete %s\n", tmpsave);
-
-	CL_PrepareDownloadSaveGame(tmpsave);
 	cl_redownloadinggamestate = true;
 }
 
 static void PT_CanReceiveGamestate(SINT8 node)
 {
-	if (client || sendingsavegame[node])
+	boolean delta = false;
+
+	// A node that couldn't use the delta we sent asks again once it's downloaded
+	if (client || (sendingsavegame[node] && !resendingsavegame[node]) || SV_SendingFile(node))
 		return;
 
+	// Can we send just what changed since the archive it has?
+	if (doomcom->datalength >= (INT16)(BASEPACKETSIZE + sizeof (gamestatebase_pak)))
+	{
+		delta = ((UINT32)LONG(netbuffer->u.gamestatebase.length) == savegamebase[node].length
+			&& (UINT32)LONG(netbuffer->u.gamestatebase.checksum) == savegamebase[node].checksum);
+		if (!delta)
+			ClearSaveGameArchive(&savegamebase[node]);
+	}
+
 	CONS_Printf(M_GetText("Resending game state to %s...\n"), player_names[nodetoplayer[node]]);
 
-	SV_SendSaveGame(node, true); // Resend a complete game state
+	SV_SendSaveGame(node, true, delta); // Resend the game state
 	resendingsavegame[node] = true;
 }
 
@@ -4808,6 +5395,8 @@ static void HandlePacketFromPlayer(SINT8 node)
 		case PT_RECEIVEDGAMESTATE:
 			sendingsavegame[node] = false;
 			resendingsavegame[node] = false;
+			SetSaveGameArchive(&savegamebase[node], &savegamepending[node]);
+			ClearSaveGameArchive(&savegamepending[node]);
 			savegameresendcooldown[node] = I_GetTime() + cv_resynchcooldown.value * TICRATE; // I_GetTime() + 5 * TICRATE;
 			break;
 		case PT_SERVERTICS:
@@ -5035,14 +5624,14 @@ static INT16 Consistancy(void)
 		ret += P_GetRandSeed();
 
 #ifdef MOBJCONSISTANCY
-	if (!thinkercap.next)
+	if (!thlist[THINK_MOBJ].cnext)
 	{
 		DEBFILE(va("Consistancy = %u\n", ret));
 		return ret;
 	}
 	if (gamestate == GS_LEVEL)
 	{
-		for (th = thinkercap.next; th != &thinkercap; th = th->next)
+		for (th = thlist[THINK_MOBJ].cnext; th != &thlist[THINK_MOBJ]; th = th->cnext)
 		{
 			if (th->function.acp1 != (actionf_p1)P_MobjThinker)
 				continue;
@@ -5570,6 +6159,9 @@ boolean TryRunTics(tic_t realtics)
 				PS_UpdateTickStats();
 			}
 
+			if (demo.simulating)
+				G_SimulatedTic(consistancy[gametic%TICQUEUE]);
+
 			// Leave a certain amount of tics present in the net buffer as long as we've ran at least one tic this frame.
 			if (client && gamestate == GS_LEVEL && leveltime > 3 && neededtic <= gametic + cv_netticbuffer.value)
 				break;
@@ -5806,7 +6398,7 @@ void NetUpdate(void)
 		return;
 
 #ifdef DEDICATEDIDLETIME
-	if (server && dedicated && gamestate == GS_LEVEL)
+	if (server && dedicated && !demo.simulating && gamestate == GS_LEVEL)
 	{
 		static tic_t dedicatedidle = 0;
 
@@ -5873,7 +6465,11 @@ void NetUpdate(void)
 	if (server)
 		CL_SendClientCmd(); // send it
 
+	Net_UpdateIOThread();
 	GetPackets(); // get packet from client or from server
+#ifdef USE_STUN
+	STUN_dispatch();
+#endif
 
 	// client send the command after a receive of the server
 	// the server send before because in single player is beter
@@ -5923,7 +6519,9 @@ void NetUpdate(void)
 			for (; tictoclear < firstticstosend; tictoclear++) // Clear only when acknowledged
 				D_Clearticcmd(tictoclear);                    // Clear the maketic the new tic
 
+			Net_BeginSendBatch();
 			SV_SendTics();
+			Net_FlushSendBatch();
 
 			neededtic = maketic; // The server is a client too
 		}
@@ -5942,7 +6540,9 @@ void NetUpdate(void)
 #endif
 		CON_Ticker();
 	}
+	Net_BeginSendBatch();
 	SV_FileSendTicker();
+	Net_FlushSendBatch();
 }
 
 /** Returns the number of players playing.
@@ -6003,6 +6603,17 @@ rewind_t *CL_SaveRewindPoint(size_t demopos)
 	return rewind;
 }
 
+// When the newest rewind point at or before time is, or 0 if there isn't one
+tic_t CL_RewindTimeBefore(tic_t time)
+{
+	rewind_t *rewind = rewindhead;
+
+	while (rewind && rewind->leveltime > time)
+		rewind = rewind->next;
+
+	return rewind ? rewind->leveltime : 0;
+}
+
 rewind_t *CL_RewindToTime(tic_t time)
 {
 	savebuffer_t save;
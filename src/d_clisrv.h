@@ -25,7 +25,7 @@ The 'packet version' is used to distinguish packet formats.
 This version is independent of VERSION and SUBVERSION. Different
 applications may follow different packet versions.
 */
-#define PACKETVERSION 1
+#define PACKETVERSION 2
 
 // Network play related stuff.
 // There is a data struct that stores network
@@ -194,6 +194,7 @@ typedef struct
 
 typedef struct {
 	UINT8 fileid;
+	UINT8 compressor; // compressor_t data is packed with, size is before that
 	UINT32 position;
 	UINT16 size;
 	UINT8 data[0]; // Size is variable using hardware_MAXPACKETLENGTH
@@ -306,6 +307,13 @@ typedef struct
 	UINT8 files[MAXFILENEEDED]; // is filled with writexxx (byteptr.h)
 } ATTRPACK filesneededconfig_pak;
 
+// Archive a client already has, so a resend can be a delta against it
+typedef struct
+{
+	UINT32 length; // 0 if the client has none
+	UINT32 checksum;
+} ATTRPACK gamestatebase_pak;
+
 //
 // Network packet data
 //
@@ -337,6 +345,7 @@ typedef struct
 		INT32 filesneedednum;               //           4 bytes
 		filesneededconfig_pak filesneededcfg; //       ??? bytes
 		UINT32 pingtable[MAXPLAYERS+1];     //          68 bytes
+		gamestatebase_pak gamestatebase;    //           8 bytes
 	} u; // This is needed to pack diff packet types data together
 } ATTRPACK doomdata_t;
 
@@ -357,7 +366,7 @@ extern UINT32 serverlistultimatecount;
 extern INT32 mapchangepending;
 
 // Points inside doomcom
-extern doomdata_t *netbuffer;
+extern ATTRTHREAD doomdata_t *netbuffer;
 extern consvar_t cv_stunserver;
 extern consvar_t cv_httpsource;
 extern consvar_t cv_kicktime;
@@ -417,10 +426,14 @@ extern consvar_t
 #ifdef VANILLAJOINNEXTROUND
 	cv_joinnextround,
 #endif
-	cv_netticbuffer, cv_allownewplayer, cv_joinrefusemessage, cv_maxplayers, cv_gamestateattempts, cv_resynchcooldown, cv_blamecfail, cv_maxsend, cv_noticedownload, cv_downloadspeed;
+	cv_netticbuffer, cv_allownewplayer, cv_joinrefusemessage, cv_maxplayers, cv_gamestateattempts, cv_resynchcooldown, cv_gamestatedeltas, cv_blamecfail, cv_maxsend, cv_noticedownload, cv_downloadspeed, cv_compressdownloads, cv_savegamecompression;
 
 extern consvar_t cv_connectawaittime;
 
+#ifdef NETTHREAD
+extern consvar_t cv_netthread;
+#endif
+
 extern consvar_t cv_discordinvites;
 
 // Used in d_net, the only dependence
@@ -496,5 +509,6 @@ typedef struct rewind_s {
 
 void CL_ClearRewinds(void);
 rewind_t *CL_SaveRewindPoint(size_t demopos);
+tic_t CL_RewindTimeBefore(tic_t time);
 rewind_t *CL_RewindToTime(tic_t time);
 #endif
@@ -447,68 +447,75 @@ static boolean D_Display(void)
 
 			R_ApplyLevelInterpolators(R_UsingFrameInterpolation() ? rendertimefrac : FRACUNIT);
 
-			for (i = 0; i <= splitscreen; i++)
+			if (!R_RenderViewsThreaded())
 			{
-				if (players[displayplayers[i]].mo || players[displayplayers[i]].playerstate == PST_DEAD)
+				PS_START_TIMING(ps_sw_serialviewstime);
+
+				for (i = 0; i <= splitscreen; i++)
 				{
-					if (i == 0) // Initialize for P1
+					if (players[displayplayers[i]].mo || players[displayplayers[i]].playerstate == PST_DEAD)
 					{
-						viewwindowy = 0;
-						viewwindowx = 0;
+						if (i == 0) // Initialize for P1
+						{
+							viewwindowy = 0;
+							viewwindowx = 0;
 
-						topleft = screens[0] + viewwindowy*vid.width + viewwindowx;
-						objectsdrawn = 0;
-					}
+							topleft = screens[0] + viewwindowy*vid.width + viewwindowx;
+							objectsdrawn = 0;
+						}
 
-					viewssnum = i;
+						viewssnum = i;
 
 #ifdef HWRENDER
-					if (rendermode == render_opengl)
-						HWR_RenderPlayerView(i, &players[displayplayers[i]]);
-					else
+						if (rendermode == render_opengl)
+							HWR_RenderPlayerView(i, &players[displayplayers[i]]);
+						else
 #endif
-					if (rendermode != render_none)
-					{
-						if (i > 0) // Splitscreen-specific
+						if (rendermode != render_none)
 						{
-							switch (i)
+							if (i > 0) // Splitscreen-specific
 							{
-								case 1:
-									if (splitscreen > 1)
-									{
-										viewwindowx = viewwidth;
-										viewwindowy = 0;
-									}
-									else
-									{
+								switch (i)
+								{
+									case 1:
+										if (splitscreen > 1)
+										{
+											viewwindowx = viewwidth;
+											viewwindowy = 0;
+										}
+										else
+										{
+											viewwindowx = 0;
+											viewwindowy = viewheight;
+										}
+										M_Memcpy(ylookup, ylookup2, viewheight*sizeof (ylookup[0]));
+										break;
+									case 2:
 										viewwindowx = 0;
 										viewwindowy = viewheight;
-									}
-									M_Memcpy(ylookup, ylookup2, viewheight*sizeof (ylookup[0]));
-									break;
-								case 2:
-									viewwindowx = 0;
-									viewwindowy = viewheight;
-									M_Memcpy(ylookup, ylookup3, viewheight*sizeof (ylookup[0]));
-									break;
-								case 3:
-									viewwindowx = viewwidth;
-									viewwindowy = viewheight;
-									M_Memcpy(ylookup, ylookup4, viewheight*sizeof (ylookup[0]));
-								default:
-									break;
-							}
+										M_Memcpy(ylookup, ylookup3, viewheight*sizeof (ylookup[0]));
+										break;
+									case 3:
+										viewwindowx = viewwidth;
+										viewwindowy = viewheight;
+										M_Memcpy(ylookup, ylookup4, viewheight*sizeof (ylookup[0]));
+									default:
+										break;
+								}
 
 
-							topleft = screens[0] + viewwindowy*vid.width + viewwindowx;
-						}
+								topleft = screens[0] + viewwindowy*vid.width + viewwindowx;
+							}
 
-						R_RenderPlayerView(&players[displayplayers[i]]);
+							R_RenderPlayerView(&players[displayplayers[i]]);
 
-						if (i > 0)
-							M_Memcpy(ylookup, ylookup1, viewheight*sizeof (ylookup[0]));
+							if (i > 0)
+								M_Memcpy(ylookup, ylookup1, viewheight*sizeof (ylookup[0]));
+						}
 					}
 				}
+
+				PS_STOP_TIMING(ps_sw_serialviewstime);
 			}
 
 			if (rendermode == render_soft)
@@ -1414,6 +1421,10 @@ void D_SRB2Main(void)
 	// for dedicated server
 	dedicated = M_CheckParm("-dedicated") != 0;
 
+	// simulating a replay starts up like a dedicated server does, minus the server
+	if (M_CheckParm("-simulate") || M_CheckParm("-timedemo-headless"))
+		dedicated = demo.simulating = true;
+
 	strcpy(title, "SRB2Kart");
 	strcpy(srb2, "SRB2Kart");
 	D_MakeTitleString(srb2);
@@ -1509,7 +1520,7 @@ void D_SRB2Main(void)
 
 	// get map from parms
 
-	if (M_CheckParm("-server") || dedicated)
+	if (M_CheckParm("-server") || (dedicated && !demo.simulating))
 		netgame = server = true;
 
 	CONS_Printf("Z_Init(): Init zone memory allocation daemon. \n");
@@ -1776,6 +1787,7 @@ void D_SRB2Main(void)
 	if (!W_InitMultipleFiles(startuppwads, true))
 		CONS_Error("A PWAD file was not found or not valid.\nCheck the log to see which ones.\n");
 	D_CleanFile(startuppwads);
+	W_LogLumpReads("Startup", false);
 	
 	//--------------------------------------------------------- CONFIG.CFG
 	M_FirstLoadConfig(); // WARNING : this do a "COM_BufExecute()"
@@ -1925,6 +1937,8 @@ void D_SRB2Main(void)
 	p = M_CheckParm("-playdemo");
 	if (!p)
 		p = M_CheckParm("-timedemo");
+	if (demo.simulating && !(p = M_CheckParm("-simulate")))
+		p = M_CheckParm("-timedemo-headless");
 	if (p && M_IsNextParm())
 	{
 		char tmp[MAX_WADPATH];
@@ -1944,7 +1958,9 @@ void D_SRB2Main(void)
 
 		CONS_Printf(M_GetText("Playing demo %s.\n"), tmp);
 
-		if (M_CheckParm("-playdemo"))
+		if (demo.simulating)
+			G_SimulateDemo(tmp);
+		else if (M_CheckParm("-playdemo"))
 		{
 			demo.quitafterplaying = true; // quit after one demo
 			G_DeferedPlayDemo(tmp);
@@ -1956,6 +1972,8 @@ void D_SRB2Main(void)
 		wipegamestate = GS_NULL;
 		return;
 	}
+	else if (demo.simulating)
+		I_Error("usage: -simulate <replay> [-hashlog <file>]");
 
 #ifdef HAVE_CURL
 	if (M_CheckProtoParam("replay"))
@@ -29,6 +29,9 @@
 #include "z_zone.h"
 #include "i_tcp.h"
 #include "d_main.h" // srb2home
+#ifdef HAVE_THREADS
+#include "i_threads.h"
+#endif
 
 //
 // NETWORKING
@@ -46,13 +49,13 @@
 #define FORCECLOSE 0x8000
 tic_t connectiontimeout = (10*TICRATE);
 
-/// \brief network packet
-doomcom_t *doomcom = NULL;
+/// \brief network packet, the network thread has its own
+ATTRTHREAD doomcom_t *doomcom = NULL;
 /// \brief network packet data, points inside doomcom
-doomdata_t *netbuffer = NULL;
+ATTRTHREAD doomdata_t *netbuffer = NULL;
 /// \brief hole punching packet, also points inside doomcom
 #ifdef HOLEPUNCH
-holepunch_t *holepunchpacket = NULL;
+ATTRTHREAD holepunch_t *holepunchpacket = NULL;
 #endif
 
 #ifdef DEBUGFILE
@@ -71,6 +74,8 @@ boolean (*I_NetGet)(void) = NULL;
 void (*I_NetSend)(void) = NULL;
 boolean (*I_NetCanSend)(void) = NULL;
 boolean (*I_NetCanGet)(void) = NULL;
+void (*I_NetBeginBatch)(void) = NULL;
+void (*I_NetFlush)(void) = NULL;
 void (*I_NetCloseSocket)(void) = NULL;
 void (*I_NetFreeNodenum)(INT32 nodenum) = NULL;
 SINT8 (*I_NetMakeNodewPort)(const char *address, const char* port) = NULL;
@@ -92,7 +97,74 @@ boolean (*I_SetBanUsername) (const char *username) = NULL;
 boolean (*I_SetBanReason) (const char *reason) = NULL;
 boolean (*I_SetUnbanTime) (time_t timestamp) = NULL;
 bannednode_t *bannednode = NULL;
+netdriverstats_t netdriverstats;
+
 
+#ifdef NETTHREAD
+// Packets the network thread has received and checked, in arrival order,
+// until HGetPacket hands them to the main thread. Only the network thread
+// moves netqueue_head and only the main thread moves netqueue_tail.
+#define NETQUEUESIZE 128
+
+typedef struct
+{
+	precise_t time; // When the network thread received it
+	INT16 node;
+	INT16 length;
+	UINT32 generation; // nodegeneration[node] when it was received
+	UINT8 data[MAXPACKETLENGTH];
+} netqueuepak_t;
+
+static netqueuepak_t netqueue[NETQUEUESIZE];
+static UINT32 netqueue_head, netqueue_tail;
+
+// Held while the ack tables or the driver are in use once the thread runs
+static I_mutex netthread_mutex;
+static ATTRTHREAD INT32 netlocks; // How deep this thread is in LockNet
+static boolean netthread_started; // Only changed while the thread isn't running
+static boolean netthread_quit, netthread_alive;
+static ATTRTHREAD boolean onnetthread;
+static doomcom_t netthread_doomcom;
+
+// Nodes the network thread owes acks: the game finished with one of their
+// reliable packets, or they resent one we already have
+static boolean nodeackdue[MAXNETNODES];
+
+// Node whose reliable packet the game is handling right now, or -1.
+// Its acks wait, since Net_UnAcknowledgePacket may still take one back.
+static INT32 netqueue_handling = -1;
+
+// The first fatal driver error the network thread ran into, for
+// Net_UpdateIOThread to raise on the main thread
+static char netthread_error[256];
+static boolean netthread_failed;
+
+// Bumped whenever a node is freed, so packets queued for whoever had the
+// number before aren't handed over as if its next owner sent them
+static UINT32 nodegeneration[MAXNETNODES];
+
+// Running average of how long each node's packets waited in netqueue, in microseconds
+static UINT32 nodequeuelatency[MAXNETNODES];
+
+static inline void LockNet(void)
+{
+	if (netlocks || netthread_started)
+	{
+		if (!netlocks)
+			I_lock_mutex(&netthread_mutex);
+		netlocks++;
+	}
+}
+
+static inline void UnlockNet(void)
+{
+	if (netlocks && !--netlocks)
+		I_unlock_mutex(netthread_mutex);
+}
+#else
+#define LockNet()
+#define UnlockNet()
+#endif
 
 // network stats
 static tic_t statstarttic;
@@ -111,6 +183,9 @@ boolean Net_GetNetStat(void)
 {
 	const tic_t t = I_GetTime();
 	static INT64 oldsendbyte = 0;
+	boolean updated = false;
+
+	LockNet();
 	if (statstarttic+STATLENGTH <= t)
 	{
 		const tic_t df = t-statstarttic;
@@ -136,9 +211,10 @@ boolean Net_GetNetStat(void)
 		sendackpacket = getackpacket = duppacket = retransmit = 0;
 		statstarttic = t;
 
-		return 1;
+		updated = true;
 	}
-	return 0;
+	UnlockNet();
+	return updated;
 }
 
 // -----------------------------------------------------------------
@@ -169,6 +245,7 @@ typedef enum
 {
 	NF_CLOSE = 1, // Flag is set when connection is closing
 	NF_TIMEOUT = 2, // Flag is set when the node got a timeout
+	NF_CLOSEPENDING = 4, // The network thread wants Net_AckTicker to close it
 } node_flags_t;
 
 #ifndef NONET
@@ -293,6 +370,7 @@ INT32 Net_GetFreeAcks(boolean urgent)
 	INT32 i, numfreeslot = 0;
 	INT32 n = 0; // Number of free acks found
 
+	LockNet();
 	for (i = 0; i < MAXACKPACKETS; i++)
 		if (!ackpak[i].acknum)
 		{
@@ -306,6 +384,7 @@ INT32 Net_GetFreeAcks(boolean urgent)
 
 			n++;
 		}
+	UnlockNet();
 
 	return n;
 }
@@ -323,11 +402,23 @@ static void RemoveAck(INT32 i)
 	DEBFILE(va("Remove ack %d\n",ackpak[i].acknum));
 	ackpak[i].acknum = 0;
 	if (nodes[node].flags & NF_CLOSE)
+	{
+#ifdef NETTHREAD
+		// Closing also stops file transfers, which is the main thread's business
+		if (onnetthread)
+		{
+			nodes[node].flags |= NF_CLOSEPENDING;
+			return;
+		}
+#endif
 		Net_CloseConnection(node);
+	}
 }
 
 // We have got a packet, proceed the ack request and ack return
-static boolean Processackpak(void)
+// Without record, only says whether the packet is a duplicate and leaves
+// the acks to send alone, for the game to record once it takes the packet
+static boolean Processackpak(boolean record)
 {
 	INT32 i;
 	boolean goodpacket = true;
@@ -350,7 +441,8 @@ static boolean Processackpak(void)
 	if (netbuffer->ack)
 	{
 		UINT8 ack = netbuffer->ack;
-		getackpacket++;
+		if (record)
+			getackpacket++;
 		if (cmpack(ack, node->firstacktosend) <= 0)
 		{
 			DEBFILE(va("Discard(1) ack %d (duplicated)\n", ack));
@@ -368,7 +460,7 @@ static boolean Processackpak(void)
 					goodpacket = false; // Discard packet (duplicate)
 					break;
 				}
-			if (goodpacket)
+			if (goodpacket && record)
 			{
 				// Is a good packet so increment the acknowledge number,
 				// Then search for a "hole" in the queue
@@ -445,9 +537,11 @@ void Net_SendAcks(INT32 node)
 #ifdef NONET
 	(void)node;
 #else
+	LockNet();
 	netbuffer->packettype = PT_NOTHING;
 	M_Memcpy(netbuffer->u.textcmd, nodes[node].acktosend, MAXACKTOSEND);
 	HSendPacket(node, false, 0, MAXACKTOSEND);
+	UnlockNet();
 #endif
 }
 
@@ -478,9 +572,14 @@ static void GotAcks(void)
 
 void Net_ConnectionTimeout(INT32 node)
 {
+	LockNet();
+
 	// Don't timeout several times
 	if (nodes[node].flags & NF_TIMEOUT)
+	{
+		UnlockNet();
 		return;
+	}
 	nodes[node].flags |= NF_TIMEOUT;
 
 	// Send a very special packet to self (hack the reboundstore queue)
@@ -495,6 +594,8 @@ void Net_ConnectionTimeout(INT32 node)
 	// Do not redo it quickly (if we do not close connection it is
 	// for a good reason!)
 	nodes[node].lasttimepacketreceived = I_GetTime();
+
+	UnlockNet();
 }
 
 // Resend the data if needed
@@ -503,6 +604,7 @@ void Net_AckTicker(void)
 #ifndef NONET
 	INT32 i;
 
+	LockNet();
 	for (i = 0; i < MAXACKPACKETS; i++)
 	{
 		const INT32 nodei = ackpak[i].destinationnode;
@@ -532,6 +634,14 @@ void Net_AckTicker(void)
 
 	for (i = 1; i < MAXNETNODES; i++)
 	{
+#ifdef NETTHREAD
+		if (nodes[i].flags & NF_CLOSEPENDING)
+		{
+			nodes[i].flags &= ~NF_CLOSEPENDING;
+			Net_CloseConnection(i);
+		}
+#endif
+
 		// This is something like node open flag
 		if (nodes[i].firstacktosend)
 		{
@@ -547,6 +657,7 @@ void Net_AckTicker(void)
 			}
 		}
 	}
+	UnlockNet();
 #endif
 }
 
@@ -557,10 +668,12 @@ void Net_UnAcknowledgePacket(INT32 node)
 #ifdef NONET
 	(void)node;
 #else
-	INT32 hm1 = (nodes[node].acktosend_head-1+MAXACKTOSEND) % MAXACKTOSEND;
+	INT32 hm1;
 	DEBFILE(va("UnAcknowledge node %d\n", node));
 	if (!node)
 		return;
+	LockNet();
+	hm1 = (nodes[node].acktosend_head-1+MAXACKTOSEND) % MAXACKTOSEND;
 	if (nodes[node].acktosend[hm1] == netbuffer->ack)
 	{
 		nodes[node].acktosend[hm1] = 0;
@@ -588,6 +701,7 @@ void Net_UnAcknowledgePacket(INT32 node)
 		if (!nodes[node].firstacktosend)
 			nodes[node].firstacktosend = 1;
 	}
+	UnlockNet();
 #endif
 }
 
@@ -601,11 +715,13 @@ static boolean Net_AllAcksReceived(void)
 {
 	INT32 i;
 
+	LockNet();
 	for (i = 0; i < MAXACKPACKETS; i++)
 		if (ackpak[i].acknum)
-			return false;
+			break;
+	UnlockNet();
 
-	return true;
+	return (i == MAXACKPACKETS);
 }
 #endif
 
@@ -670,12 +786,14 @@ void Net_AbortPacketType(UINT8 packettype)
 	(void)packettype;
 #else
 	INT32 i;
+	LockNet();
 	for (i = 0; i < MAXACKPACKETS; i++)
 		if (ackpak[i].acknum && (ackpak[i].pak.data.packettype == packettype
 			|| packettype == UINT8_MAX))
 		{
 			ackpak[i].acknum = 0;
 		}
+	UnlockNet();
 #endif
 }
 
@@ -684,7 +802,7 @@ void Net_AbortPacketType(UINT8 packettype)
 // -----------------------------------------------------------------
 
 // remove a node, clear all ack from this node and reset askret
-void Net_CloseConnection(INT32 node)
+static void CloseConnection(INT32 node)
 {
 #ifdef NONET
 	(void)node;
@@ -730,10 +848,20 @@ void Net_CloseConnection(INT32 node)
 
 	InitNode(&nodes[node]);
 	SV_AbortSendFiles(node);
+#ifdef NETTHREAD
+	nodegeneration[node]++;
+#endif
 	I_NetFreeNodenum(node);
 #endif
 }
 
+void Net_CloseConnection(INT32 node)
+{
+	LockNet();
+	CloseConnection(node);
+	UnlockNet();
+}
+
 #ifndef NONET
 //
 // Checksum
@@ -1020,10 +1148,7 @@ static boolean ShouldDropPacket(void)
 #endif
 #endif
 
-//
-// HSendPacket
-//
-boolean HSendPacket(INT32 node, boolean reliable, UINT8 acknum, size_t packetlength)
+static boolean SendPacket(INT32 node, boolean reliable, UINT8 acknum, size_t packetlength)
 {
 	doomcom->datalength = (INT16)(packetlength + BASEPACKETSIZE);
 	if (node == 0) // Packet is to go back to us
@@ -1124,36 +1249,46 @@ boolean HSendPacket(INT32 node, boolean reliable, UINT8 acknum, size_t packetlen
 }
 
 //
-// HGetPacket
-// Returns false if no packet is waiting
-// Check Datalength and checksum
+// HSendPacket
 //
-boolean HGetPacket(void)
+boolean HSendPacket(INT32 node, boolean reliable, UINT8 acknum, size_t packetlength)
 {
-	//boolean nodejustjoined;
+	boolean sent;
 
-	// Get a packet from self
-	if (rebound_tail != rebound_head)
-	{
-		M_Memcpy(netbuffer, &reboundstore[rebound_tail], reboundsize[rebound_tail]);
-		doomcom->datalength = reboundsize[rebound_tail];
-		if (netbuffer->packettype == PT_NODETIMEOUT)
-			doomcom->remotenode = netbuffer->u.textcmd[0];
-		else
-			doomcom->remotenode = 0;
+	LockNet();
+	sent = SendPacket(node, reliable, acknum, packetlength);
+	UnlockNet();
+	return sent;
+}
 
-		rebound_tail = (rebound_tail+1) % MAXREBOUND;
-#ifdef DEBUGFILE
-		if (debugfile)
-			DebugPrintpacket("GETLOCAL");
-#endif
-		return true;
-	}
+//
+// Net_BeginSendBatch
+// Lets the driver hold back packets sent by HSendPacket until
+// Net_FlushSendBatch, so a burst of them costs fewer syscalls
+//
+void Net_BeginSendBatch(void)
+{
+	LockNet();
+	if (netgame && I_NetBeginBatch)
+		I_NetBeginBatch();
+	UnlockNet();
+}
 
-	if (!netgame)
-		return false;
+void Net_FlushSendBatch(void)
+{
+	LockNet();
+	if (I_NetFlush)
+		I_NetFlush();
+	UnlockNet();
+}
 
 #ifndef NONET
+// Takes packets from the driver into doomcom until one needs the game's
+// attention, handling acks and keepalives on the way.
+// Returns false if there is no such packet waiting.
+static boolean ReceivePacket(void)
+{
+	//boolean nodejustjoined;
 
 	while(true)
 	{
@@ -1202,8 +1337,21 @@ boolean HGetPacket(void)
 			continue;
 		}*/
 
+#ifdef NETTHREAD
+		// The game hasn't taken it yet, so GetQueuedPacket records its ack
+		if (onnetthread)
+		{
+			if (!Processackpak(false))
+			{
+				// The sender may not have got our last acks
+				nodeackdue[doomcom->remotenode] = true;
+				continue; // discarded (duplicated)
+			}
+		}
+		else
+#endif
 		// Proceed the ack and ackreturn field
-		if (!Processackpak())
+		if (!Processackpak(true))
 			continue; // discarded (duplicated)
 
 		// A packet with just ackreturn
@@ -1212,8 +1360,281 @@ boolean HGetPacket(void)
 			GotAcks();
 			continue;
 		}
-		break;
+		return true;
+	}
+}
+#endif
+
+#ifdef NETTHREAD
+// Copies the oldest packet the network thread queued into doomcom
+static boolean GetQueuedPacket(void)
+{
+	UINT32 tail;
+	netqueuepak_t *pak;
+	UINT32 waited;
+
+	LockNet();
+
+	// The game is done with the last one, so its ack can go out
+	if (netqueue_handling != -1)
+	{
+		nodeackdue[netqueue_handling] = true;
+		netqueue_handling = -1;
+	}
+
+	for (tail = netqueue_tail; tail != __atomic_load_n(&netqueue_head, __ATOMIC_ACQUIRE); tail++)
+	{
+		pak = &netqueue[tail % NETQUEUESIZE];
+
+		// Its node was closed since, and the number may belong to someone else now
+		if (pak->generation != nodegeneration[pak->node])
+		{
+			__atomic_store_n(&netqueue_tail, tail + 1, __ATOMIC_RELEASE);
+			continue;
+		}
+
+		M_Memcpy(netbuffer, pak->data, pak->length);
+		doomcom->remotenode = pak->node;
+		doomcom->datalength = pak->length;
+
+		waited = (UINT32)((I_GetPreciseTime() - pak->time) * 1000000 / I_GetPrecisePrecision());
+		nodequeuelatency[pak->node] = (nodequeuelatency[pak->node] * 7 + waited) / 8;
+
+		__atomic_store_n(&netqueue_tail, tail + 1, __ATOMIC_RELEASE);
+
+		// Recorded only now, so Net_UnAcknowledgePacket can still take it back,
+		// and a packet queued twice before either was taken is dropped here
+		if (!Processackpak(true))
+			continue;
+
+		if (netbuffer->ack)
+			netqueue_handling = doomcom->remotenode;
+		UnlockNet();
+		return true;
+	}
+
+	UnlockNet();
+	return false;
+}
+
+// Runs with netthread_mutex held
+static void NetThreadReceive(void)
+{
+	UINT32 head = netqueue_head; // Nobody else moves it
+	netqueuepak_t *pak;
+	INT32 i;
+
+	while (head - __atomic_load_n(&netqueue_tail, __ATOMIC_ACQUIRE) < NETQUEUESIZE
+		&& ReceivePacket())
+	{
+		pak = &netqueue[head % NETQUEUESIZE];
+		pak->time = I_GetPreciseTime();
+		pak->node = doomcom->remotenode;
+		pak->length = doomcom->datalength;
+		pak->generation = nodegeneration[pak->node];
+		M_Memcpy(pak->data, netbuffer, doomcom->datalength);
+		__atomic_store_n(&netqueue_head, ++head, __ATOMIC_RELEASE);
 	}
+
+	// Acknowledge now rather than waiting for Net_AckTicker,
+	// so a long frame doesn't make everyone resend
+	for (i = 1; i < MAXNETNODES; i++)
+		if (nodeackdue[i] && i != netqueue_handling)
+		{
+			nodeackdue[i] = false;
+			if (nodes[i].firstacktosend)
+				Net_SendAcks(i);
+		}
+}
+
+static void NetThread(void *userdata)
+{
+	(void)userdata;
+
+	onnetthread = true;
+	doomcom = &netthread_doomcom;
+	netbuffer = (doomdata_t *)(void *)&doomcom->data;
+#ifdef HOLEPUNCH
+	holepunchpacket = (holepunch_t *)(void *)&doomcom->data;
+#endif
+
+	for (;;)
+	{
+		LockNet();
+		if (__atomic_load_n(&netthread_quit, __ATOMIC_ACQUIRE) || I_thread_is_stopped())
+		{
+			UnlockNet();
+			break;
+		}
+		NetThreadReceive();
+		UnlockNet();
+
+		I_Sleep(1);
+	}
+
+	__atomic_store_n(&netthread_alive, false, __ATOMIC_RELEASE);
+}
+
+static void StopNetThread(void)
+{
+	if (!netthread_started || onnetthread)
+		return;
+
+	__atomic_store_n(&netthread_quit, true, __ATOMIC_RELEASE);
+
+	// Only an I_Error inside LockNet gets here still holding it
+	if (netlocks)
+	{
+		netlocks = 1;
+		UnlockNet();
+	}
+
+	while (__atomic_load_n(&netthread_alive, __ATOMIC_ACQUIRE))
+		I_Sleep(1);
+
+	// Anything left in netqueue still goes out through HGetPacket
+	netthread_started = false;
+}
+
+static void StartNetThread(void)
+{
+	static boolean exitfunc = false;
+
+	if (!exitfunc)
+	{
+		I_AddExitFunc(StopNetThread); // before I_stop_threads waits on it
+		exitfunc = true;
+	}
+
+	netthread_doomcom = *doomcom;
+	memset(nodeackdue, 0, sizeof (nodeackdue));
+	netqueue_handling = -1;
+	netthread_failed = false;
+	memset(nodequeuelatency, 0, sizeof (nodequeuelatency));
+	netthread_quit = false;
+	netthread_alive = true;
+	netthread_started = true;
+	I_spawn_thread("net-io", NetThread, NULL);
+}
+#endif
+
+//
+// Net_LockDriver
+// Keeps the network thread out of the driver, e.g. while the ban list
+// it checks new nodes against is being changed
+//
+void Net_LockDriver(void)
+{
+	LockNet();
+}
+
+void Net_UnlockDriver(void)
+{
+	UnlockNet();
+}
+
+//
+// Net_DriverError
+// I_Error for the network driver. On the network thread the message
+// waits for Net_UpdateIOThread to raise it on the main thread.
+//
+void Net_DriverError(const char *format, ...)
+{
+	va_list argptr;
+	char txt[256];
+
+	va_start(argptr, format);
+	vsnprintf(txt, sizeof txt, format, argptr);
+	va_end(argptr);
+
+#ifdef NETTHREAD
+	if (onnetthread)
+	{
+		// Only the first one, the rest are likely the same
+		if (!netthread_failed)
+		{
+			strcpy(netthread_error, txt);
+			netthread_failed = true;
+		}
+		return;
+	}
+#endif
+
+	I_Error("%s", txt);
+}
+
+//
+// Net_UpdateIOThread
+// Starts or stops the network thread to match cv_netthread
+//
+void Net_UpdateIOThread(void)
+{
+#ifdef NETTHREAD
+	boolean wanted = (cv_netthread.value && netgame);
+
+	LockNet();
+	if (netthread_failed)
+	{
+		char txt[sizeof netthread_error];
+		strcpy(txt, netthread_error);
+		UnlockNet();
+		StopNetThread();
+		I_Error("%s", txt);
+	}
+	UnlockNet();
+
+#ifdef DEBUGFILE
+	if (debugfile) // DEBFILE isn't thread safe
+		wanted = false;
+#endif
+
+	if (wanted && !netthread_started)
+		StartNetThread();
+	else if (!wanted && netthread_started)
+		StopNetThread();
+#endif
+}
+
+//
+// HGetPacket
+// Returns false if no packet is waiting
+// Check Datalength and checksum
+//
+boolean HGetPacket(void)
+{
+	// Get a packet from self
+	if (rebound_tail != rebound_head)
+	{
+		M_Memcpy(netbuffer, &reboundstore[rebound_tail], reboundsize[rebound_tail]);
+		doomcom->datalength = reboundsize[rebound_tail];
+		if (netbuffer->packettype == PT_NODETIMEOUT)
+			doomcom->remotenode = netbuffer->u.textcmd[0];
+		else
+			doomcom->remotenode = 0;
+
+		rebound_tail = (rebound_tail+1) % MAXREBOUND;
+#ifdef DEBUGFILE
+		if (debugfile)
+			DebugPrintpacket("GETLOCAL");
+#endif
+		return true;
+	}
+
+	if (!netgame)
+		return false;
+
+#ifndef NONET
+#ifdef NETTHREAD
+	// Whatever the network thread already took off the socket comes first
+	if (GetQueuedPacket())
+		return true;
+	if (netthread_started)
+	{
+		doomcom->remotenode = -1;
+		return false;
+	}
+#endif
+	return ReceivePacket();
 #endif // ifndef NONET
 
 	return true;
@@ -1254,7 +1675,9 @@ SINT8 I_NetMakeNode(const char *hostname)
 			t++;
 		*t = '\0';
 
+		LockNet();
 		newnode = I_NetMakeNodewPort(localhostname, port);
+		UnlockNet();
 		free(localhostname);
 	}
 	return newnode;
@@ -1284,6 +1707,8 @@ boolean D_CheckNetGame(void)
 	I_NetGet = Internal_Get;
 	I_NetSend = Internal_Send;
 	I_NetCanSend = NULL;
+	I_NetBeginBatch = NULL;
+	I_NetFlush = NULL;
 	I_NetCloseSocket = NULL;
 	I_NetFreeNodenum = Internal_FreeNodenum;
 	I_NetMakeNodewPort = NULL;
@@ -1294,11 +1719,12 @@ boolean D_CheckNetGame(void)
 	multiplayer = false;
 
 	// only dos version with external driver will return true
-	netgame = I_InitNetwork();
+	netgame = !demo.simulating && I_InitNetwork();
 	if (!netgame && !I_NetOpenSocket)
 	{
 		D_SetDoomcom();
-		netgame = I_InitTcpNetwork();
+		if (!demo.simulating) // replays simulated headless stay offline
+			netgame = I_InitTcpNetwork();
 	}
 
 	if (netgame)
@@ -1449,6 +1875,19 @@ void Command_Ping_f(void)
 
 	for (i = 0; i < pingc; ++i)
 	{
+#ifdef NETTHREAD
+		// How long the main thread left this player's packets waiting
+		if (netthread_started && server && playernode[pingv[i].num] < MAXNETNODES)
+		{
+			CONS_Printf("%02d : %-*s %*d frames (%*d ms, %.2f ms queued)\n",
+					pingv[i].num,
+					name_width, player_names[pingv[i].num],
+					f_width,    pingv[i].f,
+					ms_width,   pingv[i].ms,
+					nodequeuelatency[playernode[pingv[i].num]] / 1000.0);
+			continue;
+		}
+#endif
 		CONS_Printf("%02d : %-*s %*d frames (%*d ms)\n",
 				pingv[i].num,
 				name_width, player_names[pingv[i].num],
@@ -1459,6 +1898,10 @@ void Command_Ping_f(void)
 	if (!server && playeringame[consoleplayer])
 	{
 		CONS_Printf("\nYour ping is %d frames (%d ms)\n", playerpingtable[consoleplayer], (INT32)(playerpingtable[consoleplayer] * (1000.00f / TICRATE)));
+#ifdef NETTHREAD
+		if (netthread_started)
+			CONS_Printf("Server packets waited %.2f ms for the game loop\n", nodequeuelatency[servernode] / 1000.0);
+#endif
 	}
 }
 
@@ -1471,6 +1914,12 @@ void D_CloseConnection(void)
 		// wait the ackreturn with timout of 5 Sec
 		Net_WaitAllAckReceived(5);
 
+#ifdef NETTHREAD
+		StopNetThread();
+		netqueue_tail = netqueue_head;
+		netqueue_handling = -1;
+#endif
+
 		// close all connection
 		for (i = 0; i < MAXNETNODES; i++)
 			Net_CloseConnection(i|FORCECLOSE);
@@ -1483,6 +1932,8 @@ void D_CloseConnection(void)
 		I_NetGet = Internal_Get;
 		I_NetSend = Internal_Send;
 		I_NetCanSend = NULL;
+		I_NetBeginBatch = NULL;
+		I_NetFlush = NULL;
 		I_NetCloseSocket = NULL;
 		I_NetFreeNodenum = Internal_FreeNodenum;
 		I_NetMakeNodewPort = NULL;
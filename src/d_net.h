@@ -27,6 +27,10 @@
 
 #define STATLENGTH (TICRATE*2)
 
+#if defined (HAVE_THREADS) && defined (HAVE_ATTRTHREAD) && !defined (NONET)
+#define NETTHREAD // cv_netthread: receive and acknowledge packets off the main thread
+#endif
+
 // stat of net
 extern INT32 ticruned, ticmiss;
 extern INT32 getbps, sendbps;
@@ -52,6 +56,12 @@ void Net_AckTicker(void);
 boolean HSendPacket(INT32 node, boolean reliable, UINT8 acknum,
 	size_t packetlength);
 boolean HGetPacket(void);
+void Net_BeginSendBatch(void);
+void Net_FlushSendBatch(void);
+void Net_UpdateIOThread(void);
+void Net_LockDriver(void);
+void Net_UnlockDriver(void);
+void Net_DriverError(const char *format, ...) FUNCPRINTF;
 void D_SetDoomcom(void);
 #ifndef NONET
 void D_SaveBan(void);
@@ -138,6 +138,7 @@ static void Fishcake_OnChange(void);
 static void Command_Playdemo_f(void);
 static void Command_Timedemo_f(void);
 static void Command_Stopdemo_f(void);
+static void Command_Demoseek_f(void);
 static void Command_StartMovie_f(void);
 static void Command_StopMovie_f(void);
 static void Command_Map_f(void);
@@ -945,7 +946,7 @@ static CV_PossibleValue_t skinselectspin_cons_t[] = {
 consvar_t cv_skinselectspin = {"skinselectspin", "5", CV_SAVE, skinselectspin_cons_t, NULL, 0, NULL, NULL, 0, 0, NULL};
 
 static CV_PossibleValue_t perfstats_cons_t[] = {
-	{0, "Off"}, {1, "Rendering"}, {2, "Logic"}, {3, "ThinkFrame"}, {4, "PreThinkFrame"}, {5, "PostThinkFrame"}, {0, NULL}};
+	{0, "Off"}, {1, "Rendering"}, {2, "Logic"}, {3, "ThinkFrame"}, {4, "PreThinkFrame"}, {5, "PostThinkFrame"}, {6, "LuaMemory"}, {0, NULL}};
 consvar_t cv_perfstats = {"perfstats", "Off", CV_CALL, perfstats_cons_t, PS_PerfStats_OnChange, 0, NULL, NULL, 0, 0, NULL};
 
 consvar_t cv_ps_thinkframe_page = {"ps_thinkframe_page", "1", CV_CALL, CV_Natural, PS_ThinkFrame_Page_OnChange, 0, NULL, NULL, 0, 0, NULL};
@@ -1129,6 +1130,7 @@ void D_RegisterServerCommands(void)
 	// p_mobj.c
 	CV_RegisterVar(&cv_itemrespawntime);
 	CV_RegisterVar(&cv_itemrespawn);
+	CV_RegisterVar(&cv_buildreject);
 	CV_RegisterVar(&cv_flagtime);
 	CV_RegisterVar(&cv_suddendeath);
 
@@ -1186,9 +1188,12 @@ void D_RegisterServerCommands(void)
 	CV_RegisterVar(&cv_maxplayers);
 	CV_RegisterVar(&cv_gamestateattempts);
 	CV_RegisterVar(&cv_resynchcooldown);
+	CV_RegisterVar(&cv_gamestatedeltas);
+	CV_RegisterVar(&cv_savegamecompression);
 	CV_RegisterVar(&cv_maxsend);
 	CV_RegisterVar(&cv_noticedownload);
 	CV_RegisterVar(&cv_downloadspeed);
+	CV_RegisterVar(&cv_compressdownloads);
     CV_RegisterVar(&cv_connectawaittime);
 	CV_RegisterVar(&cv_httpsource);
 #ifndef NONET
@@ -1235,6 +1240,7 @@ void D_RegisterServerCommands(void)
 	CV_RegisterVar(&cv_recordmultiplayerdemos);
 	CV_RegisterVar(&cv_netdemosyncquality);
 	CV_RegisterVar(&cv_maxdemosize);
+	CV_RegisterVar(&cv_demokeyframes);
 	CV_RegisterVar(&cv_demochangemap);
 
 	CV_RegisterVar(&cv_keyboardlayout);
@@ -1275,6 +1281,7 @@ void D_RegisterClientCommands(void)
 	COM_AddCommand("playdemo", Command_Playdemo_f);
 	COM_AddCommand("timedemo", Command_Timedemo_f);
 	COM_AddCommand("stopdemo", Command_Stopdemo_f);
+	COM_AddCommand("demoseek", Command_Demoseek_f);
 	COM_AddCommand("playintro", Command_Playintro_f);
 
 	COM_AddCommand("resetcamera", Command_ResetCamera_f);
@@ -1309,6 +1316,8 @@ void D_RegisterClientCommands(void)
 	CV_RegisterVar(&cv_zlib_strategya);
 	CV_RegisterVar(&cv_zlib_window_bitsa);
 	CV_RegisterVar(&cv_apng_delay);
+	CV_RegisterVar(&cv_movie_queue);
+	CV_RegisterVar(&cv_movie_dropframes);
 	// GIF variables
 	CV_RegisterVar(&cv_gif_optimize);
 	CV_RegisterVar(&cv_gif_downscale);
@@ -1357,6 +1366,9 @@ void D_RegisterClientCommands(void)
 	CV_RegisterVar(&cv_rollingdemos);
 	CV_RegisterVar(&cv_netstat);
 	CV_RegisterVar(&cv_netticbuffer);
+#ifdef NETTHREAD
+	CV_RegisterVar(&cv_netthread);
+#endif
 
 #ifdef NETGAME_DEVMODE
 	CV_RegisterVar(&cv_fishcake);
@@ -1628,6 +1640,7 @@ void D_RegisterClientCommands(void)
 #if defined(LUA_ALLOW_BYTECODE)
 	COM_AddCommand("dumplua", Command_Dumplua_f);
 #endif
+	COM_AddCommand("benchlua", Command_Benchlua_f);
 
 #ifdef HAVE_DISCORDRPC
 	CV_RegisterVar(&cv_discordrp);
@@ -3079,6 +3092,46 @@ static void Command_Stopdemo_f(void)
 	CONS_Printf(M_GetText("Stopped demo.\n"));
 }
 
+// jump to a time in the demo being played back
+static void Command_Demoseek_f(void)
+{
+	const char *arg;
+	char *end;
+	long seconds, extra;
+
+	if (COM_Argc() != 2)
+	{
+		CONS_Printf(M_GetText("demoseek <seconds or m:ss>: jump to a time in the demo being played back\n"));
+		return;
+	}
+
+	if (!demo.playback || demo.title || gamestate != GS_LEVEL)
+	{
+		CONS_Printf(M_GetText("You must be watching a replay to use this.\n"));
+		return;
+	}
+
+	// No replay runs for a day, and it keeps the sums in range
+	arg = COM_Argv(1);
+	seconds = strtol(arg, &end, 10);
+	seconds = min(seconds, 24*60*60);
+	if (*end == ':')
+	{
+		extra = strtol(end+1, &end, 10);
+		seconds = (extra < 0) ? -1 : min(seconds, 24*60)*60 + min(extra, 60);
+	}
+
+	if (*end || seconds < 0)
+	{
+		CONS_Printf(M_GetText("Invalid time '%s'.\n"), arg);
+		return;
+	}
+
+	// Times count from when the race starts, like the timer.
+	// Past the end of the replay stops at the end.
+	G_ConfirmRewind(starttime + (tic_t)seconds*TICRATE);
+}
+
 static void Command_StartMovie_f(void)
 {
 	M_StartMovie();
@@ -6417,7 +6470,7 @@ static void Command_Archivetest_f(void)
 
 	// assign mobjnum
 	i = 1;
-	for (th = thinkercap.next; th != &thinkercap; th = th->next)
+	for (th = thlist[THINK_MOBJ].cnext; th != &thlist[THINK_MOBJ]; th = th->cnext)
 		if (th->function.acp1 == (actionf_p1)P_MobjThinker)
 			((mobj_t *)th)->mobjnum = i++;
 
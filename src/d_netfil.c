@@ -55,6 +55,7 @@
 #include "m_misc.h"
 #include "m_menu.h"
 #include "md5.h"
+#include "m_compress.h"
 #include "filesrch.h"
 
 #include <errno.h>
@@ -722,6 +723,55 @@ static boolean SV_SendFile(INT32 node, const char *filename, UINT8 fileid)
 	return true;
 }
 
+// Header in front of every SF_SHAREDRAM block
+typedef struct
+{
+	UINT32 refcount;
+	UINT32 pad; // keeps the data 8-byte aligned
+} sharedram_t;
+
+/** Allocates a memory block that can be sent to several nodes at once.
+  * The caller holds the first reference, and every SV_SendRam with
+  * SF_SHAREDRAM takes another one until that transfer ends.
+  *
+  * \param size The size of the block in bytes
+  * \return The memory block
+  * \sa SV_ReleaseSharedRam
+  *
+  */
+void *SV_NewSharedRam(size_t size)
+{
+	sharedram_t *block = Z_Malloc(sizeof (sharedram_t) + size, PU_STATIC, NULL);
+
+	block->refcount = 1;
+	return block + 1;
+}
+
+/** Takes another reference to a shared memory block
+  *
+  * \param data The memory block, as returned by SV_NewSharedRam
+  * \sa SV_ReleaseSharedRam
+  *
+  */
+void SV_HoldSharedRam(void *data)
+{
+	((sharedram_t *)data - 1)->refcount++;
+}
+
+/** Drops a reference to a shared memory block, freeing it if it was the last one
+  *
+  * \param data The memory block, as returned by SV_NewSharedRam
+  * \sa SV_NewSharedRam
+  *
+  */
+void SV_ReleaseSharedRam(void *data)
+{
+	sharedram_t *block = (sharedram_t *)data - 1;
+
+	if (--block->refcount == 0)
+		Z_Free(block);
+}
+
 /** Adds a memory block to the file list for a node
   *
   * \param node The node to send the memory block to
@@ -751,6 +801,8 @@ void SV_SendRam(INT32 node, void *data, size_t size, freemethod_t freemethod, UI
 	memset(p, 0, sizeof (filetx_t));
 
 	p->ram = freemethod; // Remember how to free the memory block for when we're done sending it
+	if (freemethod == SF_SHAREDRAM)
+		SV_HoldSharedRam(data);
 	p->id.ram = data;
 	p->size = (UINT32)size;
 	p->fileid = fileid;
@@ -799,6 +851,9 @@ static void SV_EndFileSend(INT32 node)
 			free(p->id.ram);
 		case SF_NOFREERAM: // Nothing to free
 			break;
+		case SF_SHAREDRAM: // It's shared with other transfers, drop our reference
+			SV_ReleaseSharedRam(p->id.ram);
+			break;
 	}
 
 	// Remove the file request from the list
@@ -821,8 +876,10 @@ static void SV_EndFileSend(INT32 node)
 void SV_FileSendTicker(void)
 {
 	static INT32 currentnode = 0;
+	static UINT8 chunkbuf[2 * MAXPACKETLENGTH];
 	filetx_pak *p;
-	size_t size;
+	size_t size, packetsize;
+	const UINT8 *chunk;
 	filetx_t *f;
 	INT32 packetsent, ram, i, j;
 
@@ -900,7 +957,11 @@ void SV_FileSendTicker(void)
 
 		// Build a packet containing a file fragment
 		p = &netbuffer->u.filetxpak;
-		size = software_MAXPACKETLENGTH - (FILETXHEADER + BASEPACKETSIZE);
+		packetsize = size = software_MAXPACKETLENGTH - (FILETXHEADER + BASEPACKETSIZE);
+
+		// Read ahead, in case it compresses enough to fit more in
+		if (cv_compressdownloads.value)
+			size *= 2;
 
 		if (f->size - transfer[i].position < size)
 		{
@@ -909,15 +970,29 @@ void SV_FileSendTicker(void)
 
 		if (ram)
 		{
-			M_Memcpy(p->data, &f->id.ram[transfer[i].position], size);
+			chunk = (const UINT8 *)&f->id.ram[transfer[i].position];
 		}
-		else if (fread(p->data, 1, size, transferFiles[f->fileid].file) != size)
+		else if (fread(chunkbuf, 1, size, transferFiles[f->fileid].file) != size)
 		{
 			I_Error("SV_FileSendTicker: can't read %s byte on %s at %d because %s",
 				sizeu1(size), f->id.filename, transfer[i].position, M_FileError(transferFiles[f->fileid].file));
 
 			transferFiles[f->fileid].position = (UINT32)(transferFiles[f->fileid].position + size);
 		}
+		else
+		{
+			chunk = chunkbuf;
+		}
+
+		p->compressor = COMP_NONE;
+		if (cv_compressdownloads.value && (packetsize = M_Compress(COMP_LZ4, chunk, size, p->data, packetsize - 1)))
+			p->compressor = COMP_LZ4;
+		else
+		{
+			// Doesn't compress, send what fits as is
+			size = packetsize = min(size, software_MAXPACKETLENGTH - (FILETXHEADER + BASEPACKETSIZE));
+			M_Memcpy(p->data, chunk, size);
+		}
 
 		p->position = LONG(transfer[i].position);
 		// Put flag so receiver knows the total size
@@ -927,7 +1002,7 @@ void SV_FileSendTicker(void)
 		p->size = SHORT((UINT16)size);
 
 		// Send the packet
-		if (HSendPacket(i, true, 0, FILETXHEADER + size)) // Reliable SEND
+		if (HSendPacket(i, true, 0, FILETXHEADER + packetsize)) // Reliable SEND
 		{
 			// Success
 			transfer[i].position = (UINT32)(transfer[i].position + size);
@@ -953,6 +1028,12 @@ void Got_Filetxpak(void)
 	char *filename = file->filename;
 	static INT32 filetime = 0;
 
+	if (doomcom->datalength < (INT16)(BASEPACKETSIZE + FILETXHEADER))
+	{
+		DEBFILE(va("filefragment too short (%d bytes)\n", doomcom->datalength));
+		return;
+	}
+
 	if (!(strcmp(filename, "srb2.srb")
 		&& strcmp(filename, "srb2.wad")
 		&& strcmp(filename, "patch.dta")
@@ -990,6 +1071,15 @@ void Got_Filetxpak(void)
 	{
 		UINT32 pos = LONG(netbuffer->u.filetxpak.position);
 		UINT16 size = SHORT(netbuffer->u.filetxpak.size);
+		UINT8 *data = netbuffer->u.filetxpak.data;
+		const size_t datasize = doomcom->datalength - BASEPACKETSIZE - FILETXHEADER;
+
+		// A fragment claiming more than it carries would write out whatever follows it
+		if (netbuffer->u.filetxpak.compressor == COMP_NONE && size > datasize)
+		{
+			DEBFILE(va("filefragment claims %d bytes but has %s\n", size, sizeu1(datasize)));
+			return;
+		}
 		// Use a special trick to know when the file is complete (not always used)
 		// WARNING: file fragments can arrive out of order so don't stop yet!
 		if (pos & 0x80000000)
@@ -997,9 +1087,35 @@ void Got_Filetxpak(void)
 			pos &= ~0x80000000;
 			file->totalsize = pos + size;
 		}
+
+		// Unpack it if it was packed
+		if (netbuffer->u.filetxpak.compressor != COMP_NONE)
+		{
+			static UINT8 chunkbuf[UINT16_MAX];
+			const size_t chunksize = min((size_t)size, sizeof chunkbuf);
+			if (M_Decompress(netbuffer->u.filetxpak.compressor, data, datasize, chunkbuf, chunksize) != chunksize)
+			{
+				// The fragment has been acked already, so the server won't
+				// send it again; give up on the download rather than the game.
+				// CL_Reset clears fileneeded, so format the message first
+				char msg[MAX_WADPATH + 64];
+				snprintf(msg, sizeof msg, M_GetText("Corrupt download from the server\n(%s)\n\nPress ESC\n"), filename);
+				CONS_Alert(CONS_WARNING, M_GetText("Got_Filetxpak: corrupt file fragment for %s\n"), filename);
+				fclose(file->file);
+				file->file = NULL;
+				remove(filename);
+				D_QuitNetGame();
+				CL_Reset();
+				D_StartTitle();
+				M_StartMessage(msg, NULL, MM_NOTHING);
+				return;
+			}
+			data = chunkbuf;
+		}
+
 		// We can receive packet in the wrong order, anyway all os support gaped file
 		fseek(file->file, pos, SEEK_SET);
-		if (fwrite(netbuffer->u.filetxpak.data,size,1,file->file) != 1)
+		if (fwrite(data,size,1,file->file) != 1)
 			I_Error("Can't write to %s: %s\n",filename, M_FileError(file->file));
 		file->currentsize += size;
 
@@ -20,7 +20,8 @@ typedef enum
 	SF_FILE,
 	SF_Z_RAM,
 	SF_RAM,
-	SF_NOFREERAM
+	SF_NOFREERAM,
+	SF_SHAREDRAM // allocated with SV_NewSharedRam, released once sent
 } freemethod_t;
 
 typedef enum
@@ -83,6 +84,9 @@ INT32 CL_CheckFiles(void);
 boolean CL_LoadServerFiles(void);
 void SV_SendRam(INT32 node, void *data, size_t size, freemethod_t freemethod,
 	UINT8 fileid);
+void *SV_NewSharedRam(size_t size);
+void SV_HoldSharedRam(void *data);
+void SV_ReleaseSharedRam(void *data);
 
 void SV_FileSendTicker(void);
 void Got_Filetxpak(void);
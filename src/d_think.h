@@ -39,16 +39,38 @@ typedef union
 // to handle an actor.
 typedef actionf_t think_t;
 
+// Thinker classes. Every thinker sits in the main list (thinkercap),
+// which decides the order they run in, and also in the list for its
+// class (thlist), so code that only wants one kind of thinker doesn't
+// have to walk all of them.
+typedef enum
+{
+	THINK_POLYOBJ,
+	THINK_MAIN,
+	THINK_MOBJ,
+	THINK_PRECIP, // never runs, and isn't in the main list
+	NUM_THINKERLISTS
+} thinklistnum_t;
+
 // Doubly linked list of actors.
 typedef struct thinker_s
 {
 	struct thinker_s *prev;
 	struct thinker_s *next;
+
+	// Links in the class list, same relative order as the main list.
+	struct thinker_s *cprev;
+	struct thinker_s *cnext;
+
 	think_t function;
 
 	// killough 11/98: count of how many other objects reference
 	// this one using pointers. Used for garbage collection.
 	INT32 references;
+
+	// Registry reference to this thinker's Lua userdata, 0 if Lua never saw it.
+	// Lets removing it skip Lua entirely when there's nothing to invalidate.
+	INT32 luaref;
 } thinker_t;
 
 #endif
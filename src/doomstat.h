@@ -115,7 +115,7 @@ extern boolean lastdraw;
 extern postimg_t postimgtype[MAXSPLITSCREENPLAYERS];
 extern INT32 postimgparam[MAXSPLITSCREENPLAYERS];
 
-extern INT32 viewwindowx, viewwindowy;
+extern ATTRTHREAD INT32 viewwindowx, viewwindowy;
 extern INT32 viewwidth, scaledviewwidth;
 
 extern boolean gamedataloaded;
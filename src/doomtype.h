@@ -268,6 +268,11 @@ size_t strlcpy(char *dst, const char *src, size_t siz);
 
 	#define ATTRUNUSED __attribute__((unused))
 
+	#if defined (HAVE_THREADS) && defined (__ELF__) // native TLS only, emulated TLS is too slow for the drawers
+		#define ATTRTHREAD __thread
+		#define HAVE_ATTRTHREAD
+	#endif
+
 #elif defined (_MSC_VER)
 	#define ATTRNORETURN __declspec(noreturn)
 	#define ATTRINLINE __forceinline
@@ -321,6 +326,9 @@ size_t strlcpy(char *dst, const char *src, size_t siz);
 #ifndef ATTRNOINLINE
 #define ATTRNOINLINE
 #endif
+#ifndef ATTRTHREAD
+#define ATTRTHREAD
+#endif
 #ifndef PUREFUNC
 #define PUREFUNC
 #endif
@@ -52,9 +52,12 @@
 #include "b_bot.h"
 #include "m_cond.h" // condition sets
 #include "md5.h" // demo checksums
+#include "m_compress.h" // demo keyframes
+#include "m_perfstats.h" // -simulate
 #include "k_director.h" // SRB2kart
 #include "k_kart.h" // SRB2kart
 #include "r_fps.h" // frame interpolation/uncapped
+#include "i_threads.h" // demo writer
 
 #ifdef HAVE_DISCORDRPC
 #include "discord.h"
@@ -3026,7 +3029,7 @@ void G_ChangePlayerReferences(mobj_t *oldmo, mobj_t *newmo)
 	I_Assert((oldmo != NULL) && (newmo != NULL));
 
 	// scan all thinkers
-	for (th = thinkercap.next; th != &thinkercap; th = th->next)
+	for (th = thlist[THINK_MOBJ].cnext; th != &thlist[THINK_MOBJ]; th = th->cnext)
 	{
 		if (th->function.acp1 != (actionf_p1)P_MobjThinker)
 			continue;
@@ -3658,6 +3661,12 @@ static void G_DoCompleted(void)
 	if (nextmap < NUMMAPS && !mapheaderinfo[nextmap])
 		P_AllocMapHeader(nextmap);
 
+	// Get a head start on loading it while the intermission plays,
+	// unless there's a vote afterwards to pick something else
+	if (nextmap < NUMMAPS && !skipstats
+		&& !((cv_advancemap.value == 3) && !modeattacking && (multiplayer || netgame)))
+		R_PrefetchLevel(nextmap);
+
 demointermission:
 
 	if (skipstats && !modeattacking) // Don't skip stats if we're in record attack
@@ -4822,6 +4831,7 @@ static ticcmd_t oldcmd[MAXPLAYERS];
 
 // Below consts are only used for demo extrainfo sections
 #define DW_STANDING 0x00
+#define DW_KEYFRAMES 0x01
 
 // For Metal Sonic and time attack ghosts
 #define GZT_XYZ    0x01
@@ -4847,6 +4857,830 @@ static ticcmd_t oldcmd[MAXPLAYERS];
 
 static mobj_t oldmetal, oldghost[MAXPLAYERS];
 
+//
+// Demo streaming
+//
+// Recordings are written into blocks of DEMOBLOCKSIZE. When one fills up
+// it's handed off to be appended to a spool file next to where the replay
+// will be saved, on a thread of its own where there are threads, and
+// recording carries on in a new block. The header stays in memory, since
+// parts of it and the checksum after it are only filled in when the
+// replay is saved. Recordings that never fill their first block are saved
+// in one go like before.
+//
+// Playback reads the replay through a window of the same size, topped up
+// before each tic, so only about a block of it is in memory at a time.
+//
+
+#define DEMOBLOCKSIZE (1<<20) // the header has to fit in one
+#define DEMOTICSPACE (16<<10) // more than one tic ever writes or reads
+#define DEMOMAXBLOCKS 4 // waiting to be written before recording waits too
+
+typedef struct
+{
+	UINT8 *data;
+	size_t len;
+} demoblock_t;
+
+static FILE *demofile; // the spool while recording, the replay while playing back
+static char demospoolname[256];
+static size_t demobase; // where in the file demobuf.buffer starts
+static size_t demofilelen;
+static UINT8 *demohead; // the header, once the block it was in is gone
+static size_t demoheadlen;
+static boolean demowriteerror, demospoolfailed;
+
+#ifdef HAVE_THREADS
+static I_mutex demo_mutex;
+static I_cond demo_cond;
+static demoblock_t demoblocks[DEMOMAXBLOCKS];
+static size_t demoblockhead, numdemoblocks;
+static boolean demowriter, demowriterstopping;
+#endif
+
+static void G_WriteDemoBlock(demoblock_t *block)
+{
+	if (fwrite(block->data, 1, block->len, demofile) != block->len)
+		demowriteerror = true;
+	free(block->data);
+}
+
+#ifdef HAVE_THREADS
+static void G_DemoWriter(void *userdata)
+{
+	demoblock_t block;
+	(void)userdata;
+
+	I_lock_mutex(&demo_mutex);
+	for (;;)
+	{
+		while (!numdemoblocks && !demowriterstopping)
+			I_hold_cond(&demo_cond, demo_mutex);
+
+		if (!numdemoblocks)
+			break;
+
+		block = demoblocks[demoblockhead];
+		I_unlock_mutex(demo_mutex);
+		G_WriteDemoBlock(&block);
+		I_lock_mutex(&demo_mutex);
+
+		demoblockhead = (demoblockhead + 1) % DEMOMAXBLOCKS;
+		numdemoblocks--;
+		I_wake_all_cond(&demo_cond);
+	}
+
+	demowriter = false;
+	I_wake_all_cond(&demo_cond);
+	I_unlock_mutex(demo_mutex);
+}
+#endif
+
+// Waits for everything handed off so far to be written
+static void G_StopDemoWriter(void)
+{
+#ifdef HAVE_THREADS
+	I_lock_mutex(&demo_mutex);
+	demowriterstopping = true;
+	I_wake_all_cond(&demo_cond);
+	while (demowriter)
+		I_hold_cond(&demo_cond, demo_mutex);
+	I_unlock_mutex(demo_mutex);
+#endif
+}
+
+//
+// G_FlushDemo
+//
+// Hands everything recorded since the last flush to the writer and
+// starts a new block. Returns false if it couldn't.
+//
+static boolean G_FlushDemo(void)
+{
+	demoblock_t block;
+	UINT8 *next = malloc(DEMOBLOCKSIZE);
+
+	if (!next)
+		return false;
+
+	if (!demofile)
+	{
+		// Keep the header, it isn't done yet
+		snprintf(demospoolname, sizeof demospoolname, "%s.part", va(pandf, srb2home, demoname));
+		demohead = malloc(demoheadlen);
+		if (!demohead || !(demofile = fopen(demospoolname, "w+b")))
+		{
+			free(demohead);
+			demohead = NULL;
+			free(next);
+			return false;
+		}
+
+		M_Memcpy(demohead, demobuf.buffer, demoheadlen);
+		if (demoinfo_p)
+			demoinfo_p = demohead + (demoinfo_p - demobuf.buffer);
+		if (demotime_p)
+			demotime_p = demohead + (demotime_p - demobuf.buffer);
+
+		demowriteerror = false;
+#ifdef HAVE_THREADS
+		demoblockhead = numdemoblocks = 0;
+		demowriter = true;
+		demowriterstopping = false;
+		I_spawn_thread("demo-write", G_DemoWriter, NULL);
+#endif
+	}
+
+	block.data = demobuf.buffer;
+	block.len = demobuf.p - demobuf.buffer;
+
+	demobase += block.len;
+	demobuf.buffer = demobuf.p = next;
+	demoend = next + DEMOBLOCKSIZE;
+
+#ifdef HAVE_THREADS
+	I_lock_mutex(&demo_mutex);
+	while (numdemoblocks == DEMOMAXBLOCKS)
+		I_hold_cond(&demo_cond, demo_mutex);
+	demoblocks[(demoblockhead + numdemoblocks) % DEMOMAXBLOCKS] = block;
+	numdemoblocks++;
+	I_wake_all_cond(&demo_cond);
+	I_unlock_mutex(demo_mutex);
+#else
+	G_WriteDemoBlock(&block);
+#endif
+	return true;
+}
+
+//
+// G_DemoReserve
+//
+// Makes sure there's room for size more bytes of recording.
+//
+static void G_DemoReserve(size_t size)
+{
+	size_t used, len;
+	UINT8 *grown;
+
+	if (!demo.recording || !demobuf.p || demobuf.p + size <= demoend)
+		return;
+
+	// The extra info after the end marker stays in memory, so the
+	// checksum in G_FinishDemoSpool can stop right where it starts.
+	// There's never much of it.
+	if (!(demoinfo_p && *(UINT32 *)demoinfo_p) && !demospoolfailed)
+	{
+		if (G_FlushDemo())
+			return;
+
+		CONS_Alert(CONS_WARNING, M_GetText("Couldn't write %s, keeping the rest of the replay in memory\n"), demospoolname);
+		demospoolfailed = true;
+	}
+
+	used = demobuf.p - demobuf.buffer;
+	len = (demoend - demobuf.buffer) + max(size, DEMOBLOCKSIZE);
+	grown = realloc(demobuf.buffer, len);
+
+	if (!grown)
+		return; // the checks after each write will stop it
+
+	if (!demohead)
+	{
+		if (demoinfo_p)
+			demoinfo_p = grown + (demoinfo_p - demobuf.buffer);
+		if (demotime_p)
+			demotime_p = grown + (demotime_p - demobuf.buffer);
+	}
+	demobuf.buffer = grown;
+	demobuf.p = grown + used;
+	demoend = grown + len;
+}
+
+// Where in the replay demobuf.p is
+static size_t G_DemoTell(void)
+{
+	return demobase + (demobuf.p - demobuf.buffer);
+}
+
+// Drops an unsaved recording's spool
+static void G_DiscardDemoSpool(void)
+{
+	if (demofile)
+	{
+		G_StopDemoWriter();
+		fclose(demofile);
+		demofile = NULL;
+		remove(demospoolname);
+	}
+	free(demohead);
+	demohead = NULL;
+	demobase = 0;
+}
+
+//
+// G_FinishDemoSpool
+//
+// Writes the last of a spooled recording and its header, checksums it,
+// and moves it to where the replay goes.
+//
+static boolean G_FinishDemoSpool(UINT32 length)
+{
+	UINT8 *checksum = demohead + 16 + 64;
+	size_t used = demobuf.p - demobuf.buffer;
+	size_t split = length - demobase; // everything before the extra info
+	boolean ok;
+#ifdef NOMD5
+	UINT8 i;
+#endif
+
+	G_StopDemoWriter();
+	ok = !demowriteerror;
+
+	// The spool now ends right before the extra info, which is what gets checksummed
+	ok = ok && !fseek(demofile, 0, SEEK_SET) && fwrite(demohead, 1, demoheadlen, demofile) == demoheadlen;
+	ok = ok && !fseek(demofile, demobase, SEEK_SET) && fwrite(demobuf.buffer, 1, split, demofile) == split;
+#ifdef NOMD5
+	for (i = 0; i < 16; i++)
+		checksum[i] = M_RandomByte(); // This MD5 was chosen by fair dice roll and most likely < 50% correct.
+#else
+	ok = ok && !fflush(demofile) && !fseek(demofile, 16 + 64 + 16, SEEK_SET) && !md5_stream(demofile, checksum);
+#endif
+	ok = ok && !fseek(demofile, 16 + 64, SEEK_SET) && fwrite(checksum, 1, 16, demofile) == 16;
+	ok = ok && !fseek(demofile, length, SEEK_SET) && fwrite(demobuf.buffer + split, 1, used - split, demofile) == used - split;
+
+	if (fclose(demofile))
+		ok = false;
+	demofile = NULL;
+
+	if (ok)
+	{
+		const char *path = va(pandf, srb2home, demoname);
+		remove(path); // rename won't replace it everywhere
+		ok = !rename(demospoolname, path);
+	}
+
+	if (!ok)
+		remove(demospoolname);
+
+	free(demohead);
+	demohead = NULL;
+	demobase = 0;
+	return ok;
+}
+
+// Reads the window of a replay that starts at pos
+static void G_ReadDemoWindow(size_t pos)
+{
+	size_t n = 0;
+
+	if (!fseek(demofile, pos, SEEK_SET))
+		n = fread(demobuf.buffer, 1, DEMOBLOCKSIZE, demofile);
+
+	demobase = pos;
+	demobuf.p = demobuf.buffer;
+	demoend = demobuf.buffer + n;
+}
+
+//
+// G_OpenDemoFile
+//
+// Opens a replay to be played back a window at a time.
+//
+static boolean G_OpenDemoFile(const char *name)
+{
+	long len;
+
+	if (demofile) // never stopped?
+		fclose(demofile);
+
+	if (!(demofile = fopen(name, "rb")))
+		return false;
+
+	if (fseek(demofile, 0, SEEK_END) || (len = ftell(demofile)) <= 0)
+	{
+		fclose(demofile);
+		demofile = NULL;
+		return false;
+	}
+	demofilelen = (size_t)len;
+
+	demobuf.buffer = Z_Malloc(DEMOBLOCKSIZE, PU_STATIC, NULL);
+	G_ReadDemoWindow(0);
+	return true;
+}
+
+// Frees the replay being played back
+static void G_CloseDemoFile(void)
+{
+	if (demofile)
+		fclose(demofile);
+	demofile = NULL;
+	Z_Free(demobuf.buffer);
+	demobuf.buffer = NULL;
+}
+
+//
+// G_DemoFill
+//
+// Tops up the playback window so there's at least a tic's worth of
+// the replay in front of demobuf.p.
+//
+static void G_DemoFill(void)
+{
+	size_t keep;
+
+	if (!demofile || !demobuf.p || demobuf.p + DEMOTICSPACE <= demoend)
+		return;
+
+	if (demobase + (demoend - demobuf.buffer) >= demofilelen)
+		return; // the rest of it is already here
+
+	keep = demoend - demobuf.p;
+	memmove(demobuf.buffer, demobuf.p, keep);
+	demobase += demobuf.p - demobuf.buffer;
+	demobuf.p = demobuf.buffer;
+	demoend = demobuf.buffer + keep + fread(demobuf.buffer + keep, 1, DEMOBLOCKSIZE - keep, demofile);
+}
+
+// Moves playback to pos in the replay
+static void G_DemoSeek(size_t pos)
+{
+	if (!demofile || (pos >= demobase && pos < demobase + (demoend - demobuf.buffer)))
+		demobuf.p = demobuf.buffer + (pos - demobase);
+	else
+		G_ReadDemoWindow(pos);
+}
+
+//
+// Demo keyframes
+//
+// With demo_keyframes on, recordings take a P_SaveNetGame snapshot of the
+// game every so many seconds, along with the ticcmd and ghost deltas the
+// tics after it are read against. They're kept aside until the tics end,
+// then written straight after the end marker, with how long the replay is
+// and an index of when each was taken and where its tic starts. That's
+// still in the part the checksum covers and the spool streams out, but
+// older versions stop at the marker and jump to the extra info, which
+// only says where the keyframes are.
+//
+// Only so much is kept while recording. Past that, every other keyframe
+// is dropped and they're taken half as often from then on.
+//
+// Playback only trusts them if the replay's checksum matches. Seeking
+// loads the newest keyframe before the time it's going to when that's
+// closer than any rewind point, or than where playback already is.
+//
+
+#define KEYFRAMESAVESIZE (768*1024) // same as rewind points
+#define KEYFRAMEINFOSIZE (MAXPLAYERS*(11 + 6*4) + 1 + 4)
+#define KEYFRAMEMAXBYTES (16<<20) // kept while recording
+
+typedef struct
+{
+	tic_t leveltime;
+	UINT32 demopos; // where the tic it was taken on starts
+	UINT32 blobpos; // where it is in the file, when played back
+	UINT32 bloblen;
+	UINT8 *blob; // when recording
+} demokeyframe_t;
+
+static CV_PossibleValue_t demokeyframes_cons_t[] = {{0, "MIN"}, {60, "MAX"}, {0, NULL}};
+consvar_t cv_demokeyframes = {"demo_keyframes", "0", CV_SAVE, demokeyframes_cons_t, NULL, 0, NULL, NULL, 0, 0, NULL};
+
+static demokeyframe_t *demokeyframes;
+static size_t numdemokeyframes, maxdemokeyframes;
+static UINT8 *keyframesave, *keyframepack;
+
+static size_t demokeyframebytes; // blobs kept while recording
+static UINT8 demokeyframethin; // how many times they've been halved
+static UINT32 demokeyframepos; // where they went, once written
+static tic_t demoendtime; // how long the replay being played back is, if it says
+static boolean demokeyframesloaded;
+
+static void G_ClearDemoKeyframes(void)
+{
+	size_t i;
+
+	for (i = 0; i < numdemokeyframes; i++)
+		Z_Free(demokeyframes[i].blob);
+	Z_Free(demokeyframes);
+	demokeyframes = NULL;
+	numdemokeyframes = maxdemokeyframes = 0;
+
+	demokeyframebytes = 0;
+	demokeyframethin = 0;
+	demokeyframepos = 0;
+	demoendtime = 0;
+	demokeyframesloaded = false;
+
+	free(keyframesave);
+	free(keyframepack);
+	keyframesave = keyframepack = NULL;
+}
+
+static demokeyframe_t *G_AddDemoKeyframe(void)
+{
+	if (numdemokeyframes == maxdemokeyframes)
+	{
+		maxdemokeyframes = maxdemokeyframes ? maxdemokeyframes*2 : 64;
+		demokeyframes = Z_Realloc(demokeyframes, maxdemokeyframes * sizeof (*demokeyframes), PU_STATIC, NULL);
+	}
+	memset(&demokeyframes[numdemokeyframes], 0, sizeof (*demokeyframes));
+	return &demokeyframes[numdemokeyframes++];
+}
+
+// Drops every other keyframe taken so far, keeping the first
+static void G_ThinDemoKeyframes(void)
+{
+	size_t i, n = 0;
+
+	for (i = 0; i < numdemokeyframes; i++)
+	{
+		if (i & 1)
+		{
+			demokeyframebytes -= demokeyframes[i].bloblen;
+			Z_Free(demokeyframes[i].blob);
+		}
+		else
+			demokeyframes[n++] = demokeyframes[i];
+	}
+
+	numdemokeyframes = n;
+	demokeyframethin++;
+}
+
+//
+// G_TakeDemoKeyframe
+//
+// Snapshots the game for the tic about to be written, if it's time to.
+//
+static void G_TakeDemoKeyframe(void)
+{
+	savebuffer_t save;
+	demokeyframe_t *key;
+	size_t rawlen, packlen;
+	compressor_t method = COMP_LZ4;
+	UINT8 *p;
+	INT32 i;
+
+	if (!cv_demokeyframes.value || leveltime <= starttime || demoinfo_p == NULL || *(UINT32 *)demoinfo_p != 0)
+		return;
+
+	if (leveltime < (numdemokeyframes ? demokeyframes[numdemokeyframes-1].leveltime : starttime) + ((tic_t)cv_demokeyframes.value*TICRATE << demokeyframethin))
+		return;
+
+	if (!keyframesave)
+	{
+		keyframesave = malloc(KEYFRAMESAVESIZE);
+		keyframepack = malloc(KEYFRAMESAVESIZE);
+		if (!keyframesave || !keyframepack)
+		{
+			G_ClearDemoKeyframes();
+			return;
+		}
+	}
+
+	save.buffer = save.p = keyframesave;
+	P_SaveNetGame(&save, false);
+	rawlen = save.p - save.buffer;
+
+	packlen = M_Compress(method, keyframesave, rawlen, keyframepack, rawlen);
+	if (!packlen)
+	{
+		method = COMP_NONE;
+		packlen = rawlen;
+	}
+
+	key = G_AddDemoKeyframe();
+	key->leveltime = leveltime;
+	key->demopos = (UINT32)G_DemoTell();
+	key->bloblen = (UINT32)(KEYFRAMEINFOSIZE + packlen);
+	key->blob = p = Z_Malloc(key->bloblen, PU_STATIC, NULL);
+
+	for (i = 0; i < MAXPLAYERS; i++)
+	{
+		WRITESINT8(p, oldcmd[i].forwardmove);
+		WRITESINT8(p, oldcmd[i].sidemove);
+		WRITEINT16(p, oldcmd[i].angleturn);
+		WRITEINT16(p, oldcmd[i].aiming);
+		WRITEUINT16(p, oldcmd[i].buttons);
+		WRITEINT16(p, oldcmd[i].driftturn);
+		WRITEUINT8(p, oldcmd[i].latency);
+
+		// Recording keeps the ghost momentum >>8 from how playback does
+		WRITEFIXED(p, oldghost[i].x);
+		WRITEFIXED(p, oldghost[i].y);
+		WRITEFIXED(p, oldghost[i].z);
+		WRITEFIXED(p, oldghost[i].momx<<8);
+		WRITEFIXED(p, oldghost[i].momy<<8);
+		WRITEFIXED(p, oldghost[i].momz<<8);
+	}
+
+	WRITEUINT8(p, method);
+	WRITEUINT32(p, rawlen);
+	M_Memcpy(p, method == COMP_NONE ? keyframesave : keyframepack, packlen);
+
+	demokeyframebytes += key->bloblen;
+	while (demokeyframebytes > KEYFRAMEMAXBYTES && numdemokeyframes > 1 && demokeyframethin < 16)
+		G_ThinDemoKeyframes();
+}
+
+//
+// G_EndDemoTics
+//
+// Writes the end marker of a recording, then the keyframes, and starts
+// the extra info after them.
+//
+static void G_EndDemoTics(void)
+{
+	size_t i, len;
+	UINT32 blobpos;
+	const UINT8 *blob;
+
+	G_DemoReserve(1 + 4 + 4);
+	WRITEUINT8(demobuf.p, DEMOMARKER); // add the demo end marker
+
+	demokeyframepos = (UINT32)G_DemoTell();
+	WRITEUINT32(demobuf.p, leveltime);
+	WRITEUINT32(demobuf.p, numdemokeyframes);
+
+	blobpos = demokeyframepos + 4 + 4 + 16*numdemokeyframes;
+	for (i = 0; i < numdemokeyframes; i++)
+	{
+		G_DemoReserve(16);
+		WRITEUINT32(demobuf.p, demokeyframes[i].leveltime);
+		WRITEUINT32(demobuf.p, demokeyframes[i].demopos);
+		WRITEUINT32(demobuf.p, blobpos);
+		WRITEUINT32(demobuf.p, demokeyframes[i].bloblen);
+		blobpos += demokeyframes[i].bloblen;
+	}
+
+	// A bit at a time, so the spool can take it as it goes
+	for (i = 0; i < numdemokeyframes; i++)
+	{
+		blob = demokeyframes[i].blob;
+		for (len = demokeyframes[i].bloblen; len; )
+		{
+			size_t chunk = min(len, DEMOTICSPACE);
+			G_DemoReserve(chunk);
+			M_Memcpy(demobuf.p, blob, chunk);
+			demobuf.p += chunk;
+			blob += chunk;
+			len -= chunk;
+		}
+
+		Z_Free(demokeyframes[i].blob);
+		demokeyframes[i].blob = NULL;
+	}
+
+	*(UINT32 *)demoinfo_p = G_DemoTell();
+}
+
+// Reads len bytes from pos in the replay being played back, wherever the window is
+static boolean G_ReadDemoAt(size_t pos, void *dest, size_t len)
+{
+	boolean ok;
+
+	if (!demofile)
+	{
+		if (pos + len > (size_t)(demoend - demobuf.buffer))
+			return false;
+		M_Memcpy(dest, demobuf.buffer + pos, len);
+		return true;
+	}
+
+	ok = !fseek(demofile, pos, SEEK_SET) && fread(dest, 1, len, demofile) == len;
+	fseek(demofile, demobase + (demoend - demobuf.buffer), SEEK_SET); // where G_DemoFill carries on from
+	return ok;
+}
+
+// Whether the checksum in the header of the replay being played back matches
+static boolean G_DemoChecksumMatches(UINT32 length)
+{
+#ifdef NOMD5
+	(void)length;
+	return true; // nothing to check against
+#else
+	UINT8 want[16], got[16], *buf;
+	const size_t len = length - (16 + 64 + 16);
+	boolean ok;
+
+	if (length < 16 + 64 + 16 || !G_ReadDemoAt(16 + 64, want, 16))
+		return false;
+
+	if (!demofile)
+	{
+		if (length > (size_t)(demoend - demobuf.buffer))
+			return false;
+		md5_buffer((char *)demobuf.buffer + 16 + 64 + 16, len, got);
+		return !memcmp(want, got, 16);
+	}
+
+	// Only done once per replay, so reading it all back in is fine
+	if (length > demofilelen)
+		return false;
+	buf = malloc(len);
+	if (!buf)
+		return false;
+
+	ok = G_ReadDemoAt(16 + 64 + 16, buf, len);
+	if (ok)
+		md5_buffer((char *)buf, len, got);
+	free(buf);
+
+	return ok && !memcmp(want, got, 16);
+#endif
+}
+
+//
+// G_LoadDemoKeyframes
+//
+// Finds the keyframe index of the replay being played back, if it has
+// one, and checks it. The keyframes themselves are read when they're used.
+// Restarting the same replay keeps what was already found.
+//
+static void G_LoadDemoKeyframes(UINT32 extrainfo, boolean restarting)
+{
+	const UINT32 infostart = extrainfo;
+	UINT8 entry[16], *p;
+	UINT32 count, i, pos, indexend;
+	tic_t endtime;
+
+	if (restarting && demokeyframesloaded)
+		return;
+
+	G_ClearDemoKeyframes();
+	demokeyframesloaded = true;
+
+	if (!extrainfo)
+		return;
+
+	for (i = 0; i <= MAXPLAYERS; i++) // step over the standings
+	{
+		if (!G_ReadDemoAt(extrainfo, entry, 1))
+			return;
+		if (entry[0] != DW_STANDING)
+			break;
+		extrainfo += 1 + 1 + 3*16 + 4;
+	}
+
+	if (entry[0] != DW_KEYFRAMES || !G_ReadDemoAt(extrainfo + 1, entry, 4))
+		return;
+
+	p = entry;
+	pos = READUINT32(p);
+
+	// They sit between the end marker and the extra info
+	if (pos < 16 + 64 + 16 || pos > infostart || infostart - pos < 8 || !G_ReadDemoAt(pos, entry, 8))
+		return;
+
+	p = entry;
+	endtime = READUINT32(p);
+	count = READUINT32(p);
+	if (count > (infostart - pos - 8) / 16)
+		return;
+	indexend = pos + 8 + 16*count;
+
+	// P_LoadNetGame is only as careful as it has to be with our own saves
+	if (!G_DemoChecksumMatches(infostart))
+	{
+		CONS_Alert(CONS_WARNING, M_GetText("Replay checksum doesn't match, ignoring its keyframes\n"));
+		return;
+	}
+
+	for (i = 0; i < count; i++)
+	{
+		demokeyframe_t *key;
+
+		if (!G_ReadDemoAt(pos + 8 + 16*i, entry, 16))
+			break;
+
+		key = G_AddDemoKeyframe();
+		p = entry;
+		key->leveltime = READUINT32(p);
+		key->demopos = READUINT32(p);
+		key->blobpos = READUINT32(p);
+		key->bloblen = READUINT32(p);
+
+		if ((i && key->leveltime <= key[-1].leveltime) || key->leveltime > endtime
+		|| key->demopos < 16 + 64 + 16 || key->demopos >= pos
+		|| key->blobpos < indexend || key->blobpos > infostart || key->bloblen > infostart - key->blobpos)
+			break;
+	}
+
+	if (i < count)
+	{
+		CONS_Alert(CONS_WARNING, M_GetText("Replay keyframe index is broken, ignoring it\n"));
+		G_ClearDemoKeyframes();
+		demokeyframesloaded = true;
+		return;
+	}
+
+	demoendtime = endtime;
+	CONS_Debug(DBG_SETUP, "Replay has %s keyframes\n", sizeu1(numdemokeyframes));
+}
+
+// The newest keyframe at or before time
+static demokeyframe_t *G_FindDemoKeyframe(tic_t time)
+{
+	size_t lo = 0, hi = numdemokeyframes;
+
+	while (lo < hi)
+	{
+		size_t mid = (lo + hi) / 2;
+		if (demokeyframes[mid].leveltime <= time)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo ? &demokeyframes[lo-1] : NULL;
+}
+
+//
+// G_LoadDemoKeyframe
+//
+// Puts the game and playback back how they were when key was taken.
+// Returns false if it couldn't be read back.
+//
+static boolean G_LoadDemoKeyframe(demokeyframe_t *key)
+{
+	savebuffer_t save;
+	UINT8 *blob, *p, *raw;
+	UINT8 method;
+	UINT32 rawlen;
+	size_t packlen;
+	boolean ok = false;
+	INT32 i;
+
+	if (key->bloblen < KEYFRAMEINFOSIZE || key->bloblen > KEYFRAMESAVESIZE + KEYFRAMEINFOSIZE)
+		return false;
+
+	blob = Z_Malloc(key->bloblen, PU_STATIC, NULL);
+	if (!G_ReadDemoAt(key->blobpos, blob, key->bloblen))
+	{
+		Z_Free(blob);
+		return false;
+	}
+
+	p = blob + KEYFRAMEINFOSIZE - 1 - 4;
+	method = READUINT8(p);
+	rawlen = READUINT32(p);
+	packlen = key->bloblen - KEYFRAMEINFOSIZE;
+
+	if (method == COMP_NONE)
+	{
+		raw = p;
+		ok = (rawlen == packlen);
+	}
+	else if (method < NUMCOMPRESSORS && rawlen <= KEYFRAMESAVESIZE)
+	{
+		raw = Z_Malloc(rawlen, PU_STATIC, NULL);
+		ok = (M_Decompress(method, p, packlen, raw, rawlen) == rawlen);
+	}
+	else
+		raw = NULL;
+
+	if (ok)
+	{
+		save.buffer = save.p = raw;
+		ok = P_LoadNetGame(&save, false);
+	}
+
+	if (raw != p)
+		Z_Free(raw);
+
+	if (ok)
+	{
+		wipegamestate = gamestate; // No fading back in!
+		timeinmap = leveltime;
+
+		p = blob;
+		for (i = 0; i < MAXPLAYERS; i++)
+		{
+			oldcmd[i].forwardmove = READSINT8(p);
+			oldcmd[i].sidemove = READSINT8(p);
+			oldcmd[i].angleturn = READINT16(p);
+			oldcmd[i].aiming = READINT16(p);
+			oldcmd[i].buttons = READUINT16(p);
+			oldcmd[i].driftturn = READINT16(p);
+			oldcmd[i].latency = READUINT8(p);
+
+			oldghost[i].x = READFIXED(p);
+			oldghost[i].y = READFIXED(p);
+			oldghost[i].z = READFIXED(p);
+			oldghost[i].momx = READFIXED(p);
+			oldghost[i].momy = READFIXED(p);
+			oldghost[i].momz = READFIXED(p);
+		}
+
+		G_DemoSeek(key->demopos);
+	}
+
+	Z_Free(blob);
+	return ok;
+}
+
 void G_SaveMetal(UINT8 **buffer)
 {
 	I_Assert(buffer != NULL && *buffer != NULL);
@@ -4915,9 +5749,11 @@ void G_ReadDemoExtraData(void)
 	INT32 p, extradata, i;
 	char name[17];
 
-	if (leveltime > starttime)
+	G_DemoFill();
+
+	if (leveltime > starttime && !demo.simulating) // nothing to rewind headless
 	{
-		rewind_t *rewind = CL_SaveRewindPoint(demobuf.p - demobuf.buffer);
+		rewind_t *rewind = CL_SaveRewindPoint(G_DemoTell());
 		if (rewind)
 		{
 			memcpy(rewind->oldcmd, oldcmd, sizeof (oldcmd));
@@ -5077,6 +5913,10 @@ void G_WriteDemoExtraData(void)
 	INT32 i,j;
 	char name[17];
 
+	// This is the first thing written each tic
+	G_DemoReserve(DEMOTICSPACE);
+	G_TakeDemoKeyframe();
+
 	for (i = 0; i < MAXPLAYERS; i++)
 	{
 		if (demo_extradata[i])
@@ -5180,6 +6020,7 @@ void G_ReadDemoTiccmd(ticcmd_t *cmd, INT32 playernum)
 
 	if (!demobuf.p || !demo.deferstart)
 		return;
+	G_DemoFill();
 	ziptic = READUINT8(demobuf.p);
 
 	if (ziptic & ZT_FWD)
@@ -5350,10 +6191,13 @@ void G_GhostAddHit(INT32 playernum, mobj_t *victim)
 
 void G_WriteAllGhostTics(void)
 {
-	UINT8 *save_demo_p = demobuf.p;
+	UINT8 *save_demo_p;
 #define CHECKSPACE(num) if (demobuf.p+(num) > demoend) { demobuf.p = save_demo_p; G_CheckDemoStatus(); return; }
 
 	INT32 i, counter = leveltime;
+
+	G_DemoReserve(DEMOTICSPACE);
+	save_demo_p = demobuf.p;
 	for (i = 0; i < MAXPLAYERS; i++)
 	{
 		if (!playeringame[i] || players[i].spectator)
@@ -5681,7 +6525,7 @@ void G_ConsGhostTic(INT32 playernum)
 				demobuf.p += sizeof(angle_t); // angle, unnecessary for cons.
 
 				mobj = NULL;
-				for (th = thinkercap.next; th != &thinkercap; th = th->next)
+				for (th = thlist[THINK_MOBJ].cnext; th != &thlist[THINK_MOBJ]; th = th->cnext)
 				{
 					if (th->function.acp1 != (actionf_p1)P_MobjThinker)
 						continue;
@@ -6165,6 +7009,9 @@ void G_ConfirmRewind(tic_t rewindtime)
 
 	CV_StealthSetValue(&cv_renderview, 0);
 
+	if (demoendtime && rewindtime > demoendtime)
+		rewindtime = demoendtime;
+
 	if (rewindtime <= starttime)
 	{
 		demo.rewinding = false;
@@ -6173,14 +7020,20 @@ void G_ConfirmRewind(tic_t rewindtime)
 	else
 	{
 		rewind_t *rewind;
+		demokeyframe_t *key = G_FindDemoKeyframe(rewindtime);
+		boolean forward = (rewindtime >= leveltime);
 		sound_disabled = true; // Prevent sound spam
 		demo.rewinding = true;
 
-		rewind = CL_RewindToTime(rewindtime);
-
-		if (rewind)
+		// A keyframe past the closest rewind point, or past here when going
+		// forward, saves simulating up to it
+		if (key && key->leveltime > (forward ? leveltime : CL_RewindTimeBefore(rewindtime)) && G_LoadDemoKeyframe(key))
+			paused = false;
+		else if (forward)
+			paused = false; // just carry on from here
+		else if ((rewind = CL_RewindToTime(rewindtime)))
 		{
-			demobuf.p = demobuf.buffer + rewind->demopos;
+			G_DemoSeek(rewind->demopos);
 			memcpy(oldcmd, rewind->oldcmd, sizeof (oldcmd));
 			memcpy(oldghost, rewind->oldghost, sizeof (oldghost));
 			paused = false;
@@ -6194,6 +7047,9 @@ void G_ConfirmRewind(tic_t rewindtime)
 
 	for (j = 0; j < rewindtime && leveltime < rewindtime; j++)
 	{
+		// The replay can end before the time asked for
+		if (!demo.playback || gamestate != GS_LEVEL)
+			break;
 		G_Ticker((j % NEWTICRATERATIO) == 0);
 	}
 
@@ -6435,10 +7291,10 @@ void G_WriteMetalTic(mobj_t *metal)
 //
 void G_RecordDemo(const char *name)
 {
-	INT32 maxsize;
-
 	demobuf.p = NULL;
 	demo.recording = false;
+	G_DiscardDemoSpool();
+	G_ClearDemoKeyframes();
 	if (demobuf.buffer)
 		free(demobuf.buffer);
 	demobuf.buffer = NULL;
@@ -6451,10 +7307,9 @@ void G_RecordDemo(const char *name)
 		strcpy(demoname, name);
 		strcat(demoname, ".lmp");
 
-		maxsize = cv_maxdemosize.value*1024*1024;
-
-		demobuf.buffer = malloc(maxsize);
-		demoend = demobuf.buffer + maxsize;
+		// Only the first block, the rest are added as it fills up
+		demobuf.buffer = malloc(DEMOBLOCKSIZE);
+		demoend = demobuf.buffer + DEMOBLOCKSIZE;
 
 		if (demobuf.buffer)
 			demo.recording = true;
@@ -6495,6 +7350,8 @@ void G_BeginRecording(void)
 	memset(name,0,sizeof(name));
 
 	demobuf.p = demobuf.buffer;
+	demobase = 0;
+	demospoolfailed = false;
 	demoflags = DF_GHOST|(multiplayer ? DF_MULTIPLAYER : (modeattacking<<DF_ATTACKSHIFT));
 
 	if (encoremode)
@@ -6643,6 +7500,9 @@ void G_BeginRecording(void)
 	if (demoflags & DF_LUAVARS)
 		LUA_Archive(&demobuf, false);
 
+	// Everything up to here is kept until the replay is saved
+	demoheadlen = demobuf.p - demobuf.buffer;
+
 	memset(&oldcmd,0,sizeof(oldcmd));
 	memset(&oldghost,0,sizeof(oldghost));
 	memset(&ghostext,0,sizeof(ghostext));
@@ -6699,10 +7559,9 @@ void G_WriteStanding(UINT8 ranking, char *name, INT32 skinnum, UINT8 color, UINT
 	char temp[17];
 
 	if (demoinfo_p && *(UINT32 *)demoinfo_p == 0)
-	{
-		WRITEUINT8(demobuf.p, DEMOMARKER); // add the demo end marker
-		*(UINT32 *)demoinfo_p = demobuf.p - demobuf.buffer;
-	}
+		G_EndDemoTics();
+
+	G_DemoReserve(1 + 1 + 3*16 + 4);
 
 	WRITEUINT8(demobuf.p, DW_STANDING);
 	WRITEUINT8(demobuf.p, ranking);
@@ -7293,7 +8152,7 @@ void G_DoPlayDemo(char *defdemoname)
 	// No demo name means we're restarting the current demo
 	if (defdemoname == NULL)
 	{
-		demobuf.p = demobuf.buffer;
+		G_DemoSeek(0);
 		pdemoname = ZZ_Alloc(1); // Easier than adding checks for this everywhere it's freed
 	}
 	else
@@ -7312,7 +8171,7 @@ void G_DoPlayDemo(char *defdemoname)
 		if (FIL_CheckExtension(defdemoname))
 		{
 			//FIL_DefaultExtension(defdemoname, ".lmp");
-			if (!FIL_ReadFile(defdemoname, &demobuf.buffer))
+			if (!G_OpenDemoFile(defdemoname))
 			{
 				snprintf(msg, 1024, M_GetText("Failed to read file '%s'.\n"), defdemoname);
 				CONS_Alert(CONS_ERROR, "%s", msg);
@@ -7320,7 +8179,6 @@ void G_DoPlayDemo(char *defdemoname)
 				M_StartMessage(msg, NULL, MM_NOTHING);
 				return;
 			}
-			demobuf.p = demobuf.buffer;
 		}
 		// load demo resource from WAD
 		else if ((l = W_CheckNumForName(defdemoname)) == LUMPERROR)
@@ -7334,6 +8192,8 @@ void G_DoPlayDemo(char *defdemoname)
 		else // it's an internal demo
 		{
 			demobuf.buffer = demobuf.p = W_CacheLumpNum(l, PU_STATIC);
+			demoend = demobuf.buffer + W_LumpLength(l);
+			demobase = 0;
 #if defined(SKIPERRORS) && !defined(DEVELOP)
 			skiperrors = true; // SRB2Kart: Don't print warnings for staff ghosts, since they'll inevitably happen when we make bugfixes/changes...
 #endif
@@ -7349,8 +8209,7 @@ void G_DoPlayDemo(char *defdemoname)
 		CONS_Alert(CONS_ERROR, "%s", msg);
 		M_StartMessage(msg, NULL, MM_NOTHING);
 		Z_Free(pdemoname);
-		Z_Free(demobuf.buffer);
-		demobuf.buffer = NULL;
+		G_CloseDemoFile();
 		demo.playback = false;
 		demo.title = false;
 		return;
@@ -7378,8 +8237,7 @@ void G_DoPlayDemo(char *defdemoname)
 		CONS_Alert(CONS_ERROR, "%s", msg);
 		M_StartMessage(msg, NULL, MM_NOTHING);
 		Z_Free(pdemoname);
-		Z_Free(demobuf.buffer);
-		demobuf.buffer = NULL;
+		G_CloseDemoFile();
 		demo.playback = false;
 		demo.title = false;
 		return;
@@ -7391,8 +8249,7 @@ void G_DoPlayDemo(char *defdemoname)
 		CONS_Alert(CONS_ERROR, "%s", msg);
 		M_StartMessage(msg, NULL, MM_NOTHING);
 		Z_Free(pdemoname);
-		Z_Free(demobuf.buffer);
-		demobuf.buffer = NULL;
+		G_CloseDemoFile();
 		demo.playback = false;
 		demo.title = false;
 		return;
@@ -7411,8 +8268,7 @@ void G_DoPlayDemo(char *defdemoname)
 			CONS_Alert(CONS_ERROR, "%s", msg);
 			M_StartMessage(msg, NULL, MM_NOTHING);
 			Z_Free(pdemoname);
-			Z_Free(demobuf.buffer);
-			demobuf.buffer = NULL;
+			G_CloseDemoFile();
 			demo.playback = false;
 			demo.title = false;
 			return;
@@ -7472,8 +8328,7 @@ void G_DoPlayDemo(char *defdemoname)
 			if (!CON_Ready()) // In the console they'll just see the notice there! No point pulling them out.
 				M_StartMessage(msg, NULL, MM_NOTHING);
 			Z_Free(pdemoname);
-			Z_Free(demobuf.buffer);
-			demobuf.buffer = NULL;
+			G_CloseDemoFile();
 			demo.playback = false;
 			demo.title = false;
 			return;
@@ -7508,7 +8363,7 @@ void G_DoPlayDemo(char *defdemoname)
 #ifdef DEMO_COMPAT_100
 	if (demo.version != 0x0001)
 #endif
-	demobuf.p += 4; // Extrainfo location
+	G_LoadDemoKeyframes(READUINT32(demobuf.p), defdemoname == NULL); // Extrainfo location
 
 #ifdef DEMO_COMPAT_100
 	if (demo.version == 0x0001)
@@ -7539,8 +8394,7 @@ void G_DoPlayDemo(char *defdemoname)
 			CONS_Alert(CONS_ERROR, "%s", msg);
 			M_StartMessage(msg, NULL, MM_NOTHING);
 			Z_Free(pdemoname);
-			Z_Free(demobuf.buffer);
-			demobuf.buffer = NULL;
+			G_CloseDemoFile();
 			demo.playback = false;
 			demo.title = false;
 			return;
@@ -7553,8 +8407,7 @@ void G_DoPlayDemo(char *defdemoname)
 			CONS_Alert(CONS_ERROR, "%s", msg);
 			M_StartMessage(msg, NULL, MM_NOTHING);
 			Z_Free(pdemoname);
-			Z_Free(demobuf.buffer);
-			demobuf.buffer = NULL;
+			G_CloseDemoFile();
 			demo.playback = false;
 			demo.title = false;
 			return;
@@ -7578,8 +8431,7 @@ void G_DoPlayDemo(char *defdemoname)
 			CONS_Alert(CONS_ERROR, "%s", msg);
 			M_StartMessage(msg, NULL, MM_NOTHING);
 			Z_Free(pdemoname);
-			Z_Free(demobuf.buffer);
-			demobuf.buffer = NULL;
+			G_CloseDemoFile();
 			demo.playback = false;
 			demo.title = false;
 			return;
@@ -7622,8 +8474,7 @@ void G_DoPlayDemo(char *defdemoname)
 		CONS_Alert(CONS_ERROR, "%s", msg);
 		M_StartMessage(msg, NULL, MM_NOTHING);
 		Z_Free(pdemoname);
-		Z_Free(demobuf.buffer);
-		demobuf.buffer = NULL;
+		G_CloseDemoFile();
 		demo.playback = false;
 		demo.title = false;
 		return;
@@ -7677,8 +8528,7 @@ void G_DoPlayDemo(char *defdemoname)
 				CONS_Alert(CONS_ERROR, "%s", msg);
 				M_StartMessage(msg, NULL, MM_NOTHING);
 				Z_Free(pdemoname);
-				Z_Free(demobuf.buffer);
-				demobuf.buffer = NULL;
+				G_CloseDemoFile();
 				demo.playback = false;
 				demo.title = false;
 				return;
@@ -7692,8 +8542,7 @@ void G_DoPlayDemo(char *defdemoname)
 			CONS_Alert(CONS_ERROR, "%s", msg);
 			M_StartMessage(msg, NULL, MM_NOTHING);
 			Z_Free(pdemoname);
-			Z_Free(demobuf.buffer);
-			demobuf.buffer = NULL;
+			G_CloseDemoFile();
 			demo.playback = false;
 			demo.title = false;
 			return;
@@ -8244,6 +9093,64 @@ void G_TimeDemo(const char *name)
 	G_DeferedPlayDemo(name);
 }
 
+//
+// G_SimulateDemo
+// Plays a replay back for -simulate, with no video or sound and a tic per
+// loop, logging each tic's consistancy hash so runs on different builds can
+// be diffed. The log goes to -hashlog <file>, or simulate.log in srb2home.
+//
+static FILE *simlog;
+static precise_t simstarttime;
+static tic_t simtics;
+
+void G_SimulateDemo(const char *name)
+{
+	const char *logname = va(pandf, srb2home, "simulate.log");
+
+	if (M_CheckParm("-hashlog") && M_IsNextParm())
+		logname = M_GetNextParm();
+
+	if (!(simlog = fopen(logname, "w")))
+		CONS_Alert(CONS_WARNING, M_GetText("Couldn't open %s, not logging tic hashes\n"), logname);
+
+	singletics = true;
+	simtics = 0;
+	PS_ResetTickTotals();
+	simstarttime = I_GetPreciseTime();
+	G_DeferedPlayDemo(name);
+}
+
+// Reports on a finished -simulate run and quits
+static ATTRNORETURN void FUNCNORETURN G_FinishSimulation(void)
+{
+	const double precision = I_GetPrecisePrecision();
+	double wallsecs = (I_GetPreciseTime() - simstarttime) / precision;
+
+	if (simlog)
+		fclose(simlog);
+	simlog = NULL;
+
+	if (!simtics)
+		I_Error("Couldn't simulate the replay");
+
+	CONS_Printf(M_GetText("simulated %u tics in %f seconds, %f tics/sec\n"), simtics, wallsecs, simtics / wallsecs);
+	PS_PrintTickTotals(simtics);
+	I_Quit();
+}
+
+// Called after each tic -simulate runs, with its consistancy hash
+void G_SimulatedTic(INT16 consistancy)
+{
+	if (!demo.playback) // didn't start
+		G_FinishSimulation();
+
+	PS_AddTickTotals();
+
+	if (simlog)
+		fprintf(simlog, "%u %u %04x\n", simtics, leveltime, (UINT16)consistancy);
+	simtics++;
+}
+
 void G_DoPlayMetal(void)
 {
 	lumpnum_t l;
@@ -8260,7 +9167,7 @@ void G_DoPlayMetal(void)
 		metalbuffer = metal_p = W_CacheLumpNum(l, PU_STATIC);
 
 	// find metal sonic
-	for (th = thinkercap.next; th != &thinkercap; th = th->next)
+	for (th = thlist[THINK_MOBJ].cnext; th != &thlist[THINK_MOBJ]; th = th->cnext)
 	{
 		if (th->function.acp1 != (actionf_p1)P_MobjThinker)
 			continue;
@@ -8370,8 +9277,8 @@ ATTRNORETURN void FUNCNORETURN G_StopMetalRecording(void)
 // called from stopdemo command, map command, and g_checkdemoStatus.
 void G_StopDemo(void)
 {
-	Z_Free(demobuf.buffer);
-	demobuf.buffer = NULL;
+	G_CloseDemoFile();
+	G_ClearDemoKeyframes();
 	if (demo.playback)
 	{
 		CV_SetValue(&cv_director, directorstate);
@@ -8425,6 +9332,12 @@ boolean G_CheckDemoStatus(void)
 
 	// DO NOT end metal sonic demos here
 
+	if (demo.simulating && demo.playback)
+	{
+		G_StopDemo();
+		G_FinishSimulation();
+	}
+
 	if (demo.timing)
 	{
 		INT32 demotime;
@@ -8472,6 +9385,11 @@ boolean G_CheckDemoStatus(void)
 		return true;
 	}
 
+	if (demo.recording)
+	{
+		G_DiscardDemoSpool();
+		G_ClearDemoKeyframes();
+	}
 	demo.recording = false;
 
 	return false;
@@ -8479,17 +9397,24 @@ boolean G_CheckDemoStatus(void)
 
 void G_SaveDemo(void)
 {
-	UINT8 *p = demobuf.buffer+16; // after version
+	UINT8 *p;
 	UINT32 length;
+	boolean saved;
 #ifdef NOMD5
 	UINT8 i;
 #endif
 
 	// Ensure extrainfo pointer is always available, even if no info is present.
 	if (demoinfo_p && *(UINT32 *)demoinfo_p == 0)
+		G_EndDemoTics();
+
+	G_DemoReserve(1 + 4 + 1);
+	p = (demohead ? demohead : demobuf.buffer)+16; // after version
+
+	if (demokeyframepos)
 	{
-		WRITEUINT8(demobuf.p, DEMOMARKER); // add the demo end marker
-		*(UINT32 *)demoinfo_p = demobuf.p - demobuf.buffer;
+		WRITEUINT8(demobuf.p, DW_KEYFRAMES);
+		WRITEUINT32(demobuf.p, demokeyframepos);
 	}
 	WRITEUINT8(demobuf.p, DW_END); // Mark end of demo extra data.
 
@@ -8537,20 +9462,28 @@ void G_SaveDemo(void)
 
 	length = *(UINT32 *)demoinfo_p;
 	WRITEUINT32(demoinfo_p, length);
+
+	if (demofile) // most of it is spooled already
+		saved = G_FinishDemoSpool(length);
+	else
+	{
 #ifdef NOMD5
-	for (i = 0; i < 16; i++, p++)
-		*p = M_RandomByte(); // This MD5 was chosen by fair dice roll and most likely < 50% correct.
+		for (i = 0; i < 16; i++, p++)
+			*p = M_RandomByte(); // This MD5 was chosen by fair dice roll and most likely < 50% correct.
 #else
-	// Make a checksum of everything after the checksum in the file up to the end of the standard data. Extrainfo is freely modifiable.
-	md5_buffer((char *)p+16, (demobuf.buffer + length) - (p+16), p);
+		// Make a checksum of everything after the checksum in the file up to the end of the standard data. Extrainfo is freely modifiable.
+		md5_buffer((char *)p+16, (demobuf.buffer + length) - (p+16), p);
 #endif
 
+		saved = FIL_WriteFile(va(pandf, srb2home, demoname), demobuf.buffer, demobuf.p - demobuf.buffer); // finally output the file.
+	}
 
-	if (FIL_WriteFile(va(pandf, srb2home, demoname), demobuf.buffer, demobuf.p - demobuf.buffer)) // finally output the file.
+	if (saved)
 		demo.savemode = DSM_SAVED;
 	free(demobuf.buffer);
 	demobuf.buffer = NULL;
 	demo.recording = false;
+	G_ClearDemoKeyframes();
 
 	if (modeattacking != ATTACKING_RECORD)
 	{
@@ -41,13 +41,14 @@ extern savebuffer_t demobuf;
 // ======================================
 
 // demoplaying back and demo recording
-extern consvar_t cv_recordmultiplayerdemos, cv_netdemosyncquality, cv_maxdemosize, cv_demochangemap;
+extern consvar_t cv_recordmultiplayerdemos, cv_netdemosyncquality, cv_maxdemosize, cv_demochangemap, cv_demokeyframes;
 
 // Publicly-accessible demo vars
 struct demovars_s {
 	char titlename[65];
 	textinput_t titlenameinput;
 	boolean recording, playback, timing;
+	boolean simulating; // -simulate: headless, as fast as the game logic goes
 	UINT16 version; // Current file format of the demo being played
 	boolean title; // Title Screen demo can be cancelled by any key
 	boolean rewinding; // Rewind in progress
@@ -361,6 +362,8 @@ extern demoghost *ghosts;
 
 void G_DoPlayDemo(char *defdemoname);
 void G_TimeDemo(const char *name);
+void G_SimulateDemo(const char *name);
+void G_SimulatedTic(INT16 consistancy);
 void G_AddGhost(char *defdemoname);
 void G_UpdateStaffGhostName(lumpnum_t l);
 void G_DoPlayMetal(void);
@@ -72,10 +72,10 @@ typedef struct
 #pragma pack()
 #endif
 
-extern doomcom_t *doomcom;
+extern ATTRTHREAD doomcom_t *doomcom;
 
 #ifdef HOLEPUNCH
-extern holepunch_t *holepunchpacket;
+extern ATTRTHREAD holepunch_t *holepunchpacket;
 #endif
 
 /**	\brief return packet in doomcom struct
@@ -94,6 +94,25 @@ extern void (*I_NetSend)(void);
 */
 extern boolean (*I_NetCanSend)(void);
 
+/**	\brief hold back packets sent from now on, so the driver can send them
+	together; may be NULL
+*/
+extern void (*I_NetBeginBatch)(void);
+
+/**	\brief send any packets held back since I_NetBeginBatch; may be NULL
+*/
+extern void (*I_NetFlush)(void);
+
+/**	\brief syscall and datagram counts kept by the driver, for packetstat
+*/
+typedef struct
+{
+	UINT32 recvcalls, recvpackets;
+	UINT32 sendcalls, sendpackets;
+} netdriverstats_t;
+
+extern netdriverstats_t netdriverstats;
+
 /**	\brief	close a connection
 
 	\param	nodenum	node to be closed
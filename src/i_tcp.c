@@ -12,6 +12,10 @@
 ///        This is not really OS-dependent because all OSes have the same socket API.
 ///        Just use ifdef for OS-dependent parts.
 
+#if defined (__linux__) && !defined (_GNU_SOURCE)
+#define _GNU_SOURCE // recvmmsg, sendmmsg
+#endif
+
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
@@ -188,6 +192,10 @@ typedef unsigned long SOCKET_TYPE;
 typedef int socklen_t;
 #endif
 
+#if defined (__linux__) && !defined (NONET)
+#define HAVE_MMSG // read and write several datagrams per syscall
+#endif
+
 #ifndef NONET
 
 typedef struct
@@ -212,6 +220,42 @@ static banned_t *banned;
 #ifdef HOLEPUNCH
 static const INT32 hole_punch_magic = MSBF_LONG (0x52eb11);
 #endif
+
+// Caches which node each IPv4 address:port belongs to, so a busy server
+// doesn't compare every packet against every node. Emptied whenever
+// clientaddress changes, so a hit always agrees with the full scan.
+#define NODEHASHSIZE 256
+
+typedef struct
+{
+	UINT32 addr;
+	UINT16 port;
+	SINT8 node; // 0 if unused, node 0 is never looked up
+} nodehash_t;
+
+static nodehash_t nodehash[NODEHASHSIZE];
+
+#ifdef HAVE_MMSG
+#define MMSGBATCH 32
+
+typedef struct
+{
+	mysockaddr_t address;
+	SOCKET_TYPE socket;
+	INT16 node; // send queue only
+	INT16 length;
+	UINT8 data[MAXPACKETLENGTH];
+} mmsgpacket_t;
+
+// Datagrams read by the last recvmmsg, handed out one per SOCK_Get
+static mmsgpacket_t recvqueue[MMSGBATCH];
+static size_t recvhead = 0, recvcount = 0;
+
+// Datagrams held back between I_NetBeginBatch and I_NetFlush
+static mmsgpacket_t sendqueue[MMSGBATCH];
+static size_t sendcount = 0;
+static boolean sendbatching = false;
+#endif
 #endif
 
 static size_t numbans = 0;
@@ -377,7 +421,7 @@ static inline void I_UPnP_rem(const char *port, const char * servicetype)
 
 static const char *SOCK_AddrToStr(mysockaddr_t *sk)
 {
-	static char s[64]; // 255.255.255.255:65535 or IPv6:65535
+	static ATTRTHREAD char s[64]; // 255.255.255.255:65535 or IPv6:65535, one per thread
 #ifdef HAVE_NTOP
 	void *addr;
 
@@ -396,15 +440,15 @@ static const char *SOCK_AddrToStr(mysockaddr_t *sk)
 		sprintf(s, "Unknown family type, error #%u", errno);
 #ifdef HAVE_IPV6
 	else if(sk->any.sa_family == AF_INET6 && sk->ip6.sin6_port != 0)
-		strcat(s, va(":%d", ntohs(sk->ip6.sin6_port)));
+		sprintf(s + strlen(s), ":%d", ntohs(sk->ip6.sin6_port));
 #endif
 	else if(sk->any.sa_family == AF_INET  && sk->ip4.sin_port  != 0)
-		strcat(s, va(":%d", ntohs(sk->ip4.sin_port)));
+		sprintf(s + strlen(s), ":%d", ntohs(sk->ip4.sin_port));
 #else
 	if (sk->any.sa_family == AF_INET)
 	{
 		strcpy(s, inet_ntoa(sk->ip4.sin_addr));
-		if (sk->ip4.sin_port != 0) strcat(s, va(":%d", ntohs(sk->ip4.sin_port)));
+		if (sk->ip4.sin_port != 0) sprintf(s + strlen(s), ":%d", ntohs(sk->ip4.sin_port));
 	}
 	else
 		sprintf(s, "Unknown type");
@@ -420,9 +464,14 @@ static const char *SOCK_GetNodeAddress(INT32 node)
 #ifdef NONET
 	return NULL;
 #else
-	if (!nodeconnected[node])
-		return NULL;
-	return SOCK_AddrToStr(&clientaddress[node]);
+	const char *s = NULL;
+
+	// The network thread may be handing out nodes
+	Net_LockDriver();
+	if (nodeconnected[node])
+		s = SOCK_AddrToStr(&clientaddress[node]);
+	Net_UnlockDriver();
+	return s;
 #endif
 }
 
@@ -530,14 +579,17 @@ static SINT8 getfreenode(void)
 {
 	SINT8 j;
 
+	Net_LockDriver();
 	cleanupnodes();
 
 	for (j = 0; j < MAXNETNODES; j++)
 		if (!nodeconnected[j])
 		{
 			nodeconnected[j] = true;
+			Net_UnlockDriver();
 			return j;
 		}
+	Net_UnlockDriver();
 
 	/** \warning No free node? Just in case a node might not have been freed properly,
 	  *          look if there are connected nodes that aren't in game, and forget them.
@@ -559,6 +611,7 @@ void Command_Numnodes(void)
 	INT32 ingame = 0;
 	INT32 i;
 
+	Net_LockDriver();
 	for (i = 1; i < MAXNETNODES; i++)
 	{
 		if (!(nodeconnected[i] || nodeingame[i]))
@@ -584,6 +637,7 @@ void Command_Numnodes(void)
 			CONS_Printf(" -       ");
 		CONS_Printf(" - %s\n", I_GetNodeAddress(i));
 	}
+	Net_UnlockDriver();
 
 	CONS_Printf("\n"
 				"Connected: %d\n"
@@ -643,11 +697,205 @@ static boolean hole_punch(ssize_t c)
 }
 #endif
 
+static void SOCK_ClearNodeHash(void)
+{
+	memset(nodehash, 0, sizeof (nodehash));
+}
+
+static inline nodehash_t *SOCK_NodeHashSlot(const mysockaddr_t *addr)
+{
+	UINT32 h = addr->ip4.sin_addr.s_addr ^ ((UINT32)addr->ip4.sin_port << 16);
+	return &nodehash[(h * 2654435761u) >> 24];
+}
+
+// Returns the node a packet from this address belongs to, or -1
+static SINT8 SOCK_FindNode(mysockaddr_t *fromaddress)
+{
+	nodehash_t *slot = NULL;
+	int j;
+
+	if (fromaddress->any.sa_family == AF_INET)
+	{
+		slot = SOCK_NodeHashSlot(fromaddress);
+		if (slot->node && slot->addr == fromaddress->ip4.sin_addr.s_addr
+			&& slot->port == fromaddress->ip4.sin_port)
+			return slot->node;
+	}
+
+	for (j = 1; j <= MAXNETNODES; j++) //include LAN
+	{
+		if (SOCK_cmpaddr(fromaddress, &clientaddress[j], 0))
+		{
+			if (slot)
+			{
+				slot->addr = fromaddress->ip4.sin_addr.s_addr;
+				slot->port = fromaddress->ip4.sin_port;
+				slot->node = (SINT8)j;
+			}
+			return (SINT8)j;
+		}
+	}
+
+	return -1;
+}
+
+// Puts the sender of the packet in doomcom->data into doomcom->remotenode,
+// giving it a new node if it isn't known yet.
+// Returns true for a new node, false otherwise; remotenode is left at -1
+// if there was no free slot.
+static boolean SOCK_IdentifyNode(mysockaddr_t *fromaddress, socklen_t fromlen, SOCKET_TYPE socket, ssize_t c)
+{
+	size_t i;
+	int j;
+
+	// find remote node number
+	j = SOCK_FindNode(fromaddress);
+	if (j != -1)
+	{
+		doomcom->remotenode = (INT16)j; // good packet from a game player
+		doomcom->datalength = (INT16)c;
+		nodesocket[j] = socket;
+		return false;
+	}
+	// not found
+
+	// find a free slot
+	j = getfreenode();
+	if (j > 0)
+	{
+		const time_t curTime = time(NULL);
+
+		M_Memcpy(&clientaddress[j], fromaddress, fromlen);
+		SOCK_ClearNodeHash();
+		nodesocket[j] = socket;
+		DEBFILE(va("New node detected: node:%d address:%s\n", j,
+				SOCK_GetNodeAddress(j)));
+		doomcom->remotenode = (INT16)j; // good packet from a game player
+		doomcom->datalength = (INT16)c;
+
+		// check if it's a banned dude so we can send a refusal later
+		for (i = 0; i < numbans; i++)
+		{
+			if (SOCK_cmpaddr(fromaddress, &banned[i].address, banned[i].mask))
+			{
+				if (banned[i].timestamp != NO_BAN_TIME)
+				{
+					if (curTime >= banned[i].timestamp)
+					{
+						SOCK_bannednode[j].timeleft = NO_BAN_TIME;
+						SOCK_bannednode[j].banid = SIZE_MAX;
+						DEBFILE("This dude was banned, but enough time has passed\n");
+						break;
+					}
+
+					SOCK_bannednode[j].timeleft = banned[i].timestamp - curTime;
+					SOCK_bannednode[j].banid = i;
+					DEBFILE("This dude has been temporarily banned\n");
+					break;
+				}
+				else
+				{
+					SOCK_bannednode[j].timeleft = NO_BAN_TIME;
+					SOCK_bannednode[j].banid = i;
+					DEBFILE("This dude has been banned\n");
+					break;
+				}
+			}
+		}
+
+		if (i == numbans)
+		{
+			SOCK_bannednode[j].timeleft = NO_BAN_TIME;
+			SOCK_bannednode[j].banid = SIZE_MAX;
+		}
+
+		return true;
+	}
+
+	DEBFILE("New node detected: No more free slots\n");
+	doomcom->remotenode = -1;
+	return false;
+}
+
+#ifdef HAVE_MMSG
+// Reads as many waiting datagrams as fit into recvqueue,
+// one recvmmsg per socket instead of one recvfrom per datagram
+static boolean SOCK_FillRecvQueue(void)
+{
+	static struct mmsghdr msgs[MMSGBATCH];
+	static struct iovec iov[MMSGBATCH];
+	size_t n, k, count = 0;
+	int r;
+
+	for (n = 0; n < mysocketses && count < MMSGBATCH; n++)
+	{
+		for (k = count; k < MMSGBATCH; k++)
+		{
+			iov[k].iov_base = recvqueue[k].data;
+			iov[k].iov_len = MAXPACKETLENGTH;
+			memset(&msgs[k].msg_hdr, 0, sizeof (msgs[k].msg_hdr));
+			msgs[k].msg_hdr.msg_name = &recvqueue[k].address;
+			msgs[k].msg_hdr.msg_namelen = (socklen_t)sizeof (recvqueue[k].address);
+			msgs[k].msg_hdr.msg_iov = &iov[k];
+			msgs[k].msg_hdr.msg_iovlen = 1;
+		}
+
+		r = recvmmsg(mysockets[n], &msgs[count], (unsigned int)(MMSGBATCH - count), MSG_DONTWAIT, NULL);
+		netdriverstats.recvcalls++;
+		if (r <= 0)
+			continue;
+
+		netdriverstats.recvpackets += r;
+		for (k = count; k < count + (size_t)r; k++)
+		{
+			recvqueue[k].socket = mysockets[n];
+			recvqueue[k].length = (INT16)msgs[k].msg_len;
+		}
+		count += (size_t)r;
+	}
+
+	recvhead = 0;
+	recvcount = count;
+	return (count > 0);
+}
+
 // Returns true if a packet was received from a new node, false in all other cases
 static boolean SOCK_Get(void)
 {
-	size_t i, n;
-	int j;
+	mmsgpacket_t *p;
+
+	while (recvcount || SOCK_FillRecvQueue())
+	{
+		p = &recvqueue[recvhead++];
+		recvcount--;
+
+		if (p->length <= 0)
+			continue;
+
+		M_Memcpy(doomcom->data, p->data, p->length);
+#ifdef USE_STUN
+		if (STUN_got_response(doomcom->data, p->length))
+			continue;
+#endif
+#ifdef HOLEPUNCH
+		if (hole_punch(p->length))
+			continue;
+#endif
+
+		if (SOCK_IdentifyNode(&p->address, (socklen_t)sizeof (p->address), p->socket, p->length))
+			return true;
+		if (doomcom->remotenode != -1)
+			return false;
+	}
+
+	doomcom->remotenode = -1; // no packet
+	return false;
+}
+#else
+// Returns true if a packet was received from a new node, false in all other cases
+static boolean SOCK_Get(void)
+{
+	size_t n;
 	ssize_t c;
 	mysockaddr_t fromaddress;
 	socklen_t fromlen;
@@ -657,8 +905,10 @@ static boolean SOCK_Get(void)
 		fromlen = (socklen_t)sizeof(fromaddress);
 		c = recvfrom(mysockets[n], (char *)&doomcom->data, MAXPACKETLENGTH, 0,
 			(void *)&fromaddress, &fromlen);
+		netdriverstats.recvcalls++;
 		if (c > 0)
 		{
+			netdriverstats.recvpackets++;
 #ifdef USE_STUN
 			if (STUN_got_response(doomcom->data, c))
 			{
@@ -672,72 +922,10 @@ static boolean SOCK_Get(void)
 			}
 #endif
 
-			// find remote node number
-			for (j = 1; j <= MAXNETNODES; j++) //include LAN
-			{
-				if (SOCK_cmpaddr(&fromaddress, &clientaddress[j], 0))
-				{
-					doomcom->remotenode = (INT16)j; // good packet from a game player
-					doomcom->datalength = (INT16)c;
-					nodesocket[j] = mysockets[n];
-					return false;
-				}
-			}
-			// not found
-
-			// find a free slot
-			j = getfreenode();
-			if (j > 0)
-			{
-				const time_t curTime = time(NULL);
-
-				M_Memcpy(&clientaddress[j], &fromaddress, fromlen);
-				nodesocket[j] = mysockets[n];
-				DEBFILE(va("New node detected: node:%d address:%s\n", j,
-						SOCK_GetNodeAddress(j)));
-				doomcom->remotenode = (INT16)j; // good packet from a game player
-				doomcom->datalength = (INT16)c;
-
-				// check if it's a banned dude so we can send a refusal later
-				for (i = 0; i < numbans; i++)
-				{
-					if (SOCK_cmpaddr(&fromaddress, &banned[i].address, banned[i].mask))
-					{
-						if (banned[i].timestamp != NO_BAN_TIME)
-						{
-							if (curTime >= banned[i].timestamp)
-							{
-								SOCK_bannednode[j].timeleft = NO_BAN_TIME;
-								SOCK_bannednode[j].banid = SIZE_MAX;
-								DEBFILE("This dude was banned, but enough time has passed\n");
-								break;
-							}
-
-							SOCK_bannednode[j].timeleft = banned[i].timestamp - curTime;
-							SOCK_bannednode[j].banid = i;
-							DEBFILE("This dude has been temporarily banned\n");
-							break;
-						}
-						else
-						{
-							SOCK_bannednode[j].timeleft = NO_BAN_TIME;
-							SOCK_bannednode[j].banid = i;
-							DEBFILE("This dude has been banned\n");
-							break;
-						}
-					}
-				}
-
-				if (i == numbans)
-				{
-					SOCK_bannednode[j].timeleft = NO_BAN_TIME;
-					SOCK_bannednode[j].banid = SIZE_MAX;
-				}
-
+			if (SOCK_IdentifyNode(&fromaddress, fromlen, mysockets[n], c))
 				return true;
-			}
-			else
-				DEBFILE("New node detected: No more free slots\n");
+			if (doomcom->remotenode != -1)
+				return false;
 		}
 	}
 
@@ -745,6 +933,7 @@ static boolean SOCK_Get(void)
 	return false;
 }
 #endif
+#endif
 
 // check if we can send (do not go over the buffer)
 #ifndef NONET
@@ -789,6 +978,10 @@ static boolean SOCK_CanGet(void)
 	fd_set tset;
 	int rselect;
 
+#ifdef HAVE_MMSG
+	if (recvcount)
+		return true;
+#endif
 	if(!FD_CPY(&masterset, &tset, mysockets, mysocketses))
 		return false;
 	rselect = select(255, &tset, NULL, NULL, &timeval_for_select);
@@ -800,28 +993,112 @@ static boolean SOCK_CanGet(void)
 #endif
 
 #ifndef NONET
-static inline ssize_t SOCK_SendToAddr(SOCKET_TYPE socket, mysockaddr_t *sockaddr)
+static inline socklen_t SOCK_AddrLen(const mysockaddr_t *sockaddr)
 {
-	socklen_t d4 = (socklen_t)sizeof(struct sockaddr_in);
-#ifdef HAVE_IPV6
-	socklen_t d6 = (socklen_t)sizeof(struct sockaddr_in6);
-#endif
-	socklen_t d, da = (socklen_t)sizeof(mysockaddr_t);
-
 	switch (sockaddr->any.sa_family)
 	{
-		case AF_INET:  d = d4; break;
+		case AF_INET:  return (socklen_t)sizeof(struct sockaddr_in);
 #ifdef HAVE_IPV6
-		case AF_INET6: d = d6; break;
+		case AF_INET6: return (socklen_t)sizeof(struct sockaddr_in6);
 #endif
-		default:       d = da; break;
+		default:       return (socklen_t)sizeof(mysockaddr_t);
 	}
+}
+
+static inline ssize_t SOCK_SendToAddr(SOCKET_TYPE socket, mysockaddr_t *sockaddr)
+{
+	ssize_t c = sendto(socket, (char *)&doomcom->data, doomcom->datalength, 0, &sockaddr->any, SOCK_AddrLen(sockaddr));
 
-	return sendto(socket, (char *)&doomcom->data, doomcom->datalength, 0, &sockaddr->any, d);
+	netdriverstats.sendcalls++;
+	if (c != ERRSOCKET)
+		netdriverstats.sendpackets++;
+	return c;
 }
 
 #define ALLOWEDERROR(x) ((x) == ECONNREFUSED || (x) == EWOULDBLOCK || (x) == EHOSTUNREACH || (x) == ENETUNREACH)
 
+#ifdef HAVE_MMSG
+// Sends everything in sendqueue, one sendmmsg per run of packets
+// going out of the same socket
+static void SOCK_Flush(void)
+{
+	static struct mmsghdr msgs[MMSGBATCH];
+	static struct iovec iov[MMSGBATCH];
+	size_t i, k, end;
+	int r;
+
+	for (k = 0; k < sendcount; k++)
+	{
+		iov[k].iov_base = sendqueue[k].data;
+		iov[k].iov_len = sendqueue[k].length;
+		memset(&msgs[k].msg_hdr, 0, sizeof (msgs[k].msg_hdr));
+		msgs[k].msg_hdr.msg_name = &sendqueue[k].address;
+		msgs[k].msg_hdr.msg_namelen = SOCK_AddrLen(&sendqueue[k].address);
+		msgs[k].msg_hdr.msg_iov = &iov[k];
+		msgs[k].msg_hdr.msg_iovlen = 1;
+	}
+
+	for (i = 0; i < sendcount; i = end)
+	{
+		for (end = i + 1; end < sendcount && sendqueue[end].socket == sendqueue[i].socket; end++)
+			;
+
+		while (i < end)
+		{
+			r = sendmmsg(sendqueue[i].socket, &msgs[i], (unsigned int)(end - i), 0);
+			netdriverstats.sendcalls++;
+
+			if (r > 0)
+			{
+				netdriverstats.sendpackets += r;
+				i += (size_t)r;
+			}
+			else
+			{
+				// the first packet of the run failed, report it like SOCK_Send would
+				int e = errno; // save error code so it can't be modified later
+				if (!ALLOWEDERROR(e))
+				{
+					sendcount = 0;
+					Net_DriverError("SOCK_Send, error sending to node %d (%s) #%u: %s", sendqueue[i].node,
+						SOCK_GetNodeAddress(sendqueue[i].node), e, strerror(e));
+					return;
+				}
+				i++;
+			}
+		}
+	}
+
+	sendcount = 0;
+}
+
+static void SOCK_BeginBatch(void)
+{
+	sendbatching = true;
+}
+
+static void SOCK_EndBatch(void)
+{
+	SOCK_Flush();
+	sendbatching = false;
+}
+
+static void SOCK_QueueSend(void)
+{
+	mmsgpacket_t *p;
+
+	if (sendcount == MMSGBATCH)
+		SOCK_Flush();
+
+	p = &sendqueue[sendcount++];
+	p->socket = nodesocket[doomcom->remotenode];
+	p->address = clientaddress[doomcom->remotenode];
+	p->node = doomcom->remotenode;
+	p->length = doomcom->datalength;
+	M_Memcpy(p->data, doomcom->data, doomcom->datalength);
+}
+#endif
+
 static void SOCK_Send(void)
 {
 	ssize_t c = ERRSOCKET;
@@ -861,6 +1138,13 @@ static void SOCK_Send(void)
 	}
 	else
 	{
+#ifdef HAVE_MMSG
+		if (sendbatching)
+		{
+			SOCK_QueueSend();
+			return;
+		}
+#endif
 		c = SOCK_SendToAddr(nodesocket[doomcom->remotenode], &clientaddress[doomcom->remotenode]);
 	}
 
@@ -868,7 +1152,7 @@ static void SOCK_Send(void)
 	{
 		int e = errno; // save error code so it can't be modified later
 		if (!ALLOWEDERROR(e))
-			I_Error("SOCK_Send, error sending to node %d (%s) #%u: %s", doomcom->remotenode,
+			Net_DriverError("SOCK_Send, error sending to node %d (%s) #%u: %s", doomcom->remotenode,
 				SOCK_GetNodeAddress(doomcom->remotenode), e, strerror(e));
 	}
 }
@@ -889,6 +1173,7 @@ static void SOCK_FreeNodenum(INT32 numnode)
 
 	// put invalid address
 	memset(&clientaddress[numnode], 0, sizeof (clientaddress[numnode]));
+	SOCK_ClearNodeHash();
 }
 #endif
 
@@ -1294,6 +1579,10 @@ boolean I_InitTcpDriver(void)
 static void SOCK_CloseSocket(void)
 {
 	size_t i;
+#ifdef HAVE_MMSG
+	SOCK_EndBatch();
+	recvcount = 0;
+#endif
 	for (i=0; i < MAXNETNODES+1; i++)
 	{
 		if (mysockets[i] != (SOCKET_TYPE)ERRSOCKET
@@ -1376,9 +1665,12 @@ static SINT8 SOCK_NetMakeNodewPort(const char *address, const char *port)
 	{
 		if (!SOCK_GetAddr(&clientaddress[newnode].ip4, address, port, true))
 		{
+			Net_LockDriver();
 			nodeconnected[newnode] = false;
+			Net_UnlockDriver();
 			return -1;
 		}
+		SOCK_ClearNodeHash();
 	}
 
 	return newnode;
@@ -1449,6 +1741,7 @@ static boolean SOCK_OpenSocket(void)
 	size_t i;
 
 	memset(clientaddress, 0, sizeof (clientaddress));
+	SOCK_ClearNodeHash();
 
 	nodeconnected[0] = true; // always connected to self
 	for (i = 1; i < MAXNETNODES; i++)
@@ -1465,6 +1758,10 @@ static boolean SOCK_OpenSocket(void)
 	I_NetCanSend = SOCK_CanSend;
 	I_NetCanGet = SOCK_CanGet;
 #endif
+#ifdef HAVE_MMSG
+	I_NetBeginBatch = SOCK_BeginBatch;
+	I_NetFlush = SOCK_EndBatch;
+#endif
 #ifdef HOLEPUNCH
 
 	I_NetRequestHolePunch = SOCK_RequestHolePunch;
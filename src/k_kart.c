@@ -40,6 +40,7 @@
 #include "lua_hud.h"	// For Lua hud checks
 #include "lua_hook.h"	// For MobjDamage and ShouldDamage
 #include "d_main.h"		// found_extra_kart
+#include "qs22j.h"
 
 
 #include "i_video.h"
@@ -8355,6 +8356,136 @@ static void K_KartDrift(player_t *player, boolean onground)
 	else
 		player->kartstuff[k_brakedrift] = 0;
 }
+//
+// Checkpoint waypoint index
+//
+// K_KartUpdatePosition needs the averaged distance from a player to the
+// waypoints of their current and next starpost. Rather than walking every
+// waypoint for every pair of players, the waypoints are sorted by starpost
+// number once per tic, and each player's distances are remembered until
+// they move or pass a starpost.
+//
+static mobj_t **kwaypoints = NULL;
+static size_t kwaypointcount = 0, kwaypointsize = 0;
+static mobj_t *kwaypointhead = NULL; // waypointcap when the index was built
+static tic_t kwaypointtime = 0; // leveltime when the index was built
+static UINT32 kwaypointgen = 0; // bumped every rebuild; 0 means no index
+
+typedef struct
+{
+	UINT32 gen;
+	fixed_t x, y, z;
+	INT32 starpostnum;
+	UINT8 laps;
+	fixed_t prevcheck, nextcheck;
+} kcheckcache_t;
+
+static kcheckcache_t kcheckcache[MAXPLAYERS];
+
+static int K_WaypointCompare(const void *a, const void *b)
+{
+	const INT32 ha = (*(mobj_t *const *)a)->health;
+	const INT32 hb = (*(mobj_t *const *)b)->health;
+	return (ha > hb) - (ha < hb);
+}
+
+//
+// K_ClearWaypointIndex
+// Forgets the waypoint index, for when the waypoint list is rebuilt.
+//
+void K_ClearWaypointIndex(void)
+{
+	kwaypointcount = 0;
+	kwaypointhead = NULL;
+	kwaypointgen = 0;
+	memset(kcheckcache, 0, sizeof (kcheckcache));
+}
+
+static void K_UpdateWaypointIndex(void)
+{
+	mobj_t *mo;
+
+	if (kwaypointgen && kwaypointhead == waypointcap && kwaypointtime == leveltime)
+		return;
+
+	kwaypointcount = 0;
+	for (mo = waypointcap; mo != NULL; mo = mo->tracer)
+	{
+		if (kwaypointcount == kwaypointsize)
+		{
+			kwaypointsize = kwaypointsize ? kwaypointsize * 2 : 64;
+			kwaypoints = Z_Realloc(kwaypoints, kwaypointsize * sizeof (*kwaypoints), PU_STATIC, NULL);
+		}
+		kwaypoints[kwaypointcount++] = mo;
+	}
+
+	qs22j(kwaypoints, kwaypointcount, sizeof (*kwaypoints), K_WaypointCompare);
+
+	kwaypointhead = waypointcap;
+	kwaypointtime = leveltime;
+	if (++kwaypointgen == 0)
+		kwaypointgen = 1;
+}
+
+// Averaged distance from mo to the waypoints of a starpost that count on this lap.
+static fixed_t K_StarpostDistance(mobj_t *pmo, INT32 starpostnum, UINT8 laps)
+{
+	size_t lo = 0, hi = kwaypointcount;
+	fixed_t dist = 0;
+	INT32 count = 0;
+
+	// find the first waypoint for this starpost
+	while (lo < hi)
+	{
+		size_t mid = lo + (hi - lo) / 2;
+		if (kwaypoints[mid]->health < starpostnum)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	for (; lo < kwaypointcount && kwaypoints[lo]->health == starpostnum; lo++)
+	{
+		mobj_t *mo = kwaypoints[lo];
+
+		if (mo->movecount && mo->movecount != laps+1)
+			continue;
+
+		dist += P_AproxDistance(P_AproxDistance(mo->x - pmo->x,
+												mo->y - pmo->y),
+												mo->z - pmo->z) / FRACUNIT;
+		count++;
+	}
+
+	if (count > 1)
+		dist /= count;
+
+	return dist;
+}
+
+// Fills in k_prevcheck and k_nextcheck, reusing the last result if nothing changed.
+static void K_UpdateCheckDistances(player_t *player)
+{
+	kcheckcache_t *cache = &kcheckcache[player - players];
+	mobj_t *pmo = player->mo;
+
+	if (cache->gen != kwaypointgen || cache->x != pmo->x || cache->y != pmo->y || cache->z != pmo->z
+		|| cache->starpostnum != player->starpostnum || cache->laps != player->laps)
+	{
+		cache->gen = kwaypointgen;
+		cache->x = pmo->x;
+		cache->y = pmo->y;
+		cache->z = pmo->z;
+		cache->starpostnum = player->starpostnum;
+		cache->laps = player->laps;
+		cache->prevcheck = K_StarpostDistance(pmo, player->starpostnum, player->laps);
+		cache->nextcheck = K_StarpostDistance(pmo, player->starpostnum + 1, player->laps);
+	}
+
+	player->kartstuff[k_prevcheck] = cache->prevcheck;
+	player->kartstuff[k_nextcheck] = cache->nextcheck;
+}
+
 //
 // K_KartUpdatePosition
 //
@@ -8362,13 +8493,14 @@ void K_KartUpdatePosition(player_t *player)
 {
 	fixed_t position = 1;
 	fixed_t oldposition = player->kartstuff[k_position];
-	fixed_t i, ppcd, pncd, ipcd, incd;
-	fixed_t pmo, imo;
-	mobj_t *mo;
+	fixed_t i;
 
 	if (player->spectator || !player->mo)
 		return;
 
+	if (G_RaceGametype())
+		K_UpdateWaypointIndex();
+
 	for (i = 0; i < MAXPLAYERS; i++)
 	{
 		if (!playeringame[i] || players[i].spectator || !players[i].mo)
@@ -8382,47 +8514,8 @@ void K_KartUpdatePosition(player_t *player)
 			else if (((players[i].starpostnum) + (numstarposts+1)*players[i].laps) ==
 				((player->starpostnum) + (numstarposts+1)*player->laps))
 			{
-				ppcd = pncd = ipcd = incd = 0;
-
-				player->kartstuff[k_prevcheck] = players[i].kartstuff[k_prevcheck] = 0;
-				player->kartstuff[k_nextcheck] = players[i].kartstuff[k_nextcheck] = 0;
-
-				// This checks every thing on the map, and looks for MT_BOSS3WAYPOINT (the thing we're using for checkpoint wp's, for now)
-				for (mo = waypointcap; mo != NULL; mo = mo->tracer)
-				{
-					pmo = P_AproxDistance(P_AproxDistance(	mo->x - player->mo->x,
-															mo->y - player->mo->y),
-															mo->z - player->mo->z) / FRACUNIT;
-					imo = P_AproxDistance(P_AproxDistance(	mo->x - players[i].mo->x,
-															mo->y - players[i].mo->y),
-															mo->z - players[i].mo->z) / FRACUNIT;
-
-					if (mo->health == player->starpostnum && (!mo->movecount || mo->movecount == player->laps+1))
-					{
-						player->kartstuff[k_prevcheck] += pmo;
-						ppcd++;
-					}
-					if (mo->health == (player->starpostnum + 1) && (!mo->movecount || mo->movecount == player->laps+1))
-					{
-						player->kartstuff[k_nextcheck] += pmo;
-						pncd++;
-					}
-					if (mo->health == players[i].starpostnum && (!mo->movecount || mo->movecount == players[i].laps+1))
-					{
-						players[i].kartstuff[k_prevcheck] += imo;
-						ipcd++;
-					}
-					if (mo->health == (players[i].starpostnum + 1) && (!mo->movecount || mo->movecount == players[i].laps+1))
-					{
-						players[i].kartstuff[k_nextcheck] += imo;
-						incd++;
-					}
-				}
-
-				if (ppcd > 1) player->kartstuff[k_prevcheck] /= ppcd;
-				if (pncd > 1) player->kartstuff[k_nextcheck] /= pncd;
-				if (ipcd > 1) players[i].kartstuff[k_prevcheck] /= ipcd;
-				if (incd > 1) players[i].kartstuff[k_nextcheck] /= incd;
+				K_UpdateCheckDistances(player);
+				K_UpdateCheckDistances(&players[i]);
 
 				if ((players[i].kartstuff[k_nextcheck] > 0 || player->kartstuff[k_nextcheck] > 0) && !player->exiting)
 				{
@@ -87,6 +87,7 @@ player_t *K_FindJawzTarget(mobj_t *actor, player_t *source);
 boolean K_CheckPlayersRespawnColliding(INT32 playernum, fixed_t x, fixed_t y);
 INT16 K_GetKartTurnValue(player_t *player, INT16 turnvalue);
 INT32 K_GetKartDriftSparkValue(player_t *player);
+void K_ClearWaypointIndex(void);
 void K_KartUpdatePosition(player_t *player);
 void K_DropItems(player_t *player);
 void K_DropRocketSneaker(player_t *player);
@@ -0,0 +1,225 @@
+// SONIC ROBO BLAST 2
+//-----------------------------------------------------------------------------
+// Copyright (C) 2012-2016 by John "JTE" Muniz.
+// Copyright (C) 2012-2018 by Sonic Team Junior.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  lua_alloc.c
+/// \brief Size-classed allocator for the Lua state
+///
+/// Lua makes and drops thousands of small tables, strings and closures every
+/// tic in bigger mods. Sending each of them through Z_Realloc costs a
+/// memblock_t header and the zone's list bookkeeping, so small requests are
+/// served from per-size-class freelists instead. Lua always tells us how big
+/// a block was when it frees or resizes it, so the chunks need no header at
+/// all. The slabs themselves still come from the zone with PU_LUA, so memfree
+/// keeps counting them as Lua memory, and they are only given back when the
+/// state is closed.
+
+#include "doomdef.h"
+#include "z_zone.h"
+#include "lua_alloc.h"
+
+#define LUASLABSIZE (16*1024)
+
+typedef union luaslab_u
+{
+	union luaslab_u *next; // every slab carved so far, for LUA_ClearHeap
+	UINT8 pad[16]; // keeps the chunks after it 16 byte aligned
+} luaslab_t;
+
+typedef struct luachunk_s
+{
+	struct luachunk_s *next;
+} luachunk_t;
+
+luaheapstats_t luaheapstats;
+
+static luaslab_t *luaslabs;
+static luachunk_t *luafreelists[LUA_NUMSIZECLASSES];
+
+static const UINT16 luaclasssizes[LUA_NUMSIZECLASSES] =
+{
+	16, 32, 48, 64, 80, 96, 112, 128,
+	160, 192, 224, 256,
+	320, 384, 448, 512
+};
+
+// Size class for each 16 byte step up to LUA_MAXSMALLSIZE, indexed by (size-1)>>4
+static const UINT8 luaclassof[LUA_MAXSMALLSIZE>>4] =
+{
+	0, 1, 2, 3, 4, 5, 6, 7,
+	8, 8, 9, 9, 10, 10, 11, 11,
+	12, 12, 12, 12, 13, 13, 13, 13,
+	14, 14, 14, 14, 15, 15, 15, 15
+};
+
+#define LUA_SizeClass(size) luaclassof[((size) - 1)>>4]
+
+//
+// LUA_SlabAlloc
+// Takes a chunk off a size class's freelist, carving a new slab if it's empty.
+//
+static void *LUA_SlabAlloc(UINT8 c)
+{
+	luasizeclass_t *sc = &luaheapstats.classes[c];
+	luachunk_t *chunk = luafreelists[c];
+
+	if (chunk == NULL)
+	{
+		luaslab_t *slab = Z_Malloc(LUASLABSIZE, PU_LUA, NULL);
+		UINT8 *p;
+		UINT32 i;
+
+		if (!sc->size)
+		{
+			sc->size = luaclasssizes[c];
+			sc->chunks = (LUASLABSIZE - sizeof (luaslab_t)) / sc->size;
+		}
+
+		slab->next = luaslabs;
+		luaslabs = slab;
+		sc->slabs++;
+
+		// Thread the chunks back to front, so they get handed out in address order.
+		p = (UINT8 *)(slab + 1) + (sc->chunks - 1) * sc->size;
+		for (i = 0; i < sc->chunks; i++, p -= sc->size)
+		{
+			((luachunk_t *)(void *)p)->next = chunk;
+			chunk = (luachunk_t *)(void *)p;
+		}
+	}
+
+	luafreelists[c] = chunk->next;
+
+	sc->allocs++;
+	if (++sc->live > sc->peak)
+		sc->peak = sc->live;
+
+	return chunk;
+}
+
+//
+// LUA_SlabFree
+// Puts a chunk back on its size class's freelist.
+//
+static void LUA_SlabFree(void *ptr, UINT8 c)
+{
+	luachunk_t *chunk = ptr;
+
+	chunk->next = luafreelists[c];
+	luafreelists[c] = chunk;
+	luaheapstats.classes[c].live--;
+}
+
+static void *LUA_NewBlock(size_t size)
+{
+	luaheapstats.allocs++;
+	luaheapstats.allocbytes += size;
+
+	if (size <= LUA_MAXSMALLSIZE)
+		return LUA_SlabAlloc(LUA_SizeClass(size));
+
+	luaheapstats.largeallocs++;
+	return Z_Malloc(size, PU_LUA, NULL);
+}
+
+static void LUA_FreeBlock(void *ptr, size_t size)
+{
+	luaheapstats.freebytes += size;
+
+	if (size <= LUA_MAXSMALLSIZE)
+		LUA_SlabFree(ptr, LUA_SizeClass(size));
+	else
+		Z_Free(ptr);
+}
+
+//
+// LUA_HeapAlloc
+// The lua_Alloc for the main state. Lua 5.1 passes the old size of every
+// block it frees or resizes, and 0 along with a NULL ptr for new ones.
+//
+void *LUA_HeapAlloc(void *ud, void *ptr, size_t osize, size_t nsize)
+{
+	void *newptr;
+	(void)ud;
+
+	if (nsize == 0)
+	{
+		if (ptr)
+			LUA_FreeBlock(ptr, osize);
+		return NULL;
+	}
+
+	if (ptr == NULL)
+		return LUA_NewBlock(nsize);
+
+	if (osize > LUA_MAXSMALLSIZE && nsize > LUA_MAXSMALLSIZE)
+	{
+		// Big to big, the zone can resize it in place
+		luaheapstats.allocs++;
+		luaheapstats.largeallocs++;
+		luaheapstats.allocbytes += nsize;
+		luaheapstats.freebytes += osize;
+		return Z_Realloc(ptr, nsize, PU_LUA, NULL);
+	}
+
+	if (osize <= LUA_MAXSMALLSIZE && nsize <= LUA_MAXSMALLSIZE
+		&& LUA_SizeClass(osize) == LUA_SizeClass(nsize))
+	{
+		// Still fits the chunk it's in
+		luaheapstats.allocbytes += nsize;
+		luaheapstats.freebytes += osize;
+		return ptr;
+	}
+
+	newptr = LUA_NewBlock(nsize);
+	M_Memcpy(newptr, ptr, min(osize, nsize));
+	LUA_FreeBlock(ptr, osize);
+	return newptr;
+}
+
+//
+// LUA_ClearHeap
+// Gives every slab back to the zone and resets the stats.
+// Only call this after lua_close, nothing may be holding on to a chunk.
+//
+void LUA_ClearHeap(void)
+{
+	while (luaslabs)
+	{
+		luaslab_t *next = luaslabs->next;
+		Z_Free(luaslabs);
+		luaslabs = next;
+	}
+
+	memset(luafreelists, 0, sizeof luafreelists);
+	memset(&luaheapstats, 0, sizeof luaheapstats);
+}
+
+//
+// LUA_PrintHeapStats
+// Prints how each size class is doing, for memfree.
+//
+void LUA_PrintHeapStats(void)
+{
+	const luasizeclass_t *sc;
+	UINT32 i;
+
+	CONS_Printf("\x82%s", M_GetText("Lua Size Classes\n"));
+	for (i = 0; i < LUA_NUMSIZECLASSES; i++)
+	{
+		sc = &luaheapstats.classes[i];
+		if (!sc->slabs)
+			continue;
+		CONS_Printf(M_GetText("%4s bytes        : %7s KB, %u/%u used (peak %u), %u allocs\n"),
+			sizeu1(sc->size), sizeu2((sc->slabs * LUASLABSIZE)>>10),
+			sc->live, sc->slabs * sc->chunks, sc->peak, sc->allocs);
+	}
+	CONS_Printf(M_GetText("Large allocs      : %u of %u\n"), luaheapstats.largeallocs, luaheapstats.allocs);
+	CONS_Printf(M_GetText("Allocated / freed : %s / %s KB\n"),
+		sizeu1((size_t)(luaheapstats.allocbytes>>10)), sizeu2((size_t)(luaheapstats.freebytes>>10)));
+}
@@ -0,0 +1,57 @@
+// SONIC ROBO BLAST 2
+//-----------------------------------------------------------------------------
+// Copyright (C) 2012-2016 by John "JTE" Muniz.
+// Copyright (C) 2012-2018 by Sonic Team Junior.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  lua_alloc.h
+/// \brief Size-classed allocator for the Lua state
+
+#ifndef __LUA_ALLOC__
+#define __LUA_ALLOC__
+
+#include "doomtype.h"
+
+// Allocations up to this size are carved out of size-classed slabs,
+// anything bigger goes to the zone like before.
+#define LUA_MAXSMALLSIZE 512
+#define LUA_NUMSIZECLASSES 16
+
+typedef struct
+{
+	size_t size; // chunk size in bytes
+	UINT32 chunks; // chunks per slab
+	UINT32 slabs; // slabs carved for this class
+	UINT32 live; // chunks currently handed out to Lua
+	UINT32 peak;
+	UINT32 allocs; // chunks handed out since the state was created
+} luasizeclass_t;
+
+typedef struct
+{
+	luasizeclass_t classes[LUA_NUMSIZECLASSES];
+
+	// Running totals since the state was created.
+	// allocbytes - freebytes is the memory Lua is using right now, and
+	// how fast they grow is how hard the garbage collector has to work.
+	UINT32 allocs;
+	UINT32 largeallocs; // allocations too big for a size class
+	UINT64 allocbytes;
+	UINT64 freebytes;
+} luaheapstats_t;
+
+extern luaheapstats_t luaheapstats;
+
+// lua_Alloc for the main state.
+void *LUA_HeapAlloc(void *ud, void *ptr, size_t osize, size_t nsize);
+
+// Gives every slab back to the zone. Only call once the state is closed.
+void LUA_ClearHeap(void);
+
+// Prints the per-class stats, for memfree.
+void LUA_PrintHeapStats(void);
+
+#endif
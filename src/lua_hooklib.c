@@ -93,15 +93,14 @@ struct hook_s
 };
 typedef struct hook_s* hook_p;
 
-// For each mobj type, a linked list to its thinker and collision hooks.
-// That way, we don't have to iterate through all the hooks.
-// We could do that with all other mobj hooks, but it would probably just be
-// a waste of memory since they are only called occasionally. Probably...
-static hook_p mobjthinkerhooks[NUMMOBJTYPES];
-static hook_p mobjcollidehooks[NUMMOBJTYPES];
+// For each mobj hook type, a linked list per mobj type (MT_NULL for hooks
+// that apply to every type). That way, dispatch only ever touches hooks
+// that will actually run. The per-type arrays are allocated the first time
+// a hook of that kind is added, so unused hook types cost one pointer.
+static hook_p *mobjhooks[hook_MAX];
 
-// For each mobj type, a linked list for other mobj hooks
-static hook_p mobjhooks[NUMMOBJTYPES];
+// Registry reference to the hooks table, so dispatch can skip the string lookup
+static int hooksref = LUA_NOREF;
 
 // A linked list for player hooks
 static hook_p playerhooks;
@@ -189,16 +188,12 @@ static int lib_addHook(lua_State *L)
 	// set hook.id to the highest id + 1
 	hook.id = nextid++;
 
-	// Special cases for some hook types (see the comments above mobjthinkerhooks declaration)
+	// Special cases for some hook types (see the comments above mobjhooks declaration)
 	switch(hook.type)
 	{
 	case hook_MobjThinker:
-		lastp = &mobjthinkerhooks[hook.s.mt];
-		break;
 	case hook_MobjCollide:
 	case hook_MobjMoveCollide:
-		lastp = &mobjcollidehooks[hook.s.mt];
-		break;
 	case hook_MobjSpawn:
 	case hook_TouchSpecial:
 	case hook_MobjFuse:
@@ -209,7 +204,9 @@ static int lib_addHook(lua_State *L)
 	case hook_BossDeath:
 	case hook_MobjRemoved:
 	case hook_MobjScaleChange:
-		lastp = &mobjhooks[hook.s.mt];
+		if (!mobjhooks[hook.type])
+			mobjhooks[hook.type] = ZZ_Calloc(NUMMOBJTYPES * sizeof (hook_p));
+		lastp = &mobjhooks[hook.type][hook.s.mt];
 		break;
 	case hook_JumpSpecial:
 	case hook_AbilitySpecial:
@@ -258,6 +255,8 @@ int LUA_HookLib(lua_State *L)
 	lua_register(L, "addHook", lib_addHook);
 
 	lua_newtable(L);
+	lua_pushvalue(L, -1);
+	hooksref = luaL_ref(L, LUA_REGISTRYINDEX);
 	lua_setfield(L, LUA_REGISTRYINDEX, "hooks");
 
 	return 0;
@@ -268,30 +267,32 @@ boolean LUAh_MobjHook(mobj_t *mo, enum hook which)
 	hook_p hookp;
 	boolean hooked = false;
 	int HOOKSINDEX;
+	precise_t time_taken = 0;
 	if (!gL || !(hooksAvailable[which/8] & (1<<(which%8))))
 		return false;
 
 	I_Assert(mo->type < NUMMOBJTYPES);
 
-	if (!(mobjhooks[MT_NULL] || mobjhooks[mo->type]))
+	if (!(mobjhooks[which][MT_NULL] || mobjhooks[which][mo->type]))
 		return false;
 
+	if (cv_perfstats.value == 2)
+		time_taken = I_GetPreciseTime();
+
 	lua_settop(gL, 0);
 	lua_pushcfunction(gL, LUA_GetErrorMessage);
 
-	lua_getfield(gL, LUA_REGISTRYINDEX, "hooks");
+	lua_rawgeti(gL, LUA_REGISTRYINDEX, hooksref);
 	HOOKSINDEX = lua_gettop(gL);
 	I_Assert(lua_istable(L, HOOKSINDEX));
 
+	// Every hook in these lists runs, so the argument can be pushed up front
+	LUA_PushUserdata(gL, mo, META_MOBJ);
+
 	// Look for all generic mobj hooks
-	for (hookp = mobjhooks[MT_NULL]; hookp; hookp = hookp->next)
+	for (hookp = mobjhooks[which][MT_NULL]; hookp; hookp = hookp->next)
 	{
-		if (hookp->type != which)
-			continue;
-
 		ps_lua_mobjhooks.value.i++;
-		if (lua_gettop(gL) == 2)
-			LUA_PushUserdata(gL, mo, META_MOBJ);
 		lua_rawgeti(gL, HOOKSINDEX, hookp->id);
 		lua_pushvalue(gL, -2);
 		if (lua_pcall(gL, 1, 1, 1)) {
@@ -306,14 +307,9 @@ boolean LUAh_MobjHook(mobj_t *mo, enum hook which)
 		lua_pop(gL, 1);
 	}
 
-	for (hookp = mobjhooks[mo->type]; hookp; hookp = hookp->next)
+	for (hookp = mobjhooks[which][mo->type]; hookp; hookp = hookp->next)
 	{
-		if (hookp->type != which)
-			continue;
-
 		ps_lua_mobjhooks.value.i++;
-		if (lua_gettop(gL) == 2)
-			LUA_PushUserdata(gL, mo, META_MOBJ);
 		lua_rawgeti(gL, HOOKSINDEX, hookp->id);
 		lua_pushvalue(gL, -2);
 		if (lua_pcall(gL, 1, 1, 1)) {
@@ -329,6 +325,10 @@ boolean LUAh_MobjHook(mobj_t *mo, enum hook which)
 	}
 
 	lua_settop(gL, 0);
+
+	if (cv_perfstats.value == 2)
+		ps_lua_mobjhook_time.value.p += I_GetPreciseTime() - time_taken;
+
 	return hooked;
 }
 
@@ -343,7 +343,7 @@ boolean LUAh_PlayerHook(player_t *plr, enum hook which)
 	lua_settop(gL, 0);
 	lua_pushcfunction(gL, LUA_GetErrorMessage);
 
-	lua_getfield(gL, LUA_REGISTRYINDEX, "hooks");
+	lua_rawgeti(gL, LUA_REGISTRYINDEX, hooksref);
 	HOOKSINDEX = lua_gettop(gL);
 	I_Assert(lua_istable(L, HOOKSINDEX));
 
@@ -384,7 +384,7 @@ void LUAh_MapChange(INT16 mapnumber)
 	lua_settop(gL, 0);
 	lua_pushcfunction(gL, LUA_GetErrorMessage);
 
-	lua_getfield(gL, LUA_REGISTRYINDEX, "hooks");
+	lua_rawgeti(gL, LUA_REGISTRYINDEX, hooksref);
 	HOOKSINDEX = lua_gettop(gL);
 	I_Assert(lua_istable(L, HOOKSINDEX));
 
@@ -417,7 +417,7 @@ void LUAh_MapLoad(void)
 	lua_settop(gL, 0);
 	lua_pushcfunction(gL, LUA_GetErrorMessage);
 
-	lua_getfield(gL, LUA_REGISTRYINDEX, "hooks");
+	lua_rawgeti(gL, LUA_REGISTRYINDEX, hooksref);
 	HOOKSINDEX = lua_gettop(gL);
 	I_Assert(lua_istable(L, HOOKSINDEX));
 
@@ -450,7 +450,7 @@ void LUAh_PlayerJoin(int playernum)
 	lua_settop(gL, 0);
 	lua_pushcfunction(gL, LUA_GetErrorMessage);
 
-	lua_getfield(gL, LUA_REGISTRYINDEX, "hooks");
+	lua_rawgeti(gL, LUA_REGISTRYINDEX, hooksref);
 	HOOKSINDEX = lua_gettop(gL);
 	I_Assert(lua_istable(L, HOOKSINDEX));
 
@@ -485,7 +485,7 @@ void LUAh_PreThinkFrame(void)
 
 	lua_pushcfunction(gL, LUA_GetErrorMessage);
 
-	lua_getfield(gL, LUA_REGISTRYINDEX, "hooks");
+	lua_rawgeti(gL, LUA_REGISTRYINDEX, hooksref);
 	HOOKSINDEX = lua_gettop(gL);
 	I_Assert(lua_istable(L, HOOKSINDEX));
 
@@ -532,7 +532,7 @@ void LUAh_ThinkFrame(void)
 
 	lua_pushcfunction(gL, LUA_GetErrorMessage);
 
-	lua_getfield(gL, LUA_REGISTRYINDEX, "hooks");
+	lua_rawgeti(gL, LUA_REGISTRYINDEX, hooksref);
 	HOOKSINDEX = lua_gettop(gL);
 	I_Assert(lua_istable(L, HOOKSINDEX));
 
@@ -578,7 +578,7 @@ void LUAh_PostThinkFrame(void)
 
 	lua_pushcfunction(gL, LUA_GetErrorMessage);
 
-	lua_getfield(gL, LUA_REGISTRYINDEX, "hooks");
+	lua_rawgeti(gL, LUA_REGISTRYINDEX, hooksref);
 	HOOKSINDEX = lua_gettop(gL);
 	I_Assert(lua_istable(L, HOOKSINDEX));
 
@@ -622,7 +622,7 @@ void LUAh_IntermissionThinker(void)
 
 	lua_pushcfunction(gL, LUA_GetErrorMessage);;
 
-	lua_getfield(gL, LUA_REGISTRYINDEX, "hooks");
+	lua_rawgeti(gL, LUA_REGISTRYINDEX, hooksref);
 	HOOKSINDEX = lua_gettop(gL);
 	I_Assert(lua_istable(L, HOOKSINDEX));
 
@@ -654,7 +654,7 @@ void LUAh_VoteThinker(void)
 
 	lua_pushcfunction(gL, LUA_GetErrorMessage);
 
-	lua_getfield(gL, LUA_REGISTRYINDEX, "hooks");
+	lua_rawgeti(gL, LUA_REGISTRYINDEX, hooksref);
 	HOOKSINDEX = lua_gettop(gL);
 	I_Assert(lua_istable(L, HOOKSINDEX));
 
@@ -686,7 +686,7 @@ void LUAh_TitleThinker(void)
 
 	lua_pushcfunction(gL, LUA_GetErrorMessage);
 	
-	lua_getfield(gL, LUA_REGISTRYINDEX, "hooks");
+	lua_rawgeti(gL, LUA_REGISTRYINDEX, hooksref);
 	HOOKSINDEX = lua_gettop(gL);
 	I_Assert(lua_istable(L, HOOKSINDEX));
 
@@ -714,33 +714,33 @@ UINT8 LUAh_MobjCollideHook(mobj_t *thing1, mobj_t *thing2, enum hook which)
 	hook_p hookp;
 	UINT8 shouldCollide = 0; // 0 = default, 1 = force yes, 2 = force no.
 	int HOOKSINDEX;
+	precise_t time_taken = 0;
 	if (!gL || !(hooksAvailable[which/8] & (1<<(which%8))))
 		return 0;
 
 	I_Assert(thing1->type < NUMMOBJTYPES);
 
-	if (!(mobjcollidehooks[MT_NULL] || mobjcollidehooks[thing1->type]))
+	if (!(mobjhooks[which][MT_NULL] || mobjhooks[which][thing1->type]))
 		return 0;
 
+	if (cv_perfstats.value == 2)
+		time_taken = I_GetPreciseTime();
+
 	lua_settop(gL, 0);
 	lua_pushcfunction(gL, LUA_GetErrorMessage);
 
-	lua_getfield(gL, LUA_REGISTRYINDEX, "hooks");
+	lua_rawgeti(gL, LUA_REGISTRYINDEX, hooksref);
 	HOOKSINDEX = lua_gettop(gL);
 	I_Assert(lua_istable(L, HOOKSINDEX));
 
+	// Every hook in these lists runs, so the arguments can be pushed up front
+	LUA_PushUserdata(gL, thing1, META_MOBJ);
+	LUA_PushUserdata(gL, thing2, META_MOBJ);
+
 	// Look for all generic mobj collision hooks
-	for (hookp = mobjcollidehooks[MT_NULL]; hookp; hookp = hookp->next)
+	for (hookp = mobjhooks[which][MT_NULL]; hookp; hookp = hookp->next)
 	{
-		if (hookp->type != which)
-			continue;
-
 		ps_lua_mobjhooks.value.i++;
-		if (lua_gettop(gL) == 2)
-		{
-			LUA_PushUserdata(gL, thing1, META_MOBJ);
-			LUA_PushUserdata(gL, thing2, META_MOBJ);
-		}
 		lua_rawgeti(gL, HOOKSINDEX, hookp->id);
 		lua_pushvalue(gL, -3);
 		lua_pushvalue(gL, -3);
@@ -761,17 +761,9 @@ UINT8 LUAh_MobjCollideHook(mobj_t *thing1, mobj_t *thing2, enum hook which)
 		lua_pop(gL, 1);
 	}
 
-	for (hookp = mobjcollidehooks[thing1->type]; hookp; hookp = hookp->next)
+	for (hookp = mobjhooks[which][thing1->type]; hookp; hookp = hookp->next)
 	{
-		if (hookp->type != which)
-			continue;
-
 		ps_lua_mobjhooks.value.i++;
-		if (lua_gettop(gL) == 2)
-		{
-			LUA_PushUserdata(gL, thing1, META_MOBJ);
-			LUA_PushUserdata(gL, thing2, META_MOBJ);
-		}
 		lua_rawgeti(gL, HOOKSINDEX, hookp->id);
 		lua_pushvalue(gL, -3);
 		lua_pushvalue(gL, -3);
@@ -793,6 +785,10 @@ UINT8 LUAh_MobjCollideHook(mobj_t *thing1, mobj_t *thing2, enum hook which)
 	}
 
 	lua_settop(gL, 0);
+
+	if (cv_perfstats.value == 2)
+		ps_lua_mobjcollide_time.value.p += I_GetPreciseTime() - time_taken;
+
 	return shouldCollide;
 }
 
@@ -802,27 +798,32 @@ boolean LUAh_MobjThinker(mobj_t *mo)
 	hook_p hookp;
 	boolean hooked = false;
 	int HOOKSINDEX;
+	precise_t time_taken = 0;
 	if (!gL || !(hooksAvailable[hook_MobjThinker/8] & (1<<(hook_MobjThinker%8))))
 		return false;
 
 	I_Assert(mo->type < NUMMOBJTYPES);
 
-	if (!(mobjthinkerhooks[MT_NULL] || mobjthinkerhooks[mo->type]))
+	if (!(mobjhooks[hook_MobjThinker][MT_NULL] || mobjhooks[hook_MobjThinker][mo->type]))
 		return false;
 
+	if (cv_perfstats.value == 2)
+		time_taken = I_GetPreciseTime();
+
 	lua_settop(gL, 0);
 	lua_pushcfunction(gL, LUA_GetErrorMessage);
 
-	lua_getfield(gL, LUA_REGISTRYINDEX, "hooks");
+	lua_rawgeti(gL, LUA_REGISTRYINDEX, hooksref);
 	HOOKSINDEX = lua_gettop(gL);
 	I_Assert(lua_istable(L, HOOKSINDEX));
 
+	// Every hook in these lists runs, so the argument can be pushed up front
+	LUA_PushUserdata(gL, mo, META_MOBJ);
+
 	// Look for all generic mobj thinker hooks
-	for (hookp = mobjthinkerhooks[MT_NULL]; hookp; hookp = hookp->next)
+	for (hookp = mobjhooks[hook_MobjThinker][MT_NULL]; hookp; hookp = hookp->next)
 	{
 		ps_lua_mobjhooks.value.i++;
-		if (lua_gettop(gL) == 2)
-			LUA_PushUserdata(gL, mo, META_MOBJ);
 		lua_rawgeti(gL, HOOKSINDEX, hookp->id);
 		lua_pushvalue(gL, -2);
 		if (lua_pcall(gL, 1, 1, 1)) {
@@ -837,11 +838,9 @@ boolean LUAh_MobjThinker(mobj_t *mo)
 		lua_pop(gL, 1);
 	}
 
-	for (hookp = mobjthinkerhooks[mo->type]; hookp; hookp = hookp->next)
+	for (hookp = mobjhooks[hook_MobjThinker][mo->type]; hookp; hookp = hookp->next)
 	{
 		ps_lua_mobjhooks.value.i++;
-		if (lua_gettop(gL) == 2)
-			LUA_PushUserdata(gL, mo, META_MOBJ);
 		lua_rawgeti(gL, HOOKSINDEX, hookp->id);
 		lua_pushvalue(gL, -2);
 		if (lua_pcall(gL, 1, 1, 1)) {
@@ -857,6 +856,10 @@ boolean LUAh_MobjThinker(mobj_t *mo)
 	}
 
 	lua_settop(gL, 0);
+
+	if (cv_perfstats.value == 2)
+		ps_lua_mobjthinker_time.value.p += I_GetPreciseTime() - time_taken;
+
 	return hooked;
 }
 
@@ -871,22 +874,19 @@ boolean LUAh_TouchSpecial(mobj_t *special, mobj_t *toucher)
 
 	I_Assert(special->type < NUMMOBJTYPES);
 
-	if (!(mobjhooks[MT_NULL] || mobjhooks[special->type]))
+	if (!(mobjhooks[hook_TouchSpecial][MT_NULL] || mobjhooks[hook_TouchSpecial][special->type]))
 		return false;
 
 	lua_settop(gL, 0);
 	lua_pushcfunction(gL, LUA_GetErrorMessage);
 
-	lua_getfield(gL, LUA_REGISTRYINDEX, "hooks");
+	lua_rawgeti(gL, LUA_REGISTRYINDEX, hooksref);
 	HOOKSINDEX = lua_gettop(gL);
 	I_Assert(lua_istable(L, HOOKSINDEX));
 
 	// Look for all generic touch special hooks
-	for (hookp = mobjhooks[MT_NULL]; hookp; hookp = hookp->next)
+	for (hookp = mobjhooks[hook_TouchSpecial][MT_NULL]; hookp; hookp = hookp->next)
 	{
-		if (hookp->type != hook_TouchSpecial)
-			continue;
-
 		ps_lua_mobjhooks.value.i++;
 		if (lua_gettop(gL) == 2)
 		{
@@ -908,11 +908,8 @@ boolean LUAh_TouchSpecial(mobj_t *special, mobj_t *toucher)
 		lua_pop(gL, 1);
 	}
 
-	for (hookp = mobjhooks[special->type]; hookp; hookp = hookp->next)
+	for (hookp = mobjhooks[hook_TouchSpecial][special->type]; hookp; hookp = hookp->next)
 	{
-		if (hookp->type != hook_TouchSpecial)
-			continue;
-
 		ps_lua_mobjhooks.value.i++;
 		if (lua_gettop(gL) == 2)
 		{
@@ -949,22 +946,19 @@ UINT8 LUAh_ShouldDamage(mobj_t *target, mobj_t *inflictor, mobj_t *source, INT32
 
 	I_Assert(target->type < NUMMOBJTYPES);
 
-	if (!(mobjhooks[MT_NULL] || mobjhooks[target->type]))
+	if (!(mobjhooks[hook_ShouldDamage][MT_NULL] || mobjhooks[hook_ShouldDamage][target->type]))
 		return 0;
 
 	lua_settop(gL, 0);
 	lua_pushcfunction(gL, LUA_GetErrorMessage);
 
-	lua_getfield(gL, LUA_REGISTRYINDEX, "hooks");
+	lua_rawgeti(gL, LUA_REGISTRYINDEX, hooksref);
 	HOOKSINDEX = lua_gettop(gL);
 	I_Assert(lua_istable(L, HOOKSINDEX));
 
 	// Look for all generic should damage hooks
-	for (hookp = mobjhooks[MT_NULL]; hookp; hookp = hookp->next)
+	for (hookp = mobjhooks[hook_ShouldDamage][MT_NULL]; hookp; hookp = hookp->next)
 	{
-		if (hookp->type != hook_ShouldDamage)
-			continue;
-
 		ps_lua_mobjhooks.value.i++;
 		if (lua_gettop(gL) == 2)
 		{
@@ -995,11 +989,8 @@ UINT8 LUAh_ShouldDamage(mobj_t *target, mobj_t *inflictor, mobj_t *source, INT32
 		lua_pop(gL, 1);
 	}
 
-	for (hookp = mobjhooks[target->type]; hookp; hookp = hookp->next)
+	for (hookp = mobjhooks[hook_ShouldDamage][target->type]; hookp; hookp = hookp->next)
 	{
-		if (hookp->type != hook_ShouldDamage)
-			continue;
-
 		ps_lua_mobjhooks.value.i++;
 		if (lua_gettop(gL) == 2)
 		{
@@ -1045,22 +1036,19 @@ boolean LUAh_MobjDamage(mobj_t *target, mobj_t *inflictor, mobj_t *source, INT32
 
 	I_Assert(target->type < NUMMOBJTYPES);
 
-	if (!(mobjhooks[MT_NULL] || mobjhooks[target->type]))
+	if (!(mobjhooks[hook_MobjDamage][MT_NULL] || mobjhooks[hook_MobjDamage][target->type]))
 		return false;
 
 	lua_settop(gL, 0);
 	lua_pushcfunction(gL, LUA_GetErrorMessage);
 
-	lua_getfield(gL, LUA_REGISTRYINDEX, "hooks");
+	lua_rawgeti(gL, LUA_REGISTRYINDEX, hooksref);
 	HOOKSINDEX = lua_gettop(gL);
 	I_Assert(lua_istable(L, HOOKSINDEX));
 
 	// Look for all generic mobj damage hooks
-	for (hookp = mobjhooks[MT_NULL]; hookp; hookp = hookp->next)
+	for (hookp = mobjhooks[hook_MobjDamage][MT_NULL]; hookp; hookp = hookp->next)
 	{
-		if (hookp->type != hook_MobjDamage)
-			continue;
-
 		ps_lua_mobjhooks.value.i++;
 		if (lua_gettop(gL) == 2)
 		{
@@ -1086,11 +1074,8 @@ boolean LUAh_MobjDamage(mobj_t *target, mobj_t *inflictor, mobj_t *source, INT32
 		lua_pop(gL, 1);
 	}
 
-	for (hookp = mobjhooks[target->type]; hookp; hookp = hookp->next)
+	for (hookp = mobjhooks[hook_MobjDamage][target->type]; hookp; hookp = hookp->next)
 	{
-		if (hookp->type != hook_MobjDamage)
-			continue;
-
 		ps_lua_mobjhooks.value.i++;
 		if (lua_gettop(gL) == 2)
 		{
@@ -1131,22 +1116,19 @@ boolean LUAh_MobjDeath(mobj_t *target, mobj_t *inflictor, mobj_t *source)
 
 	I_Assert(target->type < NUMMOBJTYPES);
 
-	if (!(mobjhooks[MT_NULL] || mobjhooks[target->type]))
+	if (!(mobjhooks[hook_MobjDeath][MT_NULL] || mobjhooks[hook_MobjDeath][target->type]))
 		return false;
 
 	lua_settop(gL, 0);
 	lua_pushcfunction(gL, LUA_GetErrorMessage);
 
-	lua_getfield(gL, LUA_REGISTRYINDEX, "hooks");
+	lua_rawgeti(gL, LUA_REGISTRYINDEX, hooksref);
 	HOOKSINDEX = lua_gettop(gL);
 	I_Assert(lua_istable(L, HOOKSINDEX));
 
 	// Look for all generic mobj death hooks
-	for (hookp = mobjhooks[MT_NULL]; hookp; hookp = hookp->next)
+	for (hookp = mobjhooks[hook_MobjDeath][MT_NULL]; hookp; hookp = hookp->next)
 	{
-		if (hookp->type != hook_MobjDeath)
-			continue;
-
 		if (lua_gettop(gL) == 2)
 		{
 			LUA_PushUserdata(gL, target, META_MOBJ);
@@ -1169,11 +1151,8 @@ boolean LUAh_MobjDeath(mobj_t *target, mobj_t *inflictor, mobj_t *source)
 		lua_pop(gL, 1);
 	}
 
-	for (hookp = mobjhooks[target->type]; hookp; hookp = hookp->next)
+	for (hookp = mobjhooks[hook_MobjDeath][target->type]; hookp; hookp = hookp->next)
 	{
-		if (hookp->type != hook_MobjDeath)
-			continue;
-
 		ps_lua_mobjhooks.value.i++;
 		if (lua_gettop(gL) == 2)
 		{
@@ -1213,7 +1192,7 @@ boolean LUAh_BotTiccmd(player_t *bot, ticcmd_t *cmd)
 	lua_settop(gL, 0);
 	lua_pushcfunction(gL, LUA_GetErrorMessage);
 
-	lua_getfield(gL, LUA_REGISTRYINDEX, "hooks");
+	lua_rawgeti(gL, LUA_REGISTRYINDEX, hooksref);
 	HOOKSINDEX = lua_gettop(gL);
 	I_Assert(lua_istable(L, HOOKSINDEX));
 
@@ -1259,7 +1238,7 @@ boolean LUAh_PlayerCmd(player_t *player, ticcmd_t *cmd)
 	lua_settop(gL, 0);
 	lua_pushcfunction(gL, LUA_GetErrorMessage);
 
-	lua_getfield(gL, LUA_REGISTRYINDEX, "hooks");
+	lua_rawgeti(gL, LUA_REGISTRYINDEX, hooksref);
 	HOOKSINDEX = lua_gettop(gL);
 	I_Assert(lua_istable(L, HOOKSINDEX));
 
@@ -1306,7 +1285,7 @@ boolean LUAh_BotAI(mobj_t *sonic, mobj_t *tails, ticcmd_t *cmd)
 	lua_settop(gL, 0);
 	lua_pushcfunction(gL, LUA_GetErrorMessage);
 
-	lua_getfield(gL, LUA_REGISTRYINDEX, "hooks");
+	lua_rawgeti(gL, LUA_REGISTRYINDEX, hooksref);
 	HOOKSINDEX = lua_gettop(gL);
 	I_Assert(lua_istable(L, HOOKSINDEX));
 
@@ -1374,7 +1353,7 @@ boolean LUAh_LinedefExecute(line_t *line, mobj_t *mo, sector_t *sector)
 	lua_settop(gL, 0);
 	lua_pushcfunction(gL, LUA_GetErrorMessage);
 
-	lua_getfield(gL, LUA_REGISTRYINDEX, "hooks");
+	lua_rawgeti(gL, LUA_REGISTRYINDEX, hooksref);
 	HOOKSINDEX = lua_gettop(gL);
 	I_Assert(lua_istable(L, HOOKSINDEX));
 
@@ -1419,7 +1398,7 @@ boolean LUAh_PlayerMsg(int source, int target, int flags, char *msg, int mute)
 	lua_settop(gL, 0);
 	lua_pushcfunction(gL, LUA_GetErrorMessage);
 
-	lua_getfield(gL, LUA_REGISTRYINDEX, "hooks");
+	lua_rawgeti(gL, LUA_REGISTRYINDEX, hooksref);
 	HOOKSINDEX = lua_gettop(gL);
 	I_Assert(lua_istable(L, HOOKSINDEX));
 
@@ -1484,7 +1463,7 @@ boolean LUAh_HurtMsg(player_t *player, mobj_t *inflictor, mobj_t *source)
 	lua_settop(gL, 0);
 	lua_pushcfunction(gL, LUA_GetErrorMessage);
 
-	lua_getfield(gL, LUA_REGISTRYINDEX, "hooks");
+	lua_rawgeti(gL, LUA_REGISTRYINDEX, hooksref);
 	HOOKSINDEX = lua_gettop(gL);
 	I_Assert(lua_istable(L, HOOKSINDEX));
 
@@ -1535,7 +1514,7 @@ void LUAh_NetArchiveHook(lua_CFunction archFunc, savebuffer_t *save)
 	lua_pushcfunction(gL, LUA_GetErrorMessage);
 	errorhandlerindex = lua_gettop(gL);
 
-	lua_getfield(gL, LUA_REGISTRYINDEX, "hooks");
+	lua_rawgeti(gL, LUA_REGISTRYINDEX, hooksref);
 	HOOKSINDEX = lua_gettop(gL);
 	I_Assert(lua_istable(L, HOOKSINDEX));
 
@@ -1572,7 +1551,7 @@ void LUAh_PlayerQuit(player_t *plr, int reason)
 	lua_settop(gL, 0);
 	lua_pushcfunction(gL, LUA_GetErrorMessage);
 
-	lua_getfield(gL, LUA_REGISTRYINDEX, "hooks");
+	lua_rawgeti(gL, LUA_REGISTRYINDEX, hooksref);
 	HOOKSINDEX = lua_gettop(gL);
 	I_Assert(lua_istable(L, HOOKSINDEX));
 
@@ -1612,7 +1591,7 @@ boolean LUAh_MusicChange(const char *oldname, char *newname, UINT16 *mflags, boo
 	lua_settop(gL, 0);
 	lua_pushcfunction(gL, LUA_GetErrorMessage);
 
-	lua_getfield(gL, LUA_REGISTRYINDEX, "hooks");
+	lua_rawgeti(gL, LUA_REGISTRYINDEX, hooksref);
 	HOOKSINDEX = lua_gettop(gL);
 	I_Assert(lua_istable(L, HOOKSINDEX));
 
@@ -1676,7 +1655,7 @@ UINT8 LUAh_ShouldSpin(player_t *player, mobj_t *inflictor, mobj_t *source)
 	lua_settop(gL, 0);
 	lua_pushcfunction(gL, LUA_GetErrorMessage);
 
-	lua_getfield(gL, LUA_REGISTRYINDEX, "hooks");
+	lua_rawgeti(gL, LUA_REGISTRYINDEX, hooksref);
 	HOOKSINDEX = lua_gettop(gL);
 	I_Assert(lua_istable(L, HOOKSINDEX));
 
@@ -1731,7 +1710,7 @@ UINT8 LUAh_ShouldExplode(player_t *player, mobj_t *inflictor, mobj_t *source)
 	lua_settop(gL, 0);
 	lua_pushcfunction(gL, LUA_GetErrorMessage);
 
-	lua_getfield(gL, LUA_REGISTRYINDEX, "hooks");
+	lua_rawgeti(gL, LUA_REGISTRYINDEX, hooksref);
 	HOOKSINDEX = lua_gettop(gL);
 	I_Assert(lua_istable(L, HOOKSINDEX));
 
@@ -1786,7 +1765,7 @@ UINT8 LUAh_ShouldSquish(player_t *player, mobj_t *inflictor, mobj_t *source)
 	lua_settop(gL, 0);
 	lua_pushcfunction(gL, LUA_GetErrorMessage);
 
-	lua_getfield(gL, LUA_REGISTRYINDEX, "hooks");
+	lua_rawgeti(gL, LUA_REGISTRYINDEX, hooksref);
 	HOOKSINDEX = lua_gettop(gL);
 	I_Assert(lua_istable(L, HOOKSINDEX));
 
@@ -1841,7 +1820,7 @@ boolean LUAh_PlayerSpin(player_t *player, mobj_t *inflictor, mobj_t *source)
 	lua_settop(gL, 0);
 	lua_pushcfunction(gL, LUA_GetErrorMessage);
 
-	lua_getfield(gL, LUA_REGISTRYINDEX, "hooks");
+	lua_rawgeti(gL, LUA_REGISTRYINDEX, hooksref);
 	HOOKSINDEX = lua_gettop(gL);
 	I_Assert(lua_istable(L, HOOKSINDEX));
 
@@ -1891,7 +1870,7 @@ boolean LUAh_PlayerSquish(player_t *player, mobj_t *inflictor, mobj_t *source)
 	lua_settop(gL, 0);
 	lua_pushcfunction(gL, LUA_GetErrorMessage);
 
-	lua_getfield(gL, LUA_REGISTRYINDEX, "hooks");
+	lua_rawgeti(gL, LUA_REGISTRYINDEX, hooksref);
 	HOOKSINDEX = lua_gettop(gL);
 	I_Assert(lua_istable(L, HOOKSINDEX));
 
@@ -1941,7 +1920,7 @@ boolean LUAh_PlayerExplode(player_t *player, mobj_t *inflictor, mobj_t *source)
 	lua_settop(gL, 0);
 	lua_pushcfunction(gL, LUA_GetErrorMessage);
 
-	lua_getfield(gL, LUA_REGISTRYINDEX, "hooks");
+	lua_rawgeti(gL, LUA_REGISTRYINDEX, hooksref);
 	HOOKSINDEX = lua_gettop(gL);
 	I_Assert(lua_istable(L, HOOKSINDEX));
 
@@ -1989,7 +1968,7 @@ boolean LUAh_KartHyudoro(player_t *player, INT32 *target, boolean sink)
 
 	lua_settop(gL, 0);
 	
-	lua_getfield(gL, LUA_REGISTRYINDEX, "hooks");
+	lua_rawgeti(gL, LUA_REGISTRYINDEX, hooksref);
 	HOOKSINDEX = lua_gettop(gL);
 	I_Assert(lua_istable(L, HOOKSINDEX));
 
@@ -2043,7 +2022,7 @@ boolean LUAh_KartStealBumper(player_t *player, player_t *target, boolean *force)
 
 	lua_settop(gL, 0);
 	
-	lua_getfield(gL, LUA_REGISTRYINDEX, "hooks");
+	lua_rawgeti(gL, LUA_REGISTRYINDEX, hooksref);
 	HOOKSINDEX = lua_gettop(gL);
 	I_Assert(lua_istable(L, HOOKSINDEX));
 
@@ -2094,7 +2073,7 @@ boolean LUAh_KartSneaker(player_t *player, int type)
 
 	lua_settop(gL, 0);
 	
-	lua_getfield(gL, LUA_REGISTRYINDEX, "hooks");
+	lua_rawgeti(gL, LUA_REGISTRYINDEX, hooksref);
 	HOOKSINDEX = lua_gettop(gL);
 	I_Assert(lua_istable(L, HOOKSINDEX));
 
@@ -2142,7 +2121,7 @@ boolean LUAh_PlayerItemUse(player_t *player, kartitems_t itemType, boolean wasHo
 
 	lua_settop(gL, 0);
 	
-	lua_getfield(gL, LUA_REGISTRYINDEX, "hooks");
+	lua_rawgeti(gL, LUA_REGISTRYINDEX, hooksref);
 	HOOKSINDEX = lua_gettop(gL);
 	I_Assert(lua_istable(L, HOOKSINDEX));
 
@@ -2196,54 +2175,52 @@ boolean LUAh_MobjScaleChange(mobj_t *target, fixed_t newscale, fixed_t oldscale)
 
 	lua_settop(gL, 0);
 	
-	lua_getfield(gL, LUA_REGISTRYINDEX, "hooks");
+	lua_rawgeti(gL, LUA_REGISTRYINDEX, hooksref);
 	HOOKSINDEX = lua_gettop(gL);
 	I_Assert(lua_istable(L, HOOKSINDEX));
 
 	// Look for all generic mobj death hooks
-	for (hookp = mobjhooks[MT_NULL]; hookp; hookp = hookp->next)
-		if (hookp->type == hook_MobjScaleChange)
-		{
-			lua_rawgeti(gL, HOOKSINDEX, hookp->id);
-
-			LUA_PushUserdata(gL, target, META_MOBJ);
-			lua_pushfixed(gL, newscale);
-			lua_pushfixed(gL, oldscale);
+	for (hookp = mobjhooks[hook_MobjScaleChange][MT_NULL]; hookp; hookp = hookp->next)
+	{
+		lua_rawgeti(gL, HOOKSINDEX, hookp->id);
 
-			if (lua_pcall(gL, 3, 1, 0)) {
-				if (!hookp->error || cv_debug & DBG_LUA)
-					CONS_Alert(CONS_WARNING,"%s\n",lua_tostring(gL, -1));
-				lua_pop(gL, 1);
-				hookp->error = true;
-				continue;
-			}
-			if (lua_toboolean(gL, -1))
-				hooked = true;
+		LUA_PushUserdata(gL, target, META_MOBJ);
+		lua_pushfixed(gL, newscale);
+		lua_pushfixed(gL, oldscale);
 
+		if (lua_pcall(gL, 3, 1, 0)) {
+			if (!hookp->error || cv_debug & DBG_LUA)
+				CONS_Alert(CONS_WARNING,"%s\n",lua_tostring(gL, -1));
 			lua_pop(gL, 1);
+			hookp->error = true;
+			continue;
 		}
+		if (lua_toboolean(gL, -1))
+			hooked = true;
 
-	for (hookp = mobjhooks[target->type]; hookp; hookp = hookp->next)
-		if (hookp->type == hook_MobjScaleChange)
-		{
-			lua_rawgeti(gL, HOOKSINDEX, hookp->id);
+		lua_pop(gL, 1);
+	}
 
-			LUA_PushUserdata(gL, target, META_MOBJ);
-			lua_pushfixed(gL, newscale);
-			lua_pushfixed(gL, oldscale);
+	for (hookp = mobjhooks[hook_MobjScaleChange][target->type]; hookp; hookp = hookp->next)
+	{
+		lua_rawgeti(gL, HOOKSINDEX, hookp->id);
 
-			if (lua_pcall(gL, 3, 1, 0)) {
-				if (!hookp->error || cv_debug & DBG_LUA)
-					CONS_Alert(CONS_WARNING,"%s\n",lua_tostring(gL, -1));
-				lua_pop(gL, 1);
-				hookp->error = true;
-				continue;
-			}
-			if (lua_toboolean(gL, -1))
-				hooked = true;
+		LUA_PushUserdata(gL, target, META_MOBJ);
+		lua_pushfixed(gL, newscale);
+		lua_pushfixed(gL, oldscale);
 
+		if (lua_pcall(gL, 3, 1, 0)) {
+			if (!hookp->error || cv_debug & DBG_LUA)
+				CONS_Alert(CONS_WARNING,"%s\n",lua_tostring(gL, -1));
 			lua_pop(gL, 1);
+			hookp->error = true;
+			continue;
 		}
+		if (lua_toboolean(gL, -1))
+			hooked = true;
+
+		lua_pop(gL, 1);
+	}
 
 	lua_settop(gL, 0);
 	return hooked;
@@ -2259,7 +2236,7 @@ void LUAh_ServerJoin(void)
 	lua_settop(gL, 0);
 	lua_pushcfunction(gL, LUA_GetErrorMessage);
 
-	lua_getfield(gL, LUA_REGISTRYINDEX, "hooks");
+	lua_rawgeti(gL, LUA_REGISTRYINDEX, hooksref);
 	HOOKSINDEX = lua_gettop(gL);
 	I_Assert(lua_istable(L, HOOKSINDEX));
 
@@ -569,15 +569,9 @@ static int player_get(lua_State *L)
     lua_pushvalue(L, 2); // Push field name
     lua_rawget(L, -2); // Get getter/setter table from metatable
 
-    // If field exists, run getter for it
-    if (!lua_isnil(L, -1)) {
-        //CONS_Printf("Running getter for field %s\n", field);
-        lua_rawgeti(L, -1, UDATALIB_GETTER);
-        lua_pushlightuserdata(L, plr);
-        lua_call(L, 1, 1);
-        //CONS_Printf("Getter returned %s\n", lua_typename(L, lua_type(L, -1)));
-        return 1;
-    }
+    // If field exists, read it
+    if (!lua_isnil(L, -1))
+        return udatalib_getfield(L, -1, plr);
 
     lua_pop(L, 1);
 
@@ -616,13 +610,9 @@ static int player_set(lua_State *L)
     lua_pushvalue(L, 2); // Push field name
     lua_rawget(L, -2); // Get getter/setter table from metatable
 
-    // If field exists, run setter for it
+    // If field exists, write it
     if (!lua_isnil(L, -1)) {
-        //CONS_Printf("Running setter for field %s\n", luaL_checkstring(L, 2));
-        lua_rawgeti(L, -1, UDATALIB_SETTER);
-        lua_pushlightuserdata(L, plr);
-        lua_pushvalue(L, 3);
-        lua_call(L, 2, 0);
+        udatalib_setfield(L, -1, plr, 3);
         return 0;
     }
 
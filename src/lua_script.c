@@ -24,6 +24,7 @@
 #include "p_slopes.h" // for P_SlopeById
 #include "s_sound.h"
 #include "m_menu.h"
+#include "i_system.h" // I_GetPreciseTime for LUA_Benchmark
 #ifdef LUA_ALLOW_BYTECODE
 #include "d_netfil.h" // for LUA_DumpFile
 #endif
@@ -31,6 +32,7 @@
 #include "lua_script.h"
 #include "lua_libs.h"
 #include "lua_glib.h"
+#include "lua_alloc.h"
 #include "lua_hook.h"
 
 #include "doomstat.h"
@@ -62,7 +64,8 @@ static lua_CFunction liblist[] = {
 	NULL
 };
 
-// Lua asks for memory using this.
+// The math state asks for memory using this,
+// the main state uses LUA_HeapAlloc in lua_alloc.c.
 static void *LUA_Alloc(void *ud, void *ptr, size_t osize, size_t nsize)
 {
 	(void)ud;
@@ -197,11 +200,12 @@ void LUA_ClearState(void)
 	if (gL)
 		lua_close(gL);
 	gL = NULL;
+	LUA_ClearHeap();
 
 	CONS_Printf(M_GetText("Pardon me while I initialize the Lua scripting interface...\n"));
 
 	// allocate state
-	L = lua_newstate(LUA_Alloc, NULL);
+	L = lua_newstate(LUA_HeapAlloc, NULL);
 	lua_atpanic(L, LUA_Panic);
 
 	// open base libraries
@@ -367,6 +371,79 @@ void LUA_DumpFile(const char *filename)
 }
 #endif
 
+// Field access micro-benchmarks for the benchlua command.
+// Each test is {name, field accesses per iteration, function(mo, iterations)}.
+// Writes only ever put back the value that was already there.
+static const char luabenchscript[] =
+	"local tests = {\n"
+	"	{\"read x, y, z\", 3, function(mo, n) local s = 0 for i = 1, n do s = s + mo.x + mo.y + mo.z end return s end},\n"
+	"	{\"read momx, momy, momz\", 3, function(mo, n) local s = 0 for i = 1, n do s = s + mo.momx + mo.momy + mo.momz end return s end},\n"
+	"	{\"read angle, flags, type\", 3, function(mo, n) local s = 0 for i = 1, n do s = s + mo.angle + mo.flags + mo.type end return s end},\n"
+	"	{\"read player, subsector\", 2, function(mo, n) local a, b for i = 1, n do a, b = mo.player, mo.subsector end end},\n"
+	"	{\"write momx, momy, momz\", 3, function(mo, n) local x, y, z = mo.momx, mo.momy, mo.momz for i = 1, n do mo.momx = x mo.momy = y mo.momz = z end end},\n"
+	"	{\"read target (custom getter)\", 1, function(mo, n) local t for i = 1, n do t = mo.target end end},\n"
+	"	{\"write scale (custom setter)\", 1, function(mo, n) local s = mo.scale for i = 1, n do mo.scale = s end end},\n"
+	"	{\"read player.speed, player.flashing\", 2, function(mo, n) local p, s = mo.player, 0 if not p then return end for i = 1, n do s = s + p.speed + p.flashing end end},\n"
+	"	{\"read custom Lua field\", 1, function(mo, n) local s = 0 mo.luabenchfield = 1 for i = 1, n do s = s + mo.luabenchfield end mo.luabenchfield = nil end},\n"
+	"}\n"
+	"return tests\n";
+
+//
+// LUA_Benchmark
+// Times userdata field access on mo, for the benchlua command.
+//
+void LUA_Benchmark(mobj_t *mo, INT32 iterations)
+{
+	const double precision = I_GetPrecisePrecision();
+	precise_t start, time;
+	int i, n;
+
+	if (!gL)
+		return;
+
+	lua_settop(gL, 0);
+	lua_pushcfunction(gL, LUA_GetErrorMessage);
+
+	if (luaL_loadbuffer(gL, luabenchscript, sizeof luabenchscript - 1, "=benchlua")
+		|| LUA_Call(gL, 0, 1, 1))
+	{
+		lua_settop(gL, 0);
+		return;
+	}
+
+	CONS_Printf("%d iterations per test\n", iterations);
+
+	n = (int)lua_objlen(gL, 2);
+	for (i = 1; i <= n; i++)
+	{
+		const char *name;
+		int accesses;
+
+		lua_rawgeti(gL, 2, i);
+		lua_rawgeti(gL, -1, 1);
+		name = lua_tostring(gL, -1);
+		lua_rawgeti(gL, -2, 2);
+		accesses = (int)lua_tointeger(gL, -1);
+		lua_rawgeti(gL, -3, 3);
+		LUA_PushUserdata(gL, mo, META_MOBJ);
+		lua_pushinteger(gL, iterations);
+
+		start = I_GetPreciseTime();
+		if (LUA_Call(gL, 2, 0, 1))
+			break;
+		time = I_GetPreciseTime() - start;
+
+		CONS_Printf("%-36s %8.3f ms, %6.1f ns per access\n", name,
+			time * 1000.0 / precision,
+			time * 1000000000.0 / precision / ((double)iterations * accesses));
+
+		lua_settop(gL, 2);
+	}
+
+	lua_settop(gL, 0);
+	lua_gc(gL, LUA_GCSTEP, 0);
+}
+
 fixed_t LUA_EvalMath(const char *word)
 {
 	char buf[1024], *b;
@@ -428,18 +505,55 @@ void LUA_InvalidateMathlibCache(const char *name)
 	lua_call(mL, 1, 0);
 }
 
+// What every userdata made by LUA_PushUserdata holds.
+// The pointer has to come first, the libs cast the userdata to a pointer to pointer.
+typedef struct
+{
+	void *data;
+	INT32 ref; // registry reference kept in the object's luaref, 0 if it has none
+} luahandle_t;
+
+// Mobjs, sectors and lines remember the registry reference of their userdata,
+// so pushing them again is an array lookup instead of a hash lookup, and
+// freeing one Lua never saw doesn't have to ask Lua about it.
+static INT32 *LUA_HandleSlot(void *data, const char *meta)
+{
+	if (fastcmp(meta, META_MOBJ))
+		return &((thinker_t *)data)->luaref;
+	if (fastcmp(meta, META_SECTOR))
+		return &((sector_t *)data)->luaref;
+	if (fastcmp(meta, META_LINE))
+		return &((line_t *)data)->luaref;
+	return NULL;
+}
+
 // Takes a pointer, any pointer, and a metatable name
 // Creates a userdata for that pointer with the given metatable
 // Pushes it to the stack and stores it in the registry.
 void LUA_PushUserdata(lua_State *L, void *data, const char *meta)
 {
-	void **userdata;
+	luahandle_t *userdata;
+	INT32 *slot;
 
 	if (!data) { // push a NULL
 		lua_pushnil(L);
 		return;
 	}
 
+	slot = LUA_HandleSlot(data, meta);
+	if (slot && *slot > 0)
+	{
+		lua_rawgeti(L, LUA_REGISTRYINDEX, *slot);
+		userdata = lua_touserdata(L, -1);
+
+		// The reference can be stale if the object was never cleared, so make sure it's ours
+		if (userdata && lua_objlen(L, -1) == sizeof (luahandle_t) && userdata->data == data)
+			return;
+
+		lua_pop(L, 1);
+		*slot = 0;
+	}
+
 	lua_getfield(L, LUA_REGISTRYINDEX, LREG_VALID);
 	I_Assert(lua_istable(L, -1));
 	lua_pushlightuserdata(L, data);
@@ -448,8 +562,9 @@ void LUA_PushUserdata(lua_State *L, void *data, const char *meta)
 		lua_pop(L, 1); // pop the nil
 
 		// create the userdata
-		userdata = lua_newuserdata(L, sizeof(void *));
-		*userdata = data;
+		userdata = lua_newuserdata(L, sizeof(luahandle_t));
+		userdata->data = data;
+		userdata->ref = 0;
 		luaL_getmetatable(L, meta);
 		lua_setmetatable(L, -2);
 
@@ -460,13 +575,25 @@ void LUA_PushUserdata(lua_State *L, void *data, const char *meta)
 
 		// stack is left with the userdata on top, as if getting it had originally succeeded.
 	}
+
+	if (slot)
+	{
+		userdata = lua_touserdata(L, -1);
+		if (!userdata->ref)
+		{
+			lua_pushvalue(L, -1);
+			userdata->ref = luaL_ref(L, LUA_REGISTRYINDEX);
+		}
+		*slot = userdata->ref;
+	}
+
 	lua_remove(L, -2); // remove LREG_VALID
 }
 
 // When userdata is freed, use this function to remove it from Lua.
 void LUA_InvalidateUserdata(void *data)
 {
-	void **userdata;
+	luahandle_t *userdata;
 	if (!gL)
 		return;
 
@@ -490,7 +617,12 @@ void LUA_InvalidateUserdata(void *data)
 
 			// invalidate the userdata
 			userdata = lua_touserdata(gL, -1);
-			*userdata = NULL;
+			userdata->data = NULL;
+			if (userdata->ref)
+			{
+				luaL_unref(gL, LUA_REGISTRYINDEX, userdata->ref);
+				userdata->ref = 0;
+			}
 		lua_pop(gL, 1);
 
 		// remove it from the registry
@@ -509,17 +641,20 @@ void LUA_InvalidateLevel(void)
 		return;
 
 	for (th = thinkercap.next; th && th != &thinkercap; th = th->next)
-		LUA_InvalidateUserdata(th);
+		if (th->luaref)
+			LUA_InvalidateUserdata(th);
 
 	LUA_InvalidateMapthings();
 
 	for (i = 0; i < numsubsectors; i++)
 		LUA_InvalidateUserdata(&subsectors[i]);
 	for (i = 0; i < numsectors; i++)
-		LUA_InvalidateUserdata(&sectors[i]);
+		if (sectors[i].luaref)
+			LUA_InvalidateUserdata(&sectors[i]);
 	for (i = 0; i < numlines; i++)
 	{
-		LUA_InvalidateUserdata(&lines[i]);
+		if (lines[i].luaref)
+			LUA_InvalidateUserdata(&lines[i]);
 		LUA_InvalidateUserdata(lines[i].sidenum);
 	}
 	for (i = 0; i < numsides; i++)
@@ -1304,7 +1439,7 @@ void LUA_Archive(savebuffer_t *save, boolean network)
 	{
 		if (gamestate == GS_LEVEL)
 		{
-			for (th = thinkercap.next; th != &thinkercap; th = th->next)
+			for (th = thlist[THINK_MOBJ].cnext; th != &thlist[THINK_MOBJ]; th = th->cnext)
 			{
 				if (th->function.acp1 != (actionf_p1)P_MobjThinker)
 					continue;
@@ -1346,7 +1481,7 @@ void LUA_UnArchive(savebuffer_t *save, boolean network)
 	{
 		do {
 			mobjnum = READUINT32(save->p); // read a mobjnum
-			for (th = thinkercap.next; th != &thinkercap; th = th->next)
+			for (th = thlist[THINK_MOBJ].cnext; th != &thlist[THINK_MOBJ]; th = th->cnext)
 			{
 				if (th->function.acp1 != (actionf_p1)P_MobjThinker)
 					continue;
@@ -46,6 +46,7 @@ void LUA_LoadLump(UINT16 wad, UINT16 lump);
 void LUA_DumpFile(const char *filename);
 #endif
 fixed_t LUA_EvalMath(const char *word);
+void LUA_Benchmark(mobj_t *mo, INT32 iterations);
 
 // Need better name for this ;-;
 void LUA_InvalidateMathlibCache(const char *name);
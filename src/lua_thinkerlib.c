@@ -27,11 +27,28 @@ static const actionf_p1 iter_funcs[] = {
 	(actionf_p1)P_MobjThinker
 };
 
+// Which list each option walks; NUM_THINKERLISTS is the main list.
+static const thinklistnum_t iter_lists[] = {
+	NUM_THINKERLISTS,
+	THINK_MOBJ
+};
+
 struct iterationState {
 	actionf_p1 filter;
+	thinklistnum_t list;
 	int next;
 };
 
+static inline thinker_t *iterationHead(const struct iterationState *it)
+{
+	return (it->list == NUM_THINKERLISTS) ? &thinkercap : &thlist[it->list];
+}
+
+static inline thinker_t *iterationNext(const struct iterationState *it, thinker_t *th)
+{
+	return (it->list == NUM_THINKERLISTS) ? th->next : th->cnext;
+}
+
 static int iterationState_gc(lua_State *L)
 {
 	struct iterationState *it = luaL_checkudata(L, -1, META_ITERATIONSTATE);
@@ -52,12 +69,14 @@ static int iterationState_gc(lua_State *L)
 
 static int lib_iterateThinkers(lua_State *L)
 {
-	thinker_t *th = NULL, *next = NULL;
+	thinker_t *th = NULL, *next = NULL, *head;
 	struct iterationState *it = luaL_checkudata(L, 1, META_ITERATIONSTATE);
 	lua_settop(L, 2);
 
+	head = iterationHead(it);
+
 	if (lua_isnil(L, 2))
-		th = &thinkercap;
+		th = head;
 	else if (lua_isuserdata(L, 2))
 	{
 		if (lua_islightuserdata(L, 2))
@@ -83,17 +102,18 @@ static int lib_iterateThinkers(lua_State *L)
 	it->next = LUA_REFNIL;
 
 	if (th && !next)
-		next = th->next;
+		next = iterationNext(it, th);
 	if (!next)
 		return luaL_error(L, "next thinker invalidated during iteration");
 
-	for (; next != &thinkercap; next = next->next)
+	for (; next != head; next = iterationNext(it, next))
 		if (!it->filter || next->function.acp1 == it->filter)
 		{
+			thinker_t *after = iterationNext(it, next);
 			push_thinker(next);
-			if (next->next != &thinkercap)
+			if (after != head)
 			{
-				push_thinker(next->next);
+				push_thinker(after);
 				it->next = luaL_ref(L, LUA_REGISTRYINDEX);
 			}
 			return 1;
@@ -104,13 +124,15 @@ static int lib_iterateThinkers(lua_State *L)
 static int lib_startIterate(lua_State *L)
 {
 	struct iterationState *it;
+	int option = luaL_checkoption(L, 1, "mobj", iter_opt);
 
 	lua_pushvalue(L, lua_upvalueindex(1));
 	it = lua_newuserdata(L, sizeof(struct iterationState));
 	luaL_getmetatable(L, META_ITERATIONSTATE);
 	lua_setmetatable(L, -2);
 
-	it->filter = iter_funcs[luaL_checkoption(L, 1, "mobj", iter_opt)];
+	it->filter = iter_funcs[option];
+	it->list = iter_lists[option];
 	it->next = LUA_REFNIL;
 	return 2;
 }
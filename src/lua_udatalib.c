@@ -93,9 +93,90 @@ int udatalib_setter_tic(lua_State *L)
 UDATALIB_SIMPLE_SETTER(tic_t, (tic_t)luaL_checkinteger)
 
 
+// Simple getters and setters udatalib_getfield and udatalib_setfield
+// can do inline instead of calling them.
+// Enums are only read inline when the compiler made them int sized.
+#define ENUM_KIND(type) (sizeof (type) == sizeof (INT32) ? UDATA_INT32 : UDATA_CUSTOM)
+
+static const struct {
+    lua_CFunction getter;
+    udata_kind_t kind;
+    const char *meta;
+} simple_getters[] = {
+    {udatalib_getter_fixed,       UDATA_INT32,   NULL},
+    {udatalib_getter_angle,       UDATA_UINT32,  NULL},
+    {udatalib_getter_uint8,       UDATA_UINT8,   NULL},
+    {udatalib_getter_sint8,       UDATA_SINT8,   NULL},
+    {udatalib_getter_uint16,      UDATA_UINT16,  NULL},
+    {udatalib_getter_int16,       UDATA_INT16,   NULL},
+    {udatalib_getter_uint32,      UDATA_UINT32,  NULL},
+    {udatalib_getter_int32,       UDATA_INT32,   NULL},
+    {udatalib_getter_uint64,      UDATA_UINT64,  NULL},
+    {udatalib_getter_int64,       UDATA_INT64,   NULL},
+    {udatalib_getter_boolean,     UDATA_BOOLEAN, NULL},
+    {udatalib_getter_tic,         UDATA_UINT32,  NULL},
+    {udatalib_getter_spritenum,   ENUM_KIND(spritenum_t),   NULL},
+    {udatalib_getter_mobjtype,    ENUM_KIND(mobjtype_t),    NULL},
+    {udatalib_getter_playerstate, ENUM_KIND(playerstate_t), NULL},
+    {udatalib_getter_panim,       ENUM_KIND(panim_t),       NULL},
+    {udatalib_getter_mobj,        UDATA_USERDATA, META_MOBJ},
+    {udatalib_getter_player,      UDATA_USERDATA, META_PLAYER},
+    {udatalib_getter_mapthing,    UDATA_USERDATA, META_MAPTHING},
+    {udatalib_getter_subsector,   UDATA_USERDATA, META_SUBSECTOR},
+    {udatalib_getter_slope,       UDATA_USERDATA, META_SLOPE},
+    {NULL, UDATA_CUSTOM, NULL}
+};
+
+static const struct {
+    lua_CFunction setter;
+    udata_kind_t kind;
+} simple_setters[] = {
+    {udatalib_setter_fixed,           UDATA_INT32},
+    {udatalib_setter_angle,           UDATA_UINT32},
+    {udatalib_setter_uint8,           UDATA_UINT8},
+    {udatalib_setter_sint8,           UDATA_SINT8},
+    {udatalib_setter_uint16,          UDATA_UINT16},
+    {udatalib_setter_int16,           UDATA_INT16},
+    {udatalib_setter_uint32,          UDATA_UINT32},
+    {udatalib_setter_int32,           UDATA_INT32},
+    {udatalib_setter_uint64,          UDATA_UINT64},
+    {udatalib_setter_int64,           UDATA_INT64},
+    {udatalib_setter_boolean,         UDATA_BOOLEAN},
+    {udatalib_setter_boolean_nocheck, UDATA_ANYBOOLEAN},
+    {udatalib_setter_tic,             UDATA_UINT32},
+    {udatalib_setter_spritenum,       ENUM_KIND(spritenum_t)},
+    {udatalib_setter_playerstate,     ENUM_KIND(playerstate_t)},
+    {udatalib_setter_panim,           ENUM_KIND(panim_t)},
+    {NULL, UDATA_CUSTOM}
+};
+
+#undef ENUM_KIND
+
 void udatalib_addfield(lua_State *L, int mt, udata_field_t field)
 {
     int idx = abs_index(L, mt);
+    udata_desc_t *desc;
+    unsigned i;
+
+    desc = lua_newuserdata(L, sizeof (*desc)); // Push descriptor
+    desc->offset = field.offset;
+    desc->getkind = desc->setkind = UDATA_CUSTOM;
+    desc->meta = NULL;
+
+    for (i = 0; simple_getters[i].getter; ++i)
+        if (simple_getters[i].getter == field.getter)
+        {
+            desc->getkind = simple_getters[i].kind;
+            desc->meta = simple_getters[i].meta;
+            break;
+        }
+
+    for (i = 0; simple_setters[i].setter; ++i)
+        if (simple_setters[i].setter == field.setter)
+        {
+            desc->setkind = simple_setters[i].kind;
+            break;
+        }
 
     lua_createtable(L, 2, 0); // Push table
 
@@ -109,11 +190,13 @@ void udatalib_addfield(lua_State *L, int mt, udata_field_t field)
 
     lua_rawseti(L, -2, UDATALIB_SETTER); // Pop closure, add to table
 
+    lua_setfenv(L, -2); // Pop table, use it as the descriptor's environment
+
     lua_pushstring(L, field.name); // Push field name
-    lua_pushvalue(L, -2); // Copy table
-    lua_rawset(L, idx); // Pop field name and table, add to metatable
+    lua_pushvalue(L, -2); // Copy descriptor
+    lua_rawset(L, idx); // Pop field name and descriptor, add to metatable
 
-    lua_pop(L, 1); // Pop field table
+    lua_pop(L, 1); // Pop descriptor
 }
 
 void udatalib_addfields(lua_State *L, int mt, const udata_field_t fields[])
@@ -124,3 +207,64 @@ void udatalib_addfields(lua_State *L, int mt, const udata_field_t fields[])
         //CONS_Printf("Add field name=%s, offset=%d, getter=%p, setter=%p\n", fields[i].name, fields[i].offset, fields[i].getter, fields[i].setter);
     }
 }
+
+int udatalib_getfield(lua_State *L, int desc, void *obj)
+{
+    const udata_desc_t *d = lua_touserdata(L, desc);
+    void *p = (UINT8 *)obj + d->offset;
+
+    switch (d->getkind)
+    {
+        case UDATA_SINT8:    lua_pushinteger(L, *(SINT8 *)p); return 1;
+        case UDATA_UINT8:    lua_pushinteger(L, *(UINT8 *)p); return 1;
+        case UDATA_INT16:    lua_pushinteger(L, *(INT16 *)p); return 1;
+        case UDATA_UINT16:   lua_pushinteger(L, *(UINT16 *)p); return 1;
+        case UDATA_INT32:    lua_pushinteger(L, *(INT32 *)p); return 1;
+        case UDATA_UINT32:   lua_pushinteger(L, *(UINT32 *)p); return 1;
+        case UDATA_INT64:    lua_pushinteger(L, *(INT64 *)p); return 1;
+        case UDATA_UINT64:   lua_pushinteger(L, *(UINT64 *)p); return 1;
+        case UDATA_BOOLEAN:  lua_pushboolean(L, *(boolean *)p); return 1;
+        case UDATA_USERDATA: LUA_PushUserdata(L, *(void **)p, d->meta); return 1;
+        default: break;
+    }
+
+    // Custom getter, call it like before
+    desc = abs_index(L, desc);
+    lua_getfenv(L, desc);
+    lua_rawgeti(L, -1, UDATALIB_GETTER);
+    lua_pushlightuserdata(L, obj);
+    lua_call(L, 1, 1);
+    return 1;
+}
+
+void udatalib_setfield(lua_State *L, int desc, void *obj, int value)
+{
+    const udata_desc_t *d = lua_touserdata(L, desc);
+    void *p = (UINT8 *)obj + d->offset;
+
+    desc = abs_index(L, desc);
+    value = abs_index(L, value);
+
+    switch (d->setkind)
+    {
+        case UDATA_SINT8:      *(SINT8 *)p = (SINT8)luaL_checkinteger(L, value); return;
+        case UDATA_UINT8:      *(UINT8 *)p = (UINT8)luaL_checkinteger(L, value); return;
+        case UDATA_INT16:      *(INT16 *)p = (INT16)luaL_checkinteger(L, value); return;
+        case UDATA_UINT16:     *(UINT16 *)p = (UINT16)luaL_checkinteger(L, value); return;
+        case UDATA_INT32:      *(INT32 *)p = (INT32)luaL_checkinteger(L, value); return;
+        case UDATA_UINT32:     *(UINT32 *)p = (UINT32)luaL_checkinteger(L, value); return;
+        case UDATA_INT64:      *(INT64 *)p = (INT64)luaL_checkinteger(L, value); return;
+        case UDATA_UINT64:     *(UINT64 *)p = (UINT64)luaL_checkinteger(L, value); return;
+        case UDATA_BOOLEAN:    *(boolean *)p = luaL_checkboolean(L, value); return;
+        case UDATA_ANYBOOLEAN: *(boolean *)p = lua_toboolean(L, value); return;
+        default: break;
+    }
+
+    // Custom setter, call it like before
+    lua_getfenv(L, desc);
+    lua_rawgeti(L, -1, UDATALIB_SETTER);
+    lua_pushlightuserdata(L, obj);
+    lua_pushvalue(L, value);
+    lua_call(L, 2, 0);
+    lua_pop(L, 1); // Pop environment
+}
@@ -17,6 +17,34 @@ typedef struct udata_field_s {
     lua_CFunction setter;
 } udata_field_t;
 
+// What udatalib_getfield and udatalib_setfield can read or write inline,
+// without calling the getter or setter closure.
+// udatalib_addfield works it out from the simple getters and setters below,
+// everything else is UDATA_CUSTOM.
+typedef enum {
+    UDATA_CUSTOM = 0,
+    UDATA_SINT8,
+    UDATA_UINT8,
+    UDATA_INT16,
+    UDATA_UINT16,
+    UDATA_INT32,
+    UDATA_UINT32,
+    UDATA_INT64,
+    UDATA_UINT64,
+    UDATA_BOOLEAN,
+    UDATA_ANYBOOLEAN, // setter takes any value, like lua_toboolean
+    UDATA_USERDATA, // pointer pushed with LUA_PushUserdata, getter only
+} udata_kind_t;
+
+// Field descriptor udatalib_addfield stores in the metatable under the field's name,
+// as a full userdata whose environment table holds the getter and setter closures.
+typedef struct udata_desc_s {
+    size_t offset;
+    udata_kind_t getkind;
+    udata_kind_t setkind;
+    const char *meta; // metatable name for UDATA_USERDATA
+} udata_desc_t;
+
 // Simple setters and getters, for situations where getter is simply
 // "return obj.field" and setter is "obj.field = value"
 int udatalib_getter_fixed(lua_State *L);
@@ -73,6 +101,14 @@ void udatalib_addfield(lua_State *L, int mt, udata_field_t field);
 // Convinience function to add array of fields at once.
 void udatalib_addfields(lua_State *L, int mt, const udata_field_t fields[]);
 
+// Pushes the value of the field described by the descriptor at index desc.
+// Simple fields are read straight from obj, custom ones call the getter.
+int udatalib_getfield(lua_State *L, int desc, void *obj);
+
+// Sets the field described by the descriptor at index desc to the value at
+// index value. Simple fields are written straight to obj, custom ones call the setter.
+void udatalib_setfield(lua_State *L, int desc, void *obj, int value);
+
 // I miss C++ template functons :(
 
 // Get pointer to field value within getter or setter
@@ -32,10 +32,13 @@ consvar_t cv_gif_downscale =  {"gif_downscale", "On", CV_SAVE, CV_OnOff, NULL, 0
 #ifdef HAVE_ANIGIF
 static boolean gif_optimize = false; // So nobody can do something dumb
 static boolean gif_downscale = false; // like changing cvars mid output
+static INT32 gif_width, gif_height; // the screen size when the file was opened
 
 static FILE *gif_out = NULL;
 static INT32 gif_frames = 0;
+static tic_t gif_time = 0; // tics written so far, for the frame delays
 static UINT8 gif_writeover = 0;
+static UINT8 *gif_lastframe = NULL; // what the last frame left on screen, for optimizing
 
 
 // OPTIMIZE gif output
@@ -51,13 +54,13 @@ static UINT8 gif_writeover = 0;
 static UINT8 GIF_optimizecmprow(const UINT8 *dst, const UINT8 *src, INT32 row,
 	INT32 *last, INT32 *left, INT32 *right)
 {
-	const UINT8 *dp = dst + (vid.width * row);
-	const UINT8 *sp = src + (vid.width * row);
+	const UINT8 *dp = dst + (gif_width * row);
+	const UINT8 *sp = src + (gif_width * row);
 	const UINT8 *dtmp, *stmp;
 	UINT8 doleft = 1, doright = 1;
 	INT32 i = 0;
 
-	if (!memcmp(sp, dp, vid.width))
+	if (!memcmp(sp, dp, gif_width))
 		return 0; // unchanged.
 
 	*last = row;
@@ -84,14 +87,14 @@ static UINT8 GIF_optimizecmprow(const UINT8 *dst, const UINT8 *src, INT32 row,
 	}
 
 	// right side
-	i = vid.width - 1;
-	if (*right == vid.width - 1) // edge reached
+	i = gif_width - 1;
+	if (*right == gif_width - 1) // edge reached
 		doright = 0;
 	else if (*right >= 0) // right set, non-end-of-width
 	{
 		dtmp = dp + *right + 1;
 		stmp = sp + *right + 1;
-		if (!memcmp(stmp, dtmp, vid.width - (*right + 1)))
+		if (!memcmp(stmp, dtmp, gif_width - (*right + 1)))
 			doright = 0; // right side not changed
 	}
 	while (doright)
@@ -121,7 +124,7 @@ static UINT8 GIF_optimizecmprow(const UINT8 *dst, const UINT8 *src, INT32 row,
 static void GIF_optimizeregion(const UINT8 *dst, const UINT8 *src,
 	INT32 *x, INT32 *y, INT32 *w, INT32 *h)
 {
-	INT32 st = 0, sb = vid.height - 1; // work from both directions
+	INT32 st = 0, sb = gif_height - 1; // work from both directions
 	INT32 firstchg_t = -1, firstchg_b = -1; // store first changed row.
 	INT32 lastchg_t = -1, lastchg_b = -1; // Store last row... just in case
 	INT32 lmpix = -1, rmpix = -1; // store left and rightmost change
@@ -132,7 +135,7 @@ static void GIF_optimizeregion(const UINT8 *dst, const UINT8 *src,
 		if (!stopt)
 		{
 			if (GIF_optimizecmprow(dst, src, st++, &lastchg_t, &lmpix, &rmpix)
-			 && lmpix == 0 && rmpix == vid.width - 1)
+			 && lmpix == 0 && rmpix == gif_width - 1)
 				stopt = 1;
 			if (firstchg_t < 0 && lastchg_t >= 0)
 				firstchg_t = lastchg_t;
@@ -140,7 +143,7 @@ static void GIF_optimizeregion(const UINT8 *dst, const UINT8 *src,
 		if (!stopb)
 		{
 			if (GIF_optimizecmprow(dst, src, sb--, &lastchg_b, &lmpix, &rmpix)
-			 && lmpix == 0 && rmpix == vid.width - 1)
+			 && lmpix == 0 && rmpix == gif_width - 1)
 				stopb = 1;
 			if (firstchg_b < 0 && lastchg_b >= 0)
 				firstchg_b = lastchg_b;
@@ -214,10 +217,10 @@ static void GIF_bwrwrite(UINT32 idata)
 
 // SCReen BUFfer (obviously)
 // ---
-static UINT8 *scrbuf_pos;
-static UINT8 *scrbuf_linebegin;
-static UINT8 *scrbuf_lineend;
-static UINT8 *scrbuf_writeend;
+static const UINT8 *scrbuf_pos;
+static const UINT8 *scrbuf_linebegin;
+static const UINT8 *scrbuf_lineend;
+static const UINT8 *scrbuf_writeend;
 static INT16 scrbuf_downscaleamt = 1;
 
 
@@ -242,8 +245,6 @@ static void GIF_prepareLZW(void)
 	gifbwr_bits_min = 9;
 	giflzw_nextCodeToAssign = GIFLZW_DICTSTART;
 
-	if (!giflzw_hashTable)
-		giflzw_hashTable = Z_Malloc(16384*sizeof(UINT32), PU_STATIC, NULL);
 	memset(giflzw_hashTable, 0, 16384*sizeof(UINT32));
 }
 
@@ -349,8 +350,8 @@ static void GIF_lzw(void)
 		}
 		if ((scrbuf_pos += scrbuf_downscaleamt) >= scrbuf_lineend)
 		{
-			scrbuf_lineend += (vid.width * scrbuf_downscaleamt);
-			scrbuf_linebegin += (vid.width * scrbuf_downscaleamt);
+			scrbuf_lineend += (gif_width * scrbuf_downscaleamt);
+			scrbuf_linebegin += (gif_width * scrbuf_downscaleamt);
 			scrbuf_pos = scrbuf_linebegin;
 		}
 		// Just a bit of overflow prevention
@@ -412,14 +413,14 @@ static void GIF_headwrite(void)
 	if (gif_downscale)
 	{
 		scrbuf_downscaleamt = vid.dupx;
-		rwidth = (vid.width / scrbuf_downscaleamt);
-		rheight = (vid.height / scrbuf_downscaleamt);
+		rwidth = (gif_width / scrbuf_downscaleamt);
+		rheight = (gif_height / scrbuf_downscaleamt);
 	}
 	else
 	{
 		scrbuf_downscaleamt = 1;
-		rwidth = vid.width;
-		rheight = vid.height;
+		rwidth = gif_width;
+		rheight = gif_height;
 	}
 	WRITEUINT16(p, rwidth);
 	WRITEUINT16(p, rheight);
@@ -453,7 +454,7 @@ static void GIF_headwrite(void)
 const UINT8 gifframe_gchead[4] = {0x21,0xF9,0x04,0x04}; // GCE, bytes, packed byte (no trans = 0 | no input = 0 | don't remove = 4)
 
 static UINT8 *gifframe_data = NULL;
-static size_t gifframe_size = 8192;
+static size_t gifframe_size = 0;
 
 
 //
@@ -469,11 +470,11 @@ static void GIF_rgbconvert(UINT8 *linear, UINT8 *scr)
 
 	InitColorLUT();
 
-	for (x = 0; x < vid.width; x += scrbuf_downscaleamt)
+	for (x = 0; x < gif_width; x += scrbuf_downscaleamt)
 	{
-		for (y = 0; y < vid.height; y += scrbuf_downscaleamt)
+		for (y = 0; y < gif_height; y += scrbuf_downscaleamt)
 		{
-			dest = y*vid.width + x;
+			dest = y*gif_width + x;
 			src = dest*3;
 
 			r = (UINT8)linear[src];
@@ -488,67 +489,33 @@ static void GIF_rgbconvert(UINT8 *linear, UINT8 *scr)
 //
 // GIF_framewrite
 // writes a frame into the file.
+// doesn't touch the screen or the zone, so it can run off the main thread.
 //
-static void GIF_framewrite(void)
+static void GIF_framewrite(const UINT8 *movie_screen, tic_t tics)
 {
-	UINT8 *p;
-	UINT8 *movie_screen = screens[2];
+	UINT8 *p = gifframe_data;
 	INT32 blitx, blity, blitw, blith;
 
-	if (!gifframe_data)
-		gifframe_data = Z_Malloc(gifframe_size, PU_STATIC, NULL);
-	p = gifframe_data;
-
 	if (!gif_out)
 		return;
 
 	// Compare image data (for optimizing GIF)
 	if (gif_optimize && gif_frames > 0)
-	{
-		// before blit movie_screen points to last frame, cur_screen points to this frame
-		UINT8 *cur_screen = screens[0];
-		GIF_optimizeregion(cur_screen, movie_screen, &blitx, &blity, &blitw, &blith);
-
-		// blit to temp screen
-		if (rendermode == render_soft)
-			I_ReadScreen(movie_screen);
-#ifdef HWRENDER
-		else if (rendermode == render_opengl)
-		{
-			UINT8 *linear = HWR_GetScreenshot();
-			GIF_rgbconvert(linear, movie_screen);
-			//free(linear); // Allocated 'statically', no need to free now
-		}
-#endif
-	}
+		GIF_optimizeregion(movie_screen, gif_lastframe, &blitx, &blity, &blitw, &blith);
 	else
 	{
 		blitx = blity = 0;
-		blitw = vid.width;
-		blith = vid.height;
-
-#ifdef HWRENDER
-		// Copy the current OpenGL frame into the base screen
-		if (rendermode == render_opengl)
-		{
-			UINT8 *linear = HWR_GetScreenshot();
-			GIF_rgbconvert(linear, screens[0]);
-			//free(linear); // Allocated 'statically', no need to free now
-		}
-#endif
-
-		// Copy the first frame into the movie screen
-		// OpenGL already does the same above.
-		if (gif_frames == 0 && rendermode == render_soft)
-			I_ReadScreen(movie_screen);
-
-		movie_screen = screens[0];
+		blitw = gif_width;
+		blith = gif_height;
 	}
 
+	if (gif_optimize)
+		M_Memcpy(gif_lastframe, movie_screen, gif_width * gif_height);
+
 	// screen regions are handled in GIF_lzw
 	{
-		int d1 = (int)((100.0f/NEWTICRATE)*(gif_frames+1));
-		int d2 = (int)((100.0f/NEWTICRATE)*(gif_frames));
+		int d1 = (int)((100.0f/NEWTICRATE)*(gif_time+tics));
+		int d2 = (int)((100.0f/NEWTICRATE)*(gif_time));
 		UINT16 delay = d1-d2;
 		INT32 startline;
 
@@ -574,19 +541,17 @@ static void GIF_framewrite(void)
 		WRITEUINT16(p, (UINT16)(blith / scrbuf_downscaleamt));
 		WRITEUINT8(p, 0); // no local table of colors
 
-		scrbuf_pos = movie_screen + blitx + (blity * vid.width);
-		scrbuf_writeend = scrbuf_pos + (blitw - 1) + ((blith - 1) * vid.width);
+		scrbuf_pos = movie_screen + blitx + (blity * gif_width);
+		scrbuf_writeend = scrbuf_pos + (blitw - 1) + ((blith - 1) * gif_width);
 
-		if (!gifbwr_buf)
-			gifbwr_buf = Z_Malloc(256, PU_STATIC, NULL);
 		gifbwr_cur = gifbwr_buf;
 
 		GIF_prepareLZW();
 		giflzw_workingCode = UINT16_MAX;
 		WRITEUINT8(p, gifbwr_bits_min - 1);
 
-		startline = (scrbuf_pos - movie_screen) / vid.width;
-		scrbuf_linebegin = movie_screen + (startline * vid.width) + blitx;
+		startline = (scrbuf_pos - movie_screen) / gif_width;
+		scrbuf_linebegin = movie_screen + (startline * gif_width) + blitx;
 		scrbuf_lineend = scrbuf_linebegin + blitw;
 
 		//prewrite a table clear
@@ -597,12 +562,8 @@ static void GIF_framewrite(void)
 		{
 			GIF_lzw(); // main lzw packing loop
 
-			if ((size_t)(p - gifframe_data) + gifbwr_bufsize + 1 >= gifframe_size)
-			{
-				INT32 temppos = p - gifframe_data;
-				gifframe_data = Z_Realloc(gifframe_data, (gifframe_size *= 2), PU_STATIC, NULL);
-				p = gifframe_data + temppos; // realloc moves gifframe_data, so p is now invalid
-			}
+			// gifframe_data is sized for the worst case in GIF_open
+			I_Assert((size_t)(p - gifframe_data) + gifbwr_bufsize + 2 < gifframe_size);
 
 			// reset after writing to read
 			gifbwr_cur = gifbwr_buf;
@@ -616,6 +577,7 @@ static void GIF_framewrite(void)
 	}
 	fwrite(gifframe_data, 1, (p - gifframe_data), gif_out);
 	++gif_frames;
+	gif_time += tics;
 }
 
 
@@ -636,19 +598,55 @@ INT32 GIF_open(const char *filename)
 
 	gif_optimize = (!!cv_gif_optimize.value);
 	gif_downscale = (!!cv_gif_downscale.value);
+	gif_width = vid.width;
+	gif_height = vid.height;
 	GIF_headwrite();
 	gif_frames = 0;
+	gif_time = 0;
+
+	// Everything the encoder needs is allocated up front, since the frames
+	// may be written on another thread. Every pixel takes at most a 12-bit
+	// code, plus the table clears and the sub-block lengths.
+	gifframe_size = (size_t)gif_width * gif_height * 2 + 1024;
+	gifframe_data = Z_Malloc(gifframe_size, PU_STATIC, NULL);
+	gifbwr_buf = Z_Malloc(256, PU_STATIC, NULL);
+	giflzw_hashTable = Z_Malloc(16384*sizeof(UINT32), PU_STATIC, NULL);
+
+	if (gif_optimize)
+		gif_lastframe = Z_Calloc(gif_width * gif_height, PU_STATIC, NULL);
 	return 1;
 }
 
+//
+// GIF_capture
+// copies the screen into a palette-indexed frame for GIF_frame.
+// dest must start out zeroed, when downscaling only the pixels that
+// get written are filled in.
+//
+void GIF_capture(UINT8 *dest)
+{
+	if (rendermode == render_soft)
+		I_ReadScreen(dest);
+#ifdef HWRENDER
+	else if (rendermode == render_opengl)
+	{
+		UINT8 *linear = HWR_GetScreenshot();
+		if (linear)
+			GIF_rgbconvert(linear, dest);
+		//free(linear); // Allocated 'statically', no need to free now
+	}
+#endif
+}
+
 //
 // GIF_frame
-// writes a frame into the output gif
+// writes a frame from GIF_capture into the output gif,
+// to stay up for the given number of tics
 //
-void GIF_frame(void)
+void GIF_frame(const UINT8 *frame, tic_t tics)
 {
 	// there's not much actually needed here, is there.
-	GIF_framewrite();
+	GIF_framewrite(frame, tics);
 }
 
 //
@@ -672,11 +670,16 @@ INT32 GIF_close(void)
 	if (gifframe_data)
 		Z_Free(gifframe_data);
 	gifframe_data = NULL;
+	gifframe_size = 0;
 
 	if (giflzw_hashTable)
 		Z_Free(giflzw_hashTable);
 	giflzw_hashTable = NULL;
 
+	if (gif_lastframe)
+		Z_Free(gif_lastframe);
+	gif_lastframe = NULL;
+
 	CONS_Printf(M_GetText("Animated gif closed; wrote %d frames\n"), gif_frames);
 	return 1;
 }
@@ -23,7 +23,8 @@
 
 #ifdef HAVE_ANIGIF
 INT32 GIF_open(const char *filename);
-void GIF_frame(void);
+void GIF_capture(UINT8 *dest);
+void GIF_frame(const UINT8 *frame, tic_t tics);
 INT32 GIF_close(void);
 #endif
 
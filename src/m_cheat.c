@@ -667,6 +667,28 @@ void Command_Dumplua_f(void)
 }
 #endif
 
+void Command_Benchlua_f(void)
+{
+	INT32 iterations = 1000000;
+
+	REQUIRE_INLEVEL;
+	REQUIRE_SINGLEPLAYER;
+
+	if (!players[consoleplayer].mo)
+		return;
+
+	if (COM_Argc() > 1)
+		iterations = atoi(COM_Argv(1));
+
+	if (iterations <= 0)
+	{
+		CONS_Printf(M_GetText("benchlua [iterations]: Time Lua userdata field access on your player object.\n"));
+		return;
+	}
+
+	LUA_Benchmark(players[consoleplayer].mo, iterations);
+}
+
 void Command_Savecheckpoint_f(void)
 {
 	REQUIRE_DEVMODE;
@@ -902,7 +924,7 @@ static mapthing_t *OP_CreateNewMapThing(player_t *player, UINT16 type, boolean c
 		thinker_t *th;
 		mobj_t *mo;
 
-		for (th = thinkercap.next; th != &thinkercap; th = th->next)
+		for (th = thlist[THINK_MOBJ].cnext; th != &thlist[THINK_MOBJ]; th = th->cnext)
 		{
 			if (th->function.acp1 != (actionf_p1)P_MobjThinker)
 				continue;
@@ -70,5 +70,6 @@ void Command_CauseCfail_f(void);
 #if defined(LUA_ALLOW_BYTECODE)
 void Command_Dumplua_f(void);
 #endif
+void Command_Benchlua_f(void);
 
 #endif
@@ -0,0 +1,619 @@
+// SONIC ROBO BLAST 2
+//-----------------------------------------------------------------------------
+// Copyright (C) 1998-2000 by DooM Legacy Team.
+// Copyright (C) 1999-2018 by Sonic Team Junior.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  m_compress.c
+/// \brief Compressors for gamestate and file transfers
+
+#include "doomdef.h"
+#include "z_zone.h"
+#include "lzf.h"
+#include "m_compress.h"
+
+// ==========================================================================
+//                                                                 LZ4 STYLE
+// ==========================================================================
+//
+// A stream is a series of sequences, each made of:
+//  - a token: the number of literals in the high nibble, and the match
+//    length minus LZ4MINMATCH in the low one. 15 in either means extra
+//    bytes follow, each added on until one isn't 255.
+//  - the literals.
+//  - a little endian UINT16 offset back to the match, and the extra match
+//    length bytes.
+// The last sequence stops after its literals.
+//
+
+#define LZ4MINMATCH 4
+#define LZ4MAXOFFSET 65535
+#define LZ4HASHBITS 12
+
+#define LZ4HCHASHBITS 15
+#define LZ4HCDEPTH 64 // Candidates checked per position
+
+static inline UINT32 LZ4_Read32(const UINT8 *p)
+{
+	UINT32 v;
+	memcpy(&v, p, sizeof v);
+	return v;
+}
+
+static inline UINT32 LZ4_Hash(UINT32 v, INT32 bits)
+{
+	return (v * 2654435761u) >> (32 - bits);
+}
+
+static UINT8 *LZ4_WriteLength(UINT8 *op, size_t length)
+{
+	for (length -= 15; length >= 255; length -= 255)
+		*op++ = 255;
+	*op++ = (UINT8)length;
+	return op;
+}
+
+//
+// LZ4_WriteSequence
+//
+// Writes literals followed by a match, or just literals if matchlength is 0.
+// Returns the new output position, or NULL if it doesn't fit.
+//
+static UINT8 *LZ4_WriteSequence(UINT8 *op, const UINT8 *oend, const UINT8 *literals, size_t numliterals, size_t offset, size_t matchlength)
+{
+	const size_t extra = matchlength ? matchlength - LZ4MINMATCH : 0;
+	UINT8 *token = op++;
+
+	if (token >= oend || (size_t)(oend - op) < numliterals + numliterals / 255 + 1 + (matchlength ? 2 + extra / 255 + 1 : 0))
+		return NULL;
+
+	*token = (UINT8)((numliterals >= 15 ? 15 : numliterals) << 4);
+	if (numliterals >= 15)
+		op = LZ4_WriteLength(op, numliterals);
+	memcpy(op, literals, numliterals);
+	op += numliterals;
+
+	if (!matchlength)
+		return op;
+
+	*op++ = (UINT8)(offset & 0xFF);
+	*op++ = (UINT8)(offset >> 8);
+	*token |= (UINT8)(extra >= 15 ? 15 : extra);
+	if (extra >= 15)
+		op = LZ4_WriteLength(op, extra);
+	return op;
+}
+
+// Greedy, with a single hash table slot per 4 byte sequence.
+static size_t LZ4_Compress(const void *in, size_t inlen, void *out, size_t outlen)
+{
+	const UINT8 *base = in;
+	UINT8 *op = out;
+	const UINT8 *oend = op + outlen;
+	UINT32 table[1 << LZ4HASHBITS];
+	size_t pos = 0, anchor = 0, misses = 0;
+
+	memset(table, 0, sizeof table);
+
+	while (pos + LZ4MINMATCH <= inlen)
+	{
+		const UINT32 seq = LZ4_Read32(base + pos);
+		const UINT32 h = LZ4_Hash(seq, LZ4HASHBITS);
+		size_t ref = table[h];
+
+		table[h] = (UINT32)pos;
+
+		if (ref < pos && pos - ref <= LZ4MAXOFFSET && LZ4_Read32(base + ref) == seq)
+		{
+			size_t length = LZ4MINMATCH;
+
+			while (pos + length < inlen && base[ref + length] == base[pos + length])
+				length++;
+			while (pos > anchor && ref > 0 && base[pos - 1] == base[ref - 1])
+			{
+				pos--;
+				ref--;
+				length++;
+			}
+
+			if (!(op = LZ4_WriteSequence(op, oend, base + anchor, pos - anchor, pos - ref, length)))
+				return 0;
+
+			pos += length;
+			anchor = pos;
+			misses = 0;
+		}
+		else // Skip faster through data that doesn't compress
+			pos += 1 + (misses++ >> 5);
+	}
+
+	if (!(op = LZ4_WriteSequence(op, oend, base + anchor, inlen - anchor, 0, 0)))
+		return 0;
+	return op - (UINT8 *)out;
+}
+
+static boolean LZ4_ReadLength(const UINT8 **ip, const UINT8 *iend, size_t *length)
+{
+	UINT8 b;
+
+	do
+	{
+		if (*ip >= iend)
+			return false;
+		b = *(*ip)++;
+		*length += b;
+	} while (b == 255);
+
+	return true;
+}
+
+static size_t LZ4_Decompress(const void *in, size_t inlen, void *out, size_t outlen)
+{
+	const UINT8 *ip = in;
+	const UINT8 *iend = ip + inlen;
+	UINT8 *op = out;
+	const UINT8 *oend = op + outlen;
+
+	while (ip < iend)
+	{
+		const UINT8 token = *ip++;
+		size_t length = token >> 4, offset;
+		const UINT8 *match;
+
+		if (length == 15 && !LZ4_ReadLength(&ip, iend, &length))
+			return 0;
+		if (length > (size_t)(iend - ip) || length > (size_t)(oend - op))
+			return 0;
+		memcpy(op, ip, length);
+		op += length;
+		ip += length;
+
+		if (ip == iend)
+			break;
+
+		if (iend - ip < 2)
+			return 0;
+		offset = ip[0] | (ip[1] << 8);
+		ip += 2;
+		if (!offset || offset > (size_t)(op - (UINT8 *)out))
+			return 0;
+
+		length = token & 15;
+		if (length == 15 && !LZ4_ReadLength(&ip, iend, &length))
+			return 0;
+		length += LZ4MINMATCH;
+		if (length > (size_t)(oend - op))
+			return 0;
+
+		match = op - offset;
+		if (offset >= length)
+		{
+			memcpy(op, match, length);
+			op += length;
+		}
+		else while (length--) // Overlapping, repeats the last offset bytes
+			*op++ = *match++;
+	}
+
+	return op - (UINT8 *)out;
+}
+
+typedef struct
+{
+	const UINT8 *base;
+	size_t length;
+	INT32 *head; // Latest position with each hash, or -1
+	UINT16 *chain; // Distance back to the previous position with the same hash, or 0
+} lz4hc_t;
+
+static void LZ4HC_Insert(lz4hc_t *hc, size_t pos)
+{
+	UINT32 h;
+	size_t delta;
+
+	if (pos + LZ4MINMATCH > hc->length)
+		return;
+
+	h = LZ4_Hash(LZ4_Read32(hc->base + pos), LZ4HCHASHBITS);
+	delta = hc->head[h] < 0 ? 0 : pos - hc->head[h];
+	hc->chain[pos & LZ4MAXOFFSET] = (UINT16)(delta > LZ4MAXOFFSET ? 0 : delta);
+	hc->head[h] = (INT32)pos;
+}
+
+// Returns the longest match for pos among the positions inserted so far.
+static size_t LZ4HC_FindMatch(const lz4hc_t *hc, size_t pos, size_t *offset)
+{
+	const UINT8 *base = hc->base;
+	size_t best = 0;
+	INT32 depth = LZ4HCDEPTH;
+	INT32 candidate;
+
+	if (pos + LZ4MINMATCH > hc->length)
+		return 0;
+
+	candidate = hc->head[LZ4_Hash(LZ4_Read32(base + pos), LZ4HCHASHBITS)];
+
+	while (candidate >= 0 && pos - candidate <= LZ4MAXOFFSET && depth--)
+	{
+		const size_t ref = candidate;
+		UINT16 delta;
+
+		if (pos + best < hc->length && base[ref + best] == base[pos + best]
+			&& LZ4_Read32(base + ref) == LZ4_Read32(base + pos))
+		{
+			size_t length = LZ4MINMATCH;
+
+			while (pos + length < hc->length && base[ref + length] == base[pos + length])
+				length++;
+			if (length > best)
+			{
+				best = length;
+				*offset = pos - ref;
+			}
+		}
+
+		delta = hc->chain[ref & LZ4MAXOFFSET];
+		if (!delta)
+			break;
+		candidate -= delta;
+	}
+
+	return best;
+}
+
+// Same stream format, but searches hash chains and defers a match by a byte
+// if that finds a longer one.
+static size_t LZ4HC_Compress(const void *in, size_t inlen, void *out, size_t outlen)
+{
+	lz4hc_t hc;
+	UINT8 *op = out;
+	const UINT8 *oend = op + outlen;
+	size_t pos = 0, anchor = 0, next = 0;
+
+	hc.base = in;
+	hc.length = inlen;
+	hc.head = Z_Malloc((1 << LZ4HCHASHBITS) * sizeof (INT32), PU_STATIC, NULL);
+	hc.chain = Z_Calloc((LZ4MAXOFFSET + 1) * sizeof (UINT16), PU_STATIC, NULL);
+	memset(hc.head, 0xFF, (1 << LZ4HCHASHBITS) * sizeof (INT32));
+
+	while (op && pos + LZ4MINMATCH <= inlen)
+	{
+		size_t offset = 0, length, lazyoffset = 0;
+
+		for (; next < pos; next++)
+			LZ4HC_Insert(&hc, next);
+
+		length = LZ4HC_FindMatch(&hc, pos, &offset);
+		if (length < LZ4MINMATCH)
+		{
+			pos++;
+			continue;
+		}
+
+		LZ4HC_Insert(&hc, next++);
+		if (LZ4HC_FindMatch(&hc, pos + 1, &lazyoffset) > length)
+		{
+			pos++;
+			continue;
+		}
+
+		op = LZ4_WriteSequence(op, oend, hc.base + anchor, pos - anchor, offset, length);
+		pos += length;
+		anchor = pos;
+	}
+
+	if (op)
+		op = LZ4_WriteSequence(op, oend, hc.base + anchor, inlen - anchor, 0, 0);
+
+	Z_Free(hc.head);
+	Z_Free(hc.chain);
+
+	return op ? op - (UINT8 *)out : 0;
+}
+
+// ==========================================================================
+//                                                            LZ4 + HUFFMAN
+// ==========================================================================
+//
+// The LZ4HC stream, Huffman coded a byte at a time:
+//  - UINT32 length of the LZ4 stream, little endian
+//  - 256 code lengths, a nibble each, low nibble first
+//  - the codes, most significant bit first
+//
+
+#define HUFFMAXBITS 15
+#define HUFFHEADERSIZE (4 + 128)
+
+//
+// Huff_BuildLengths
+//
+// Makes code lengths out of byte counts. If the tree comes out deeper than
+// HUFFMAXBITS, the counts are flattened and it's built again.
+//
+static void Huff_BuildLengths(const UINT32 *counts, UINT8 *lengths)
+{
+	UINT32 weight[511];
+	INT16 parent[511];
+	UINT32 freqs[256];
+	INT32 i, numleaves;
+
+	memcpy(freqs, counts, sizeof freqs);
+
+	for (;;)
+	{
+		INT32 numnodes, maxdepth = 0;
+
+		memset(lengths, 0, 256);
+		for (i = numleaves = 0; i < 256; i++)
+			if (freqs[i])
+				numleaves++;
+
+		if (numleaves <= 1)
+		{
+			for (i = 0; i < 256; i++)
+				if (freqs[i])
+					lengths[i] = 1;
+			return;
+		}
+
+		for (i = 0; i < 256; i++)
+		{
+			weight[i] = freqs[i];
+			parent[i] = -1;
+		}
+
+		// Join the two lightest parentless nodes until only the root is left
+		for (numnodes = 256; numnodes < 256 + numleaves - 1; numnodes++)
+		{
+			INT32 a = -1, b = -1;
+
+			for (i = 0; i < numnodes; i++)
+			{
+				if (parent[i] != -1 || (i < 256 && !freqs[i]))
+					continue;
+				if (a == -1 || weight[i] < weight[a])
+				{
+					b = a;
+					a = i;
+				}
+				else if (b == -1 || weight[i] < weight[b])
+					b = i;
+			}
+
+			weight[numnodes] = weight[a] + weight[b];
+			parent[numnodes] = -1;
+			parent[a] = parent[b] = (INT16)numnodes;
+		}
+
+		for (i = 0; i < 256; i++)
+		{
+			INT32 node, depth = 0;
+
+			if (!freqs[i])
+				continue;
+			for (node = i; parent[node] != -1; node = parent[node])
+				depth++;
+			lengths[i] = (UINT8)min(depth, 255);
+			maxdepth = max(maxdepth, depth);
+		}
+
+		if (maxdepth <= HUFFMAXBITS)
+			return;
+
+		for (i = 0; i < 256; i++)
+			if (freqs[i])
+				freqs[i] = (freqs[i] + 1) / 2;
+	}
+}
+
+// Gives out canonical codes for the lengths. Returns false if they're oversubscribed.
+static boolean Huff_AssignCodes(const UINT8 *lengths, UINT16 *codes)
+{
+	UINT16 count[HUFFMAXBITS + 1], nextcode[HUFFMAXBITS + 1];
+	INT32 i, code = 0, left = 1;
+
+	memset(count, 0, sizeof count);
+	for (i = 0; i < 256; i++)
+		count[lengths[i]]++;
+	count[0] = 0;
+
+	for (i = 1; i <= HUFFMAXBITS; i++)
+	{
+		left = (left << 1) - count[i];
+		if (left < 0)
+			return false;
+		code = (code + count[i - 1]) << 1;
+		nextcode[i] = (UINT16)code;
+	}
+
+	for (i = 0; i < 256; i++)
+		if (lengths[i])
+			codes[i] = nextcode[lengths[i]]++;
+
+	return true;
+}
+
+static size_t LZ4H_Compress(const void *in, size_t inlen, void *out, size_t outlen)
+{
+	const size_t lzmax = inlen + inlen / 255 + 16;
+	UINT8 *lz, *op = out;
+	const UINT8 *oend = op + outlen;
+	UINT32 counts[256];
+	UINT8 lengths[256];
+	UINT16 codes[256];
+	UINT32 acc = 0;
+	INT32 numbits = 0;
+	size_t lzlen, i;
+
+	if (outlen <= HUFFHEADERSIZE)
+		return 0;
+
+	lz = Z_Malloc(lzmax, PU_STATIC, NULL);
+	lzlen = LZ4HC_Compress(in, inlen, lz, lzmax);
+
+	memset(counts, 0, sizeof counts);
+	for (i = 0; i < lzlen; i++)
+		counts[lz[i]]++;
+
+	Huff_BuildLengths(counts, lengths);
+	Huff_AssignCodes(lengths, codes);
+
+	*op++ = (UINT8)(lzlen);
+	*op++ = (UINT8)(lzlen >> 8);
+	*op++ = (UINT8)(lzlen >> 16);
+	*op++ = (UINT8)(lzlen >> 24);
+	for (i = 0; i < 256; i += 2)
+		*op++ = (UINT8)(lengths[i] | (lengths[i + 1] << 4));
+
+	for (i = 0; i < lzlen; i++)
+	{
+		acc = (acc << lengths[lz[i]]) | codes[lz[i]];
+		numbits += lengths[lz[i]];
+
+		while (numbits >= 8)
+		{
+			if (op >= oend)
+			{
+				Z_Free(lz);
+				return 0;
+			}
+			numbits -= 8;
+			*op++ = (UINT8)(acc >> numbits);
+		}
+	}
+
+	Z_Free(lz);
+
+	if (numbits)
+	{
+		if (op >= oend)
+			return 0;
+		*op++ = (UINT8)(acc << (8 - numbits));
+	}
+
+	return (lzlen ? op - (UINT8 *)out : 0);
+}
+
+static size_t LZ4H_Decompress(const void *in, size_t inlen, void *out, size_t outlen)
+{
+	const UINT8 *ip = in;
+	const UINT8 *iend = ip + inlen;
+	UINT8 lengths[256];
+	UINT16 codes[256];
+	UINT16 *table;
+	UINT8 *lz;
+	UINT32 acc = 0;
+	INT32 numbits = 0;
+	size_t lzlen, padding = 0, i, result = 0;
+
+	if (inlen <= HUFFHEADERSIZE)
+		return 0;
+
+	lzlen = ip[0] | (ip[1] << 8) | (ip[2] << 16) | ((size_t)ip[3] << 24);
+	ip += 4;
+	if (!lzlen || lzlen > outlen + outlen / 255 + 16)
+		return 0;
+
+	for (i = 0; i < 256; i += 2, ip++)
+	{
+		lengths[i] = *ip & 15;
+		lengths[i + 1] = *ip >> 4;
+	}
+	if (!Huff_AssignCodes(lengths, codes))
+		return 0;
+
+	// Every HUFFMAXBITS bit pattern maps to the symbol whose code it starts with
+	table = Z_Calloc((1 << HUFFMAXBITS) * sizeof (UINT16), PU_STATIC, NULL);
+	for (i = 0; i < 256; i++)
+	{
+		const UINT32 first = (UINT32)codes[i] << (HUFFMAXBITS - lengths[i]);
+		UINT32 j;
+
+		if (!lengths[i])
+			continue;
+		for (j = 0; j < (1u << (HUFFMAXBITS - lengths[i])); j++)
+			table[first + j] = (UINT16)(i | (lengths[i] << 8));
+	}
+
+	lz = Z_Malloc(lzlen, PU_STATIC, NULL);
+	for (i = 0; i < lzlen; i++)
+	{
+		UINT16 entry;
+
+		while (numbits < HUFFMAXBITS)
+		{
+			if (ip < iend)
+				acc = (acc << 8) | *ip++;
+			else
+			{
+				acc <<= 8;
+				padding++;
+			}
+			numbits += 8;
+		}
+
+		entry = table[(acc >> (numbits - HUFFMAXBITS)) & ((1 << HUFFMAXBITS) - 1)];
+		if (!(entry >> 8))
+			break;
+		lz[i] = (UINT8)entry;
+		numbits -= entry >> 8;
+	}
+
+	// Did it decode everything, without reading past the end?
+	if (i == lzlen && padding * 8 <= (size_t)numbits)
+		result = LZ4_Decompress(lz, lzlen, out, outlen);
+
+	Z_Free(table);
+	Z_Free(lz);
+	return result;
+}
+
+// ==========================================================================
+//                                                                 INTERFACE
+// ==========================================================================
+
+const compressorinfo_t compressors[NUMCOMPRESSORS] =
+{
+	{"None", NULL, NULL},
+	{"LZF", lzf_compress, lzf_decompress},
+	{"LZ4", LZ4_Compress, LZ4_Decompress},
+	{"LZ4H", LZ4H_Compress, LZ4H_Decompress},
+};
+
+/** Compresses a block of memory.
+  *
+  * \param method The compressor to use.
+  * \param in     Data to compress.
+  * \param inlen  Length of the data.
+  * \param out    Where to put the compressed data.
+  * \param outlen Room there is at out.
+  * \return Compressed length, or 0 if it didn't fit or there's no such compressor.
+  * \sa M_Decompress
+  */
+size_t M_Compress(compressor_t method, const void *in, size_t inlen, void *out, size_t outlen)
+{
+	if (method >= NUMCOMPRESSORS || !compressors[method].compress || !inlen)
+		return 0;
+	return compressors[method].compress(in, inlen, out, outlen);
+}
+
+/** Decompresses a block of memory compressed with M_Compress.
+  *
+  * \param method The compressor it was compressed with.
+  * \param in     Compressed data.
+  * \param inlen  Length of the compressed data.
+  * \param out    Where to put the decompressed data.
+  * \param outlen Room there is at out.
+  * \return Decompressed length, or 0 if the data is corrupt, didn't fit,
+  *         or there's no such compressor.
+  * \sa M_Compress
+  */
+size_t M_Decompress(compressor_t method, const void *in, size_t inlen, void *out, size_t outlen)
+{
+	if (method >= NUMCOMPRESSORS || !compressors[method].decompress || !inlen)
+		return 0;
+	return compressors[method].decompress(in, inlen, out, outlen);
+}
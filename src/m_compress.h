@@ -0,0 +1,45 @@
+// SONIC ROBO BLAST 2
+//-----------------------------------------------------------------------------
+// Copyright (C) 1998-2000 by DooM Legacy Team.
+// Copyright (C) 1999-2018 by Sonic Team Junior.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  m_compress.h
+/// \brief Compressors for gamestate and file transfers
+
+#ifndef __M_COMPRESS__
+#define __M_COMPRESS__
+
+#include "doomtype.h"
+
+// Values go over the network, only ever add to the end
+typedef enum
+{
+	COMP_NONE,
+	COMP_LZF, // lzf.c, the only one older versions had
+	COMP_LZ4, // LZ4 style, fast
+	COMP_LZ4H, // LZ4 style with a deeper match search, then Huffman coded
+	NUMCOMPRESSORS
+} compressor_t;
+
+typedef struct
+{
+	const char *name;
+
+	// Returns the compressed size, or 0 if it doesn't fit in outlen bytes.
+	size_t (*compress)(const void *in, size_t inlen, void *out, size_t outlen);
+
+	// Returns the decompressed size, or 0 if the data is corrupt
+	// or doesn't fit in outlen bytes.
+	size_t (*decompress)(const void *in, size_t inlen, void *out, size_t outlen);
+} compressorinfo_t;
+
+extern const compressorinfo_t compressors[NUMCOMPRESSORS];
+
+size_t M_Compress(compressor_t method, const void *in, size_t inlen, void *out, size_t outlen);
+size_t M_Decompress(compressor_t method, const void *in, size_t inlen, void *out, size_t outlen);
+
+#endif
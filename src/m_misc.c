@@ -41,6 +41,7 @@
 #include "m_argv.h"
 #include "i_system.h"
 #include "command.h" // cv_execversion
+#include "i_threads.h"
 
 #include "m_anigif.h"
 
@@ -159,6 +160,10 @@ consvar_t cv_zlib_strategya = {"apng_strategy", "RLE", CV_SAVE, zlib_strategy_t,
 consvar_t cv_zlib_window_bitsa = {"apng_window_size", "32k", CV_SAVE, zlib_window_bits_t, NULL, 0, NULL, NULL, 0, 0, NULL};
 consvar_t cv_apng_delay = {"apng_speed", "1/2x", CV_SAVE, apng_delay_t, NULL, 0, NULL, NULL, 0, 0, NULL};
 
+static CV_PossibleValue_t movie_queue_t[] = {{0, "MIN"}, {32, "MAX"}, {0, NULL}};
+consvar_t cv_movie_queue = {"movie_queue", "8", CV_SAVE, movie_queue_t, NULL, 0, NULL, NULL, 0, 0, NULL};
+consvar_t cv_movie_dropframes = {"movie_dropframes", "On", CV_SAVE, CV_OnOff, NULL, 0, NULL, NULL, 0, 0, NULL};
+
 boolean takescreenshot = false; // Take a screenshot this tic
 
 moviemode_t moviemode = MM_OFF;
@@ -955,13 +960,12 @@ static inline boolean M_PNGLib(void)
 #endif
 }
 
-static void M_PNGFrame(png_structp png_ptr, png_infop png_info_ptr, png_bytep png_buf)
+static void M_PNGFrame(png_structp png_ptr, png_infop png_info_ptr, png_bytep png_buf, png_uint_32 width, png_uint_32 height, tic_t tics)
 {
 	png_uint_32 pitch = png_get_rowbytes(png_ptr, png_info_ptr);
-	PNG_CONST png_uint_32 height = vid.height;
 	png_bytepp row_pointers = png_malloc(png_ptr, height* sizeof (png_bytep));
 	png_uint_32 y;
-	png_uint_16 framedelay = (png_uint_16)cv_apng_delay.value;
+	png_uint_16 framedelay = (png_uint_16)min((tic_t)cv_apng_delay.value * tics, UINT16_MAX);
 
 	apng_frames++;
 
@@ -975,7 +979,7 @@ static void M_PNGFrame(png_structp png_ptr, png_infop png_info_ptr, png_bytep pn
 	if (aPNG_write_frame_head)
 #endif
 		aPNG_write_frame_head(apng_ptr, apng_info_ptr, row_pointers,
-			vid.width, /* width */
+			width,     /* width */
 			height,    /* height */
 			0,         /* x offset */
 			0,         /* y offset */
@@ -1137,6 +1141,268 @@ static inline moviemode_t M_StartMovieGIF(const char *pathname)
 	return MM_OFF;
 #endif
 }
+
+//
+// Movie frame queue
+//
+// Capturing a frame is a copy, but compressing it takes long enough to
+// make the game stutter, so by default frames are handed off to a worker
+// thread through a small ring of buffers. When the worker falls behind
+// and the ring is full, frames are either dropped, with the next one
+// kept up for the time the dropped ones would have been, or the game
+// waits, depending on movie_dropframes. movie_queue 0 encodes each frame
+// on the spot like it always used to.
+//
+
+typedef struct
+{
+	UINT8 *data;
+	INT32 width, height; // the screen size it was captured at
+	tic_t tics; // how long it stays up, counting any frames dropped before it
+} movieframe_t;
+
+static movieframe_t *movieframes;
+static size_t moviequeuesize, moviequeuehead, moviequeuecount;
+static size_t movieframesize;
+static tic_t moviedroppedtics;
+
+static UINT32 moviecaptured, moviedropped;
+static UINT32 movieencoded; // only touched by whoever is encoding
+static precise_t movieencodetime, movieencodeworst;
+
+#ifdef HAVE_THREADS
+static I_mutex movie_mutex;
+static I_cond movie_cond;
+static boolean movieworker, moviestopping;
+#endif
+
+static void M_CaptureFrame(movieframe_t *frame)
+{
+	frame->width = vid.width;
+	frame->height = vid.height;
+
+	switch (moviemode)
+	{
+#ifdef HAVE_ANIGIF
+		case MM_GIF:
+			GIF_capture(frame->data);
+			break;
+#endif
+#ifdef USE_APNG
+		case MM_APNG:
+			if (rendermode == render_soft)
+				I_ReadScreen(frame->data); // munge planar buffer to linear
+#ifdef HWRENDER
+			else
+			{
+				UINT8 *linear = HWR_GetScreenshot();
+				if (linear)
+					M_Memcpy(frame->data, linear, movieframesize);
+			}
+#endif
+			break;
+#endif
+		default:
+			break;
+	}
+}
+
+static void M_EncodeFrame(movieframe_t *frame)
+{
+	precise_t t = I_GetPreciseTime();
+
+	switch (moviemode)
+	{
+#ifdef HAVE_ANIGIF
+		case MM_GIF:
+			GIF_frame(frame->data, frame->tics);
+			break;
+#endif
+#ifdef USE_APNG
+		case MM_APNG:
+			M_PNGFrame(apng_ptr, apng_info_ptr, (png_bytep)frame->data, frame->width, frame->height, frame->tics);
+			break;
+#endif
+		default:
+			break;
+	}
+
+	t = I_GetPreciseTime() - t;
+	movieencodetime += t;
+	if (t > movieencodeworst)
+		movieencodeworst = t;
+	movieencoded++;
+}
+
+#ifdef HAVE_THREADS
+static void M_MovieWorker(void *userdata)
+{
+	movieframe_t *frame;
+	(void)userdata;
+
+	I_lock_mutex(&movie_mutex);
+	for (;;)
+	{
+		while (!moviequeuecount && !moviestopping)
+			I_hold_cond(&movie_cond, movie_mutex);
+
+		// Whatever's still queued gets written before stopping
+		if (!moviequeuecount)
+			break;
+
+		// The frame stays in the queue until it's done, so it can't be reused under us
+		frame = &movieframes[moviequeuehead];
+		I_unlock_mutex(movie_mutex);
+		M_EncodeFrame(frame);
+		I_lock_mutex(&movie_mutex);
+
+		moviequeuehead = (moviequeuehead + 1) % moviequeuesize;
+		moviequeuecount--;
+		I_wake_all_cond(&movie_cond);
+	}
+
+	movieworker = false;
+	I_wake_all_cond(&movie_cond);
+	I_unlock_mutex(movie_mutex);
+}
+
+static void M_StopMovieOnExit(void)
+{
+	// Finish the file, and don't leave the worker waiting on a frame
+	// that will never come
+	if (moviemode == MM_GIF || moviemode == MM_APNG)
+		M_StopMovie();
+}
+#endif
+
+static void M_StartFrameQueue(void)
+{
+	size_t i;
+
+	movieframesize = vid.width * vid.height;
+#if defined (USE_APNG) && defined (HWRENDER)
+	if (moviemode == MM_APNG && rendermode != render_soft)
+		movieframesize *= 3; // RGB
+#endif
+
+#ifdef HAVE_THREADS
+	moviequeuesize = max(cv_movie_queue.value, 1);
+#else
+	moviequeuesize = 1;
+#endif
+	moviequeuehead = moviequeuecount = 0;
+	moviedroppedtics = 0;
+	moviecaptured = moviedropped = movieencoded = 0;
+	movieencodetime = movieencodeworst = 0;
+
+	// Zeroed for GIF_capture
+	movieframes = Z_Calloc(moviequeuesize * sizeof (*movieframes), PU_STATIC, NULL);
+	for (i = 0; i < moviequeuesize; i++)
+		movieframes[i].data = Z_Calloc(movieframesize, PU_STATIC, NULL);
+
+#ifdef HAVE_THREADS
+	if (cv_movie_queue.value)
+	{
+		static boolean exitfunc = false;
+
+		if (!exitfunc)
+		{
+			I_AddExitFunc(M_StopMovieOnExit);
+			exitfunc = true;
+		}
+
+		// The encoders allocate everything they need up front,
+		// so the worker leaves the zone alone
+		movieworker = true;
+		moviestopping = false;
+		I_spawn_thread("movie-encode", M_MovieWorker, NULL);
+	}
+#endif
+}
+
+static void M_StopFrameQueue(void)
+{
+	size_t i;
+
+	if (!movieframes)
+		return;
+
+#ifdef HAVE_THREADS
+	I_lock_mutex(&movie_mutex);
+	if (movieworker)
+	{
+		moviestopping = true;
+		I_wake_all_cond(&movie_cond);
+		while (movieworker)
+			I_hold_cond(&movie_cond, movie_mutex);
+	}
+	I_unlock_mutex(movie_mutex);
+#endif
+
+	for (i = 0; i < moviequeuesize; i++)
+		Z_Free(movieframes[i].data);
+	Z_Free(movieframes);
+	movieframes = NULL;
+
+	if (movieencoded)
+		CONS_Printf(M_GetText("Encoded %u frames, %.2f ms each on average, %.2f ms at worst; dropped %u of %u\n"),
+			movieencoded,
+			(double)movieencodetime * 1000.0 / I_GetPrecisePrecision() / movieencoded,
+			(double)movieencodeworst * 1000.0 / I_GetPrecisePrecision(),
+			moviedropped, moviecaptured + moviedropped);
+}
+
+//
+// M_QueueFrame
+//
+// Grabs the screen and encodes it, or queues it up for the worker.
+// Returns false if the frame was dropped.
+//
+static boolean M_QueueFrame(void)
+{
+	movieframe_t *frame;
+
+#ifdef HAVE_THREADS
+	if (movieworker)
+	{
+		I_lock_mutex(&movie_mutex);
+		if (moviequeuecount == moviequeuesize)
+		{
+			if (cv_movie_dropframes.value)
+			{
+				I_unlock_mutex(movie_mutex);
+				moviedroppedtics++;
+				moviedropped++;
+				return false;
+			}
+
+			while (moviequeuecount == moviequeuesize)
+				I_hold_cond(&movie_cond, movie_mutex);
+		}
+		frame = &movieframes[(moviequeuehead + moviequeuecount) % moviequeuesize];
+		I_unlock_mutex(movie_mutex);
+
+		// The worker won't look at it until it's counted
+		M_CaptureFrame(frame);
+		frame->tics = 1 + moviedroppedtics;
+		moviedroppedtics = 0;
+		moviecaptured++;
+
+		I_lock_mutex(&movie_mutex);
+		moviequeuecount++;
+		I_wake_all_cond(&movie_cond);
+		I_unlock_mutex(movie_mutex);
+		return true;
+	}
+#endif
+
+	frame = &movieframes[0];
+	M_CaptureFrame(frame);
+	frame->tics = 1;
+	moviecaptured++;
+	M_EncodeFrame(frame);
+	return true;
+}
 #endif
 
 void M_StartMovie(void)
@@ -1181,6 +1447,9 @@ void M_StartMovie(void)
 	else if (moviemode == MM_SCREENSHOT)
 		CONS_Printf(M_GetText("Movie mode enabled (%s).\n"), "screenshots");
 
+	if (moviemode == MM_APNG || moviemode == MM_GIF)
+		M_StartFrameQueue();
+
 	//singletics = (moviemode != MM_OFF);
 #endif
 }
@@ -1202,39 +1471,26 @@ void M_SaveFrame(void)
 			takescreenshot = true;
 			return;
 		case MM_GIF:
-			GIF_frame();
+#ifdef HAVE_ANIGIF
+			M_QueueFrame();
+#else
+			moviemode = MM_OFF;
+#endif
 			return;
 		case MM_APNG:
 #ifdef USE_APNG
+			if (!apng_FILE) // should not happen!!
 			{
-				UINT8 *linear = NULL;
-				if (!apng_FILE) // should not happen!!
-				{
-					moviemode = MM_OFF;
-					return;
-				}
-
-				if (rendermode == render_soft)
-				{
-					// munge planar buffer to linear
-					linear = screens[2];
-					I_ReadScreen(linear);
-				}
-#ifdef HWRENDER
-				else
-					linear = HWR_GetScreenshot();
-#endif
-				M_PNGFrame(apng_ptr, apng_info_ptr, (png_bytep)linear);
-#ifdef HWRENDER
-				if (rendermode != render_soft && linear)
-					free(linear);
-#endif
+				moviemode = MM_OFF;
+				return;
+			}
+
+			M_QueueFrame();
 
-				if (apng_frames == PNG_UINT_31_MAX)
-				{
-					CONS_Alert(CONS_NOTICE, M_GetText("Max movie size reached\n"));
-					M_StopMovie();
-				}
+			if (moviecaptured == PNG_UINT_31_MAX)
+			{
+				CONS_Alert(CONS_NOTICE, M_GetText("Max movie size reached\n"));
+				M_StopMovie();
 			}
 #else
 			moviemode = MM_OFF;
@@ -1249,6 +1505,10 @@ void M_SaveFrame(void)
 void M_StopMovie(void)
 {
 #if NUMSCREENS > 2
+	// Let the encoder catch up first
+	if (moviemode == MM_GIF || moviemode == MM_APNG)
+		M_StopFrameQueue();
+
 	switch (moviemode)
 	{
 		case MM_GIF:
@@ -34,6 +34,7 @@ extern consvar_t cv_moviemode;
 extern consvar_t cv_zlib_memory, cv_zlib_level, cv_zlib_strategy, cv_zlib_window_bits;
 extern consvar_t cv_zlib_memorya, cv_zlib_levela, cv_zlib_strategya, cv_zlib_window_bitsa;
 extern consvar_t cv_apng_delay;
+extern consvar_t cv_movie_queue, cv_movie_dropframes;
 
 void M_StartMovie(void);
 void M_SaveFrame(void);
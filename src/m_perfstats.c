@@ -19,6 +19,7 @@
 #include "z_zone.h"
 #include "p_local.h"
 #include "r_fps.h"
+#include "lua_alloc.h"
 
 #ifdef HWRENDER
 #include "hardware/hw_main.h"
@@ -58,7 +59,8 @@ static ps_metric_t ps_mobjcount = {0};
 static ps_metric_t ps_regularcount = {0};
 static ps_metric_t ps_scenerycount = {0};
 static ps_metric_t ps_nothinkcount = {0};
-static ps_metric_t ps_otherthcount = {0};
+static ps_metric_t ps_polythcount = {0};
+static ps_metric_t ps_mainthcount = {0};
 static ps_metric_t ps_precipcount = {0};
 static ps_metric_t ps_removecount = {0};
 
@@ -69,9 +71,18 @@ ps_metric_t ps_lua_thinkframe_time = {0};
 ps_metric_t ps_lua_postthinkframe_time = {0};
 
 ps_metric_t ps_lua_mobjhooks = {0};
+ps_metric_t ps_lua_mobjthinker_time = {0};
+ps_metric_t ps_lua_mobjcollide_time = {0};
+ps_metric_t ps_lua_mobjhook_time = {0};
 
 ps_metric_t ps_otherlogictime = {0};
 
+static ps_metric_t ps_lua_heapsize = {0};
+static ps_metric_t ps_lua_allocs = {0};
+static ps_metric_t ps_lua_largeallocs = {0};
+static ps_metric_t ps_lua_allocbytes = {0};
+static ps_metric_t ps_lua_freebytes = {0};
+
 // Columns for perfstats pages.
 
 // Position on screen is determined separately in the drawing functions.
@@ -106,7 +117,10 @@ perfstatrow_t rendertime_rows[] = {
 	{" portals", " Portals:       ", &ps_sw_portaltime, PS_TIME|PS_LEVEL|PS_SW},
 	{" planes ", " R_DrawPlanes:  ", &ps_sw_planetime, PS_TIME|PS_LEVEL|PS_SW},
 	{" masked ", " R_DrawMasked:  ", &ps_sw_maskedtime, PS_TIME|PS_LEVEL|PS_SW},
+	{"  sprsrt", "  Sprite sort:  ", &ps_sw_spritesorttime, PS_TIME|PS_LEVEL|PS_SW},
 	{" other  ", " Other:         ", &ps_otherrendertime, PS_TIME|PS_LEVEL|PS_SW},
+	{" serial ", " Views serial:  ", &ps_sw_serialviewstime, PS_TIME|PS_LEVEL|PS_SW|PS_HIDE_ZERO},
+	{" thread ", " Views threaded:", &ps_sw_threadedviewstime, PS_TIME|PS_LEVEL|PS_SW|PS_HIDE_ZERO},
 
 	{"ui     ", "UI render:     ", &ps_uitime, PS_TIME},
 	{"finupdt", "I_FinishUpdate:", &ps_swaptime, PS_TIME},
@@ -155,6 +169,9 @@ perfstatrow_t gamelogic_rows[] = {
 	{"logic  ", "Game logic:     ", &ps_tictime, PS_TIME},
 	{" plrthnk", " P_PlayerThink:  ", &ps_playerthink_time, PS_TIME|PS_LEVEL},
 	{" thnkers", " P_RunThinkers:  ", &ps_thinkertime, PS_TIME|PS_LEVEL},
+	{"  lmthnk", "  Lua mobjthink: ", &ps_lua_mobjthinker_time, PS_TIME|PS_LEVEL},
+	{"  lmcoll", "  Lua mobjcoll:  ", &ps_lua_mobjcollide_time, PS_TIME|PS_LEVEL},
+	{"  lmhook", "  Lua mobjhooks: ", &ps_lua_mobjhook_time, PS_TIME|PS_LEVEL},
 /*	{"  plyobjs", "  Polyobjects:    ", &ps_thlist_times[THINK_POLYOBJ], PS_TIME|PS_LEVEL},
 	{"  main   ", "  Main:           ", &ps_thlist_times[THINK_MAIN], PS_TIME|PS_LEVEL},
 	{"  mobjs  ", "  Mobjs:          ", &ps_thlist_times[THINK_MOBJ], PS_TIME|PS_LEVEL},
@@ -174,7 +191,8 @@ perfstatrow_t thinkercount_rows[] = {
 	{"  scenery", "  Scenery:        ", &ps_scenerycount, PS_LEVEL},
 	{"  nothink", "  Nothink:        ", &ps_nothinkcount, PS_HIDE_ZERO|PS_LEVEL},
 	{" precip ", " Precipitation:  ", &ps_precipcount, PS_LEVEL},
-	{" other  ", " Other:          ", &ps_otherthcount, PS_LEVEL},
+	{" polyobj", " Polyobjects:    ", &ps_polythcount, PS_HIDE_ZERO|PS_LEVEL},
+	{" main   ", " Level specials: ", &ps_mainthcount, PS_LEVEL},
 	{" remove ", " Pending removal:", &ps_removecount, PS_LEVEL},
 	{0}
 };
@@ -185,6 +203,19 @@ perfstatrow_t misc_calls_rows[] = {
 	{0}
 };
 
+// Lua memory stats columns
+
+// How much Lua allocates and frees per tic is what the garbage collector
+// has to keep up with, so a mod that thrashes shows up here.
+perfstatrow_t luamemory_rows[] = {
+	{"heap KB", "Lua heap KB:    ", &ps_lua_heapsize, 0},
+	{"allocs ", "Allocations:    ", &ps_lua_allocs, 0},
+	{" large ", " Large:         ", &ps_lua_largeallocs, 0},
+	{"alloc B", "Bytes allocated:", &ps_lua_allocbytes, 0},
+	{"freed B", "Bytes freed:    ", &ps_lua_freebytes, 0},
+	{0}
+};
+
 // Sample collection status for averaging.
 // Maximum of these two is shown to user if nonzero to tell that
 // the reported averages are not correct yet.
@@ -566,6 +597,7 @@ static void PS_UpdateFrameStats(void)
 static void PS_CountThinkers(void)
 {
 	thinker_t *thinker;
+	UINT8 i;
 
 	ps_thinkercount.value.i = 0;
 	ps_mobjcount.value.i = 0;
@@ -573,35 +605,19 @@ static void PS_CountThinkers(void)
 	ps_scenerycount.value.i = 0;
 	ps_nothinkcount.value.i = 0;
 	ps_precipcount.value.i = 0;
-	ps_otherthcount.value.i = 0;
+	ps_polythcount.value.i = 0;
+	ps_mainthcount.value.i = 0;
 	ps_removecount.value.i = 0;
-	for (thinker = thinkercap.next; thinker != &thinkercap; thinker = thinker->next)
+	for (i = 0; i < NUM_THINKERLISTS; i++)
 	{
-		if (thinker->function.acp1 != (actionf_p1)P_NullPrecipThinker)
-			ps_thinkercount.value.i++;
-
-		if (thinker->function.acp1 == (actionf_p1)P_RemoveThinkerDelayed)
-			ps_removecount.value.i++;
-		else if (thinker->function.acp1 == (actionf_p1)P_MobjThinker)
-		{
-			mobj_t *mobj = (mobj_t*)thinker;
-			ps_mobjcount.value.i++;
-			if (mobj->flags & MF_NOTHINK)
-				ps_nothinkcount.value.i++;
-			else if (mobj->flags & MF_SCENERY)
-				ps_scenerycount.value.i++;
-			else
-				ps_regularcount.value.i++;
-		}
-		else if (thinker->function.acp1 == (actionf_p1)P_NullPrecipThinker)
-			ps_precipcount.value.i++;
-		else
-			ps_otherthcount.value.i++;
-	}
-	/*for (i = 0; i < NUM_THINKERLISTS; i++)
-	{
-		for (thinker = thlist[i].next; thinker != &thlist[i]; thinker = thinker->next)
+		for (thinker = thlist[i].cnext; thinker != &thlist[i]; thinker = thinker->cnext)
 		{
+			if (i == THINK_PRECIP)
+			{
+				ps_precipcount.value.i++;
+				continue;
+			}
+
 			ps_thinkercount.value.i++;
 			if (thinker->function.acp1 == (actionf_p1)P_RemoveThinkerDelayed)
 				ps_removecount.value.i++;
@@ -611,29 +627,51 @@ static void PS_CountThinkers(void)
 				ps_mainthcount.value.i++;
 			else if (i == THINK_MOBJ)
 			{
-				if (thinker->function.acp1 == (actionf_p1)P_MobjThinker)
-				{
-					mobj_t *mobj = (mobj_t*)thinker;
-					ps_mobjcount.value.i++;
-					if (mobj->flags & MF_NOTHINK)
-						ps_nothinkcount.value.i++;
-					else if (mobj->flags & MF_SCENERY)
-						ps_scenerycount.value.i++;
-					else
-						ps_regularcount.value.i++;
-				}
+				mobj_t *mobj = (mobj_t*)thinker;
+				ps_mobjcount.value.i++;
+				if (mobj->flags & MF_NOTHINK)
+					ps_nothinkcount.value.i++;
+				else if (mobj->flags & MF_SCENERY)
+					ps_scenerycount.value.i++;
+				else
+					ps_regularcount.value.i++;
 			}
-			else if (i == THINK_DYNSLOPE)
-				ps_dynslopethcount.value.i++;
-			else if (i == THINK_PRECIP)
-				ps_precipcount.value.i++;
 		}
-	}*/
+	}
+}
+
+// Game logic time not spent in any of the other game logic rows
+static void PS_UpdateOtherLogicTime(void)
+{
+	ps_otherlogictime.value.p =
+		ps_tictime.value.p -
+		ps_playerthink_time.value.p -
+		ps_thinkertime.value.p -
+		ps_lua_prethinkframe_time.value.p -
+		ps_lua_thinkframe_time.value.p -
+		ps_lua_postthinkframe_time.value.p;
+}
+
+// Lua allocator totals turned into per-tic values.
+// Kept up to date every tic so switching pages doesn't show one huge spike.
+static void PS_UpdateLuaMemoryStats(void)
+{
+	static luaheapstats_t last;
+
+	ps_lua_heapsize.value.i = (INT32)((luaheapstats.allocbytes - luaheapstats.freebytes)>>10);
+	ps_lua_allocs.value.i = (INT32)(luaheapstats.allocs - last.allocs);
+	ps_lua_largeallocs.value.i = (INT32)(luaheapstats.largeallocs - last.largeallocs);
+	ps_lua_allocbytes.value.i = (INT32)(luaheapstats.allocbytes - last.allocbytes);
+	ps_lua_freebytes.value.i = (INT32)(luaheapstats.freebytes - last.freebytes);
+
+	last = luaheapstats;
 }
 
 // Update all metrics that are calculated on every tick.
 void PS_UpdateTickStats(void)
 {
+	PS_UpdateLuaMemoryStats();
+
 	if (cv_perfstats.value == 1 && cv_ps_samplesize.value > 1)
 	{
 		PS_UpdateRowHistories(gamelogicbrief_row, false);
@@ -642,16 +680,7 @@ void PS_UpdateTickStats(void)
 	{
 		if (PS_IsLevelActive())
 		{
-			ps_otherlogictime.value.p =
-				ps_tictime.value.p -
-				ps_playerthink_time.value.p -
-				ps_thinkertime.value.p -
-				ps_lua_prethinkframe_time.value.p -
-				ps_lua_thinkframe_time.value.p -
-				ps_lua_postthinkframe_time.value.p;
-
-
-
+			PS_UpdateOtherLogicTime();
 			PS_CountThinkers();
 		}
 
@@ -662,9 +691,13 @@ void PS_UpdateTickStats(void)
 			PS_UpdateRowHistories(misc_calls_rows, false);
 		}
 	}
+	if (cv_perfstats.value == 6 && cv_ps_samplesize.value > 1)
+	{
+		PS_UpdateRowHistories(luamemory_rows, false);
+	}
 	if (cv_ps_samplesize.value > 1)
 	{
-		if(cv_perfstats.value >= 3 && PS_IsLevelActive())
+		if(cv_perfstats.value >= 3 && cv_perfstats.value <= 5 && PS_IsLevelActive())
 		{
 						int i;
 			if (cv_perfstats.value == 3)
@@ -696,6 +729,61 @@ void PS_UpdateTickStats(void)
 	}
 }
 
+// Running totals of the game logic and call count rows, in row order,
+// for reports over a whole run like -simulate's
+
+#define PS_MAXTOTALS 24
+
+static perfstatrow_t *totals_rows[] = {gamelogic_rows, misc_calls_rows, luamemory_rows, NULL};
+static INT64 ps_totals[PS_MAXTOTALS];
+
+void PS_ResetTickTotals(void)
+{
+	memset(ps_totals, 0, sizeof (ps_totals));
+}
+
+// Adds this tick's values to the totals. Call after ps_tictime is stopped.
+void PS_AddTickTotals(void)
+{
+	perfstatrow_t **rows, *row;
+	int i = 0;
+
+	PS_UpdateOtherLogicTime();
+
+	for (rows = totals_rows; *rows; rows++)
+		for (row = *rows; row->lores_label && i < PS_MAXTOTALS; row++, i++)
+		{
+			if (!PS_IsRowValid(row))
+				continue;
+			if (row->flags & PS_TIME)
+				ps_totals[i] += (INT64)row->metric->value.p;
+			else
+				ps_totals[i] += row->metric->value.i;
+		}
+}
+
+// Prints the totals, and what they come to per tick, to the console.
+void PS_PrintTickTotals(tic_t tics)
+{
+	const double precision = I_GetPrecisePrecision();
+	perfstatrow_t **rows, *row;
+	int i = 0;
+
+	if (!tics)
+		return;
+
+	for (rows = totals_rows; *rows; rows++)
+		for (row = *rows; row->lores_label && i < PS_MAXTOTALS; row++, i++)
+		{
+			if (row->flags & PS_TIME)
+				CONS_Printf("%s %10.3f ms total, %8.2f us/tic\n", row->hires_label,
+					ps_totals[i] * 1000.0 / precision, ps_totals[i] * 1000000.0 / precision / tics);
+			else
+				CONS_Printf("%s %10s total, %8.2f per tic\n", row->hires_label,
+					sizeu1((size_t)ps_totals[i]), (double)ps_totals[i] / tics);
+		}
+}
+
 static void PS_DrawDescriptorHeader(void)
 {
 	if (cv_ps_samplesize.value > 1)
@@ -712,7 +800,7 @@ static void PS_DrawDescriptorHeader(void)
 		int samples_left = max(ps_frame_samples_left, ps_tick_samples_left);
 		int x, y;
 
-		if (cv_perfstats.value >= 3)		
+		if (cv_perfstats.value >= 3 && cv_perfstats.value <= 5)
 		{
 			x = 2;
 			y = 0;
@@ -799,6 +887,43 @@ static void PS_DrawGameLogicStats(void)
 	PS_DrawPerfRows(x, y, V_PURPLEMAP, misc_calls_rows);
 }
 
+static void PS_DrawLuaMemoryStats(void)
+{
+	const boolean hires = PS_HighResolution();
+	const INT32 flags = V_MONOSPACE | V_ALLOWLOWERCASE;
+	const int row = hires ? 5 : 8;
+	int i, x, y;
+
+	PS_DrawDescriptorHeader();
+
+	PS_DrawPerfRows(20, 10, V_YELLOWMAP, luamemory_rows);
+
+	// Size classes, drawn straight from the allocator since they aren't per-tic values
+	x = hires ? 115 : 100;
+	y = 10;
+	if (hires)
+		V_DrawSmallString(x, y, flags | V_BLUEMAP, "Class   Live   Peak  Slabs  Allocs");
+	else
+		V_DrawThinString(x, y, flags | V_BLUEMAP, "Class  Live  Peak Slabs");
+	y += row;
+
+	for (i = 0; i < LUA_NUMSIZECLASSES; i++)
+	{
+		const luasizeclass_t *sc = &luaheapstats.classes[i];
+
+		if (!sc->slabs)
+			continue;
+
+		if (hires)
+			V_DrawSmallString(x, y, flags, va("%5s %6u %6u %6u %7u",
+				sizeu1(sc->size), sc->live, sc->peak, sc->slabs, sc->allocs));
+		else
+			V_DrawThinString(x, y, flags, va("%5s %5u %5u %5u",
+				sizeu1(sc->size), sc->live, sc->peak, sc->slabs));
+		y += row;
+	}
+}
+
 // Maybe needs to be defined in header, with some prefix like PS_, but eh,
 // works like that too. Just need to (un)define it outside so
 // PS_ThinkFrame_Page_OnChange can see this too
@@ -973,6 +1098,10 @@ void M_DrawPerfStats(void)
 		// tics when frame skips happen
 		PS_DrawGameLogicStats();
 	}
+	else if (cv_perfstats.value == 6) // lua memory
+	{
+		PS_DrawLuaMemoryStats();
+	}
 	else if (cv_perfstats.value >= 3) // lua thinkframe	
 	{
 		if (!PS_IsLevelActive())
@@ -48,6 +48,9 @@ extern ps_metric_t ps_lua_prethinkframe_time;
 extern ps_metric_t ps_lua_thinkframe_time;
 extern ps_metric_t ps_lua_postthinkframe_time;
 extern ps_metric_t ps_lua_mobjhooks;
+extern ps_metric_t ps_lua_mobjthinker_time;
+extern ps_metric_t ps_lua_mobjcollide_time;
+extern ps_metric_t ps_lua_mobjhook_time;
 
 extern ps_metric_t ps_otherlogictime;
 
@@ -58,6 +61,10 @@ void PS_SetPostThinkFrameHookInfo(int index, precise_t time_taken, char* short_s
 
 void PS_UpdateTickStats(void);
 
+void PS_ResetTickTotals(void);
+void PS_AddTickTotals(void);
+void PS_PrintTickTotals(tic_t tics);
+
 void M_DrawPerfStats(void);
 
 void PS_PerfStats_OnChange(void);
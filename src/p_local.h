@@ -66,9 +66,12 @@
 
 // both the head and tail of the thinker list
 extern thinker_t thinkercap;
+// heads of the per-class thinker lists, linked through cprev/cnext
+extern thinker_t thlist[NUM_THINKERLISTS];
 
 void P_InitThinkers(void);
-void P_AddThinker(thinker_t *thinker);
+void P_AddThinker(const thinklistnum_t n, thinker_t *thinker);
+void P_AddThinkerFront(const thinklistnum_t n, thinker_t *thinker);
 void P_RemoveThinker(thinker_t *thinker);
 void P_UnlinkThinker(thinker_t *thinker);
 
@@ -395,6 +398,7 @@ boolean P_DoSpring(mobj_t *spring, mobj_t *object);
 // P_SETUP
 //
 extern UINT8 *rejectmatrix; // for fast sight rejection
+extern size_t rejectmatrixsize;
 extern INT32 *blockmaplump; // offsets in blockmap are from here
 extern INT32 *blockmap; // Big blockmap
 extern INT32 bmapwidth;
@@ -3743,7 +3743,7 @@ static boolean PIT_ChangeSector(mobj_t *thing, boolean realcrush)
 						thinker_t *think;
 						elevator_t *crumbler;
 
-						for (think = thinkercap.next; think != &thinkercap; think = think->next)
+						for (think = thlist[THINK_MAIN].cnext; think != &thlist[THINK_MAIN]; think = think->cnext)
 						{
 							if (think->function.acp1 != (actionf_p1)T_StartCrumble)
 								continue;
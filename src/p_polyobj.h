@@ -83,7 +83,6 @@ typedef struct polyobj_s
 
 	degenmobj_t spawnSpot; // location of spawn spot
 	vertex_t    centerPt;  // center point
-	fixed_t zdist;         // viewz distance for sorting
 	angle_t angle;         // for rotation
 	UINT8 attached;         // if true, is attached to a subsector
 
@@ -99,8 +98,6 @@ typedef struct polyobj_s
 	UINT8 isBad;         // a bad polyobject: should not be rendered/manipulated
 	INT32 translucency; // index to translucency tables
 
-	struct visplane_s *visplane; // polyobject's visplane, for ease of putting into the list later
-
 	// these are saved for netgames, so do not let Lua touch these!
 	INT32 spawnflags; // Flags the polyobject originally spawned with
 } polyobj_t;
@@ -0,0 +1,782 @@
+// SONIC ROBO BLAST 2
+//-----------------------------------------------------------------------------
+// Copyright (C) 1998-2000 by DooM Legacy Team.
+// Copyright (C) 1999-2018 by Sonic Team Junior.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  p_reject.c
+/// \brief Builds a REJECT table for maps that don't ship one
+///
+///	Sight is traced in 2D through the two-sided lines of the map: a sector
+///	is only rejected from another if no straight line can get from one to
+///	the other through openings at all. Heights, FOFs and polyobjects are
+///	ignored, so the table only ever rejects pairs P_CheckSight would have
+///	failed anyway, and games with and without it stay in sync.
+
+#include <math.h>
+
+#include "doomdef.h"
+#include "byteptr.h"
+#include "command.h"
+#include "d_main.h" // srb2home
+#include "i_system.h"
+#include "i_threads.h"
+#include "m_misc.h"
+#include "p_local.h"
+#include "p_setup.h"
+#include "r_state.h"
+#include "z_zone.h"
+
+consvar_t cv_buildreject = {"buildreject", "Off", CV_NETVAR, CV_OnOff, NULL, 0, NULL, NULL, 0, 0, NULL};
+
+// Bump whenever the output can change, old cache files are rebuilt
+#define REJECTVERSION 1
+#define REJECTMAGIC "RJCT"
+#define REJECTHEADERSIZE 20
+
+#define REJECTCACHEDIR "reject"
+
+#define REJECTMAXSECTORS 16384 // the work matrix alone is 32MB at this size
+#define REJECTMAXWORKERS 4 // including the main thread
+
+// Flow gives up on a source sector and lets it see everything past these
+#define REJECTMAXVISITS (1<<15)
+#define REJECTMAXDEPTH 1024
+
+// Map units; rounding only ever lets more through
+#define REJECTEPSILON 0.5
+#define REJECTSIDEEPSILON 0.000001 // far enough from a line to trust the side
+
+typedef struct
+{
+	double x1, y1, x2, y2;
+	double nx, ny, nd; // unit normal pointing into the destination sector
+	size_t line;
+	size_t to;
+} rejectportal_t;
+
+// The part of a portal a straight line from the source can still go through
+typedef struct
+{
+	double x1, y1, x2, y2;
+	const rejectportal_t *portal;
+} rejectpass_t;
+
+// Keeps nx*x + ny*y >= nd
+typedef struct
+{
+	double nx, ny, nd;
+} rejectplane_t;
+
+// How much of a portal was already flowed through from one source portal,
+// counting only flows that finished without being cut short by the stack
+typedef struct
+{
+	UINT32 gen;
+	boolean used;
+	double t0, t1;
+} rejectmemo_t;
+
+typedef struct
+{
+	UINT8 *row; // sectors visible from the current source
+	UINT8 *instack;
+	rejectmemo_t *memo;
+	UINT32 gen;
+	size_t numvisible;
+	size_t visits;
+	size_t depth;
+	size_t stackhits; // portals skipped for already being in the stack
+	boolean abort;
+} rejectworker_t;
+
+static rejectportal_t *rejectportals;
+static size_t numrejectportals;
+static size_t *sectorportals; // portals leading out of each sector, by sector
+static size_t *sectorportalstart; // numsectors + 1 entries
+static UINT8 *leakysectors;
+
+static UINT8 *rejectvisible; // numsectors rows of rejectrowbytes
+static size_t rejectrowbytes;
+static size_t rejectnext;
+static size_t rejectdone; // rows actually built
+
+#ifdef HAVE_THREADS
+static I_mutex reject_mutex;
+static I_cond reject_cond;
+static UINT8 rejectbusy;
+#endif
+
+//
+// RJ_ClipSegment
+// Keeps the part of a segment in front of a line.
+// Returns false if nothing is left.
+//
+static boolean RJ_ClipSegment(rejectpass_t *seg, const rejectplane_t *plane)
+{
+	double d1 = plane->nx*seg->x1 + plane->ny*seg->y1 - plane->nd + REJECTEPSILON;
+	double d2 = plane->nx*seg->x2 + plane->ny*seg->y2 - plane->nd + REJECTEPSILON;
+	double f;
+
+	if (d1 >= 0.0 && d2 >= 0.0)
+		return true;
+	if (d1 < 0.0 && d2 < 0.0)
+		return false;
+
+	f = d1 / (d1 - d2);
+
+	if (d1 < 0.0)
+	{
+		seg->x1 += (seg->x2 - seg->x1) * f;
+		seg->y1 += (seg->y2 - seg->y1) * f;
+	}
+	else
+	{
+		seg->x2 = seg->x1 + (seg->x2 - seg->x1) * f;
+		seg->y2 = seg->y1 + (seg->y2 - seg->y1) * f;
+	}
+	return true;
+}
+
+//
+// RJ_MakeSeparators
+// Any line going through both src and pass stays between the lines that
+// join one end of each with src and pass on opposite sides. Lines that
+// can't be told apart are skipped. Returns how many planes were added.
+//
+static UINT8 RJ_MakeSeparators(const rejectportal_t *src, const rejectpass_t *pass, rejectplane_t *planes)
+{
+	const double sx[2] = {src->x1, src->x2}, sy[2] = {src->y1, src->y2};
+	const double px[2] = {pass->x1, pass->x2}, py[2] = {pass->y1, pass->y2};
+	double nx, ny, nd, len, ds, dp;
+	UINT8 i, j, n = 0;
+
+	for (i = 0; i < 2; i++)
+		for (j = 0; j < 2; j++)
+		{
+			nx = sy[i] - py[j];
+			ny = px[j] - sx[i];
+			len = sqrt(nx*nx + ny*ny);
+			if (len < REJECTSIDEEPSILON)
+				continue;
+
+			nx /= len;
+			ny /= len;
+			nd = nx*sx[i] + ny*sy[i];
+
+			ds = nx*sx[i^1] + ny*sy[i^1] - nd;
+			dp = nx*px[j^1] + ny*py[j^1] - nd;
+			if (fabs(ds) < REJECTSIDEEPSILON || fabs(dp) < REJECTSIDEEPSILON)
+				continue;
+			if ((ds < 0.0) == (dp < 0.0))
+				continue;
+
+			if (dp < 0.0)
+			{
+				nx = -nx;
+				ny = -ny;
+				nd = -nd;
+			}
+
+			planes[n].nx = nx;
+			planes[n].ny = ny;
+			planes[n].nd = nd;
+			n++;
+		}
+
+	return n;
+}
+
+static void RJ_SegmentRange(const rejectportal_t *portal, const rejectpass_t *seg, double *t1, double *t2)
+{
+	double dx = portal->x2 - portal->x1, dy = portal->y2 - portal->y1;
+	double len2 = dx*dx + dy*dy;
+
+	*t1 = ((seg->x1 - portal->x1)*dx + (seg->y1 - portal->y1)*dy) / len2;
+	*t2 = ((seg->x2 - portal->x1)*dx + (seg->y2 - portal->y1)*dy) / len2;
+
+	if (*t1 > *t2)
+	{
+		double t = *t1;
+		*t1 = *t2;
+		*t2 = t;
+	}
+}
+
+//
+// RJ_Explored
+// Everything a line through src and seg can reach was already flowed
+// through if a wider part of the same portal was. Otherwise seg is widened
+// to cover everything seen of the portal so far, so that the next time
+// round is more likely to be covered.
+//
+static boolean RJ_Explored(rejectworker_t *w, size_t portalnum, rejectpass_t *seg)
+{
+	const rejectportal_t *portal = &rejectportals[portalnum];
+	rejectmemo_t *memo = &w->memo[portalnum];
+	double dx = portal->x2 - portal->x1, dy = portal->y2 - portal->y1;
+	double t1, t2;
+
+	if (memo->gen != w->gen)
+	{
+		memo->gen = w->gen;
+		memo->used = false;
+	}
+
+	if (!memo->used)
+		return false;
+
+	RJ_SegmentRange(portal, seg, &t1, &t2);
+
+	if (memo->t0 <= t1 && memo->t1 >= t2)
+		return true;
+
+	// Flowing through more than is really visible only lets more through
+	t1 = min(t1, memo->t0);
+	t2 = max(t2, memo->t1);
+	seg->x1 = portal->x1 + dx*t1;
+	seg->y1 = portal->y1 + dy*t1;
+	seg->x2 = portal->x1 + dx*t2;
+	seg->y2 = portal->y1 + dy*t2;
+	return false;
+}
+
+//
+// RJ_Remember
+// Records seg as flowed through. Only called once the flow is over, and
+// only if nothing under it was skipped for being in the stack, since what
+// a flow reaches then depends on the path taken to it and not just on seg.
+//
+static void RJ_Remember(rejectworker_t *w, size_t portalnum, const rejectpass_t *seg)
+{
+	rejectmemo_t *memo = &w->memo[portalnum];
+	double t1, t2;
+
+	RJ_SegmentRange(&rejectportals[portalnum], seg, &t1, &t2);
+
+	if (memo->used)
+	{
+		t1 = min(t1, memo->t0);
+		t2 = max(t2, memo->t1);
+	}
+
+	memo->used = true;
+	memo->t0 = t1;
+	memo->t1 = t2;
+}
+
+static void RJ_MarkVisible(rejectworker_t *w, size_t s)
+{
+	if (w->row[s>>3] & (1<<(s&7)))
+		return;
+
+	w->row[s>>3] |= 1<<(s&7);
+
+	// Sight can leak out of an unclosed sector anywhere,
+	// and there's no point going on once everything is in
+	if (leakysectors[s] || ++w->numvisible == numsectors)
+		w->abort = true;
+}
+
+//
+// RJ_Flow
+// Marks every sector a straight line through src and pass can get into.
+//
+static void RJ_Flow(rejectworker_t *w, const rejectportal_t *src, const rejectpass_t *pass)
+{
+	const size_t sector = pass->portal->to;
+	rejectplane_t planes[6];
+	UINT8 numplanes, j;
+	size_t i;
+
+	planes[0].nx = src->nx;
+	planes[0].ny = src->ny;
+	planes[0].nd = src->nd;
+	planes[1].nx = pass->portal->nx;
+	planes[1].ny = pass->portal->ny;
+	planes[1].nd = pass->portal->nd;
+	numplanes = 2 + RJ_MakeSeparators(src, pass, &planes[2]);
+
+	for (i = sectorportalstart[sector]; i < sectorportalstart[sector + 1]; i++)
+	{
+		const size_t portalnum = sectorportals[i];
+		const rejectportal_t *portal = &rejectportals[portalnum];
+		rejectpass_t next;
+		size_t stackhits;
+
+		if (w->abort)
+			return;
+
+		if (portal->line == pass->portal->line)
+			continue;
+
+		if (w->instack[portalnum])
+		{
+			w->stackhits++;
+			continue;
+		}
+
+		if (++w->visits > REJECTMAXVISITS || w->depth >= REJECTMAXDEPTH)
+		{
+			w->abort = true;
+			return;
+		}
+
+		next.x1 = portal->x1;
+		next.y1 = portal->y1;
+		next.x2 = portal->x2;
+		next.y2 = portal->y2;
+		next.portal = portal;
+
+		for (j = 0; j < numplanes; j++)
+			if (!RJ_ClipSegment(&next, &planes[j]))
+				break;
+		if (j < numplanes)
+			continue;
+
+		if (RJ_Explored(w, portalnum, &next))
+			continue;
+
+		RJ_MarkVisible(w, portal->to);
+
+		stackhits = w->stackhits;
+		w->instack[portalnum] = 1;
+		w->depth++;
+		RJ_Flow(w, src, &next);
+		w->depth--;
+		w->instack[portalnum] = 0;
+
+		if (!w->abort && w->stackhits == stackhits)
+			RJ_Remember(w, portalnum, &next);
+	}
+}
+
+//
+// RJ_BuildRow
+// Finds every sector that might be seen from sector s.
+//
+static void RJ_BuildRow(rejectworker_t *w, size_t s)
+{
+	size_t i;
+
+	w->row = rejectvisible + s*rejectrowbytes;
+	w->numvisible = 0;
+	w->visits = 0;
+	w->depth = 0;
+	w->stackhits = 0;
+	w->abort = false;
+
+	RJ_MarkVisible(w, s);
+
+	for (i = sectorportalstart[s]; i < sectorportalstart[s + 1] && !w->abort; i++)
+	{
+		const size_t portalnum = sectorportals[i];
+		const rejectportal_t *portal = &rejectportals[portalnum];
+		rejectpass_t pass;
+
+		pass.x1 = portal->x1;
+		pass.y1 = portal->y1;
+		pass.x2 = portal->x2;
+		pass.y2 = portal->y2;
+		pass.portal = portal;
+
+		w->gen++;
+		RJ_MarkVisible(w, portal->to);
+
+		w->instack[portalnum] = 1;
+		RJ_Flow(w, portal, &pass);
+		w->instack[portalnum] = 0;
+	}
+
+	if (w->abort)
+	{
+		memset(w->instack, 0, numrejectportals);
+		memset(w->row, 0xFF, rejectrowbytes);
+	}
+}
+
+static size_t RJ_NextSector(void)
+{
+	size_t s;
+#ifdef HAVE_THREADS
+	I_lock_mutex(&reject_mutex);
+#endif
+	s = rejectnext++;
+#ifdef HAVE_THREADS
+	I_unlock_mutex(reject_mutex);
+#endif
+	return s;
+}
+
+static void RJ_Work(rejectworker_t *w)
+{
+	size_t s;
+
+	while ((s = RJ_NextSector()) < numsectors)
+	{
+#ifdef HAVE_THREADS
+		if (I_thread_is_stopped())
+			break;
+#endif
+		RJ_BuildRow(w, s);
+#ifdef HAVE_THREADS
+		I_lock_mutex(&reject_mutex);
+#endif
+		rejectdone++;
+#ifdef HAVE_THREADS
+		I_unlock_mutex(reject_mutex);
+#endif
+	}
+}
+
+#ifdef HAVE_THREADS
+static void RJ_Worker(void *userdata)
+{
+	RJ_Work(userdata);
+
+	I_lock_mutex(&reject_mutex);
+	rejectbusy--;
+	I_wake_all_cond(&reject_cond);
+	I_unlock_mutex(reject_mutex);
+}
+#endif
+
+//
+// RJ_MakePortals
+// Every line with a back side is a way through, whatever its flags say,
+// since those can be changed in-game.
+//
+static void RJ_MakePortals(void)
+{
+	size_t i, s, n = 0;
+
+	rejectportals = Z_Malloc(2 * numlines * sizeof (*rejectportals), PU_STATIC, NULL);
+	sectorportalstart = Z_Calloc((numsectors + 1) * sizeof (*sectorportalstart), PU_STATIC, NULL);
+
+	for (i = 0; i < numlines; i++)
+	{
+		const line_t *ld = &lines[i];
+		double x1, y1, x2, y2, nx, ny, len;
+
+		if (!ld->frontsector || !ld->backsector)
+			continue;
+
+		x1 = (double)ld->v1->x / FRACUNIT;
+		y1 = (double)ld->v1->y / FRACUNIT;
+		x2 = (double)ld->v2->x / FRACUNIT;
+		y2 = (double)ld->v2->y / FRACUNIT;
+
+		len = sqrt((x2 - x1)*(x2 - x1) + (y2 - y1)*(y2 - y1));
+		if (len < REJECTEPSILON)
+			continue;
+
+		// The front side is to the right of v1 -> v2
+		nx = (y1 - y2) / len;
+		ny = (x2 - x1) / len;
+
+		for (s = 0; s < 2; s++)
+		{
+			rejectportal_t *portal = &rejectportals[n++];
+			const sector_t *from = s ? ld->backsector : ld->frontsector;
+			const sector_t *to = s ? ld->frontsector : ld->backsector;
+
+			portal->x1 = x1;
+			portal->y1 = y1;
+			portal->x2 = x2;
+			portal->y2 = y2;
+			portal->nx = s ? -nx : nx;
+			portal->ny = s ? -ny : ny;
+			portal->nd = portal->nx*x1 + portal->ny*y1;
+			portal->line = i;
+			portal->to = to - sectors;
+
+			sectorportalstart[from - sectors + 1]++;
+		}
+	}
+
+	numrejectportals = n;
+
+	for (s = 0; s < numsectors; s++)
+		sectorportalstart[s + 1] += sectorportalstart[s];
+
+	sectorportals = Z_Malloc((n + 1) * sizeof (*sectorportals), PU_STATIC, NULL);
+	{
+		size_t *fill = Z_Malloc(numsectors * sizeof (*fill), PU_STATIC, NULL);
+		M_Memcpy(fill, sectorportalstart, numsectors * sizeof (*fill));
+
+		for (i = 0; i < n; i++)
+		{
+			// Portals come in pairs, front to back first
+			const line_t *ld = &lines[rejectportals[i].line];
+			const sector_t *from = (i & 1) ? ld->backsector : ld->frontsector;
+			sectorportals[fill[from - sectors]++] = i;
+		}
+
+		Z_Free(fill);
+	}
+}
+
+//
+// RJ_FindLeaks
+// A sector whose lines don't close up can't be trusted to keep sight out,
+// so anything that can see it sees everything.
+//
+static void RJ_FindLeaks(void)
+{
+	UINT8 *odd = Z_Calloc(numvertexes, PU_STATIC, NULL);
+	size_t s, i;
+
+	leakysectors = Z_Calloc(numsectors, PU_STATIC, NULL);
+
+	for (s = 0; s < numsectors; s++)
+	{
+		const sector_t *sec = &sectors[s];
+
+		for (i = 0; i < sec->linecount; i++)
+		{
+			const line_t *ld = sec->lines[i];
+			if ((ld->frontsector == sec) != (ld->backsector == sec))
+			{
+				odd[ld->v1 - vertexes] ^= 1;
+				odd[ld->v2 - vertexes] ^= 1;
+			}
+		}
+
+		for (i = 0; i < sec->linecount; i++)
+		{
+			const line_t *ld = sec->lines[i];
+			if (odd[ld->v1 - vertexes] || odd[ld->v2 - vertexes])
+				leakysectors[s] = 1;
+			odd[ld->v1 - vertexes] = odd[ld->v2 - vertexes] = 0;
+		}
+	}
+
+	Z_Free(odd);
+}
+
+//
+// RJ_BuildMatrix
+// Flows sight out of every sector, split across threads, and rejects the
+// pairs that can't see each other either way round. Returns false if the
+// workers were stopped before every row was built.
+//
+static boolean RJ_BuildMatrix(void)
+{
+	rejectworker_t workers[REJECTMAXWORKERS];
+	UINT8 numworkers = 1, i;
+	size_t a, b;
+
+	RJ_MakePortals();
+	RJ_FindLeaks();
+
+	rejectrowbytes = (numsectors + 7) / 8;
+	rejectvisible = Z_Calloc(numsectors * rejectrowbytes, PU_STATIC, NULL);
+	rejectnext = rejectdone = 0;
+
+#ifdef HAVE_THREADS
+	numworkers = REJECTMAXWORKERS;
+#endif
+
+	// Workers must not touch the zone, so they get everything up front
+	for (i = 0; i < numworkers; i++)
+	{
+		workers[i].instack = Z_Calloc(numrejectportals + 1, PU_STATIC, NULL);
+		workers[i].memo = Z_Calloc((numrejectportals + 1) * sizeof (rejectmemo_t), PU_STATIC, NULL);
+		workers[i].gen = 0;
+	}
+
+#ifdef HAVE_THREADS
+	rejectbusy = numworkers - 1;
+	for (i = 1; i < numworkers; i++)
+		I_spawn_thread("reject-worker", RJ_Worker, &workers[i]);
+#endif
+
+	RJ_Work(&workers[0]);
+
+#ifdef HAVE_THREADS
+	I_lock_mutex(&reject_mutex);
+	while (rejectbusy)
+		I_hold_cond(&reject_cond, reject_mutex);
+	I_unlock_mutex(reject_mutex);
+#endif
+
+	for (i = 0; i < numworkers; i++)
+	{
+		Z_Free(workers[i].instack);
+		Z_Free(workers[i].memo);
+	}
+
+	// A row that was never built would reject everything, so don't guess
+	if (rejectdone == numsectors)
+	{
+		rejectmatrixsize = (numsectors * numsectors + 7) / 8;
+		rejectmatrix = Z_Calloc(rejectmatrixsize, PU_LEVEL, NULL);
+	}
+
+	for (a = 0; rejectmatrix && a < numsectors; a++)
+	{
+		const UINT8 *rowa = rejectvisible + a*rejectrowbytes;
+		for (b = 0; b < numsectors; b++)
+		{
+			const UINT8 *rowb = rejectvisible + b*rejectrowbytes;
+			size_t pnum;
+
+			if ((rowa[b>>3] & (1<<(b&7))) || (rowb[a>>3] & (1<<(a&7))))
+				continue;
+
+			pnum = a*numsectors + b;
+			rejectmatrix[pnum>>3] |= 1<<(pnum&7);
+		}
+	}
+
+	Z_Free(rejectvisible);
+	Z_Free(leakysectors);
+	Z_Free(sectorportals);
+	Z_Free(sectorportalstart);
+	Z_Free(rejectportals);
+	rejectvisible = leakysectors = NULL;
+	sectorportals = sectorportalstart = NULL;
+	rejectportals = NULL;
+
+	return (rejectmatrix != NULL);
+}
+
+//
+// RJ_GeometryChecksum
+// The map MD5 doesn't cover VERTEXES.
+//
+static UINT32 RJ_GeometryChecksum(void)
+{
+	UINT32 hash = 2166136261u;
+	size_t i;
+	UINT8 k;
+
+	for (i = 0; i < numvertexes; i++)
+	{
+		const UINT32 v[2] = {(UINT32)vertexes[i].x, (UINT32)vertexes[i].y};
+		for (k = 0; k < 8; k++)
+		{
+			hash ^= (v[k>>2] >> ((k&3)*8)) & 0xFF;
+			hash *= 16777619u;
+		}
+	}
+
+	return hash;
+}
+
+static const char *RJ_CachePath(void)
+{
+	char md5hex[33];
+	UINT8 i;
+
+	for (i = 0; i < 16; i++)
+		sprintf(&md5hex[i*2], "%02x", mapmd5[i]);
+
+	return va("%s" PATHSEP REJECTCACHEDIR PATHSEP "%s.rej", srb2home, md5hex);
+}
+
+static boolean RJ_LoadCache(const char *path, UINT32 checksum, size_t size)
+{
+	UINT8 *buffer = NULL, *p;
+	size_t length = FIL_ReadFile(path, &buffer);
+	boolean ok = false;
+
+	if (!length)
+		return false;
+
+	p = buffer + 4;
+	if (length == REJECTHEADERSIZE + size
+	&& !memcmp(buffer, REJECTMAGIC, 4)
+	&& READUINT32(p) == REJECTVERSION
+	&& READUINT32(p) == numsectors
+	&& READUINT32(p) == numvertexes
+	&& READUINT32(p) == checksum)
+	{
+		rejectmatrix = Z_Malloc(size, PU_LEVEL, NULL);
+		rejectmatrixsize = size;
+		M_Memcpy(rejectmatrix, p, size);
+		ok = true;
+	}
+
+	Z_Free(buffer);
+	return ok;
+}
+
+static void RJ_SaveCache(const char *path, UINT32 checksum, size_t size)
+{
+	UINT8 *buffer = Z_Malloc(REJECTHEADERSIZE + size, PU_STATIC, NULL);
+	UINT8 *p = buffer;
+
+	M_Memcpy(p, REJECTMAGIC, 4);
+	p += 4;
+	WRITEUINT32(p, REJECTVERSION);
+	WRITEUINT32(p, numsectors);
+	WRITEUINT32(p, numvertexes);
+	WRITEUINT32(p, checksum);
+	M_Memcpy(p, rejectmatrix, size);
+
+	I_mkdir(va("%s" PATHSEP REJECTCACHEDIR, srb2home), 0755);
+	if (!FIL_WriteFile(path, buffer, REJECTHEADERSIZE + size))
+		CONS_Debug(DBG_SETUP, "P_SetupRejectMatrix: couldn't write %s\n", path);
+
+	Z_Free(buffer);
+}
+
+//
+// P_SetupRejectMatrix
+// Fills in rejectmatrix for a map that didn't come with a usable one,
+// from the on-disk cache if this map was seen before.
+//
+void P_SetupRejectMatrix(void)
+{
+	const size_t size = (numsectors * numsectors + 7) / 8;
+	char *path;
+	UINT32 checksum;
+	precise_t t;
+
+	if (!cv_buildreject.value || !numsectors || numsectors > REJECTMAXSECTORS)
+		return;
+
+	if (rejectmatrix)
+	{
+		// Nodebuilders that don't make one still write a blank lump,
+		// and one that's too short is no use either
+		if (rejectmatrixsize >= size)
+		{
+			size_t i;
+			for (i = 0; i < size; i++)
+				if (rejectmatrix[i])
+					return;
+		}
+		Z_Free(rejectmatrix);
+		rejectmatrix = NULL;
+		rejectmatrixsize = 0;
+	}
+
+	checksum = RJ_GeometryChecksum();
+	path = Z_StrDup(RJ_CachePath());
+
+	if (RJ_LoadCache(path, checksum, size))
+	{
+		CONS_Debug(DBG_SETUP, "P_SetupRejectMatrix: loaded %s\n", path);
+		Z_Free(path);
+		return;
+	}
+
+	t = I_GetPreciseTime();
+	if (!RJ_BuildMatrix())
+	{
+		Z_Free(path);
+		return;
+	}
+	t = I_GetPreciseTime() - t;
+
+	CONS_Debug(DBG_SETUP, "P_SetupRejectMatrix: built %s sector table in %.2f ms\n",
+		sizeu1(numsectors), (double)t * 1000.0 / I_GetPrecisePrecision());
+
+	RJ_SaveCache(path, checksum, size);
+	Z_Free(path);
+}
@@ -921,7 +921,10 @@ static void P_NetUnArchiveWorld(savebuffer_t *save)
 		if (diff & LD_FLAG)
 			li->flags = READINT16(get);
 		if (diff & LD_SPECIAL)
+		{
 			li->special = READINT16(get);
+			P_MarkSpecialListsStale();
+		}
 		if (diff & LD_CLLCOUNT)
 			li->callcount = READINT16(get);
 
@@ -1766,8 +1769,7 @@ static void P_NetArchiveThinkers(savebuffer_t *save)
 	// save off the current thinkers
 	for (th = thinkercap.next; th != &thinkercap; th = th->next)
 	{
-		if (!(th->function.acp1 == (actionf_p1)P_RemoveThinkerDelayed
-		 || th->function.acp1 == (actionf_p1)P_NullPrecipThinker))
+		if (th->function.acp1 != (actionf_p1)P_RemoveThinkerDelayed)
 			numsaved++;
 
 		if (th->function.acp1 == (actionf_p1)P_MobjThinker)
@@ -1775,9 +1777,6 @@ static void P_NetArchiveThinkers(savebuffer_t *save)
 			SaveMobjThinker(save, th, tc_mobj);
 			continue;
 		}
-#ifdef PARANOIA
-		else if (th->function.acp1 == (actionf_p1)P_NullPrecipThinker);
-#endif
 		else if (th->function.acp1 == (actionf_p1)T_MoveCeiling)
 		{
 			SaveCeilingThinker(save, th, tc_ceiling);
@@ -1973,7 +1972,7 @@ mobj_t *P_FindNewPosition(UINT32 oldposition)
 	thinker_t *th;
 	mobj_t *mobj;
 
-	for (th = thinkercap.next; th != &thinkercap; th = th->next)
+	for (th = thlist[THINK_MOBJ].cnext; th != &thlist[THINK_MOBJ]; th = th->cnext)
 	{
 		if (th->function.acp1 != (actionf_p1)P_MobjThinker)
 			continue;
@@ -2305,7 +2304,7 @@ static void LoadMobjThinker(savebuffer_t *save, actionf_p1 thinker)
 			skyboxmo[0] = mobj;
 	}
 
-	P_AddThinker(&mobj->thinker);
+	P_AddThinker(THINK_MOBJ, &mobj->thinker);
 
 	if (diff2 & MD2_WAYPOINTCAP)
 		P_SetTarget(&waypointcap, mobj);
@@ -2347,7 +2346,7 @@ static void LoadSpecialLevelThinker(savebuffer_t *save, actionf_p1 thinker, UINT
 			ht->sector->floordata = ht;
 	}
 
-	P_AddThinker(&ht->thinker);
+	P_AddThinker(THINK_MAIN, &ht->thinker);
 }
 
 //
@@ -2376,7 +2375,7 @@ static void LoadCeilingThinker(savebuffer_t *save, actionf_p1 thinker)
 	ht->sourceline = READFIXED(save->p);
 	if (ht->sector)
 		ht->sector->ceilingdata = ht;
-	P_AddThinker(&ht->thinker);
+	P_AddThinker(THINK_MAIN, &ht->thinker);
 }
 
 //
@@ -2400,7 +2399,7 @@ static void LoadFloormoveThinker(savebuffer_t *save, actionf_p1 thinker)
 	ht->delaytimer = READFIXED(save->p);
 	if (ht->sector)
 		ht->sector->floordata = ht;
-	P_AddThinker(&ht->thinker);
+	P_AddThinker(THINK_MAIN, &ht->thinker);
 }
 
 //
@@ -2417,7 +2416,7 @@ static void LoadLightflashThinker(savebuffer_t *save, actionf_p1 thinker)
 	ht->minlight = READINT32(save->p);
 	if (ht->sector)
 		ht->sector->lightingdata = ht;
-	P_AddThinker(&ht->thinker);
+	P_AddThinker(THINK_MAIN, &ht->thinker);
 }
 
 //
@@ -2437,7 +2436,7 @@ static void LoadStrobeThinker(savebuffer_t *save, actionf_p1 thinker)
 	ht->brighttime = READINT32(save->p);
 	if (ht->sector)
 		ht->sector->lightingdata = ht;
-	P_AddThinker(&ht->thinker);
+	P_AddThinker(THINK_MAIN, &ht->thinker);
 }
 
 //
@@ -2456,7 +2455,7 @@ static void LoadGlowThinker(savebuffer_t *save, actionf_p1 thinker)
 	ht->speed = READINT32(save->p);
 	if (ht->sector)
 		ht->sector->lightingdata = ht;
-	P_AddThinker(&ht->thinker);
+	P_AddThinker(THINK_MAIN, &ht->thinker);
 }
 
 //
@@ -2475,7 +2474,7 @@ static void LoadFireflickerThinker(savebuffer_t *save, actionf_p1 thinker)
 	ht->minlight = READINT32(save->p);
 	if (ht->sector)
 		ht->sector->lightingdata = ht;
-	P_AddThinker(&ht->thinker);
+	P_AddThinker(THINK_MAIN, &ht->thinker);
 }
 
 //
@@ -2513,7 +2512,7 @@ static void LoadElevatorThinker(savebuffer_t *save, actionf_p1 thinker, UINT8 fl
 			ht->sector->floordata = ht;
 	}
 
-	P_AddThinker(&ht->thinker);
+	P_AddThinker(THINK_MAIN, &ht->thinker);
 }
 
 //
@@ -2535,7 +2534,7 @@ static void LoadScrollThinker(savebuffer_t *save, actionf_p1 thinker)
 	ht->accel = READINT32(save->p);
 	ht->exclusive = READINT32(save->p);
 	ht->type = READUINT8(save->p);
-	P_AddThinker(&ht->thinker);
+	P_AddThinker(THINK_MAIN, &ht->thinker);
 }
 
 //
@@ -2552,7 +2551,7 @@ static inline void LoadFrictionThinker(savebuffer_t *save, actionf_p1 thinker)
 	ht->affectee = READINT32(save->p);
 	ht->referrer = READINT32(save->p);
 	ht->roverfriction = READUINT8(save->p);
-	P_AddThinker(&ht->thinker);
+	P_AddThinker(THINK_MAIN, &ht->thinker);
 }
 
 //
@@ -2578,7 +2577,7 @@ static void LoadPusherThinker(savebuffer_t *save, actionf_p1 thinker)
 	ht->exclusive = READINT32(save->p);
 	ht->slider = READINT32(save->p);
 	ht->source = P_GetPushThing(ht->affectee);
-	P_AddThinker(&ht->thinker);
+	P_AddThinker(THINK_MAIN, &ht->thinker);
 }
 
 //
@@ -2598,7 +2597,7 @@ static inline void LoadLaserThinker(savebuffer_t *save, actionf_p1 thinker)
 		if (rover->secnum == (size_t)(ht->sec - sectors)
 		&& rover->master == ht->sourceline)
 			ht->ffloor = rover;
-	P_AddThinker(&ht->thinker);
+	P_AddThinker(THINK_MAIN, &ht->thinker);
 }
 
 //
@@ -2615,7 +2614,7 @@ FUNCINLINE static ATTRINLINE void LoadLightlevelThinker(savebuffer_t *save, acti
 	ht->speed = READINT32(save->p);
 	if (ht->sector)
 		ht->sector->lightingdata = ht;
-	P_AddThinker(&ht->thinker);
+	P_AddThinker(THINK_MAIN, &ht->thinker);
 }
 
 //
@@ -2631,7 +2630,7 @@ static inline void LoadExecutorThinker(savebuffer_t *save, actionf_p1 thinker)
 	ht->caller = LoadMobj(READUINT32(save->p));
 	ht->sector = LoadSector(READUINT32(save->p));
 	ht->timer = READINT32(save->p);
-	P_AddThinker(&ht->thinker);
+	P_AddThinker(THINK_MAIN, &ht->thinker);
 }
 
 //
@@ -2650,7 +2649,7 @@ static inline void LoadDisappearThinker(savebuffer_t *save, actionf_p1 thinker)
 	ht->affectee = READINT32(save->p);
 	ht->sourceline = READINT32(save->p);
 	ht->exists = READINT32(save->p);
-	P_AddThinker(&ht->thinker);
+	P_AddThinker(THINK_MAIN, &ht->thinker);
 }
 
 //
@@ -2666,7 +2665,7 @@ static inline void LoadPolyrotatetThinker(savebuffer_t *save, actionf_p1 thinker
 	ht->speed = READINT32(save->p);
 	ht->distance = READINT32(save->p);
 	ht->turnobjs = READUINT8(save->p);
-	P_AddThinker(&ht->thinker);
+	P_AddThinker(THINK_POLYOBJ, &ht->thinker);
 }
 
 //
@@ -2684,7 +2683,7 @@ static void LoadPolymoveThinker(savebuffer_t *save, actionf_p1 thinker)
 	ht->momy = READFIXED(save->p);
 	ht->distance = READINT32(save->p);
 	ht->angle = READANGLE(save->p);
-	P_AddThinker(&ht->thinker);
+	P_AddThinker(THINK_POLYOBJ, &ht->thinker);
 }
 
 //
@@ -2709,7 +2708,7 @@ static inline void LoadPolywaypointThinker(savebuffer_t *save, actionf_p1 thinke
 	ht->diffy = READFIXED(save->p);
 	ht->diffz = READFIXED(save->p);
 	ht->target = LoadMobj(READUINT32(save->p));
-	P_AddThinker(&ht->thinker);
+	P_AddThinker(THINK_POLYOBJ, &ht->thinker);
 }
 
 //
@@ -2734,7 +2733,7 @@ static inline void LoadPolyslidedoorThinker(savebuffer_t *save, actionf_p1 think
 	ht->momx = READFIXED(save->p);
 	ht->momy = READFIXED(save->p);
 	ht->closing = READUINT8(save->p);
-	P_AddThinker(&ht->thinker);
+	P_AddThinker(THINK_POLYOBJ, &ht->thinker);
 }
 
 //
@@ -2754,7 +2753,7 @@ static inline void LoadPolyswingdoorThinker(savebuffer_t *save, actionf_p1 think
 	ht->initDistance = READINT32(save->p);
 	ht->distance = READINT32(save->p);
 	ht->closing = READUINT8(save->p);
-	P_AddThinker(&ht->thinker);
+	P_AddThinker(THINK_POLYOBJ, &ht->thinker);
 }
 
 //
@@ -2771,7 +2770,7 @@ static inline void LoadPolydisplaceThinker(savebuffer_t *save, actionf_p1 thinke
 	ht->dx = READFIXED(save->p);
 	ht->dy = READFIXED(save->p);
 	ht->oldHeights = READFIXED(save->p);
-	P_AddThinker(&ht->thinker);
+	P_AddThinker(THINK_POLYOBJ, &ht->thinker);
 }
 
 //
@@ -2790,16 +2789,22 @@ static void P_NetUnArchiveThinkers(savebuffer_t *save)
 		I_Error("Bad $$$.sav at archive block Thinkers");
 
 	// remove all the current thinkers
-	currentthinker = thinkercap.next;
+	for (currentthinker = thlist[THINK_PRECIP].cnext; currentthinker != &thlist[THINK_PRECIP]; currentthinker = next)
+	{
+		next = currentthinker->cnext;
+		P_RemoveSavegameMobj((mobj_t *)currentthinker);
+	}
+
 	for (currentthinker = thinkercap.next; currentthinker != &thinkercap; currentthinker = next)
 	{
 		next = currentthinker->next;
 
-		if (currentthinker->function.acp1 == (actionf_p1)P_MobjThinker || currentthinker->function.acp1 == (actionf_p1)P_NullPrecipThinker)
+		if (currentthinker->function.acp1 == (actionf_p1)P_MobjThinker)
 			P_RemoveSavegameMobj((mobj_t *)currentthinker); // item isn't saved, don't remove it
 		else
 		{
 			(next->prev = currentthinker->prev)->next = next;
+			(currentthinker->cnext->cprev = currentthinker->cprev)->cnext = currentthinker->cnext;
 			R_DestroyLevelInterpolators(currentthinker);
 			Z_Free(currentthinker);
 		}
@@ -2985,8 +2990,8 @@ static void P_NetUnArchiveThinkers(savebuffer_t *save)
 		executor_t *delay = NULL;
 		polywaypoint_t *polywp = NULL;
 		UINT32 mobjnum;
-		for (currentthinker = thinkercap.next; currentthinker != &thinkercap;
-			currentthinker = currentthinker->next)
+		for (currentthinker = thlist[THINK_MAIN].cnext; currentthinker != &thlist[THINK_MAIN];
+			currentthinker = currentthinker->cnext)
 		{
 			if (currentthinker->function.acp1 != (actionf_p1)T_ExecutorDelay)
 				continue;
@@ -2996,8 +3001,8 @@ static void P_NetUnArchiveThinkers(savebuffer_t *save)
 			if ((mobjnum = (UINT32)(size_t)delay->caller))
 				delay->caller = P_FindNewPosition(mobjnum);
 		}
-		for (currentthinker = thinkercap.next; currentthinker != &thinkercap;
-			 currentthinker = currentthinker->next)
+		for (currentthinker = thlist[THINK_POLYOBJ].cnext; currentthinker != &thlist[THINK_POLYOBJ];
+			 currentthinker = currentthinker->cnext)
 		{
 			if (currentthinker->function.acp1 != (actionf_p1)T_PolyObjWaypoint)
 				continue;
@@ -3110,8 +3115,8 @@ static inline void P_FinishMobjs(void)
 	mobj_t *mobj;
 
 	// put info field there real value
-	for (currentthinker = thinkercap.next; currentthinker != &thinkercap;
-		currentthinker = currentthinker->next)
+	for (currentthinker = thlist[THINK_MOBJ].cnext; currentthinker != &thlist[THINK_MOBJ];
+		currentthinker = currentthinker->cnext)
 	{
 		if (currentthinker->function.acp1 != (actionf_p1)P_MobjThinker)
 			continue;
@@ -3134,8 +3139,8 @@ static void P_RelinkPointers(void)
 	mobj_t *mobj;
 
 	// use info field (value = oldposition) to relink mobjs
-	for (currentthinker = thinkercap.next; currentthinker != &thinkercap;
-		currentthinker = currentthinker->next)
+	for (currentthinker = thlist[THINK_MOBJ].cnext; currentthinker != &thlist[THINK_MOBJ];
+		currentthinker = currentthinker->cnext)
 	{
 		if (currentthinker->function.acp1 != (actionf_p1)P_MobjThinker)
 			continue;
@@ -3577,7 +3582,7 @@ void P_SaveNetGame(savebuffer_t *save, boolean resending)
 	// Assign the mobjnumber for pointer tracking
 	if (gamestate == GS_LEVEL)
 	{
-		for (th = thinkercap.next; th != &thinkercap; th = th->next)
+		for (th = thlist[THINK_MOBJ].cnext; th != &thlist[THINK_MOBJ]; th = th->cnext)
 		{
 			if (th->function.acp1 != (actionf_p1)P_MobjThinker)
 				continue;
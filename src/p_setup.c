@@ -139,6 +139,7 @@ precipmobj_t **precipblocklinks;
 // Without special effect, this could be used as a PVS lookup as well.
 //
 UINT8 *rejectmatrix;
+size_t rejectmatrixsize;
 
 // Maintain single and multi player starting spots.
 INT32 numdmstarts, numcoopstarts, numredctfstarts, numbluectfstarts;
@@ -1120,6 +1121,7 @@ static void P_SetupLines(void)
 		ld->frontsector = ld->backsector = NULL;
 		ld->validcount = 0;
 		ld->firsttag = ld->nexttag = -1;
+		ld->firstspecial = ld->nextspecial = -1;
 		ld->callcount = 0;
 
 		// killough 11/98: fix common wad errors (missing sidedefs):
@@ -1898,6 +1900,7 @@ static void P_LoadRawReject(UINT8 *data, size_t count)
 		rejectmatrix = Z_Malloc(count, PU_LEVEL, NULL); // allocate memory for the reject matrix
 		M_Memcpy(rejectmatrix, data, count); // copy the data into it
 	}
+	rejectmatrixsize = rejectmatrix ? count : 0;
 }
 
 static void P_LoadMapBSP(const virtres_t* virt)
@@ -1936,7 +1939,10 @@ static void P_LoadMapLUT(const virtres_t* virt)
 	if (virtreject)
 		P_LoadRawReject(virtreject->data, virtreject->size);
 	else
+	{
 		rejectmatrix = NULL;
+		rejectmatrixsize = 0;
+	}
 
 	if (!(virtblockmap && P_LoadRawBlockMap(virtblockmap->data, virtblockmap->size)))
 		P_CreateBlockMap();
@@ -2157,7 +2163,7 @@ void P_LoadThingsOnly(void)
 	virtres_t* virt = vres_GetMap(lastloadedmaplumpnum);
 	virtlump_t* vth = vres_Find(virt, "THINGS");
 
-	for (think = thinkercap.next; think != &thinkercap; think = think->next)
+	for (think = thlist[THINK_MOBJ].cnext; think != &thlist[THINK_MOBJ]; think = think->cnext)
 	{
 		if (think->function.acp1 != (actionf_p1)P_MobjThinker)
 			continue; // not a mobj thinker
@@ -2246,6 +2252,8 @@ static void P_LoadMapFromFile(void)
 
 	P_MakeMapMD5(curmapvirt, &mapmd5);
 
+	P_SetupRejectMatrix();
+
 	// We do the following silly
 	// construction because vres_Free
 	// no-sells deletions of pointers
@@ -2564,6 +2572,10 @@ boolean P_SetupLevel(boolean skipprecip, boolean reloadinggamestate)
 
 	levelloading = true;
 
+	// Let the prefetch finish if it was for this map, before the SOCs,
+	// scripts and purges below change anything under it
+	R_StopPrefetch(gamemap-1);
+
 	// This is needed. Don't touch.
 	maptol = mapheaderinfo[gamemap-1]->typeoflevel;
 
@@ -3020,6 +3032,8 @@ boolean P_SetupLevel(boolean skipprecip, boolean reloadinggamestate)
 
 	G_AddMapToBuffer(gamemap-1);
 
+	W_LogLumpReads("Level load", true);
+
 	return true;
 }
 
@@ -3083,6 +3097,9 @@ UINT16 P_PartialAddWadFile(const char *wadfilename, boolean local)
 	boolean mapsadded = false;
 	lumpinfo_t *lumpinfo;
 
+	// The new file could replace anything it's reading
+	R_StopPrefetch(-1);
+
 	if ((numlumps = W_InitFile(wadfilename, local)) == INT16_MAX)
 	{
 		refreshdirmenu |= REFRESHDIR_NOTLOADED;
@@ -3272,6 +3289,7 @@ boolean P_MultiSetupWadFiles(boolean fullsetup)
 	{
 		partadd_important = false;
 		partadd_replacescurrentmap = false;
+		W_LogLumpReads("Addon load", true);
 		return true;
 	}
 	else
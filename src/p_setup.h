@@ -24,6 +24,10 @@ extern SINT8 midgamejoin;
 // map md5, sent to players via PT_SERVERINFO
 extern unsigned char mapmd5[16];
 
+// p_reject.c
+extern consvar_t cv_buildreject;
+void P_SetupRejectMatrix(void);
+
 // Player spawn spots for deathmatch.
 #define MAX_DM_STARTS 64
 extern mapthing_t *deathmatchstarts[MAX_DM_STARTS];
@@ -121,6 +121,9 @@ static anim_t *lastanim;
 static anim_t *anims = NULL; /// \todo free leak
 static size_t maxanims;
 
+// Something got a new special since the special lists were made
+static boolean speciallistsstale = false;
+
 //
 // P_InitPicAnims
 //
@@ -930,6 +933,8 @@ static INT32 P_FindLineFromLineTag(const line_t *line, INT32 start)
 
 		return start;
 	}
+	else if (!numlines)
+		return -1;
 	else
 	{
 		start = start >= 0 ? lines[start].nexttag :
@@ -946,21 +951,28 @@ static INT32 P_FindLineFromLineTag(const line_t *line, INT32 start)
 //
 INT32 P_FindSpecialLineFromTag(INT16 special, INT16 tag, INT32 start)
 {
+	if (!numlines)
+		return -1;
+
 	if (tag == -1)
 	{
-		start++;
-
-		// This redundant check stops the compiler from complaining about function expansion
-		// elsewhere for some reason and everything is awful
-		if (start >= (INT32)numlines)
-			return -1;
-
-		while (start < (INT32)numlines && lines[start].special != special)
-			start++;
+		if (speciallistsstale)
+			P_InitSpecialLists();
 
-		if (start >= (INT32)numlines)
-			return -1;
+		// start has to still be on this special's list to follow it,
+		// otherwise find where we were from the beginning
+		if (start >= 0 && start < (INT32)numlines && lines[start].special == special)
+			start = lines[start].nextspecial;
+		else
+		{
+			INT32 from = start;
+			start = lines[(unsigned)special % numlines].firstspecial;
+			while (start >= 0 && start <= from)
+				start = lines[start].nextspecial;
+		}
 
+		while (start >= 0 && lines[start].special != special)
+			start = lines[start].nextspecial;
 		return start;
 	}
 	else
@@ -1268,6 +1280,38 @@ static inline void P_InitTagLists(void)
 		lines[i].nexttag = lines[j].firsttag;
 		lines[j].firsttag = (INT32)i;
 	}
+
+	P_InitSpecialLists();
+}
+
+/** Hashes the linedef specials, the same way as the tags.
+  *
+  * Clearing a special leaves it on its list, which the searches skip over.
+  * Anything that gives one a new special has to call
+  * P_MarkSpecialListsStale so they get rebuilt before the next search.
+  *
+  * \sa P_FindSpecialLineFromTag
+  */
+void P_InitSpecialLists(void)
+{
+	size_t i;
+
+	for (i = 0; i < numlines; i++)
+		lines[i].firstspecial = -1;
+
+	for (i = numlines - 1; i != (size_t)-1; i--)
+	{
+		size_t j = (unsigned)lines[i].special % numlines;
+		lines[i].nextspecial = lines[j].firstspecial;
+		lines[j].firstspecial = (INT32)i;
+	}
+
+	speciallistsstale = false;
+}
+
+void P_MarkSpecialListsStale(void)
+{
+	speciallistsstale = true;
 }
 
 /** Finds minimum light from an adjacent sector.
@@ -1324,7 +1368,7 @@ static void P_AddExecutorDelay(line_t *line, mobj_t *mobj, sector_t *sector)
 	e->sector = sector;
 	e->timer = (line->backsector->ceilingheight>>FRACBITS)+(line->backsector->floorheight>>FRACBITS);
 	P_SetTarget(&e->caller, mobj); // Use P_SetTarget to make sure the mobj doesn't get freed while we're delaying.
-	P_AddThinker(&e->thinker);
+	P_AddThinker(THINK_MAIN, &e->thinker);
 }
 
 /** Used by P_LinedefExecute to check a trigger linedef's conditions
@@ -1781,12 +1825,9 @@ void P_SwitchWeather(INT32 weathernum)
 		thinker_t *next;
 		precipmobj_t *precipmobj;
 
-		for (think = thinkercap.next; think != &thinkercap; think = next)
+		for (think = thlist[THINK_PRECIP].cnext; think != &thlist[THINK_PRECIP]; think = next)
 		{
-			next = think->next;
-
-			if (think->function.acp1 != (actionf_p1)P_NullPrecipThinker)
-				continue; // not a precipmobj thinker
+			next = think->cnext;
 
 			precipmobj = (precipmobj_t *)think;
 			P_FreePrecipMobj(precipmobj);
@@ -1798,11 +1839,8 @@ void P_SwitchWeather(INT32 weathernum)
 		precipmobj_t *precipmobj;
 		state_t *st;
 
-		for (think = thinkercap.next; think != &thinkercap; think = think->next)
+		for (think = thlist[THINK_PRECIP].cnext; think != &thlist[THINK_PRECIP]; think = think->cnext)
 		{
-			if (think->function.acp1 != (actionf_p1)P_NullPrecipThinker)
-				continue; // not a precipmobj thinker
-
 			precipmobj = (precipmobj_t *)think;
 
 			if (swap == PRECIP_RAIN) // Snow To Rain
@@ -2676,7 +2714,7 @@ static void P_ProcessLineSpecial(line_t *line, mobj_t *mo, sector_t *callsec)
 				scroll_t *scroller;
 				thinker_t *th;
 
-				for (th = thinkercap.next; th != &thinkercap; th = th->next)
+				for (th = thlist[THINK_MAIN].cnext; th != &thlist[THINK_MAIN]; th = th->cnext)
 				{
 					if (th->function.acp1 != (actionf_p1)T_Scroll)
 						continue;
@@ -3011,7 +3049,7 @@ void P_SetupSignExit(player_t *player)
 
 	// didn't find any signposts in the exit sector.
 	// spin all signposts in the level then.
-	for (think = thinkercap.next; think != &thinkercap; think = think->next)
+	for (think = thlist[THINK_MOBJ].cnext; think != &thlist[THINK_MOBJ]; think = think->cnext)
 	{
 		if (think->function.acp1 != (actionf_p1)P_MobjThinker)
 			continue; // not a mobj thinker
@@ -3060,7 +3098,7 @@ boolean P_IsFlagAtBase(mobjtype_t flag)
 	mobj_t *mo;
 	INT32 specialnum = (flag == MT_REDFLAG) ? 3 : 4;
 
-	for (think = thinkercap.next; think != &thinkercap; think = think->next)
+	for (think = thlist[THINK_MOBJ].cnext; think != &thlist[THINK_MOBJ]; think = think->cnext)
 	{
 		if (think->function.acp1 != (actionf_p1)P_MobjThinker)
 			continue; // not a mobj thinker
@@ -3492,7 +3530,7 @@ void P_ProcessSpecialSector(player_t *player, sector_t *sector, sector_t *rovers
 
 			// Find the center of the Eggtrap and release all the pretty animals!
 			// The chimps are my friends.. heeheeheheehehee..... - LouisJM
-			for (th = thinkercap.next; th != &thinkercap; th = th->next)
+			for (th = thlist[THINK_MOBJ].cnext; th != &thlist[THINK_MOBJ]; th = th->cnext)
 			{
 				if (th->function.acp1 != (actionf_p1)P_MobjThinker)
 					continue;
@@ -4753,7 +4791,7 @@ static ffloor_t *P_AddFakeFloor(sector_t *sec, sector_t *sec2, line_t *master, f
 
 	// Just initialise both of these to placate the compiler.
 	i = 0;
-	th = thinkercap.next;
+	th = thlist[THINK_MAIN].cnext;
 
 	for(;;)
 	{
@@ -4763,7 +4801,7 @@ static ffloor_t *P_AddFakeFloor(sector_t *sec, sector_t *sec2, line_t *master, f
 				th = secthinkers[sec2num].thinkers[i];
 			else break;
 		}
-		else if (th == &thinkercap)
+		else if (th == &thlist[THINK_MAIN])
 			break;
 
 		// Should this FOF have spikeness?
@@ -4792,7 +4830,7 @@ static ffloor_t *P_AddFakeFloor(sector_t *sec, sector_t *sec2, line_t *master, f
 		}
 
 		if(secthinkers) i++;
-		else th = th->next;
+		else th = th->cnext;
 	}
 
 
@@ -4852,7 +4890,7 @@ static void P_AddSpikeThinker(sector_t *sec, INT32 referrer)
 
 	// create and initialize new thinker
 	spikes = Z_Calloc(sizeof (*spikes), PU_LEVSPEC, NULL);
-	P_AddThinker(&spikes->thinker);
+	P_AddThinker(THINK_MAIN, &spikes->thinker);
 
 	spikes->thinker.function.acp1 = (actionf_p1)T_SpikeSector;
 
@@ -4874,7 +4912,7 @@ static void P_AddFloatThinker(sector_t *sec, INT32 tag, line_t *sourceline)
 
 	// create and initialize new thinker
 	floater = Z_Calloc(sizeof (*floater), PU_LEVSPEC, NULL);
-	P_AddThinker(&floater->thinker);
+	P_AddThinker(THINK_MAIN, &floater->thinker);
 
 	floater->thinker.function.acp1 = (actionf_p1)T_FloatSector;
 
@@ -4903,7 +4941,7 @@ static void P_AddBlockThinker(sector_t *sec, line_t *sourceline)
 
 	// create and initialize new elevator thinker
 	block = Z_Calloc(sizeof (*block), PU_LEVSPEC, NULL);
-	P_AddThinker(&block->thinker);
+	P_AddThinker(THINK_MAIN, &block->thinker);
 
 	block->thinker.function.acp1 = (actionf_p1)T_MarioBlockChecker;
 	block->sourceline = sourceline;
@@ -4932,7 +4970,7 @@ static void P_AddRaiseThinker(sector_t *sec, line_t *sourceline)
 	levelspecthink_t *raise;
 
 	raise = Z_Calloc(sizeof (*raise), PU_LEVSPEC, NULL);
-	P_AddThinker(&raise->thinker);
+	P_AddThinker(THINK_MAIN, &raise->thinker);
 
 	raise->thinker.function.acp1 = (actionf_p1)T_RaiseSector;
 
@@ -4975,7 +5013,7 @@ static void P_AddOldAirbob(sector_t *sec, line_t *sourceline, boolean noadjust)
 	levelspecthink_t *airbob;
 
 	airbob = Z_Calloc(sizeof (*airbob), PU_LEVSPEC, NULL);
-	P_AddThinker(&airbob->thinker);
+	P_AddThinker(THINK_MAIN, &airbob->thinker);
 
 	airbob->thinker.function.acp1 = (actionf_p1)T_RaiseSector;
 
@@ -5040,7 +5078,7 @@ static inline void P_AddThwompThinker(sector_t *sec, sector_t *actionsector, lin
 
 	// create and initialize new elevator thinker
 	thwomp = Z_Calloc(sizeof (*thwomp), PU_LEVSPEC, NULL);
-	P_AddThinker(&thwomp->thinker);
+	P_AddThinker(THINK_MAIN, &thwomp->thinker);
 
 	thwomp->thinker.function.acp1 = (actionf_p1)T_ThwompSector;
 
@@ -5081,7 +5119,7 @@ static inline void P_AddNoEnemiesThinker(sector_t *sec, line_t *sourceline)
 
 	// create and initialize new thinker
 	nobaddies = Z_Calloc(sizeof (*nobaddies), PU_LEVSPEC, NULL);
-	P_AddThinker(&nobaddies->thinker);
+	P_AddThinker(THINK_MAIN, &nobaddies->thinker);
 
 	nobaddies->thinker.function.acp1 = (actionf_p1)T_NoEnemiesSector;
 
@@ -5103,7 +5141,7 @@ static inline void P_AddEachTimeThinker(sector_t *sec, line_t *sourceline)
 
 	// create and initialize new thinker
 	eachtime = Z_Calloc(sizeof (*eachtime), PU_LEVSPEC, NULL);
-	P_AddThinker(&eachtime->thinker);
+	P_AddThinker(THINK_MAIN, &eachtime->thinker);
 
 	eachtime->thinker.function.acp1 = (actionf_p1)T_EachTimeThinker;
 
@@ -5125,7 +5163,7 @@ static inline void P_AddCameraScanner(sector_t *sourcesec, sector_t *actionsecto
 
 	// create and initialize new elevator thinker
 	elevator = Z_Calloc(sizeof (*elevator), PU_LEVSPEC, NULL);
-	P_AddThinker(&elevator->thinker);
+	P_AddThinker(THINK_MAIN, &elevator->thinker);
 
 	elevator->thinker.function.acp1 = (actionf_p1)T_CameraScanner;
 	elevator->type = elevateBounce;
@@ -5215,7 +5253,7 @@ static inline void EV_AddLaserThinker(sector_t *sec, sector_t *sec2, line_t *lin
 
 	flash = Z_Calloc(sizeof (*flash), PU_LEVSPEC, NULL);
 
-	P_AddThinker(&flash->thinker);
+	P_AddThinker(THINK_MAIN, &flash->thinker);
 
 	flash->thinker.function.acp1 = (actionf_p1)T_LaserFlash;
 	flash->ffloor = ffloor;
@@ -5232,10 +5270,28 @@ static inline void EV_AddLaserThinker(sector_t *sec, sector_t *sec2, line_t *lin
 //
 static void P_RunLevelLoadExecutors(void)
 {
-	size_t i;
+	static const INT16 loadspecials[3] = {399, 328, 323};
+	INT32 next[3];
+	INT32 i;
+	UINT8 k, first;
 
-	for (i = 0; i < numlines; i++)
+	for (k = 0; k < 3; k++)
+		next[k] = P_FindSpecialLineFromTag(loadspecials[k], -1, -1);
+
+	// Go through all three in line order, like a straight scan would
+	for (;;)
 	{
+		first = 3;
+		for (k = 0; k < 3; k++)
+			if (next[k] >= 0 && (first == 3 || next[k] < next[first]))
+				first = k;
+
+		if (first == 3)
+			break;
+
+		i = next[first];
+		next[first] = P_FindSpecialLineFromTag(loadspecials[first], -1, i);
+
 		if (lines[i].special == 399 || lines[i].special == 328 || lines[i].special == 323)
 			P_RunTriggerLinedef(&lines[i], NULL, NULL);
 	}
@@ -5341,7 +5397,7 @@ void P_SpawnSpecials(INT32 fromnetsave, boolean reloadinggamestate)
 	secthinkers = Z_Calloc(numsectors * sizeof(thinkerlist_t), PU_STATIC, NULL);
 
 	// Firstly, find out how many there are in each sector
-	for (th = thinkercap.next; th != &thinkercap; th = th->next)
+	for (th = thlist[THINK_MAIN].cnext; th != &thlist[THINK_MAIN]; th = th->cnext)
 	{
 		if (th->function.acp1 == (actionf_p1)T_SpikeSector)
 			secthinkers[((levelspecthink_t *)th)->sector - sectors].count++;
@@ -5361,7 +5417,7 @@ void P_SpawnSpecials(INT32 fromnetsave, boolean reloadinggamestate)
 		}
 
 	// Finally, populate the lists.
-	for (th = thinkercap.next; th != &thinkercap; th = th->next)
+	for (th = thlist[THINK_MAIN].cnext; th != &thlist[THINK_MAIN]; th = th->cnext)
 	{
 		size_t secnum = (size_t)-1;
 
@@ -6604,7 +6660,7 @@ static void Add_Scroller(INT32 type, fixed_t dx, fixed_t dy, INT32 control, INT3
 	if ((s->control = control) != -1)
 		s->last_height = sectors[control].floorheight + sectors[control].ceilingheight;
 	s->affectee = affectee;
-	P_AddThinker(&s->thinker);
+	P_AddThinker(THINK_MAIN, &s->thinker);
 
 	// interpolation
 	switch (type)
@@ -6779,7 +6835,7 @@ static void Add_MasterDisappearer(tic_t appeartime, tic_t disappeartime, tic_t o
 	d->exists = true;
 	d->timer = 1;
 
-	P_AddThinker(&d->thinker);
+	P_AddThinker(THINK_MAIN, &d->thinker);
 }
 
 /** Makes a FOF appear/disappear
@@ -6871,7 +6927,7 @@ static void Add_Friction(INT32 friction, INT32 movefactor, INT32 affectee, INT32
 	else
 		f->roverfriction = false;
 
-	P_AddThinker(&f->thinker);
+	P_AddThinker(THINK_MAIN, &f->thinker);
 }
 
 /** Applies friction to all things in a sector.
@@ -7048,7 +7104,7 @@ static void Add_Pusher(pushertype_e type, fixed_t x_mag, fixed_t y_mag, mobj_t *
 		p->z = p->source->z;
 	}
 	p->affectee = affectee;
-	P_AddThinker(&p->thinker);
+	P_AddThinker(THINK_MAIN, &p->thinker);
 }
 
 
@@ -7581,30 +7637,26 @@ void P_StartQuake(tic_t time, fixed_t intensity, fixed_t radius)
 
 static void P_SearchForDisableLinedefs(void)
 {
-	size_t i;
-	INT32 j;
+	INT32 i, j;
 
 	// Look for disable linedefs
-	for (i = 0; i < numlines; i++)
+	for (i = -1; (i = P_FindSpecialLineFromTag(6, -1, i)) >= 0;)
 	{
-		if (lines[i].special == 6)
-		{
-			// Remove special
-			// Do *not* remove tag. That would mess with the tag lists
-			// that P_InitTagLists literally just created!
-			lines[i].special = 0;
+		// Remove special
+		// Do *not* remove tag. That would mess with the tag lists
+		// that P_InitTagLists literally just created!
+		lines[i].special = 0;
 
-			// Ability flags can disable disable linedefs now, lol
-			if (netgame || multiplayer)
-			{
-				// future: nonet flag?
-			}
-			else if ((lines[i].flags & ML_NETONLY) == ML_NETONLY)
-				continue; // Net-only never triggers in single player
-
-			// Disable any linedef specials with our tag.
-			for (j = -1; (j = P_FindLineFromLineTag(&lines[i], j)) >= 0;)
-				lines[j].special = 0;
+		// Ability flags can disable disable linedefs now, lol
+		if (netgame || multiplayer)
+		{
+			// future: nonet flag?
 		}
+		else if ((lines[i].flags & ML_NETONLY) == ML_NETONLY)
+			continue; // Net-only never triggers in single player
+
+		// Disable any linedef specials with our tag.
+		for (j = -1; (j = P_FindLineFromLineTag(&lines[i], j)) >= 0;)
+			lines[j].special = 0;
 	}
 }
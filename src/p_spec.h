@@ -52,6 +52,8 @@ fixed_t P_FindHighestCeilingSurrounding(sector_t *sec);
 INT32 P_FindSectorFromLineTag(line_t *line, INT32 start);
 INT32 P_FindSectorFromTag(INT16 tag, INT32 start);
 INT32 P_FindSpecialLineFromTag(INT16 special, INT16 tag, INT32 start);
+void P_InitSpecialLists(void);
+void P_MarkSpecialListsStale(void);
 
 INT32 P_FindMinSurroundingLight(sector_t *sector, INT32 max);
 
@@ -50,11 +50,15 @@ tic_t leveltime;
 // Both the head and tail of the thinker list.
 thinker_t thinkercap;
 
+// Heads of the per-class lists; see thinklistnum_t.
+thinker_t thlist[NUM_THINKERLISTS];
+
 void Command_Numthinkers_f(void)
 {
 	INT32 num;
 	INT32 count = 0;
 	actionf_p1 action;
+	thinklistnum_t start, end, i;
 	thinker_t *think;
 
 	if (gamestate != GS_LEVEL)
@@ -80,22 +84,28 @@ void Command_Numthinkers_f(void)
 	switch (num)
 	{
 		case 1:
+			start = end = THINK_MOBJ;
 			action = (actionf_p1)P_MobjThinker;
 			CONS_Printf(M_GetText("Number of %s: "), "P_MobjThinker");
 			break;
 		case 2:
+			start = end = THINK_PRECIP;
 			action = (actionf_p1)P_NullPrecipThinker;
 			CONS_Printf(M_GetText("Number of %s: "), "P_NullPrecipThinker");
 			break;
 		case 3:
+			start = end = THINK_MAIN;
 			action = (actionf_p1)T_Friction;
 			CONS_Printf(M_GetText("Number of %s: "), "T_Friction");
 			break;
 		case 4:
+			start = end = THINK_MAIN;
 			action = (actionf_p1)T_Pusher;
 			CONS_Printf(M_GetText("Number of %s: "), "T_Pusher");
 			break;
 		case 5:
+			start = 0;
+			end = NUM_THINKERLISTS - 1;
 			action = (actionf_p1)P_RemoveThinkerDelayed;
 			CONS_Printf(M_GetText("Number of %s: "), "P_RemoveThinkerDelayed");
 			break;
@@ -104,12 +114,15 @@ void Command_Numthinkers_f(void)
 			return;
 	}
 
-	for (think = thinkercap.next; think != &thinkercap; think = think->next)
+	for (i = start; i <= end; i++)
 	{
-		if (think->function.acp1 != action)
-			continue;
+		for (think = thlist[i].cnext; think != &thlist[i]; think = think->cnext)
+		{
+			if (think->function.acp1 != action)
+				continue;
 
-		count++;
+			count++;
+		}
 	}
 
 	CONS_Printf("%d\n", count);
@@ -141,7 +154,7 @@ void Command_CountMobjs_f(void)
 
 			count = 0;
 
-			for (th = thinkercap.next; th != &thinkercap; th = th->next)
+			for (th = thlist[THINK_MOBJ].cnext; th != &thlist[THINK_MOBJ]; th = th->cnext)
 			{
 				if (th->function.acp1 != (actionf_p1)P_MobjThinker)
 					continue;
@@ -161,7 +174,7 @@ void Command_CountMobjs_f(void)
 	{
 		count = 0;
 
-		for (th = thinkercap.next; th != &thinkercap; th = th->next)
+		for (th = thlist[THINK_MOBJ].cnext; th != &thlist[THINK_MOBJ]; th = th->cnext)
 		{
 			if (th->function.acp1 != (actionf_p1)P_MobjThinker)
 				continue;
@@ -180,24 +193,71 @@ void Command_CountMobjs_f(void)
 //
 void P_InitThinkers(void)
 {
+	UINT8 i;
+
 	thinkercap.prev = thinkercap.next = &thinkercap;
+	for (i = 0; i < NUM_THINKERLISTS; i++)
+		thlist[i].cprev = thlist[i].cnext = &thlist[i];
 	waypointcap = NULL;
+	K_ClearWaypointIndex();
 }
 
 //
 // P_AddThinker
-// Adds a new thinker at the end of the list.
+// Adds a new thinker at the end of the list,
+// and at the end of the list for class n.
 //
-void P_AddThinker(thinker_t *thinker)
+void P_AddThinker(const thinklistnum_t n, thinker_t *thinker)
 {
-	thinkercap.prev->next = thinker;
-	thinker->next = &thinkercap;
-	thinker->prev = thinkercap.prev;
-	thinkercap.prev = thinker;
+	if (n != THINK_PRECIP) // precipitation never runs, keep it out of the way
+	{
+		thinkercap.prev->next = thinker;
+		thinker->next = &thinkercap;
+		thinker->prev = thinkercap.prev;
+		thinkercap.prev = thinker;
+	}
+	else
+		thinker->prev = thinker->next = NULL;
+
+	thlist[n].cprev->cnext = thinker;
+	thinker->cnext = &thlist[n];
+	thinker->cprev = thlist[n].cprev;
+	thlist[n].cprev = thinker;
 
 	thinker->references = 0;    // killough 11/98: init reference counter to 0
 }
 
+//
+// P_AddThinkerFront
+// Like P_AddThinker, but puts the thinker at the front of both lists.
+//
+void P_AddThinkerFront(const thinklistnum_t n, thinker_t *thinker)
+{
+	I_Assert(n != THINK_PRECIP);
+
+	thinkercap.next->prev = thinker;
+	thinker->next = thinkercap.next;
+	thinker->prev = &thinkercap;
+	thinkercap.next = thinker;
+
+	thlist[n].cnext->cprev = thinker;
+	thinker->cnext = thlist[n].cnext;
+	thinker->cprev = &thlist[n];
+	thlist[n].cnext = thinker;
+
+	thinker->references = 0;
+}
+
+//
+// P_UnlinkClass
+// Takes the thinker out of its class list.
+//
+static inline void P_UnlinkClass(thinker_t *thinker)
+{
+	thinker_t *next = thinker->cnext;
+	(next->cprev = thinker->cprev)->cnext = next;
+}
+
 //
 // killough 11/98:
 //
@@ -206,6 +266,20 @@ void P_AddThinker(thinker_t *thinker)
 
 static thinker_t *currentthinker;
 
+//
+// P_InvalidateThinkerUserdata()
+//
+// Invalidates the thinker's Lua userdata, if Lua ever made one for it.
+// Thinkers that never reached Lua don't need a registry lookup.
+//
+static void P_InvalidateThinkerUserdata(thinker_t *thinker)
+{
+	if (!thinker->luaref)
+		return;
+	LUA_InvalidateUserdata(thinker);
+	thinker->luaref = 0;
+}
+
 //
 // P_RemoveThinkerDelayed()
 //
@@ -234,8 +308,10 @@ void P_RemoveThinkerDelayed(thinker_t *thinker)
 	* point it to thinker->prev, so the iterator will correctly move on to
 	* thinker->prev->next = thinker->next */
 	(next->prev = currentthinker = thinker->prev)->next = next;
+	P_UnlinkClass(thinker);
 	R_DestroyLevelInterpolators(thinker);
-	Z_Free(thinker);
+	P_InvalidateThinkerUserdata(thinker); // in case Lua saw it again after P_RemoveThinker
+	Z_FreeNoLua(thinker);
 }
 
 //
@@ -249,8 +325,11 @@ void P_UnlinkThinker(thinker_t *thinker)
 
 	I_Assert(thinker->references == 0);
 
-	(next->prev = thinker->prev)->next = next;
-	Z_Free(thinker);
+	if (next) // precipitation isn't in the main list
+		(next->prev = thinker->prev)->next = next;
+	P_UnlinkClass(thinker);
+	P_InvalidateThinkerUserdata(thinker);
+	Z_FreeNoLua(thinker);
 }
 
 //
@@ -267,7 +346,7 @@ void P_UnlinkThinker(thinker_t *thinker)
 //
 void P_RemoveThinker(thinker_t *thinker)
 {
-	LUA_InvalidateUserdata(thinker);
+	P_InvalidateThinkerUserdata(thinker);
 	thinker->function.acp1 = (actionf_p1)P_RemoveThinkerDelayed;
 }
 
@@ -318,8 +397,6 @@ static inline void P_RunThinkers(void)
 {
 	for (currentthinker = thinkercap.next; currentthinker != &thinkercap; currentthinker = currentthinker->next)
 	{
-		if (currentthinker->function.acp1 == (actionf_p1)P_NullPrecipThinker)
-			continue;
 #ifdef PARANOIA
 		I_Assert(currentthinker->function.acp1 != NULL)
 #endif
@@ -517,6 +594,9 @@ void P_Ticker(boolean run)
 		}
 		
 		ps_lua_mobjhooks.value.i = 0;
+		ps_lua_mobjthinker_time.value.p = 0;
+		ps_lua_mobjcollide_time.value.p = 0;
+		ps_lua_mobjhook_time.value.p = 0;
 		ps_checkposition_calls.value.i = 0;
 
 		PS_START_TIMING(ps_lua_prethinkframe_time);
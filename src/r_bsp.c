@@ -23,25 +23,25 @@
 
 #include "qs22j.h"
 
-seg_t *curline;
-side_t *sidedef;
-line_t *linedef;
-sector_t *frontsector;
-sector_t *backsector;
-portal_pair *g_portal; // is curline a portal seg?
+ATTRTHREAD seg_t *curline;
+ATTRTHREAD side_t *sidedef;
+ATTRTHREAD line_t *linedef;
+ATTRTHREAD sector_t *frontsector;
+ATTRTHREAD sector_t *backsector;
+ATTRTHREAD portal_pair *g_portal; // is curline a portal seg?
 
 // very ugly realloc() of drawsegs at run-time, I upped it to 512
 // instead of 256.. and someone managed to send me a level with
 // 896 drawsegs! So too bad here's a limit removal a-la-Boom
-drawseg_t *drawsegs = NULL;
-drawseg_t *ds_p = NULL;
+ATTRTHREAD drawseg_t *drawsegs = NULL;
+ATTRTHREAD drawseg_t *ds_p = NULL;
 
 // indicates doors closed wrt automap bugfix:
-INT32 doorclosed;
+ATTRTHREAD INT32 doorclosed;
 
 // A wall was drawn covering the whole screen, which means we
 // can block off the BSP across that seg.
-boolean g_walloffscreen;
+ATTRTHREAD boolean g_walloffscreen;
 
 boolean R_NoEncore(sector_t *sector, boolean ceiling)
 {
@@ -75,8 +75,8 @@ void R_ClearDrawSegs(void)
 #define MAXSEGS (MAXVIDWIDTH/2+1)
 
 // newend is one past the last valid seg
-static cliprange_t *newend;
-static cliprange_t solidsegs[MAXSEGS];
+static ATTRTHREAD cliprange_t *newend;
+static ATTRTHREAD cliprange_t solidsegs[MAXSEGS];
 
 //
 // R_ClipSolidWallSegment
@@ -415,7 +415,7 @@ static void R_AddLine(seg_t *line)
 {
 	INT32 x1, x2;
 	angle_t angle1, angle2, span, tspan;
-	static sector_t tempsec;
+	static ATTRTHREAD sector_t tempsec;
 
 	g_portal = NULL;
 
@@ -668,9 +668,23 @@ static boolean R_CheckBBox(const fixed_t *bspcoord)
 }
 
 
-size_t numpolys;        // number of polyobjects in current subsector
-size_t num_po_ptrs;     // number of polyobject pointers allocated
-polyobj_t **po_ptrs; // temp ptr array to sort polyobject pointers
+ATTRTHREAD size_t numpolys;        // number of polyobjects in current subsector
+ATTRTHREAD size_t num_po_ptrs;     // number of polyobject pointers allocated
+ATTRTHREAD polyobj_t **po_ptrs; // temp ptr array to sort polyobject pointers
+
+// Polyobjects paired with their distance from this view. Kept here rather
+// than in polyobj_t, since views can be drawn at the same time.
+typedef struct
+{
+	polyobj_t *po;
+	fixed_t zdist;
+} polysort_t;
+
+static ATTRTHREAD polysort_t *po_sort; // num_po_ptrs long
+
+// Scratch copy of a polyobject's segs, sorted for this view
+static ATTRTHREAD seg_t **po_segs;
+static ATTRTHREAD size_t num_po_segs;
 
 //
 // R_PolyobjCompare
@@ -681,8 +695,8 @@ polyobj_t **po_ptrs; // temp ptr array to sort polyobject pointers
 //
 static int R_PolyobjCompare(const void *p1, const void *p2)
 {
-	const polyobj_t *po1 = *(const polyobj_t * const *)p1;
-	const polyobj_t *po2 = *(const polyobj_t * const *)p2;
+	const polysort_t *po1 = (const polysort_t *)p1;
+	const polysort_t *po2 = (const polysort_t *)p2;
 
 	return po1->zdist - po2->zdist;
 }
@@ -708,17 +722,19 @@ void R_SortPolyObjects(subsector_t *sub)
 		{
 			// use free instead realloc since faster (thanks Lee ^_^)
 			free(po_ptrs);
+			free(po_sort);
 			po_ptrs = malloc((num_po_ptrs = numpolys*2)
 				* sizeof(*po_ptrs));
+			po_sort = malloc(num_po_ptrs * sizeof(*po_sort));
 		}
 
 		po = sub->polyList;
 
 		while (po)
 		{
-			po->zdist = R_PointToDist2(viewx, viewy,
+			po_sort[i].zdist = R_PointToDist2(viewx, viewy,
 				po->centerPt.x, po->centerPt.y);
-			po_ptrs[i++] = po;
+			po_sort[i++].po = po;
 			po = (polyobj_t *)(po->link.next);
 		}
 
@@ -726,9 +742,12 @@ void R_SortPolyObjects(subsector_t *sub)
 		// 03/10/06: only bother if there are actually polys to sort
 		if (numpolys >= 2)
 		{
-			qs22j(po_ptrs, numpolys, sizeof(polyobj_t *),
+			qs22j(po_sort, numpolys, sizeof(polysort_t),
 				R_PolyobjCompare);
 		}
+
+		for (i = 0; i < (INT32)numpolys; i++)
+			po_ptrs[i] = po_sort[i].po;
 	}
 }
 
@@ -821,7 +840,7 @@ static void R_AddPolyObjects(subsector_t *sub)
 	}
 	
 	// for render stats
-	ps_numpolyobjects.value.i += numpolys;
+	viewstats.numpolyobjects += numpolys;
 
 	// sort polyobjects
 	R_SortPolyObjects(sub);
@@ -829,9 +848,61 @@ static void R_AddPolyObjects(subsector_t *sub)
 	// render polyobjects
 	for (i = 0; i < numpolys; ++i)
 	{
-		qsort(po_ptrs[i]->segs, po_ptrs[i]->segCount, sizeof(seg_t *), R_PolysegCompare);
+		// sort a copy, the polyobject's own seg list is shared by all views
+		if (num_po_segs < po_ptrs[i]->segCount)
+		{
+			free(po_segs);
+			po_segs = malloc((num_po_segs = po_ptrs[i]->segCount*2)
+				* sizeof(*po_segs));
+		}
+		M_Memcpy(po_segs, po_ptrs[i]->segs, po_ptrs[i]->segCount * sizeof(*po_segs));
+
+		qsort(po_segs, po_ptrs[i]->segCount, sizeof(seg_t *), R_PolysegCompare);
 		for (j = 0; j < po_ptrs[i]->segCount; ++j)
-			R_AddLine(po_ptrs[i]->segs[j]);
+			R_AddLine(po_segs[j]);
+	}
+}
+
+//
+// R_FFloorsMoved
+// Checks if a sector or any of its 3D floors' control sectors has moved,
+// which means its light list needs to be rebuilt.
+//
+static boolean R_FFloorsMoved(sector_t *sector)
+{
+	ffloor_t *rover;
+
+	if (sector->moved)
+		return true;
+
+	for (rover = sector->ffloors; rover; rover = rover->next)
+	{
+		if (sectors[rover->secnum].moved)
+			return true;
+	}
+
+	return false;
+}
+
+//
+// R_PrepMovedFFloors
+// Rebuilds the light lists of every sector R_Subsector would, up front,
+// for when views are about to be drawn on more than one thread.
+//
+void R_PrepMovedFFloors(void)
+{
+	size_t i;
+
+	for (i = 0; i < numsectors; i++)
+	{
+		sector_t *sector = &sectors[i];
+
+		if (!sector->ffloors || !R_FFloorsMoved(sector))
+			continue;
+
+		sector->numlights = 0;
+		R_Prep3DFloors(sector);
+		sector->moved = false;
 	}
 }
 
@@ -842,14 +913,14 @@ static void R_AddPolyObjects(subsector_t *sub)
 // Draw one or more line segments.
 //
 
-drawseg_t *firstseg;
+ATTRTHREAD drawseg_t *firstseg;
 
 static void R_Subsector(size_t num)
 {
 	INT32 count, floorlightlevel, ceilinglightlevel, light;
 	seg_t *line;
 	subsector_t *sub;
-	static sector_t tempsec; // Deep water hack
+	static ATTRTHREAD sector_t tempsec; // Deep water hack
 	extracolormap_t *floorcolormap;
 	extracolormap_t *ceilingcolormap;
 	fixed_t floorcenterz, ceilingcenterz;
@@ -885,23 +956,9 @@ static void R_Subsector(size_t num)
 	// Check and prep all 3D floors. Set the sector floor/ceiling light levels and colormaps.
 	if (frontsector->ffloors)
 	{
-		boolean anyMoved = frontsector->moved;
-
-		if (anyMoved == false)
-		{
-			for (rover = frontsector->ffloors; rover; rover = rover->next)
-			{
-				sector_t *controlSec = &sectors[rover->secnum];
-
-				if (controlSec->moved != true)
-					continue;
-
-				anyMoved = true;
-				break;
-			}
-		}
-
-		if (anyMoved == true)
+		// Threaded views share the light lists, so R_PrepMovedFFloors
+		// has already done this for them.
+		if (!viewsthreaded && R_FFloorsMoved(frontsector))
 		{
 			frontsector->numlights = sub->sector->numlights = 0;
 			R_Prep3DFloors(frontsector);
@@ -1084,7 +1141,7 @@ static void R_Subsector(size_t num)
 				ffloor[numffloors].polyobj = po;
 				ffloor[numffloors].slope = NULL;
 //				ffloor[numffloors].ffloor = rover;
-				po->visplane = ffloor[numffloors].plane;
+				*R_PolyobjPlane(po) = ffloor[numffloors].plane;
 				numffloors++;
 			}
 
@@ -1108,7 +1165,7 @@ static void R_Subsector(size_t num)
 				ffloor[numffloors].height = polysec->ceilingheight;
 				ffloor[numffloors].slope = NULL;
 //				ffloor[numffloors].ffloor = rover;
-				po->visplane = ffloor[numffloors].plane;
+				*R_PolyobjPlane(po) = ffloor[numffloors].plane;
 				numffloors++;
 			}
 
@@ -1312,7 +1369,7 @@ void R_RenderBSPNode(INT32 bspnum)
 	const node_t *bsp;
 	INT32 side;
 
-	ps_numbspcalls.value.i++;
+	viewstats.numbspcalls++;
 
 	while (!(bspnum & NF_SUBSECTOR))  // Found a subsector?
 	{
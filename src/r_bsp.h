@@ -20,21 +20,21 @@
 
 #include "r_main.h"
 
-extern seg_t *curline;
-extern side_t *sidedef;
-extern line_t *linedef;
-extern sector_t *frontsector;
-extern sector_t *backsector;
-extern portal_pair *g_portal; // is curline a portal seg?
+extern ATTRTHREAD seg_t *curline;
+extern ATTRTHREAD side_t *sidedef;
+extern ATTRTHREAD line_t *linedef;
+extern ATTRTHREAD sector_t *frontsector;
+extern ATTRTHREAD sector_t *backsector;
+extern ATTRTHREAD portal_pair *g_portal; // is curline a portal seg?
 
 // drawsegs are allocated on the fly... see r_segs.c
 
 extern INT32 checkcoord[12][4];
 
-extern drawseg_t *drawsegs;
-extern drawseg_t *ds_p;
-extern INT32 doorclosed;
-extern boolean g_walloffscreen;
+extern ATTRTHREAD drawseg_t *drawsegs;
+extern ATTRTHREAD drawseg_t *ds_p;
+extern ATTRTHREAD INT32 doorclosed;
+extern ATTRTHREAD boolean g_walloffscreen;
 
 // BSP?
 void R_ClearClipSegs(void);
@@ -49,9 +49,9 @@ boolean R_NoEncore(sector_t *sector, boolean ceiling);
 
 void R_SortPolyObjects(subsector_t *sub);
 
-extern size_t numpolys;        // number of polyobjects in current subsector
-extern size_t num_po_ptrs;     // number of polyobject pointers allocated
-extern polyobj_t **po_ptrs; // temp ptr array to sort polyobject pointers
+extern ATTRTHREAD size_t numpolys;        // number of polyobjects in current subsector
+extern ATTRTHREAD size_t num_po_ptrs;     // number of polyobject pointers allocated
+extern ATTRTHREAD polyobj_t **po_ptrs; // temp ptr array to sort polyobject pointers
 
 sector_t *R_FakeFlat(sector_t *sec, sector_t *tempsec, INT32 *floorlightlevel,
 	INT32 *ceilinglightlevel, boolean back);
@@ -59,4 +59,5 @@ boolean R_IsEmptyLine(seg_t *line, sector_t *front, sector_t *back);
 
 INT32 R_GetPlaneLight(sector_t *sector, fixed_t planeheight, boolean underside);
 void R_Prep3DFloors(sector_t *sector);
+void R_PrepMovedFFloors(void);
 #endif
@@ -31,6 +31,12 @@
 #include "hardware/hw_glob.h" // HWR_ClearLightTables
 #endif
 
+#ifdef HAVE_THREADS
+#include "byteptr.h"
+#include "i_system.h"
+#include "i_threads.h"
+#endif
+
 #ifdef _WIN32
 #include <malloc.h> // alloca(sizeof)
 #endif
@@ -201,11 +207,19 @@ static UINT8 *R_GenerateTexture(size_t texnum)
 	size_t blocksize;
 	column_t *patchcol;
 	UINT8 *colofs;
+	boolean holes = false;
 
 	I_Assert(texnum <= (size_t)numtextures);
 	texture = textures[texnum];
 	I_Assert(texture != NULL);
 
+	// Another view or a prefetch worker may have got here first. The
+	// cache entry is only set once the texture is complete, so unlocked
+	// readers never see half of one, and the building itself can go on
+	// outside the lock.
+	if (texturecache[texnum])
+		return texturecache[texnum];
+
 	// allocate texture column offset lookup
 
 	// single-patch textures can have holes in them and may be used on
@@ -244,16 +258,13 @@ static UINT8 *R_GenerateTexture(size_t texnum)
 		// If the patch uses transparency, we have to save it this way.
 		if (holey)
 		{
-			texture->holes = true;
+			holes = true;
 			blocksize = W_LumpLengthPwad(patch->wad, patch->lump);
-			block = Z_Calloc(blocksize, PU_STATIC, // will change tag at end of this function
-				&texturecache[texnum]);
+			block = Z_Calloc(blocksize, PU_STATIC, NULL); // will change tag and user at end of this function
 			M_Memcpy(block, realpatch, blocksize);
-			texturememory += blocksize;
 
 			// use the patch's column lookup
 			colofs = (block + 8);
-			texturecolumnofs[texnum] = (UINT32 *)colofs;
 			blocktex = block;
 			for (x = 0; x < texture->width; x++)
 				*(UINT32 *)&colofs[x<<2] = LONG(LONG(*(UINT32 *)&colofs[x<<2]) + 3);
@@ -264,16 +275,13 @@ static UINT8 *R_GenerateTexture(size_t texnum)
 	}
 
 	// multi-patch textures (or 'composite')
-	texture->holes = false;
 	blocksize = (texture->width * 4) + (texture->width * texture->height);
-	texturememory += blocksize;
-	block = Z_Malloc(blocksize+1, PU_STATIC, &texturecache[texnum]);
+	block = Z_Malloc(blocksize+1, PU_STATIC, NULL);
 
 	memset(block, 0xF7, blocksize+1); // Transparency hack
 
 	// columns lookup table
 	colofs = block;
-	texturecolumnofs[texnum] = (UINT32 *)colofs;
 
 	// texture data after the lookup table
 	blocktex = block + (texture->width*4);
@@ -304,8 +312,25 @@ static UINT8 *R_GenerateTexture(size_t texnum)
 	}
 
 done:
+	Z_Lock();
+	if (texturecache[texnum])
+	{
+		// Someone else finished it while we were building ours.
+		// Might be a prefetch worker, which mustn't go near Lua.
+		Z_FreeNoLua(block);
+		block = texturecache[texnum];
+		Z_Unlock();
+		return block;
+	}
+
+	texture->holes = holes;
+	texturecolumnofs[texnum] = (UINT32 *)colofs;
+	texturememory += blocksize;
+
 	// Now that the texture has been built in column cache, it is purgable from zone memory.
+	Z_SetUser(block, (void **)&texturecache[texnum]);
 	Z_ChangeTag(block, PU_CACHE);
+	Z_Unlock();
 	return blocktex;
 }
 
@@ -365,6 +390,8 @@ void R_FlushTextureCache(void)
 {
 	INT32 i;
 
+	R_StopPrefetch(-1);
+
 	if (numtextures)
 		for (i = 0; i < numtextures; i++)
 			Z_Free(texturecache[i]);
@@ -1685,7 +1712,7 @@ void R_PrecacheLevel(void)
 	spritepresent = calloc(numsprites, sizeof (*spritepresent));
 	if (spritepresent == NULL) I_Error("%s: Out of memory looking up sprites", "R_PrecacheLevel");
 
-	for (th = thinkercap.next; th != &thinkercap; th = th->next)
+	for (th = thlist[THINK_MOBJ].cnext; th != &thlist[THINK_MOBJ]; th = th->cnext)
 		if (th->function.acp1 == (actionf_p1)P_MobjThinker)
 			spritepresent[((mobj_t *)th)->sprite] = 1;
 
@@ -1731,3 +1758,351 @@ void R_PrecacheLevel(void)
 			"texturememory: %s k\n"
 			"spritememory:  %s k\n", sizeu1(flatmemory>>10), sizeu2(texturememory>>10), sizeu3(spritememory>>10));
 }
+
+#ifdef HAVE_THREADS
+//
+// Level prefetch
+//
+// Once the next map is known on the intermission or vote screen, worker
+// threads read its lumps and build its textures into the caches that
+// R_PrecacheLevel and the renderers use, so that by the time the level is
+// set up most of what it would have waited on is already there.
+//
+
+#define PREFETCHWORKERS 3
+
+typedef enum
+{
+	PREFETCH_TEXTURE, // build a wall texture
+	PREFETCH_LUMP // just read a lump into the cache
+} prefetchtype_t;
+
+typedef struct
+{
+	prefetchtype_t type;
+	INT32 num; // texture or lump number
+} prefetchjob_t;
+
+static I_mutex prefetch_mutex;
+static I_cond prefetch_cond;
+
+static INT16 prefetchmap = -1; // 0-based, like nextmap
+static lumpnum_t prefetchlump;
+static INT32 prefetchskynum; // read when queued, the header may change under the workers
+static boolean prefetchplanning, prefetchplanned, prefetchcancel;
+static UINT8 prefetchbusy;
+
+// The workers don't free zone memory with Z_Free, since that goes to the
+// Lua state the main thread is using; anything they own is malloc'd.
+static prefetchjob_t *prefetchjobs;
+static size_t numprefetchjobs, maxprefetchjobs, nextprefetchjob;
+static precise_t prefetchstart;
+
+static void R_AddPrefetchJob(prefetchtype_t type, INT32 num)
+{
+	if (numprefetchjobs >= maxprefetchjobs)
+	{
+		size_t newmax = maxprefetchjobs ? maxprefetchjobs * 2 : 256;
+		prefetchjob_t *newjobs = realloc(prefetchjobs, newmax * sizeof (*prefetchjobs));
+		if (!newjobs)
+			return; // it's only a prefetch
+		prefetchjobs = newjobs;
+		maxprefetchjobs = newmax;
+	}
+
+	prefetchjobs[numprefetchjobs].type = type;
+	prefetchjobs[numprefetchjobs].num = num;
+	numprefetchjobs++;
+}
+
+static void R_PrefetchTextureName(const char *name, UINT8 *seen)
+{
+	INT32 i;
+
+	// R_CheckTextureNumForName keeps a cache that's only safe to use
+	// from the main thread, so look for it the long way
+	if (name[0] == '-')
+		return;
+
+	for (i = numtextures - 1; i >= 0; i--)
+		if (!strncasecmp(textures[i]->name, name, 8))
+		{
+			if (!seen[i])
+			{
+				seen[i] = 1;
+				R_AddPrefetchJob(PREFETCH_TEXTURE, i);
+			}
+			return;
+		}
+}
+
+static void R_PrefetchSprite(spritenum_t spr, UINT8 *seen)
+{
+	size_t j, k;
+
+	if (spr >= numsprites || seen[spr])
+		return;
+	seen[spr] = 1;
+
+	for (j = 0; j < sprites[spr].numframes; j++)
+	{
+		const spriteframe_t *sf = &sprites[spr].spriteframes[j];
+
+		switch (sf->rotate)
+		{
+			case SRF_SINGLE:
+				R_AddPrefetchJob(PREFETCH_LUMP, sf->lumppat[0]);
+				break;
+			case SRF_2D:
+				R_AddPrefetchJob(PREFETCH_LUMP, sf->lumppat[2]);
+				R_AddPrefetchJob(PREFETCH_LUMP, sf->lumppat[6]);
+				break;
+			default:
+				k = (sf->rotate & SRF_3DGE ? 16 : 8);
+				while (k--)
+					R_AddPrefetchJob(PREFETCH_LUMP, sf->lumppat[k]);
+				break;
+		}
+	}
+}
+
+//
+// R_PlanPrefetch
+//
+// Reads the map and works out everything it will want, the same way
+// R_PrecacheLevel does once it's loaded: sidedef textures, sector flats
+// and the sprites of the things it starts with.
+//
+static void R_PlanPrefetch(void)
+{
+	virtres_t *virt;
+	virtlump_t *vlump;
+	UINT8 *seentextures, *seensprites;
+	size_t i, n;
+	INT32 j;
+
+	seentextures = calloc(numtextures + 1, 1);
+	seensprites = calloc(numsprites + 1, 1);
+	if (!seentextures || !seensprites)
+	{
+		free(seentextures);
+		free(seensprites);
+		return;
+	}
+
+	// Reading the lumps takes the zone lock by itself, for as long as the
+	// shared file handle is in use
+	virt = vres_GetMap(prefetchlump);
+
+	// The sky always gets built
+	if (prefetchskynum)
+	{
+		char skyname[16];
+		snprintf(skyname, sizeof skyname, "SKY%d", prefetchskynum);
+		R_PrefetchTextureName(skyname, seentextures);
+	}
+
+	vlump = vres_Find(virt, "SIDEDEFS");
+	if (vlump)
+	{
+		const mapsidedef_t *msd = (const mapsidedef_t *)vlump->data;
+		n = vlump->size / sizeof (*msd);
+		for (i = 0; i < n && !prefetchcancel; i++, msd++)
+		{
+			R_PrefetchTextureName(msd->toptexture, seentextures);
+			R_PrefetchTextureName(msd->midtexture, seentextures);
+			R_PrefetchTextureName(msd->bottomtexture, seentextures);
+		}
+	}
+
+	vlump = vres_Find(virt, "SECTORS");
+	if (vlump)
+	{
+		const mapsector_t *ms = (const mapsector_t *)vlump->data;
+		char name[9];
+		lumpnum_t flat;
+
+		name[8] = '\0';
+		n = vlump->size / sizeof (*ms);
+		for (i = 0; i < n && !prefetchcancel; i++, ms++)
+		{
+			// Lots of sectors share flats, this only has to be close
+			if (i && !memcmp(ms->floorpic, ms[-1].floorpic, 8) && !memcmp(ms->ceilingpic, ms[-1].ceilingpic, 8))
+				continue;
+
+			memcpy(name, ms->floorpic, 8);
+			if ((flat = W_CheckNumForName(name)) != LUMPERROR)
+				R_AddPrefetchJob(PREFETCH_LUMP, flat);
+			memcpy(name, ms->ceilingpic, 8);
+			if ((flat = W_CheckNumForName(name)) != LUMPERROR)
+				R_AddPrefetchJob(PREFETCH_LUMP, flat);
+		}
+	}
+
+	vlump = vres_Find(virt, "THINGS");
+	if (vlump)
+	{
+		UINT8 *data = vlump->data;
+		UINT16 type, lasttype = UINT16_MAX;
+
+		n = vlump->size / (5 * sizeof (INT16));
+		for (i = 0; i < n && !prefetchcancel; i++)
+		{
+			data += 3 * sizeof (INT16); // x, y, angle
+			type = READUINT16(data) & 4095;
+			data += sizeof (INT16); // options
+
+			if (type == lasttype)
+				continue;
+			lasttype = type;
+
+			for (j = 0; j < NUMMOBJTYPES; j++)
+				if (mobjinfo[j].doomednum == type)
+				{
+					R_PrefetchSprite(states[mobjinfo[j].spawnstate].sprite, seensprites);
+					break;
+				}
+		}
+	}
+
+	free(seentextures);
+	free(seensprites);
+	vres_Free(virt);
+}
+
+static void R_RunPrefetchJob(const prefetchjob_t *job)
+{
+	switch (job->type)
+	{
+		case PREFETCH_TEXTURE:
+			if (rendermode == render_soft)
+				R_CheckTextureCache(job->num);
+			else
+			{
+				// The hardware renderer builds its own, from the same patches
+				const texture_t *texture = textures[job->num];
+				INT32 i;
+				for (i = 0; i < texture->patchcount; i++)
+					W_CacheLumpNumPwad(texture->patches[i].wad, texture->patches[i].lump, PU_CACHE);
+			}
+			break;
+		case PREFETCH_LUMP:
+			if ((lumpnum_t)job->num != LUMPERROR)
+				W_CacheLumpNum(job->num, PU_CACHE);
+			break;
+	}
+}
+
+static void R_PrefetchWorker(void *userdata)
+{
+	prefetchjob_t job;
+	(void)userdata;
+
+	I_lock_mutex(&prefetch_mutex);
+
+	// The first one in works out what to do, the rest wait for it
+	if (!prefetchplanning)
+	{
+		prefetchplanning = true;
+		I_unlock_mutex(prefetch_mutex);
+		R_PlanPrefetch();
+		I_lock_mutex(&prefetch_mutex);
+		prefetchplanned = true;
+		I_wake_all_cond(&prefetch_cond);
+	}
+	while (!prefetchplanned)
+		I_hold_cond(&prefetch_cond, prefetch_mutex);
+
+	while (!prefetchcancel && !I_thread_is_stopped() && nextprefetchjob < numprefetchjobs)
+	{
+		job = prefetchjobs[nextprefetchjob++];
+		I_unlock_mutex(prefetch_mutex);
+		R_RunPrefetchJob(&job);
+		I_lock_mutex(&prefetch_mutex);
+	}
+
+	prefetchbusy--;
+	I_wake_all_cond(&prefetch_cond);
+	I_unlock_mutex(prefetch_mutex);
+}
+
+static void R_CancelPrefetch(void)
+{
+	R_StopPrefetch(-1);
+}
+
+//
+// R_PrefetchLevel
+//
+// Starts caching what the given map (0-based) needs in the background.
+// Anything already going for another map is dropped.
+//
+void R_PrefetchLevel(INT16 mapnum)
+{
+	static boolean exitfunc = false;
+	lumpnum_t lump;
+	UINT8 i;
+
+	if (dedicated || rendermode == render_none || !precache)
+		return;
+
+	if (prefetchmap == mapnum)
+		return;
+
+	R_StopPrefetch(-1);
+
+	lump = W_CheckNumForName(G_BuildMapName(mapnum + 1));
+	if (lump == LUMPERROR)
+		return;
+
+	if (!exitfunc)
+	{
+		I_AddExitFunc(R_CancelPrefetch); // before I_stop_threads waits on them
+		exitfunc = true;
+	}
+
+	prefetchmap = mapnum;
+	prefetchlump = lump;
+	prefetchskynum = mapheaderinfo[mapnum] ? mapheaderinfo[mapnum]->skynum : 0;
+	prefetchplanning = prefetchplanned = prefetchcancel = false;
+	numprefetchjobs = nextprefetchjob = 0;
+	prefetchbusy = PREFETCHWORKERS;
+	prefetchstart = I_GetPreciseTime();
+
+	Z_SetLocking(true);
+	for (i = 0; i < PREFETCHWORKERS; i++)
+		I_spawn_thread("level-prefetch", R_PrefetchWorker, NULL);
+}
+
+//
+// R_StopPrefetch
+//
+// Waits for the workers. If they were prefetching keepmap they're left to
+// finish, since everything they do would have to be done anyway, otherwise
+// they stop at the next job. Must be called before anything that changes
+// the textures, sprites or lumps they look at.
+//
+void R_StopPrefetch(INT16 keepmap)
+{
+	if (prefetchmap == -1)
+		return;
+
+	I_lock_mutex(&prefetch_mutex);
+	if (prefetchmap != keepmap)
+		prefetchcancel = true;
+	while (prefetchbusy)
+		I_hold_cond(&prefetch_cond, prefetch_mutex);
+	I_unlock_mutex(prefetch_mutex);
+
+	Z_SetLocking(false);
+
+	CONS_Debug(DBG_SETUP, "Prefetched %s of %s jobs for %s in %.2f ms\n",
+		sizeu1(nextprefetchjob), sizeu2(numprefetchjobs), G_BuildMapName(prefetchmap + 1),
+		(double)(I_GetPreciseTime() - prefetchstart) * 1000.0 / I_GetPrecisePrecision());
+
+	free(prefetchjobs);
+	prefetchjobs = NULL;
+	numprefetchjobs = maxprefetchjobs = nextprefetchjob = 0;
+	prefetchmap = -1;
+}
+#endif
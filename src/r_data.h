@@ -78,6 +78,14 @@ UINT8 *R_GetFlat(lumpnum_t flatnum);
 void R_InitData(void);
 void R_PrecacheLevel(void);
 
+#ifdef HAVE_THREADS
+void R_PrefetchLevel(INT16 mapnum);
+void R_StopPrefetch(INT16 keepmap);
+#else
+#define R_PrefetchLevel(mapnum) (void)(mapnum)
+#define R_StopPrefetch(keepmap) (void)(keepmap)
+#endif
+
 extern size_t flatmemory, spritememory, texturememory;
 
 // Retrieval.
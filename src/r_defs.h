@@ -372,6 +372,8 @@ typedef struct sector_s
 	// flag angles sector spawned with (via linedef type 7)
 	angle_t spawn_flrpic_angle;
 	angle_t spawn_ceilpic_angle;
+
+	INT32 luaref; // registry reference to this sector's Lua userdata, 0 if Lua never saw it
 } sector_t;
 
 //
@@ -418,10 +420,13 @@ typedef struct line_s
 	void *splats; // wallsplat_t list
 #endif
 	INT32 firsttag, nexttag; // improves searches for tags.
+	INT32 firstspecial, nextspecial; // and for specials
 	polyobj_t *polyobj; // Belongs to a polyobject?
 
 	char *text; // a concatination of all front and back texture names, for linedef specials that require a string.
 	INT16 callcount; // no. of calls left before triggering, for the "X calls" linedef specials, defaults to 0
+
+	INT32 luaref; // registry reference to this line's Lua userdata, 0 if Lua never saw it
 } line_t;
 
 //
@@ -27,22 +27,28 @@
 #include "z_zone.h"
 #include "console.h" // Until buffering gets finished
 #include "k_kart.h" // SRB2kart
+#include "i_system.h" // I_GetPreciseTime
 
 #ifdef HWRENDER
 #include "hardware/hw_main.h"
 #endif
 
+#ifdef SIMD_DRAWERS
+#include <immintrin.h>
+#endif
+
 // ==========================================================================
 //                     COMMON DATA FOR 8bpp AND 16bpp
 // ==========================================================================
 
 /**	\brief view info
 */
-INT32 viewwidth, scaledviewwidth, viewheight, viewwindowx, viewwindowy;
+INT32 viewwidth, scaledviewwidth, viewheight;
+ATTRTHREAD INT32 viewwindowx, viewwindowy;
 
 /**	\brief pointer to the start of each line of the screen,
 */
-UINT8 *ylookup[MAXVIDHEIGHT*4];
+ATTRTHREAD UINT8 *ylookup[MAXVIDHEIGHT*4];
 
 /**	\brief pointer to the start of each line of the screen, for view1 (splitscreen)
 */
@@ -65,20 +71,20 @@ UINT8 *ylookup4[MAXVIDHEIGHT*4];
 */
 INT32 columnofs[MAXVIDWIDTH*4];
 
-UINT8 *topleft;
+ATTRTHREAD UINT8 *topleft;
 
 // =========================================================================
 //                      COLUMN DRAWING CODE STUFF
 // =========================================================================
 
-lighttable_t *dc_colormap;
-INT32 dc_x = 0, dc_yl = 0, dc_yh = 0;
+ATTRTHREAD lighttable_t *dc_colormap;
+ATTRTHREAD INT32 dc_x = 0, dc_yl = 0, dc_yh = 0;
 
-fixed_t dc_iscale, dc_texturemid;
-UINT8 dc_hires; // under MSVC boolean is a byte, while on other systems, it a bit,
+ATTRTHREAD fixed_t dc_iscale, dc_texturemid;
+ATTRTHREAD UINT8 dc_hires; // under MSVC boolean is a byte, while on other systems, it a bit,
                // soo lets make it a byte on all system for the ASM code
-UINT8 *dc_source;
-INT32 dc_sourcelength;
+ATTRTHREAD UINT8 *dc_source;
+ATTRTHREAD INT32 dc_sourcelength;
 
 // -----------------------
 // translucency stuff here
@@ -89,7 +95,7 @@ UINT8 *transtables; // translucency tables
 
 /**	\brief R_DrawTransColumn uses this
 */
-UINT8 *dc_transmap; // one of the translucency tables
+ATTRTHREAD UINT8 *dc_transmap; // one of the translucency tables
 
 // ----------------------
 // translation stuff here
@@ -98,31 +104,31 @@ UINT8 *dc_transmap; // one of the translucency tables
 
 /**	\brief R_DrawTranslatedColumn uses this
 */
-UINT8 *dc_translation;
+ATTRTHREAD UINT8 *dc_translation;
 
-struct r_lightlist_s *dc_lightlist = NULL;
-INT32 dc_numlights = 0, dc_maxlights, dc_texheight;
+ATTRTHREAD struct r_lightlist_s *dc_lightlist = NULL;
+ATTRTHREAD INT32 dc_numlights = 0, dc_maxlights, dc_texheight;
 
 // =========================================================================
 //                      SPAN DRAWING CODE STUFF
 // =========================================================================
 
-INT32 ds_y, ds_x1, ds_x2;
-lighttable_t *ds_colormap;
-fixed_t ds_xfrac, ds_yfrac, ds_xstep, ds_ystep;
+ATTRTHREAD INT32 ds_y, ds_x1, ds_x2;
+ATTRTHREAD lighttable_t *ds_colormap;
+ATTRTHREAD fixed_t ds_xfrac, ds_yfrac, ds_xstep, ds_ystep;
 
-UINT8 *ds_source; // points to the start of a flat
-UINT8 *ds_transmap; // one of the translucency tables
+ATTRTHREAD UINT8 *ds_source; // points to the start of a flat
+ATTRTHREAD UINT8 *ds_transmap; // one of the translucency tables
 
 // Vectors for Software's tilted slope drawers
-floatv3_t *ds_su, *ds_sv, *ds_sz;
-floatv3_t *ds_sup, *ds_svp, *ds_szp;
-float focallengthf, zeroheight;
+ATTRTHREAD floatv3_t *ds_su, *ds_sv, *ds_sz;
+ATTRTHREAD floatv3_t *ds_sup, *ds_svp, *ds_szp;
+ATTRTHREAD float focallengthf, zeroheight;
 
 /**	\brief Variable flat sizes
 */
 
-UINT32 nflatxshift, nflatyshift, nflatshiftup, nflatmask;
+ATTRTHREAD UINT32 nflatxshift, nflatyshift, nflatshiftup, nflatmask;
 
 // ==========================================================================
 //                        OLD DOOM FUZZY EFFECT
@@ -269,6 +275,9 @@ static UINT8* RGetTranslationColormap(INT32 skinnum, skincolors_t color, UINT8 f
 		else skintableindex = skinnum;
 	}
 
+	// The cache tables are shared between threaded views
+	Z_Lock();
+
 	if (flags & GTC_CACHE)
 	{
 
@@ -292,6 +301,7 @@ static UINT8* RGetTranslationColormap(INT32 skinnum, skincolors_t color, UINT8 f
 			tt[skintableindex][color] = ret;
 	}
 
+	Z_Unlock();
 	return ret;
 }
 
@@ -600,3 +610,123 @@ void R_DrawViewBorder(void)
 #ifdef HIGHCOLOR
 #include "r_draw16.c"
 #endif
+
+// ==========================================================================
+//                          DRAWER BENCHMARK
+// ==========================================================================
+
+typedef struct
+{
+	const char *name;
+	void (*func)(void);
+	boolean span;
+} drawerbench_t;
+
+static drawerbench_t drawerbenches[] =
+{
+	{"R_DrawColumn_8", R_DrawColumn_8, false},
+	{"R_DrawTranslucentColumn_8", R_DrawTranslucentColumn_8, false},
+	{"R_DrawSpan_8", R_DrawSpan_8, true},
+#ifdef SIMD_DRAWERS
+	{"R_DrawColumn_8_SSE2", R_DrawColumn_8_SSE2, false},
+	{"R_DrawTranslucentColumn_8_SSE2", R_DrawTranslucentColumn_8_SSE2, false},
+	{"R_DrawSpan_8_SSE2", R_DrawSpan_8_SSE2, true},
+	{"R_DrawColumn_8_AVX2", R_DrawColumn_8_AVX2, false},
+	{"R_DrawTranslucentColumn_8_AVX2", R_DrawTranslucentColumn_8_AVX2, false},
+	{"R_DrawSpan_8_AVX2", R_DrawSpan_8_AVX2, true},
+#endif
+	{NULL, NULL, false}
+};
+
+/** \brief Times each 8bpp drawer filling the view, for comparing the
+	plain and SIMD drawers. Draws over the view, which the next frame
+	covers up again.
+
+	drawerbench [frames]
+*/
+void Command_DrawerBench_f(void)
+{
+	INT32 frames = 100, f, i;
+	UINT8 *texture, *flat;
+	drawerbench_t *bench;
+	const double precision = I_GetPrecisePrecision();
+
+	if (rendermode != render_soft || !screens[0] || !viewwidth || !viewheight)
+	{
+		CONS_Printf(M_GetText("The drawer benchmark needs the software renderer.\n"));
+		return;
+	}
+
+	if (COM_Argc() > 1)
+		frames = max(1, atoi(COM_Argv(1)));
+
+	texture = Z_Malloc(128, PU_STATIC, NULL);
+	flat = Z_Malloc(64*64, PU_STATIC, NULL);
+	for (i = 0; i < 128; i++)
+		texture[i] = (UINT8)(i*7);
+	for (i = 0; i < 64*64; i++)
+		flat[i] = (UINT8)(i*13 + (i>>6));
+
+	CONS_Printf(M_GetText("Drawing %d frames of %dx%d:\n"), frames, viewwidth, viewheight);
+
+	for (bench = drawerbenches; bench->name; bench++)
+	{
+		precise_t start;
+		double seconds;
+
+#ifdef SIMD_DRAWERS
+		if (strstr(bench->name, "AVX2") && !R_CPUHasAVX2())
+			continue;
+#endif
+
+		start = I_GetPreciseTime();
+		for (f = 0; f < frames; f++)
+		{
+			if (bench->span)
+			{
+				ds_source = flat;
+				ds_colormap = colormaps;
+				ds_transmap = transtables;
+				nflatmask = 0xFC0; // 64x64
+				nflatxshift = 26;
+				nflatyshift = 20;
+				nflatshiftup = 10;
+				ds_x1 = 0;
+				ds_x2 = viewwidth - 1;
+				ds_xstep = FRACUNIT/3;
+				ds_ystep = FRACUNIT/7;
+				for (ds_y = 0; ds_y < viewheight; ds_y++)
+				{
+					ds_xfrac = ds_y*FRACUNIT/5;
+					ds_yfrac = ds_y*FRACUNIT/2;
+					bench->func();
+				}
+			}
+			else
+			{
+				dc_source = texture;
+				dc_sourcelength = 128;
+				dc_texheight = 128;
+				dc_colormap = colormaps;
+				dc_transmap = transtables;
+				dc_iscale = FRACUNIT/2;
+				dc_hires = 0;
+				dc_yl = 0;
+				dc_yh = viewheight - 1;
+				for (dc_x = 0; dc_x < viewwidth; dc_x++)
+				{
+					dc_texturemid = dc_x*FRACUNIT;
+					bench->func();
+				}
+			}
+		}
+		seconds = (double)(I_GetPreciseTime() - start) / precision;
+
+		CONS_Printf("%-32s %8.3f ms/frame  %8.1f Mpixels/s\n", bench->name,
+			seconds * 1000.0 / frames,
+			seconds > 0.0 ? (double)frames * viewwidth * viewheight / seconds / 1000000.0 : 0.0);
+	}
+
+	Z_Free(texture);
+	Z_Free(flat);
+}
@@ -20,67 +20,67 @@
 // -------------------------------
 // COMMON STUFF FOR 8bpp AND 16bpp
 // -------------------------------
-extern UINT8 *ylookup[MAXVIDHEIGHT*4];
+extern ATTRTHREAD UINT8 *ylookup[MAXVIDHEIGHT*4];
 extern UINT8 *ylookup1[MAXVIDHEIGHT*4];
 extern UINT8 *ylookup2[MAXVIDHEIGHT*4];
 extern UINT8 *ylookup3[MAXVIDHEIGHT*4];
 extern UINT8 *ylookup4[MAXVIDHEIGHT*4];
 extern INT32 columnofs[MAXVIDWIDTH*4];
-extern UINT8 *topleft;
+extern ATTRTHREAD UINT8 *topleft;
 
 // -------------------------
 // COLUMN DRAWING CODE STUFF
 // -------------------------
 
-extern lighttable_t *dc_colormap;
-extern INT32 dc_x, dc_yl, dc_yh;
-extern fixed_t dc_iscale, dc_texturemid;
-extern UINT8 dc_hires;
+extern ATTRTHREAD lighttable_t *dc_colormap;
+extern ATTRTHREAD INT32 dc_x, dc_yl, dc_yh;
+extern ATTRTHREAD fixed_t dc_iscale, dc_texturemid;
+extern ATTRTHREAD UINT8 dc_hires;
 
-extern UINT8 *dc_source; // first pixel in a column
+extern ATTRTHREAD UINT8 *dc_source; // first pixel in a column
 
 // translucency stuff here
 extern UINT8 *transtables; // translucency tables, should be (*transtables)[5][256][256]
-extern UINT8 *dc_transmap;
+extern ATTRTHREAD UINT8 *dc_transmap;
 
 // translation stuff here
 
-extern UINT8 *dc_translation;
+extern ATTRTHREAD UINT8 *dc_translation;
 
-extern struct r_lightlist_s *dc_lightlist;
-extern INT32 dc_numlights, dc_maxlights;
+extern ATTRTHREAD struct r_lightlist_s *dc_lightlist;
+extern ATTRTHREAD INT32 dc_numlights, dc_maxlights;
 
 //Fix TUTIFRUTI
-extern INT32 dc_texheight;
+extern ATTRTHREAD INT32 dc_texheight;
 
 // -----------------------
 // SPAN DRAWING CODE STUFF
 // -----------------------
 
-extern INT32 ds_y, ds_x1, ds_x2;
-extern lighttable_t *ds_colormap;
-extern fixed_t ds_xfrac, ds_yfrac, ds_xstep, ds_ystep;
-extern INT32 ds_waterofs, ds_bgofs;
-extern UINT8 *ds_source; // start of a 64*64 tile image
-extern INT32 dc_sourcelength;
-extern UINT8 *ds_transmap;
+extern ATTRTHREAD INT32 ds_y, ds_x1, ds_x2;
+extern ATTRTHREAD lighttable_t *ds_colormap;
+extern ATTRTHREAD fixed_t ds_xfrac, ds_yfrac, ds_xstep, ds_ystep;
+extern ATTRTHREAD INT32 ds_waterofs, ds_bgofs;
+extern ATTRTHREAD UINT8 *ds_source; // start of a 64*64 tile image
+extern ATTRTHREAD INT32 dc_sourcelength;
+extern ATTRTHREAD UINT8 *ds_transmap;
 
-extern INT32 ds_bgofs;
+extern ATTRTHREAD INT32 ds_bgofs;
 
 typedef struct {
 	float x, y, z;
 } floatv3_t;
 
 // Vectors for Software's tilted slope drawers
-extern floatv3_t *ds_su, *ds_sv, *ds_sz;
-extern floatv3_t *ds_sup, *ds_svp, *ds_szp;
-extern float focallengthf, zeroheight;
+extern ATTRTHREAD floatv3_t *ds_su, *ds_sv, *ds_sz;
+extern ATTRTHREAD floatv3_t *ds_sup, *ds_svp, *ds_szp;
+extern ATTRTHREAD float focallengthf, zeroheight;
 
 // Variable flat sizes
-extern UINT32 nflatxshift;
-extern UINT32 nflatyshift;
-extern UINT32 nflatshiftup;
-extern UINT32 nflatmask;
+extern ATTRTHREAD UINT32 nflatxshift;
+extern ATTRTHREAD UINT32 nflatyshift;
+extern ATTRTHREAD UINT32 nflatshiftup;
+extern ATTRTHREAD UINT32 nflatmask;
 
 /// \brief Top border
 #define BRDR_T 0
@@ -171,6 +171,20 @@ void R_DrawFogSpan_8(void);
 void R_DrawFogColumn_8(void);
 void R_DrawColumnShadowed_8(void);
 
+// x86 drawers, for GCC-compatible compilers that can target them
+#if defined (__GNUC__) && defined (__SSE2__) && (defined (__x86_64__) || defined (__i386__))
+#define SIMD_DRAWERS
+boolean R_CPUHasAVX2(void);
+void R_DrawColumn_8_SSE2(void);
+void R_DrawTranslucentColumn_8_SSE2(void);
+void R_DrawSpan_8_SSE2(void);
+void R_DrawColumn_8_AVX2(void);
+void R_DrawTranslucentColumn_8_AVX2(void);
+void R_DrawSpan_8_AVX2(void);
+#endif
+
+void Command_DrawerBench_f(void);
+
 // ------------------
 // 16bpp DRAWING CODE
 // ------------------
@@ -773,7 +773,7 @@ void R_DrawSpan_8 (void)
 
 // R_CalcTiltedLighting
 // Exactly what it says on the tin. I wish I wasn't too lazy to explain things properly.
-static INT32 tiltlighting[MAXVIDWIDTH];
+static ATTRTHREAD INT32 tiltlighting[MAXVIDWIDTH];
 void R_CalcTiltedLighting(fixed_t start, fixed_t end)
 {
 	// ZDoom uses a different lighting setup to us, and I couldn't figure out how to adapt their version
@@ -1773,3 +1773,388 @@ void R_DrawColumnShadowed_8(void)
 	if (dc_yl <= realyh)
 		walldrawerfunc();		// R_DrawWallColumn_8 for the appropriate architecture
 }
+
+#ifdef SIMD_DRAWERS
+// ==========================================================================
+// SIMD DRAWERS
+// ==========================================================================
+
+// These do the same as the plain drawers above, several pixels at a time.
+// SCR_SetMode picks the best set the CPU supports.
+//
+// The AVX2 drawers look up bytes with 32-bit gathers. Each lane reads the
+// 4-byte aligned word holding the byte it wants, so it never touches memory
+// outside that byte's own aligned word, whatever surrounds the table.
+
+#define ATTRAVX2 __attribute__((target("avx2")))
+
+static inline ATTRAVX2 __m256i GatherBytes(const UINT8 *table, __m256i index)
+{
+	const UINT8 *base = (const UINT8 *)((uintptr_t)table & ~(uintptr_t)3);
+	const __m256i offs = _mm256_add_epi32(index, _mm256_set1_epi32((INT32)(table - base)));
+	const __m256i three = _mm256_set1_epi32(3);
+	__m256i words = _mm256_i32gather_epi32((const int *)base, _mm256_andnot_si256(three, offs), 1);
+
+	words = _mm256_srlv_epi32(words, _mm256_slli_epi32(_mm256_and_si256(offs, three), 3));
+	return _mm256_and_si256(words, _mm256_set1_epi32(0xFF));
+}
+
+#define GATHERBYTES(table, index) GatherBytes((table), (index))
+
+/**	\brief The R_CPUHasAVX2 function
+	Whether the AVX2 drawers can be used.
+*/
+boolean R_CPUHasAVX2(void)
+{
+	static INT32 hasavx2 = -1;
+
+	if (hasavx2 == -1)
+	{
+		__builtin_cpu_init();
+		hasavx2 = (__builtin_cpu_supports("avx2") != 0);
+	}
+
+	return (boolean)hasavx2;
+}
+
+/**	\brief The R_DrawColumn_8_SSE2 function
+	R_DrawColumn_8, stepping through the texture four pixels at a time.
+*/
+void R_DrawColumn_8_SSE2(void)
+{
+	INT32 count = dc_yh - dc_yl + 1;
+	INT32 heightmask = dc_texheight - 1;
+	UINT8 *dest;
+	const UINT8 *source = dc_source;
+	const lighttable_t *colormap = dc_colormap;
+	fixed_t frac, fracstep;
+	__m128i fracs, step4, mask;
+	INT32 idx[4];
+
+	// Non-power-of-2 textures wrap every pixel, leave those to the plain drawer.
+	if (count < 4 || (dc_texheight & heightmask))
+	{
+		R_DrawColumn_8();
+		return;
+	}
+
+#ifdef RANGECHECK
+	if ((unsigned)dc_x >= (unsigned)vid.width || dc_yl < 0 || dc_yh >= vid.height)
+		return;
+#endif
+
+	dest = &topleft[dc_yl*vid.width + dc_x];
+
+	fracstep = dc_iscale;
+	frac = (dc_texturemid + FixedMul((dc_yl << FRACBITS) - centeryfrac, fracstep))*(!dc_hires);
+
+	fracs = _mm_add_epi32(_mm_set1_epi32(frac), _mm_setr_epi32(0, fracstep, fracstep*2, fracstep*3));
+	step4 = _mm_set1_epi32(fracstep*4);
+	mask = _mm_set1_epi32(heightmask);
+
+	for (; count >= 4; count -= 4)
+	{
+		_mm_storeu_si128((__m128i *)idx, _mm_and_si128(_mm_srai_epi32(fracs, FRACBITS), mask));
+		fracs = _mm_add_epi32(fracs, step4);
+
+		dest[0] = colormap[source[idx[0]]];
+		dest[vid.width] = colormap[source[idx[1]]];
+		dest[vid.width*2] = colormap[source[idx[2]]];
+		dest[vid.width*3] = colormap[source[idx[3]]];
+		dest += vid.width*4;
+	}
+
+	frac = _mm_cvtsi128_si32(fracs);
+	while (count--)
+	{
+		*dest = colormap[source[(frac>>FRACBITS) & heightmask]];
+		dest += vid.width;
+		frac += fracstep;
+	}
+}
+
+/**	\brief The R_DrawTranslucentColumn_8_SSE2 function
+	R_DrawTranslucentColumn_8, stepping through the texture four pixels at a time.
+*/
+void R_DrawTranslucentColumn_8_SSE2(void)
+{
+	INT32 count = dc_yh - dc_yl + 1;
+	INT32 heightmask = dc_texheight - 1;
+	UINT8 *dest;
+	const UINT8 *source = dc_source;
+	const UINT8 *transmap = dc_transmap;
+	const lighttable_t *colormap = dc_colormap;
+	fixed_t frac, fracstep;
+	__m128i fracs, step4, mask;
+	INT32 idx[4];
+
+	if (count < 4 || (dc_texheight & heightmask))
+	{
+		R_DrawTranslucentColumn_8();
+		return;
+	}
+
+#ifdef RANGECHECK
+	if ((unsigned)dc_x >= (unsigned)vid.width || dc_yl < 0 || dc_yh >= vid.height)
+		I_Error("R_DrawTranslucentColumn_8_SSE2: %d to %d at %d", dc_yl, dc_yh, dc_x);
+#endif
+
+	dest = &topleft[dc_yl*vid.width + dc_x];
+
+	fracstep = dc_iscale;
+	frac = (dc_texturemid + FixedMul((dc_yl << FRACBITS) - centeryfrac, fracstep))*(!dc_hires);
+
+	fracs = _mm_add_epi32(_mm_set1_epi32(frac), _mm_setr_epi32(0, fracstep, fracstep*2, fracstep*3));
+	step4 = _mm_set1_epi32(fracstep*4);
+	mask = _mm_set1_epi32(heightmask);
+
+	for (; count >= 4; count -= 4)
+	{
+		_mm_storeu_si128((__m128i *)idx, _mm_and_si128(_mm_srai_epi32(fracs, FRACBITS), mask));
+		fracs = _mm_add_epi32(fracs, step4);
+
+		dest[0] = transmap[(colormap[source[idx[0]]]<<8) + dest[0]];
+		dest[vid.width] = transmap[(colormap[source[idx[1]]]<<8) + dest[vid.width]];
+		dest[vid.width*2] = transmap[(colormap[source[idx[2]]]<<8) + dest[vid.width*2]];
+		dest[vid.width*3] = transmap[(colormap[source[idx[3]]]<<8) + dest[vid.width*3]];
+		dest += vid.width*4;
+	}
+
+	frac = _mm_cvtsi128_si32(fracs);
+	while (count--)
+	{
+		*dest = transmap[(colormap[source[(frac>>FRACBITS) & heightmask]]<<8) + *dest];
+		dest += vid.width;
+		frac += fracstep;
+	}
+}
+
+/**	\brief The R_DrawSpan_8_SSE2 function
+	R_DrawSpan_8, working out the flat offsets of eight pixels at a time.
+*/
+void R_DrawSpan_8_SSE2(void)
+{
+	UINT32 xposition, yposition, xstep, ystep;
+	const UINT8 *source = ds_source;
+	const UINT8 *colormap = ds_colormap;
+	UINT8 *dest;
+	const UINT8 *deststop = screens[0] + vid.rowbytes * vid.height;
+	size_t count = (ds_x2 - ds_x1 + 1);
+	__m128i xpos, ypos, xstep4, ystep4, mask, xshift, yshift;
+	UINT32 bit[8];
+
+	xposition = (UINT32)ds_xfrac << nflatshiftup; yposition = (UINT32)ds_yfrac << nflatshiftup;
+	xstep = (UINT32)ds_xstep << nflatshiftup; ystep = (UINT32)ds_ystep << nflatshiftup;
+
+	dest = ylookup[ds_y] + columnofs[ds_x1];
+
+	if (dest+8 > deststop)
+		return;
+
+	xpos = _mm_add_epi32(_mm_set1_epi32(xposition), _mm_setr_epi32(0, xstep, xstep*2, xstep*3));
+	ypos = _mm_add_epi32(_mm_set1_epi32(yposition), _mm_setr_epi32(0, ystep, ystep*2, ystep*3));
+	xstep4 = _mm_set1_epi32(xstep*4);
+	ystep4 = _mm_set1_epi32(ystep*4);
+	mask = _mm_set1_epi32(nflatmask);
+	xshift = _mm_cvtsi32_si128(nflatxshift);
+	yshift = _mm_cvtsi32_si128(nflatyshift);
+
+	for (; count >= 8; count -= 8)
+	{
+		_mm_storeu_si128((__m128i *)&bit[0], _mm_or_si128(_mm_and_si128(_mm_srl_epi32(ypos, yshift), mask), _mm_srl_epi32(xpos, xshift)));
+		xpos = _mm_add_epi32(xpos, xstep4);
+		ypos = _mm_add_epi32(ypos, ystep4);
+		_mm_storeu_si128((__m128i *)&bit[4], _mm_or_si128(_mm_and_si128(_mm_srl_epi32(ypos, yshift), mask), _mm_srl_epi32(xpos, xshift)));
+		xpos = _mm_add_epi32(xpos, xstep4);
+		ypos = _mm_add_epi32(ypos, ystep4);
+
+		dest[0] = colormap[source[bit[0]]];
+		dest[1] = colormap[source[bit[1]]];
+		dest[2] = colormap[source[bit[2]]];
+		dest[3] = colormap[source[bit[3]]];
+		dest[4] = colormap[source[bit[4]]];
+		dest[5] = colormap[source[bit[5]]];
+		dest[6] = colormap[source[bit[6]]];
+		dest[7] = colormap[source[bit[7]]];
+		dest += 8;
+	}
+
+	xposition = (UINT32)_mm_cvtsi128_si32(xpos);
+	yposition = (UINT32)_mm_cvtsi128_si32(ypos);
+	while (count-- && dest <= deststop)
+	{
+		*dest++ = colormap[source[((yposition >> nflatyshift) & nflatmask) | (xposition >> nflatxshift)]];
+		xposition += xstep;
+		yposition += ystep;
+	}
+}
+
+// Stores the low bytes of eight dwords to dest, dest+pitch, ...
+#define STORECOLUMN8(dest, pitch, v) \
+{ \
+	UINT32 out_[8]; \
+	_mm256_storeu_si256((__m256i *)out_, (v)); \
+	(dest)[0] = (UINT8)out_[0]; (dest)[(pitch)] = (UINT8)out_[1]; \
+	(dest)[(pitch)*2] = (UINT8)out_[2]; (dest)[(pitch)*3] = (UINT8)out_[3]; \
+	(dest)[(pitch)*4] = (UINT8)out_[4]; (dest)[(pitch)*5] = (UINT8)out_[5]; \
+	(dest)[(pitch)*6] = (UINT8)out_[6]; (dest)[(pitch)*7] = (UINT8)out_[7]; \
+}
+
+/**	\brief The R_DrawColumn_8_AVX2 function
+	R_DrawColumn_8, eight pixels at a time with gathered lookups.
+*/
+ATTRAVX2 void R_DrawColumn_8_AVX2(void)
+{
+	INT32 count = dc_yh - dc_yl + 1;
+	INT32 heightmask = dc_texheight - 1;
+	const INT32 pitch = vid.width;
+	UINT8 *dest;
+	fixed_t frac, fracstep;
+	__m256i fracs, step8, mask;
+
+	if (count < 8 || (dc_texheight & heightmask))
+	{
+		R_DrawColumn_8();
+		return;
+	}
+
+#ifdef RANGECHECK
+	if ((unsigned)dc_x >= (unsigned)vid.width || dc_yl < 0 || dc_yh >= vid.height)
+		return;
+#endif
+
+	dest = &topleft[dc_yl*pitch + dc_x];
+
+	fracstep = dc_iscale;
+	frac = (dc_texturemid + FixedMul((dc_yl << FRACBITS) - centeryfrac, fracstep))*(!dc_hires);
+
+	fracs = _mm256_add_epi32(_mm256_set1_epi32(frac), _mm256_mullo_epi32(_mm256_set1_epi32(fracstep), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)));
+	step8 = _mm256_set1_epi32(fracstep*8);
+	mask = _mm256_set1_epi32(heightmask);
+
+	for (; count >= 8; count -= 8)
+	{
+		__m256i texel = GATHERBYTES(dc_source, _mm256_and_si256(_mm256_srai_epi32(fracs, FRACBITS), mask));
+		STORECOLUMN8(dest, pitch, GATHERBYTES(dc_colormap, texel));
+		fracs = _mm256_add_epi32(fracs, step8);
+		dest += pitch*8;
+	}
+
+	frac = _mm_cvtsi128_si32(_mm256_castsi256_si128(fracs));
+	while (count--)
+	{
+		*dest = dc_colormap[dc_source[(frac>>FRACBITS) & heightmask]];
+		dest += pitch;
+		frac += fracstep;
+	}
+}
+
+/**	\brief The R_DrawTranslucentColumn_8_AVX2 function
+	R_DrawTranslucentColumn_8, eight pixels at a time with gathered lookups.
+*/
+ATTRAVX2 void R_DrawTranslucentColumn_8_AVX2(void)
+{
+	INT32 count = dc_yh - dc_yl + 1;
+	INT32 heightmask = dc_texheight - 1;
+	const INT32 pitch = vid.width;
+	UINT8 *dest;
+	fixed_t frac, fracstep;
+	__m256i fracs, step8, mask;
+
+	if (count < 8 || (dc_texheight & heightmask))
+	{
+		R_DrawTranslucentColumn_8();
+		return;
+	}
+
+#ifdef RANGECHECK
+	if ((unsigned)dc_x >= (unsigned)vid.width || dc_yl < 0 || dc_yh >= vid.height)
+		I_Error("R_DrawTranslucentColumn_8_AVX2: %d to %d at %d", dc_yl, dc_yh, dc_x);
+#endif
+
+	dest = &topleft[dc_yl*pitch + dc_x];
+
+	fracstep = dc_iscale;
+	frac = (dc_texturemid + FixedMul((dc_yl << FRACBITS) - centeryfrac, fracstep))*(!dc_hires);
+
+	fracs = _mm256_add_epi32(_mm256_set1_epi32(frac), _mm256_mullo_epi32(_mm256_set1_epi32(fracstep), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)));
+	step8 = _mm256_set1_epi32(fracstep*8);
+	mask = _mm256_set1_epi32(heightmask);
+
+	for (; count >= 8; count -= 8)
+	{
+		__m256i texel = GATHERBYTES(dc_source, _mm256_and_si256(_mm256_srai_epi32(fracs, FRACBITS), mask));
+		__m256i under = _mm256_setr_epi32(dest[0], dest[pitch], dest[pitch*2], dest[pitch*3],
+			dest[pitch*4], dest[pitch*5], dest[pitch*6], dest[pitch*7]);
+		__m256i color = _mm256_slli_epi32(GATHERBYTES(dc_colormap, texel), 8);
+		STORECOLUMN8(dest, pitch, GATHERBYTES(dc_transmap, _mm256_add_epi32(color, under)));
+		fracs = _mm256_add_epi32(fracs, step8);
+		dest += pitch*8;
+	}
+
+	frac = _mm_cvtsi128_si32(_mm256_castsi256_si128(fracs));
+	while (count--)
+	{
+		*dest = dc_transmap[(dc_colormap[dc_source[(frac>>FRACBITS) & heightmask]]<<8) + *dest];
+		dest += pitch;
+		frac += fracstep;
+	}
+}
+
+#undef STORECOLUMN8
+
+/**	\brief The R_DrawSpan_8_AVX2 function
+	R_DrawSpan_8, eight pixels at a time with gathered lookups.
+*/
+ATTRAVX2 void R_DrawSpan_8_AVX2(void)
+{
+	UINT32 xposition, yposition, xstep, ystep;
+	const UINT8 *colormap = ds_colormap;
+	UINT8 *dest;
+	const UINT8 *deststop = screens[0] + vid.rowbytes * vid.height;
+	size_t count = (ds_x2 - ds_x1 + 1);
+	const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+	__m256i xpos, ypos, xstep8, ystep8, mask;
+	__m128i xshift, yshift;
+
+	xposition = (UINT32)ds_xfrac << nflatshiftup; yposition = (UINT32)ds_yfrac << nflatshiftup;
+	xstep = (UINT32)ds_xstep << nflatshiftup; ystep = (UINT32)ds_ystep << nflatshiftup;
+
+	dest = ylookup[ds_y] + columnofs[ds_x1];
+
+	if (dest+8 > deststop)
+		return;
+
+	xpos = _mm256_add_epi32(_mm256_set1_epi32(xposition), _mm256_mullo_epi32(_mm256_set1_epi32(xstep), lanes));
+	ypos = _mm256_add_epi32(_mm256_set1_epi32(yposition), _mm256_mullo_epi32(_mm256_set1_epi32(ystep), lanes));
+	xstep8 = _mm256_set1_epi32(xstep*8);
+	ystep8 = _mm256_set1_epi32(ystep*8);
+	mask = _mm256_set1_epi32(nflatmask);
+	xshift = _mm_cvtsi32_si128(nflatxshift);
+	yshift = _mm_cvtsi32_si128(nflatyshift);
+
+	for (; count >= 8; count -= 8)
+	{
+		__m256i bit = _mm256_or_si256(_mm256_and_si256(_mm256_srl_epi32(ypos, yshift), mask), _mm256_srl_epi32(xpos, xshift));
+		__m256i color = GATHERBYTES(colormap, GATHERBYTES(ds_source, bit));
+		__m128i words = _mm_packus_epi32(_mm256_castsi256_si128(color), _mm256_extracti128_si256(color, 1));
+
+		_mm_storel_epi64((__m128i *)dest, _mm_packus_epi16(words, words));
+		xpos = _mm256_add_epi32(xpos, xstep8);
+		ypos = _mm256_add_epi32(ypos, ystep8);
+		dest += 8;
+	}
+
+	xposition = (UINT32)_mm_cvtsi128_si32(_mm256_castsi256_si128(xpos));
+	yposition = (UINT32)_mm_cvtsi128_si32(_mm256_castsi256_si128(ypos));
+	while (count-- && dest <= deststop)
+	{
+		*dest++ = colormap[ds_source[((yposition >> nflatyshift) & nflatmask) | (xposition >> nflatxshift)]];
+		xposition += xstep;
+		yposition += ystep;
+	}
+}
+
+#undef GATHERBYTES
+#undef ATTRAVX2
+#endif // SIMD_DRAWERS
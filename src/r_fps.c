@@ -78,12 +78,12 @@ static viewvars_t pview_new[MAXSPLITSCREENPLAYERS];
 static viewvars_t skyview_old[MAXSPLITSCREENPLAYERS];
 static viewvars_t skyview_new[MAXSPLITSCREENPLAYERS];
 
-static viewvars_t *oldview = &pview_old[0];
+static ATTRTHREAD viewvars_t *oldview = &pview_old[0];
 static int oldview_invalid[MAXSPLITSCREENPLAYERS] = {0, 0, 0, 0};
-viewvars_t *newview = &pview_new[0];
+ATTRTHREAD viewvars_t *newview = &pview_new[0];
 
 
-enum viewcontext_e viewcontext = VIEWCONTEXT_PLAYER1;
+ATTRTHREAD enum viewcontext_e viewcontext = VIEWCONTEXT_PLAYER1;
 
 static levelinterpolator_t **levelinterpolators;
 static size_t levelinterpolators_len;
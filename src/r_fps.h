@@ -53,7 +53,7 @@ typedef struct {
 	mobj_t *mobj;
 } viewvars_t;
 
-extern viewvars_t *newview;
+extern ATTRTHREAD viewvars_t *newview;
 
 typedef struct {
 	fixed_t x;
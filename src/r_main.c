@@ -39,15 +39,22 @@
 #include "hardware/hw_main.h"
 #endif
 
+#ifdef HAVE_ATTRTHREAD
+#include "i_threads.h"
+#include "i_system.h" // I_AddExitFunc
+#endif
+
 // Fineangles in the SCREENWIDTH wide window.
 #define FIELDOFVIEW 2048
 
 // increment every time a check is made
 size_t validcount = 1;
 
-INT32 centerx, centery;
+INT32 centerx;
+ATTRTHREAD INT32 centery;
 
-fixed_t centerxfrac, centeryfrac;
+fixed_t centerxfrac;
+ATTRTHREAD fixed_t centeryfrac;
 fixed_t projection;
 fixed_t projectiony; // aspect ratio
 fixed_t fovtan; // field of view
@@ -55,24 +62,27 @@ fixed_t fovtan; // field of view
 // just for profiling purposes
 size_t framecount;
 
-size_t loopcount;
+// views are being drawn on more than one thread
+boolean viewsthreaded = false;
 
-fixed_t viewx, viewy, viewz;
-angle_t viewangle, aimingangle, viewroll;
-UINT8 viewssnum;
-fixed_t viewcos, viewsin;
-boolean skyVisible;
+ATTRTHREAD size_t loopcount;
+
+ATTRTHREAD fixed_t viewx, viewy, viewz;
+ATTRTHREAD angle_t viewangle, aimingangle, viewroll;
+ATTRTHREAD UINT8 viewssnum;
+ATTRTHREAD fixed_t viewcos, viewsin;
+ATTRTHREAD boolean skyVisible;
 boolean skyVisiblePerPlayer[MAXSPLITSCREENPLAYERS]; // saved values of skyVisible for each splitscreen player
-sector_t *viewsector;
-player_t *viewplayer;
+ATTRTHREAD sector_t *viewsector;
+ATTRTHREAD player_t *viewplayer;
 
 // PORTALS!
 // You can thank and/or curse JTE for these.
-UINT8 portalrender;
-sector_t *portalcullsector;
-portal_pair *portal_base, *portal_cap;
-line_t *portalclipline;
-INT32 portalclipstart, portalclipend;
+ATTRTHREAD UINT8 portalrender;
+ATTRTHREAD sector_t *portalcullsector;
+ATTRTHREAD portal_pair *portal_base, *portal_cap;
+ATTRTHREAD line_t *portalclipline;
+ATTRTHREAD INT32 portalclipstart, portalclipend;
 
 fixed_t rendertimefrac;
 fixed_t rendertimefrac_unpaused;
@@ -118,12 +128,18 @@ ps_metric_t ps_sw_spritecliptime = {0};
 ps_metric_t ps_sw_portaltime = {0};
 ps_metric_t ps_sw_planetime = {0};
 ps_metric_t ps_sw_maskedtime = {0};
+ps_metric_t ps_sw_spritesorttime = {0};
 
 ps_metric_t ps_numbspcalls = {0};
 ps_metric_t ps_numsprites = {0};
 ps_metric_t ps_numdrawnodes = {0};
 ps_metric_t ps_numpolyobjects = {0};
 
+ps_metric_t ps_sw_serialviewstime = {0};
+ps_metric_t ps_sw_threadedviewstime = {0};
+
+ATTRTHREAD viewstats_t viewstats;
+
 static CV_PossibleValue_t drawdist_cons_t[] = {
 	/*{256, "256"},*/	{512, "512"},	{768, "768"},
 	{1024, "1024"},	{1536, "1536"},	{2048, "2048"},
@@ -207,6 +223,15 @@ consvar_t cv_homremoval = {"homremoval", "Yes", CV_SAVE, homremoval_cons_t, NULL
 
 consvar_t cv_maxportals = {"maxportals", "2", CV_SAVE, maxportals_cons_t, NULL, 0, NULL, NULL, 0, 0, NULL};
 
+#ifdef HAVE_ATTRTHREAD
+// bumped when the view size changes, so the view threads know to drop
+// their sloped span buffers
+static UINT32 viewsizegen;
+
+// draw splitscreen views at the same time
+consvar_t cv_viewthreads = {"splitscreenthreads", "Off", CV_SAVE, CV_OnOff, NULL, 0, NULL, NULL, 0, 0, NULL};
+#endif
+
 void SplitScreen_OnChange(void)
 {
 	UINT8 i;
@@ -286,12 +311,9 @@ static void Precipstuff_OnChange(void)
 	thinker_t *next;
 	precipmobj_t *precipmobj;
 
-	for (think = thinkercap.next; think != &thinkercap; think = next)
+	for (think = thlist[THINK_PRECIP].cnext; think != &thlist[THINK_PRECIP]; think = next)
 	{
-		next = think->next;
-
-		if (think->function.acp1 != (actionf_p1)P_NullPrecipThinker)
-			continue; // not a precipmobj thinker
+		next = think->cnext;
 
 		precipmobj = (precipmobj_t *)think;
 		P_FreePrecipMobj(precipmobj);
@@ -999,6 +1021,9 @@ void R_ExecuteSetViewSize(void)
 
 	ds_su = ds_sv = ds_sz = NULL;
 	ds_sup = ds_svp = ds_szp = NULL;
+#ifdef HAVE_ATTRTHREAD
+	viewsizegen++; // and the view threads' own
+#endif
 
 	memset(scalelight, 0xFF, sizeof(scalelight));
 
@@ -1145,7 +1170,7 @@ subsector_t *R_IsPointInSubsector(fixed_t x, fixed_t y)
 // R_SetupFrame
 //
 
-mobj_t *viewmobj;
+ATTRTHREAD mobj_t *viewmobj;
 
 void R_SkyboxFrame(player_t *player)
 {
@@ -1382,7 +1407,12 @@ void R_SkyboxFrame(player_t *player)
 	R_InterpolateView(R_UsingFrameInterpolation() ? (demo.playback && demo.freecam) ? rendertimefrac_unpaused : rendertimefrac : FRACUNIT, false);
 }
 
-void R_SetupFrame(player_t *player, boolean skybox)
+//
+// R_SetupCamera
+// Picks the camera and view context for a player's view, and catches the
+// camera up with chasecam being toggled.
+//
+static camera_t *R_SetupCamera(player_t *player, boolean *chasecamp)
 {
 	camera_t *thiscam;
 	boolean chasecam = false;
@@ -1445,6 +1475,15 @@ void R_SetupFrame(player_t *player, boolean skybox)
 	else if (thiscam && !chasecam)
 		thiscam->chase = false;
 
+	*chasecamp = chasecam;
+	return thiscam;
+}
+
+void R_SetupFrame(player_t *player, boolean skybox)
+{
+	boolean chasecam;
+	camera_t *thiscam = R_SetupCamera(player, &chasecam);
+
 	newview->sky = !skybox;
 
 	if (player->awayviewtics) // cut-away view stuff
@@ -1646,12 +1685,12 @@ void R_AddPortal(INT32 line1, INT32 line2, INT32 x1, INT32 x2)
 // I mean, there is a win16lock() or something that lasts all the rendering,
 // so maybe we should release screen lock before each netupdate below..?
 
-void R_RenderPlayerView(player_t *player)
+//
+// R_DrawViewBackdrop
+// Covers up what a player's view doesn't draw over.
+//
+static void R_DrawViewBackdrop(player_t *player)
 {
-	portal_pair *portal;
-	const boolean skybox = (skyboxmo[0] && cv_skybox.value);
-	UINT8 i;
-
 	// if this is display player 1
 	if (cv_homremoval.value && player == &players[displayplayers[0]])
 	{
@@ -1674,6 +1713,42 @@ void R_RenderPlayerView(player_t *player)
 				V_DrawScaledPatch(x, y, V_NOSCALESTART, pat);
 		}
 	}
+}
+
+// Hands a view's stats over to perfstats, in place of the last view's
+// or, if add is set, on top of the other views of the same frame
+static void R_ReportViewStats(const viewstats_t *vs, boolean add)
+{
+	if (!add)
+	{
+		ps_skyboxtime.value.p = ps_bsptime.value.p = 0;
+		ps_sw_spritecliptime.value.p = ps_sw_portaltime.value.p = 0;
+		ps_sw_planetime.value.p = ps_sw_maskedtime.value.p = ps_sw_spritesorttime.value.p = 0;
+		ps_numbspcalls.value.i = ps_numsprites.value.i = 0;
+		ps_numdrawnodes.value.i = ps_numpolyobjects.value.i = 0;
+	}
+
+	ps_skyboxtime.value.p += vs->skyboxtime;
+	ps_bsptime.value.p += vs->bsptime;
+	ps_sw_spritecliptime.value.p += vs->spritecliptime;
+	ps_sw_portaltime.value.p += vs->portaltime;
+	ps_sw_planetime.value.p += vs->planetime;
+	ps_sw_maskedtime.value.p += vs->maskedtime;
+	ps_sw_spritesorttime.value.p += vs->spritesorttime;
+	ps_numbspcalls.value.i += vs->numbspcalls;
+	ps_numsprites.value.i += vs->numsprites;
+	ps_numdrawnodes.value.i += vs->numdrawnodes;
+	ps_numpolyobjects.value.i += vs->numpolyobjects;
+}
+
+void R_RenderPlayerView(player_t *player)
+{
+	portal_pair *portal;
+	const boolean skybox = (skyboxmo[0] && cv_skybox.value);
+	UINT8 i;
+
+	if (!viewsthreaded) // otherwise they were all drawn beforehand
+		R_DrawViewBackdrop(player);
 
 	// load previous saved value of skyVisible for the player
 	for (i = 0; i <= splitscreen; i++)
@@ -1687,8 +1762,10 @@ void R_RenderPlayerView(player_t *player)
 
 	portalrender = 0;
 	portal_base = portal_cap = NULL;
-	
-	PS_START_TIMING(ps_skyboxtime);
+
+	R_NewSpriteMarks();
+
+	viewstats.skyboxtime = I_GetPreciseTime();
 	if (skybox && skyVisible)
 	{
 		R_SkyboxFrame(player);
@@ -1709,12 +1786,13 @@ void R_RenderPlayerView(player_t *player)
 #endif
 		R_DrawMasked();
 	}
-	PS_STOP_TIMING(ps_skyboxtime);
+	viewstats.skyboxtime = I_GetPreciseTime() - viewstats.skyboxtime;
 
 	R_SetupFrame(player, skybox);
 	skyVisible = false;
-	framecount++;
-	validcount++;
+	if (!viewsthreaded)
+		framecount++;
+	R_NewSpriteMarks();
 
 	// Clear buffers.
 	R_ClearPlanes();
@@ -1740,19 +1818,19 @@ void R_RenderPlayerView(player_t *player)
 
 	// The head node is the last node output.
 
-	ps_numbspcalls.value.i = ps_numpolyobjects.value.i = ps_numdrawnodes.value.i = 0;
-	PS_START_TIMING(ps_bsptime);
+	viewstats.numbspcalls = viewstats.numpolyobjects = viewstats.numdrawnodes = 0;
+	viewstats.bsptime = I_GetPreciseTime();
 	R_RenderBSPNode((INT32)numnodes - 1);
-	PS_STOP_TIMING(ps_bsptime);
+	viewstats.bsptime = I_GetPreciseTime() - viewstats.bsptime;
 	R_AddPrecipitationSprites();
-	PS_START_TIMING(ps_sw_spritecliptime);
+	viewstats.spritecliptime = I_GetPreciseTime();
 	R_ClipSprites();
-	PS_STOP_TIMING(ps_sw_spritecliptime);
+	viewstats.spritecliptime = I_GetPreciseTime() - viewstats.spritecliptime;
 	
-	ps_numsprites.value.i = numvisiblesprites;
+	viewstats.numsprites = numvisiblesprites;
 
 	// PORTAL RENDERING
-	PS_START_TIMING(ps_sw_portaltime);
+	viewstats.portaltime = I_GetPreciseTime();
 	for(portal = portal_base; portal; portal = portal_base)
 	{
 		// render the portal
@@ -1765,7 +1843,7 @@ void R_RenderPlayerView(player_t *player)
 
 		R_PortalRestoreClipValues(portal->start, portal->end, portal->ceilingclip, portal->floorclip, portal->frontscale);
 
-		validcount++;
+		R_NewSpriteMarks();
 
 		R_RenderBSPNode((INT32)numnodes - 1);
 		R_ClipSprites();
@@ -1780,20 +1858,20 @@ void R_RenderPlayerView(player_t *player)
 		Z_Free(portal->frontscale);
 		Z_Free(portal);
 	}
-	PS_STOP_TIMING(ps_sw_portaltime);
+	viewstats.portaltime = I_GetPreciseTime() - viewstats.portaltime;
 	// END PORTAL RENDERING
 
-	PS_START_TIMING(ps_sw_planetime);
+	viewstats.planetime = I_GetPreciseTime();
 	R_DrawPlanes();
-	PS_STOP_TIMING(ps_sw_planetime);
+	viewstats.planetime = I_GetPreciseTime() - viewstats.planetime;
 #ifdef FLOORSPLATS
 	R_DrawVisibleFloorSplats();
 #endif
 	// draw mid texture and sprite
 	// And now 3D floors/sides!
-	PS_START_TIMING(ps_sw_maskedtime);
+	viewstats.maskedtime = I_GetPreciseTime();
 	R_DrawMasked();
-	PS_STOP_TIMING(ps_sw_maskedtime);
+	viewstats.maskedtime = I_GetPreciseTime() - viewstats.maskedtime;
 
 	// save value to skyVisiblePerPlayer
 	// this is so that P1 can't affect whether P2 can see a skybox or not, or vice versa
@@ -1805,8 +1883,219 @@ void R_RenderPlayerView(player_t *player)
 		skyVisiblePerPlayer[i] = skyVisible;
 		break;
 	}
+
+	if (!viewsthreaded) // otherwise R_RenderViewsThreaded adds them all up
+		R_ReportViewStats(&viewstats, false);
 }
 
+#ifdef HAVE_ATTRTHREAD
+// =========================================================================
+//                    SPLITSCREEN VIEW THREADS
+// =========================================================================
+
+// Splitscreen views after the first are each drawn by a worker thread,
+// while the main thread draws the first. All the per-view renderer state
+// is thread-local, so a worker only needs told where its view goes.
+
+typedef struct
+{
+	player_t *player;
+	INT32 windowx, windowy;
+	UINT8 **lookup;
+	void (*colfunc)(void);
+	void (*spanfunc)(void);
+	void (*wallcolfunc)(void);
+	viewstats_t stats; // the worker's, for R_RenderViewsThreaded to add up
+	boolean pending;
+} viewjob_t;
+
+static viewjob_t viewjobs[MAXSPLITSCREENPLAYERS];
+
+static I_mutex viewjob_mutex;
+static I_cond viewjob_cond; // a job is pending, or time to quit
+static I_cond viewdone_cond; // a job is done
+
+static UINT8 numviewworkers;
+static boolean viewworkers_quit;
+
+static void R_DrawViewJob(viewjob_t *job)
+{
+	viewssnum = (UINT8)(job - viewjobs);
+	viewwindowx = job->windowx;
+	viewwindowy = job->windowy;
+	M_Memcpy(ylookup, job->lookup, viewheight*sizeof (ylookup[0]));
+	topleft = screens[0] + viewwindowy*vid.width + viewwindowx;
+
+	colfunc = job->colfunc;
+	spanfunc = job->spanfunc;
+	wallcolfunc = job->wallcolfunc;
+
+	R_RenderPlayerView(job->player);
+}
+
+static void R_ViewWorker(void *userdata)
+{
+	viewjob_t *job = userdata;
+	UINT32 sizegen = viewsizegen;
+
+	// The thread-local state starts out as it was at load.
+	R_InitPlanes();
+	R_InitDrawNodes();
+
+	I_lock_mutex(&viewjob_mutex);
+	for (;;)
+	{
+		while (!job->pending && !viewworkers_quit)
+			I_hold_cond(&viewjob_cond, viewjob_mutex);
+
+		if (viewworkers_quit || I_thread_is_stopped())
+			break;
+
+		I_unlock_mutex(viewjob_mutex);
+
+		if (sizegen != viewsizegen)
+		{
+			if (ds_su)
+				Z_Free(ds_su);
+			if (ds_sv)
+				Z_Free(ds_sv);
+			if (ds_sz)
+				Z_Free(ds_sz);
+
+			ds_su = ds_sv = ds_sz = NULL;
+			ds_sup = ds_svp = ds_szp = NULL;
+			sizegen = viewsizegen;
+		}
+
+		R_DrawViewJob(job);
+		job->stats = viewstats;
+
+		I_lock_mutex(&viewjob_mutex);
+		job->pending = false;
+		I_wake_all_cond(&viewdone_cond);
+	}
+	I_unlock_mutex(viewjob_mutex);
+}
+
+static void R_StopViewWorkers(void)
+{
+	I_lock_mutex(&viewjob_mutex);
+	viewworkers_quit = true;
+	I_wake_all_cond(&viewjob_cond);
+	I_unlock_mutex(viewjob_mutex);
+}
+
+static void R_StartViewWorkers(UINT8 count)
+{
+	if (!numviewworkers)
+		I_AddExitFunc(R_StopViewWorkers); // before I_stop_threads waits on them
+
+	for (; numviewworkers < count; numviewworkers++)
+		I_spawn_thread("view-worker", R_ViewWorker, &viewjobs[numviewworkers + 1]);
+}
+
+static boolean R_ViewVisible(UINT8 i)
+{
+	return (players[displayplayers[i]].mo || players[displayplayers[i]].playerstate == PST_DEAD);
+}
+
+//
+// R_RenderViewsThreaded
+// Draws every splitscreen view at once in software mode. Returns false if
+// the views should be drawn one after another instead.
+//
+boolean R_RenderViewsThreaded(void)
+{
+	UINT8 **const lookups[MAXSPLITSCREENPLAYERS] = {ylookup1, ylookup2, ylookup3, ylookup4};
+	boolean chasecam;
+	UINT8 i, numviews = 0;
+
+	if (!cv_viewthreads.value || rendermode != render_soft || !splitscreen)
+		return false;
+
+	PS_START_TIMING(ps_sw_threadedviewstime);
+
+	R_StartViewWorkers(splitscreen);
+
+	// Anything drawing a view would change for the others gets done first.
+	for (i = 0; i <= splitscreen; i++)
+	{
+		if (!R_ViewVisible(i))
+			continue;
+
+		R_SetupCamera(&players[displayplayers[i]], &chasecam);
+		R_DrawViewBackdrop(&players[displayplayers[i]]);
+	}
+
+	R_PrepMovedFFloors();
+
+	if (cv_drawdist_precip.value && curWeather != PRECIP_BLANK && curWeather != PRECIP_STORM_NORAIN)
+		P_RunPrecipThinkers();
+
+	Z_SetLocking(true);
+	viewsthreaded = true;
+
+	I_lock_mutex(&viewjob_mutex);
+	for (i = 1; i <= splitscreen; i++)
+	{
+		viewjob_t *job = &viewjobs[i];
+
+		memset(&job->stats, 0, sizeof (job->stats));
+		if (!R_ViewVisible(i))
+			continue;
+
+		job->player = &players[displayplayers[i]];
+		job->windowx = (i & 1 && splitscreen > 1) ? viewwidth : 0;
+		job->windowy = (i > 1 || (i == 1 && splitscreen == 1)) ? viewheight : 0;
+		job->lookup = lookups[i];
+		job->colfunc = colfunc;
+		job->spanfunc = spanfunc;
+		job->wallcolfunc = wallcolfunc;
+		job->pending = true;
+		numviews++;
+	}
+	I_wake_all_cond(&viewjob_cond);
+	I_unlock_mutex(viewjob_mutex);
+
+	memset(&viewstats, 0, sizeof (viewstats));
+	if (R_ViewVisible(0))
+	{
+		viewssnum = 0;
+		viewwindowx = viewwindowy = 0;
+		topleft = screens[0];
+		objectsdrawn = 0;
+
+		R_RenderPlayerView(&players[displayplayers[0]]);
+		numviews++;
+	}
+
+	I_lock_mutex(&viewjob_mutex);
+	for (i = 1; i <= splitscreen; i++)
+	{
+		while (viewjobs[i].pending)
+			I_hold_cond(&viewdone_cond, viewjob_mutex);
+	}
+	I_unlock_mutex(viewjob_mutex);
+
+	viewsthreaded = false;
+	Z_SetLocking(false);
+
+	R_ReportViewStats(&viewstats, false);
+	for (i = 1; i <= splitscreen; i++)
+		R_ReportViewStats(&viewjobs[i].stats, true);
+
+	framecount += numviews;
+
+	PS_STOP_TIMING(ps_sw_threadedviewstime);
+	return true;
+}
+#else
+boolean R_RenderViewsThreaded(void)
+{
+	return false;
+}
+#endif
+
 // =========================================================================
 //                    ENGINE COMMANDS & VARS
 // =========================================================================
@@ -1834,6 +2123,8 @@ void R_RegisterEngineStuff(void)
 	CV_RegisterVar(&cv_mobjscaleprecip);
 	CV_RegisterVar(&cv_fov);
 
+	COM_AddCommand("drawerbench", Command_DrawerBench_f);
+
 	CV_RegisterVar(&cv_chasecam);
 	CV_RegisterVar(&cv_chasecam2);
 	CV_RegisterVar(&cv_chasecam3);
@@ -1892,6 +2183,9 @@ void R_RegisterEngineStuff(void)
 	CV_RegisterVar(&cv_uncappedhud);
 
 	CV_RegisterVar(&cv_maxportals);
+#ifdef HAVE_ATTRTHREAD
+	CV_RegisterVar(&cv_viewthreads);
+#endif
 
 	CV_RegisterVar(&cv_grmaxinterpdist);
 
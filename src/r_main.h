@@ -21,15 +21,19 @@
 //
 // POV related.
 //
-extern fixed_t viewcos, viewsin;
+extern ATTRTHREAD fixed_t viewcos, viewsin;
 extern INT32 viewheight;
-extern INT32 centerx, centery;
+extern INT32 centerx;
+extern ATTRTHREAD INT32 centery;
 
-extern fixed_t centerxfrac, centeryfrac;
+extern fixed_t centerxfrac;
+extern ATTRTHREAD fixed_t centeryfrac;
 extern fixed_t projection, projectiony;
 extern fixed_t fovtan; // field of view
 
-extern size_t validcount, linecount, loopcount, framecount;
+extern size_t validcount, linecount, framecount;
+extern ATTRTHREAD size_t loopcount;
+extern boolean viewsthreaded;
 
 // The fraction of a tic being drawn (for interpolation between two tics)
 extern fixed_t rendertimefrac;
@@ -40,7 +44,7 @@ extern fixed_t renderdeltatics;
 // The current render is a new logical tic
 extern boolean renderisnewtic;
 
-extern mobj_t *viewmobj;
+extern ATTRTHREAD mobj_t *viewmobj;
 
 //
 // Lighting LUT.
@@ -138,12 +142,27 @@ extern ps_metric_t ps_sw_spritecliptime;
 extern ps_metric_t ps_sw_portaltime;
 extern ps_metric_t ps_sw_planetime;
 extern ps_metric_t ps_sw_maskedtime;
+extern ps_metric_t ps_sw_spritesorttime;
 
 extern ps_metric_t ps_numbspcalls;
 extern ps_metric_t ps_numsprites;
 extern ps_metric_t ps_numdrawnodes;
 extern ps_metric_t ps_numpolyobjects;
 
+extern ps_metric_t ps_sw_serialviewstime;
+extern ps_metric_t ps_sw_threadedviewstime;
+
+// What drawing one software view adds up to for the stats above. Each
+// thread counts in its own, so threaded views can't lose each other's counts.
+typedef struct
+{
+	precise_t skyboxtime, bsptime, spritecliptime, portaltime;
+	precise_t planetime, maskedtime, spritesorttime;
+	INT32 numbspcalls, numsprites, numdrawnodes, numpolyobjects;
+} viewstats_t;
+
+extern ATTRTHREAD viewstats_t viewstats;
+
 //
 // REFRESH - the actual rendering functions.
 //
@@ -161,6 +180,9 @@ extern consvar_t cv_skybox;
 extern consvar_t cv_tailspickup;
 extern consvar_t cv_grmaxinterpdist;
 extern consvar_t cv_ripplewater;
+#ifdef HAVE_ATTRTHREAD
+extern consvar_t cv_viewthreads;
+#endif
 
 // Called by startup code.
 void R_Init(void);
@@ -181,6 +203,7 @@ void R_SkyboxFrame(player_t *player);
 void R_SetupFrame(player_t *player, boolean skybox);
 // Called by G_Drawer.
 void R_RenderPlayerView(player_t *player);
+boolean R_RenderViewsThreaded(void);
 
 // add commands related to engine, at game startup
 void R_RegisterEngineStuff(void);
@@ -813,6 +813,9 @@ patch_t *Patch_GetRotatedSprite(spriteframe_t *sprite, size_t frame, size_t spri
 	if (rotationangle < 1 || rotationangle >= ROTANGLES)
 		return NULL;
 
+	// Rotations are built in one shared buffer
+	Z_Lock();
+
 	rotsprite = sprite->rotated[type][spriteangle];
 
 	if (rotsprite == NULL)
@@ -831,9 +834,13 @@ patch_t *Patch_GetRotatedSprite(spriteframe_t *sprite, size_t frame, size_t spri
 		lumpnum_t lump = sprite->lumppat[spriteangle];
 
 		if (lump == LUMPERROR)
+		{
+			Z_Unlock();
 			return NULL;
+		}
 
-		patch = (patch_t *)W_CacheLumpNum(lump, PU_STATIC);
+		// Take a private copy, other views may be drawing the cached one
+		patch = (patch_t *)W_CacheLumpNumForce(lump, PU_STATIC);
 
 		if (sprinfo->available)
 		{
@@ -856,6 +863,7 @@ patch_t *Patch_GetRotatedSprite(spriteframe_t *sprite, size_t frame, size_t spri
 		Z_Free(patch);
 	}
 
+	Z_Unlock();
 	return rotsprite->patches[idx];
 }
 
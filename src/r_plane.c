@@ -45,44 +45,48 @@
 // the last visplane list is outside of the hash table and is used for fof planes
 #define MAXVISPLANES ((1<<VISPLANEHASHBITS)+1)
 
-static visplane_t *visplanes[MAXVISPLANES];
-static visplane_t *freetail;
-static visplane_t **freehead = &freetail;
+static ATTRTHREAD visplane_t *visplanes[MAXVISPLANES];
+static ATTRTHREAD visplane_t *freetail;
+static ATTRTHREAD visplane_t **freehead; // &freetail, set by R_InitPlanes
 
-visplane_t *floorplane;
-visplane_t *ceilingplane;
-static visplane_t *currentplane;
+ATTRTHREAD visplane_t *floorplane;
+ATTRTHREAD visplane_t *ceilingplane;
+static ATTRTHREAD visplane_t *currentplane;
 
-visffloor_t ffloor[MAXFFLOORS];
-INT32 numffloors;
+ATTRTHREAD visffloor_t ffloor[MAXFFLOORS];
+ATTRTHREAD INT32 numffloors;
+
+// Polyobject planes waiting for R_CreateDrawNodes, by polyobject number
+static ATTRTHREAD visplane_t **polyplanes;
+static ATTRTHREAD size_t numpolyplanes;
 
 //SoM: 3/23/2000: Boom visplane hashing routine.
 #define visplane_hash(picnum,lightlevel,height) \
   ((unsigned)((picnum)*3+(lightlevel)+(height)*7) & VISPLANEHASHMASK)
 
 //SoM: 3/23/2000: Use boom opening limit removal
-size_t maxopenings;
-INT16 *openings, *lastopening; /// \todo free leak
+ATTRTHREAD size_t maxopenings;
+ATTRTHREAD INT16 *openings, *lastopening; /// \todo free leak
 
 //
 // Clip values are the solid pixel bounding the range.
 //  floorclip starts out SCREENHEIGHT
 //  ceilingclip starts out -1
 //
-INT16 floorclip[MAXVIDWIDTH], ceilingclip[MAXVIDWIDTH];
-fixed_t frontscale[MAXVIDWIDTH];
+ATTRTHREAD INT16 floorclip[MAXVIDWIDTH], ceilingclip[MAXVIDWIDTH];
+ATTRTHREAD fixed_t frontscale[MAXVIDWIDTH];
 
 //
 // spanstart holds the start of a plane span
 // initialized to 0 at start
 //
-static INT32 spanstart[MAXVIDHEIGHT];
+static ATTRTHREAD INT32 spanstart[MAXVIDHEIGHT];
 
 //
 // texture mapping
 //
-lighttable_t **planezlight;
-static fixed_t planeheight;
+ATTRTHREAD lighttable_t **planezlight;
+static ATTRTHREAD fixed_t planeheight;
 
 //added : 10-02-98: yslopetab is what yslope used to be,
 //                yslope points somewhere into yslopetab,
@@ -92,24 +96,24 @@ static fixed_t planeheight;
 //                (when mouselookin', yslope is moving into yslopetab)
 //                Check R_SetupFrame, R_SetViewSize for more...
 fixed_t yslopetab[MAXVIDHEIGHT*16];
-fixed_t *yslope;
+ATTRTHREAD fixed_t *yslope;
 
-fixed_t basexscale, baseyscale;
+ATTRTHREAD fixed_t basexscale, baseyscale;
 
-fixed_t cachedheight[MAXVIDHEIGHT];
-fixed_t cacheddistance[MAXVIDHEIGHT];
-fixed_t cachedxstep[MAXVIDHEIGHT];
-fixed_t cachedystep[MAXVIDHEIGHT];
+ATTRTHREAD fixed_t cachedheight[MAXVIDHEIGHT];
+ATTRTHREAD fixed_t cacheddistance[MAXVIDHEIGHT];
+ATTRTHREAD fixed_t cachedxstep[MAXVIDHEIGHT];
+ATTRTHREAD fixed_t cachedystep[MAXVIDHEIGHT];
 
-static fixed_t xoffs, yoffs;
+static ATTRTHREAD fixed_t xoffs, yoffs;
 
 //
 // R_InitPlanes
-// Only at game startup.
+// At game startup, and on each thread that draws views.
 //
 void R_InitPlanes(void)
 {
-	// FIXME: unused
+	freehead = &freetail;
 }
 
 // R_PortalStoreClipValues
@@ -163,8 +167,8 @@ void R_PortalRestoreClipValues(INT32 start, INT32 end, INT16 *ceil, INT16 *floor
 //
 
 #ifndef NOWATER
-INT32 ds_bgofs;
-INT32 ds_waterofs;
+ATTRTHREAD INT32 ds_bgofs;
+ATTRTHREAD INT32 ds_waterofs;
 
 struct
 {
@@ -342,6 +346,9 @@ void R_ClearPlanes(void)
 
 	lastopening = openings;
 
+	if (numpolyplanes)
+		memset(polyplanes, 0, numpolyplanes * sizeof (*polyplanes));
+
 	// texture calculation
 	memset(cachedheight, 0, sizeof (cachedheight));
 
@@ -353,6 +360,28 @@ void R_ClearPlanes(void)
 	baseyscale = -FixedDiv (FINESINE(angle),centerxfrac);
 }
 
+//
+// R_PolyobjPlane
+// Where a polyobject's plane is kept until its front seg is drawn.
+// This is per view, so it doesn't live in polyobj_t.
+//
+visplane_t **R_PolyobjPlane(polyobj_t *po)
+{
+	size_t num = (size_t)(po - PolyObjects);
+
+	if (num >= numpolyplanes)
+	{
+		size_t newnum = max(num + 1, (size_t)numPolyObjects);
+		polyplanes = realloc(polyplanes, newnum * sizeof (*polyplanes));
+		if (!polyplanes)
+			I_Error("R_PolyobjPlane: Out of memory");
+		memset(polyplanes + numpolyplanes, 0, (newnum - numpolyplanes) * sizeof (*polyplanes));
+		numpolyplanes = newnum;
+	}
+
+	return &polyplanes[num];
+}
+
 static visplane_t *new_visplane(unsigned hash)
 {
 	visplane_t *check = freetail;
@@ -1158,7 +1187,7 @@ a 'smoothing' of the texture while
 using the palette colors.
 */
 #ifdef QUINCUNX
-	if (spanfunc == R_DrawSpan_8)
+	if (spanfunc == basespanfunc)
 	{
 		INT32 i;
 		ds_transmap = transtables + ((tr_trans50-1)<<FF_TRANSSHIFT);
@@ -56,23 +56,24 @@ typedef struct visplane_s
 	boolean noencore;
 } visplane_t;
 
-extern visplane_t *floorplane;
-extern visplane_t *ceilingplane;
+extern ATTRTHREAD visplane_t *floorplane;
+extern ATTRTHREAD visplane_t *ceilingplane;
 
 // Visplane related.
-extern INT16 *lastopening, *openings;
-extern size_t maxopenings;
+extern ATTRTHREAD INT16 *lastopening, *openings;
+extern ATTRTHREAD size_t maxopenings;
 
-extern INT16 floorclip[MAXVIDWIDTH], ceilingclip[MAXVIDWIDTH];
-extern fixed_t frontscale[MAXVIDWIDTH], yslopetab[MAXVIDHEIGHT*16];
-extern fixed_t cachedheight[MAXVIDHEIGHT];
-extern fixed_t cacheddistance[MAXVIDHEIGHT];
-extern fixed_t cachedxstep[MAXVIDHEIGHT];
-extern fixed_t cachedystep[MAXVIDHEIGHT];
-extern fixed_t basexscale, baseyscale;
+extern ATTRTHREAD INT16 floorclip[MAXVIDWIDTH], ceilingclip[MAXVIDWIDTH];
+extern ATTRTHREAD fixed_t frontscale[MAXVIDWIDTH];
+extern fixed_t yslopetab[MAXVIDHEIGHT*16];
+extern ATTRTHREAD fixed_t cachedheight[MAXVIDHEIGHT];
+extern ATTRTHREAD fixed_t cacheddistance[MAXVIDHEIGHT];
+extern ATTRTHREAD fixed_t cachedxstep[MAXVIDHEIGHT];
+extern ATTRTHREAD fixed_t cachedystep[MAXVIDHEIGHT];
+extern ATTRTHREAD fixed_t basexscale, baseyscale;
 
-extern fixed_t *yslope;
-extern lighttable_t **planezlight;
+extern ATTRTHREAD fixed_t *yslope;
+extern ATTRTHREAD lighttable_t **planezlight;
 
 void R_InitPlanes(void);
 void R_PortalStoreClipValues(INT32 start, INT32 end, INT16 *ceil, INT16 *floor, fixed_t *scale);
@@ -91,6 +92,7 @@ visplane_t *R_FindPlane(fixed_t height, INT32 picnum, INT32 lightlevel, fixed_t
 visplane_t *R_CheckPlane(visplane_t *pl, INT32 start, INT32 stop);
 void R_ExpandPlane(visplane_t *pl, INT32 start, INT32 stop);
 void R_PlaneBounds(visplane_t *plane);
+visplane_t **R_PolyobjPlane(polyobj_t *po);
 
 // Draws a single visplane.
 void R_DrawSinglePlane(visplane_t *pl);
@@ -116,6 +118,6 @@ typedef struct planemgr_s
 	polyobj_t *polyobj;
 } visffloor_t;
 
-extern visffloor_t ffloor[MAXFFLOORS];
-extern INT32 numffloors;
+extern ATTRTHREAD visffloor_t ffloor[MAXFFLOORS];
+extern ATTRTHREAD INT32 numffloors;
 #endif
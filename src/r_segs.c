@@ -28,56 +28,56 @@
 // OPTIMIZE: closed two sided lines as single sided
 
 // True if any of the segs textures might be visible.
-static boolean segtextured;
-static boolean markfloor; // False if the back side is the same plane.
-static boolean markceiling;
+static ATTRTHREAD boolean segtextured;
+static ATTRTHREAD boolean markfloor; // False if the back side is the same plane.
+static ATTRTHREAD boolean markceiling;
 
-static boolean maskedtexture;
-static INT32 toptexture, bottomtexture, midtexture;
-static INT32 numthicksides, numbackffloors;
+static ATTRTHREAD boolean maskedtexture;
+static ATTRTHREAD INT32 toptexture, bottomtexture, midtexture;
+static ATTRTHREAD INT32 numthicksides, numbackffloors;
 
-angle_t rw_normalangle;
+ATTRTHREAD angle_t rw_normalangle;
 // angle to line origin
-angle_t rw_angle1;
-fixed_t rw_distance;
+ATTRTHREAD angle_t rw_angle1;
+ATTRTHREAD fixed_t rw_distance;
 
 //
 // regular wall
 //
-static INT32 rw_x, rw_stopx;
-static angle_t rw_centerangle;
-static fixed_t rw_offset;
-static fixed_t rw_offset2; // for splats
-static fixed_t rw_scale, rw_scalestep;
-static fixed_t rw_midtexturemid, rw_toptexturemid, rw_bottomtexturemid;
-static INT32 worldtop, worldbottom, worldhigh, worldlow;
-static INT32 worldtopslope, worldbottomslope, worldhighslope, worldlowslope; // worldtop/bottom at end of slope
-static fixed_t rw_toptextureslide, rw_midtextureslide, rw_bottomtextureslide; // Defines how to adjust Y offsets along the wall for slopes
-static fixed_t rw_midtextureback, rw_midtexturebackslide; // Values for masked midtexture height calculation
+static ATTRTHREAD INT32 rw_x, rw_stopx;
+static ATTRTHREAD angle_t rw_centerangle;
+static ATTRTHREAD fixed_t rw_offset;
+static ATTRTHREAD fixed_t rw_offset2; // for splats
+static ATTRTHREAD fixed_t rw_scale, rw_scalestep;
+static ATTRTHREAD fixed_t rw_midtexturemid, rw_toptexturemid, rw_bottomtexturemid;
+static ATTRTHREAD INT32 worldtop, worldbottom, worldhigh, worldlow;
+static ATTRTHREAD INT32 worldtopslope, worldbottomslope, worldhighslope, worldlowslope; // worldtop/bottom at end of slope
+static ATTRTHREAD fixed_t rw_toptextureslide, rw_midtextureslide, rw_bottomtextureslide; // Defines how to adjust Y offsets along the wall for slopes
+static ATTRTHREAD fixed_t rw_midtextureback, rw_midtexturebackslide; // Values for masked midtexture height calculation
 
 // Lactozilla: 3D floor clipping
-static boolean rw_floormarked = false;
-static boolean rw_ceilingmarked = false;
+static ATTRTHREAD boolean rw_floormarked = false;
+static ATTRTHREAD boolean rw_ceilingmarked = false;
 
-static INT32 *rw_silhouette = NULL;
-static fixed_t *rw_tsilheight = NULL;
-static fixed_t *rw_bsilheight = NULL;
+static ATTRTHREAD INT32 *rw_silhouette = NULL;
+static ATTRTHREAD fixed_t *rw_tsilheight = NULL;
+static ATTRTHREAD fixed_t *rw_bsilheight = NULL;
 
-static fixed_t pixhigh, pixlow, pixhighstep, pixlowstep;
-static fixed_t topfrac, topstep;
-static fixed_t bottomfrac, bottomstep;
+static ATTRTHREAD fixed_t pixhigh, pixlow, pixhighstep, pixlowstep;
+static ATTRTHREAD fixed_t topfrac, topstep;
+static ATTRTHREAD fixed_t bottomfrac, bottomstep;
 
-static lighttable_t **walllights;
-static INT16 *maskedtexturecol;
-static fixed_t *maskedtextureheight = NULL;
+static ATTRTHREAD lighttable_t **walllights;
+static ATTRTHREAD INT16 *maskedtexturecol;
+static ATTRTHREAD fixed_t *maskedtextureheight = NULL;
 
 // ==========================================================================
 // R_Splats Wall Splats Drawer
 // ==========================================================================
 
 #ifdef WALLSPLATS
-static INT16 last_ceilingclip[MAXVIDWIDTH];
-static INT16 last_floorclip[MAXVIDWIDTH];
+static ATTRTHREAD INT16 last_ceilingclip[MAXVIDWIDTH];
+static ATTRTHREAD INT16 last_floorclip[MAXVIDWIDTH];
 
 static void R_DrawSplatColumn(column_t *column)
 {
@@ -246,7 +246,7 @@ static void R_DrawWallSplats(void)
 //  way we don't have to store extra post_t info with each column for
 //  multi-patch textures. They are not normally needed as multi-patch
 //  textures don't have holes in it. At least not for now.
-static INT32 column2s_length; // column->length : for multi-patch on 2sided wall = texture->height
+static ATTRTHREAD INT32 column2s_length; // column->length : for multi-patch on 2sided wall = texture->height
 
 static void R_Render2sidedMultiPatchColumn(column_t *column)
 {
@@ -1633,7 +1633,7 @@ void R_StoreWallRange(INT32 start, INT32 stop)
 	INT32 range;
 	vertex_t segleft, segright;
 	fixed_t ceilingfrontslide, floorfrontslide, ceilingbackslide, floorbackslide;
-	static size_t maxdrawsegs = 0;
+	static ATTRTHREAD size_t maxdrawsegs = 0;
 
 	maskedtextureheight = NULL;
 	//initialize segleft and segright
@@ -87,17 +87,18 @@ extern side_t *sides;
 //
 // POV data.
 //
-extern fixed_t viewx, viewy, viewz;
-extern angle_t viewangle, aimingangle, viewroll;
-extern UINT8 viewssnum; // splitscreen view number
-extern boolean viewsky, skyVisible;
+extern ATTRTHREAD fixed_t viewx, viewy, viewz;
+extern ATTRTHREAD angle_t viewangle, aimingangle, viewroll;
+extern ATTRTHREAD UINT8 viewssnum; // splitscreen view number
+extern boolean viewsky;
+extern ATTRTHREAD boolean skyVisible;
 extern boolean skyVisiblePerPlayer[MAXSPLITSCREENPLAYERS]; // saved values of skyVisible of each splitscreen player
-extern sector_t *viewsector;
-extern player_t *viewplayer;
-extern UINT8 portalrender;
-extern sector_t *portalcullsector;
-extern line_t *portalclipline;
-extern INT32 portalclipstart, portalclipend;
+extern ATTRTHREAD sector_t *viewsector;
+extern ATTRTHREAD player_t *viewplayer;
+extern ATTRTHREAD UINT8 portalrender;
+extern ATTRTHREAD sector_t *portalcullsector;
+extern ATTRTHREAD line_t *portalclipline;
+extern ATTRTHREAD INT32 portalclipstart, portalclipend;
 
 extern consvar_t cv_allowmlook;
 extern consvar_t cv_maxportals;
@@ -110,10 +111,10 @@ extern angle_t doubleclipangle;
 extern INT32 viewangletox[FINEANGLES/2];
 extern angle_t xtoviewangle[MAXVIDWIDTH+1];
 
-extern fixed_t rw_distance;
-extern angle_t rw_normalangle;
+extern ATTRTHREAD fixed_t rw_distance;
+extern ATTRTHREAD angle_t rw_normalangle;
 
 // angle to line origin
-extern angle_t rw_angle1;
+extern ATTRTHREAD angle_t rw_angle1;
 
 #endif
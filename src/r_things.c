@@ -60,7 +60,7 @@ typedef struct
 //  which increases counter clockwise (protractor).
 // There was a lot of stuff grabbed wrong, so I changed it...
 //
-static lighttable_t **spritelights;
+static ATTRTHREAD lighttable_t **spritelights;
 
 // constant arrays used for psprite clipping and initializing clipping
 INT16 negonearray[MAXVIDWIDTH];
@@ -101,11 +101,11 @@ typedef struct drawsegs_xrange_s
 } drawsegs_xrange_t;
 
 #define DS_RANGES_COUNT 3
-static drawsegs_xrange_t drawsegs_xranges[DS_RANGES_COUNT];
+static ATTRTHREAD drawsegs_xrange_t drawsegs_xranges[DS_RANGES_COUNT];
 
-static drawseg_xrange_item_t *drawsegs_xrange;
-static size_t drawsegs_xrange_size = 0;
-static INT32 drawsegs_xrange_count = 0;
+static ATTRTHREAD drawseg_xrange_item_t *drawsegs_xrange;
+static ATTRTHREAD size_t drawsegs_xrange_size = 0;
+static ATTRTHREAD INT32 drawsegs_xrange_count = 0;
 
 // ==========================================================================
 //
@@ -503,10 +503,15 @@ void R_AddSpriteDefs(UINT16 wadnum)
 //
 // GAME FUNCTIONS
 //
-UINT32 visspritecount, numvisiblesprites;
+ATTRTHREAD UINT32 visspritecount, numvisiblesprites;
 
-static UINT32 clippedvissprites;
-static vissprite_t *visspritechunks[MAXVISSPRITES >> VISSPRITECHUNKBITS] = {NULL};
+static ATTRTHREAD UINT32 clippedvissprites;
+static ATTRTHREAD vissprite_t *visspritechunks[MAXVISSPRITES >> VISSPRITECHUNKBITS] = {NULL};
+
+// Which sectors have had their sprites added, per view. Views can be drawn
+// at the same time, so this can't use sector_t's validcount.
+static size_t *spritemarks[MAXSPLITSCREENPLAYERS];
+static size_t spritemarkcount[MAXSPLITSCREENPLAYERS];
 
 
 //
@@ -573,10 +578,23 @@ void R_ClearSprites(void)
 	visspritecount = numvisiblesprites = clippedvissprites = 0;
 }
 
+//
+// R_NewSpriteMarks
+// Called before each pass over the BSP,
+// so that every sector gets its sprites added again.
+//
+void R_NewSpriteMarks(void)
+{
+	if (!spritemarks[viewssnum])
+		Z_Calloc(numsectors * sizeof (*spritemarks[viewssnum]), PU_LEVEL, &spritemarks[viewssnum]);
+
+	spritemarkcount[viewssnum]++;
+}
+
 //
 // R_NewVisSprite
 //
-static vissprite_t overflowsprite;
+static ATTRTHREAD vissprite_t overflowsprite;
 
 static vissprite_t *R_GetVisSprite(UINT32 num)
 {
@@ -603,11 +621,11 @@ static vissprite_t *R_NewVisSprite(void)
 // Masked means: partly transparent, i.e. stored
 //  in posts/runs of opaque pixels.
 //
-INT16 *mfloorclip;
-INT16 *mceilingclip;
+ATTRTHREAD INT16 *mfloorclip;
+ATTRTHREAD INT16 *mceilingclip;
 
-fixed_t spryscale = 0, sprtopscreen = 0, sprbotscreen = 0;
-fixed_t windowtop = 0, windowbottom = 0;
+ATTRTHREAD fixed_t spryscale = 0, sprtopscreen = 0, sprbotscreen = 0;
+ATTRTHREAD fixed_t windowtop = 0, windowbottom = 0;
 
 void R_DrawMaskedColumn(column_t *column)
 {
@@ -676,7 +694,7 @@ void R_DrawMaskedColumn(column_t *column)
 	dc_texturemid = basetexturemid;
 }
 
-INT32 lengthcol; // column->length : for flipped column function pointers and multi-patch on 2sided wall = texture->height
+ATTRTHREAD INT32 lengthcol; // column->length : for flipped column function pointers and multi-patch on 2sided wall = texture->height
 
 static void R_DrawFlippedMaskedColumn(column_t *column)
 {
@@ -2178,11 +2196,11 @@ void R_AddSprites(sector_t *sec, INT32 lightlevel)
 	// A sector might have been split into several
 	// subsectors during BSP building.
 	// Thus we check whether its already added.
-	if (sec->validcount == validcount)
+	if (spritemarks[viewssnum][sec - sectors] == spritemarkcount[viewssnum])
 		return;
 
 	// Well, now it will be done.
-	sec->validcount = validcount;
+	spritemarks[viewssnum][sec - sectors] = spritemarkcount[viewssnum];
 
 	if (!sec->numlights)
 	{
@@ -2254,81 +2272,84 @@ void R_AddPrecipitationSprites(void)
 //
 // R_SortVisSprites
 //
-static vissprite_t vsprsortedhead;
+static ATTRTHREAD vissprite_t vsprsortedhead;
+
+// scratch space for the merge sort, one pass reads from one and writes to the other
+static ATTRTHREAD vissprite_t *vsprsortbuf[2][MAXVISSPRITES];
+
+// Draw order: smaller sortscale first, then smaller dispoffset.
+FUNCINLINE static ATTRINLINE boolean R_VisSpriteBefore(const vissprite_t *a, const vissprite_t *b)
+{
+	if (a->sortscale != b->sortscale)
+		return (a->sortscale < b->sortscale);
+	return (a->dispoffset < b->dispoffset);
+}
 
 void R_SortVisSprites(void)
 {
-	UINT32       i;
-	vissprite_t *ds, *dsprev, *dsnext, *dsfirst;
-	vissprite_t *best = NULL;
-	vissprite_t  unsorted;
-	fixed_t      bestscale;
-	INT32        bestdispoffset;
+	UINT32       i, count, width;
+	vissprite_t **src, **dest, **swap;
+	vissprite_t *ds;
+
+	vsprsortedhead.next = vsprsortedhead.prev = &vsprsortedhead;
 
 	if (!visspritecount)
 		return;
 
-	unsorted.next = unsorted.prev = &unsorted;
+	viewstats.spritesorttime = I_GetPreciseTime();
 
-	dsfirst = R_GetVisSprite(0);
-
-	// The first's prev and last's next will be set to
-	// nonsense, but are fixed in a moment
-	for (i = 0, dsnext = dsfirst, ds = NULL; i < visspritecount; i++)
+	// Gather the sprites that survived clipping, in the order they were made
+	src = vsprsortbuf[0];
+	dest = vsprsortbuf[1];
+	for (i = count = 0; i < visspritecount; i++)
 	{
-		dsprev = ds;
-		ds = dsnext;
-		if (i < visspritecount - 1) dsnext = R_GetVisSprite(i + 1);
-
-		ds->next = dsnext;
-		ds->prev = dsprev;
+		ds = R_GetVisSprite(i);
+		if (ds->cut & SC_NOTVISIBLE)
+			continue;
+		src[count++] = ds;
 	}
 
-	// Fix first and last. ds still points to the last one after the loop
-	dsfirst->prev = &unsorted;
-	unsorted.next = dsfirst;
-	if (ds)
-		ds->next = &unsorted;
-	unsorted.prev = ds;
-
-	// pull the vissprites out by scale
-	vsprsortedhead.next = vsprsortedhead.prev = &vsprsortedhead;
-	for (i = 0; i < visspritecount; i++)
+	// Bottom-up merge sort. Ties keep their original order,
+	// which is what the old selection sort produced too.
+	for (width = 1; width < count; width <<= 1)
 	{
-		bestscale = bestdispoffset = INT32_MAX;
-		for (ds = unsorted.next; ds != &unsorted; ds = ds->next)
+		UINT32 lo;
+
+		for (lo = 0; lo < count; lo += width << 1)
 		{
-			// Remove this sprite if it was determined to not be visible
-			if (ds->cut & SC_NOTVISIBLE)
-			{
-				ds->next->prev = ds->prev;
-				ds->prev->next = ds->next;
-				continue;
-			}
+			UINT32 mid = min(lo + width, count);
+			UINT32 hi = min(lo + (width << 1), count);
+			UINT32 a = lo, b = mid, out = lo;
 
-			if (ds->sortscale < bestscale)
+			while (a < mid && b < hi)
 			{
-				bestscale = ds->sortscale;
-				bestdispoffset = ds->dispoffset;
-				best = ds;
-			}
-			// order visprites of same scale by dispoffset, smallest first
-			else if (ds->sortscale == bestscale && ds->dispoffset < bestdispoffset)
-			{
-				bestdispoffset = ds->dispoffset;
-				best = ds;
+				if (R_VisSpriteBefore(src[b], src[a]))
+					dest[out++] = src[b++];
+				else
+					dest[out++] = src[a++];
 			}
+			while (a < mid)
+				dest[out++] = src[a++];
+			while (b < hi)
+				dest[out++] = src[b++];
 		}
-		if (best)
-		{
-			best->next->prev = best->prev;
-			best->prev->next = best->next;
-			best->next = &vsprsortedhead;
-			best->prev = vsprsortedhead.prev;
-			vsprsortedhead.prev->next = best;
-			vsprsortedhead.prev = best;
-		}
+
+		swap = src;
+		src = dest;
+		dest = swap;
+	}
+
+	// Link them up in draw order
+	for (i = 0; i < count; i++)
+	{
+		ds = src[i];
+		ds->next = &vsprsortedhead;
+		ds->prev = vsprsortedhead.prev;
+		vsprsortedhead.prev->next = ds;
+		vsprsortedhead.prev = ds;
 	}
+
+	viewstats.spritesorttime = I_GetPreciseTime() - viewstats.spritesorttime;
 }
 
 //
@@ -2336,8 +2357,8 @@ void R_SortVisSprites(void)
 // Creates and sorts a list of drawnodes for the scene being rendered.
 static drawnode_t *R_CreateDrawNode(drawnode_t *link);
 
-static drawnode_t nodebankhead;
-static drawnode_t nodehead;
+static ATTRTHREAD drawnode_t nodebankhead;
+static ATTRTHREAD drawnode_t nodehead;
 
 static void R_CreateDrawNodes(void)
 {
@@ -2347,7 +2368,7 @@ static void R_CreateDrawNodes(void)
 	fixed_t bestdelta, delta;
 	vissprite_t *rover;
 	drawnode_t *r2;
-	visplane_t *plane;
+	visplane_t *plane, **polyplane;
 	INT32 sintersect;
 	fixed_t scale = 0;
 
@@ -2364,9 +2385,10 @@ static void R_CreateDrawNodes(void)
 			}
 		}
 		// Check for a polyobject plane, but only if this is a front line
-		if (ds->curline->polyseg && ds->curline->polyseg->visplane && !ds->curline->side)
+		polyplane = ds->curline->polyseg ? R_PolyobjPlane(ds->curline->polyseg) : NULL;
+		if (polyplane && *polyplane && !ds->curline->side)
 		{
-			plane = ds->curline->polyseg->visplane;
+			plane = *polyplane;
 			R_PlaneBounds(plane);
 
 			if (plane->low < 0 || plane->high > vid.height || plane->high > plane->low)
@@ -2378,7 +2400,7 @@ static void R_CreateDrawNodes(void)
 				entry->plane = plane;
 				entry->seg = ds;
 			}
-			ds->curline->polyseg->visplane = NULL;
+			*polyplane = NULL;
 		}
 		if (ds->maskedtexturecol)
 		{
@@ -2430,20 +2452,18 @@ static void R_CreateDrawNodes(void)
 	// but it works getting them in for now
 	for (i = 0; i < numPolyObjects; i++)
 	{
-		if (!PolyObjects[i].visplane)
+		polyplane = R_PolyobjPlane(&PolyObjects[i]);
+		if (!*polyplane)
 			continue;
-		plane = PolyObjects[i].visplane;
+		plane = *polyplane;
+		*polyplane = NULL;
 		R_PlaneBounds(plane);
 
 		if (plane->low < 0 || plane->high > vid.height || plane->high > plane->low)
-		{
-			PolyObjects[i].visplane = NULL;
 			continue;
-		}
 		entry = R_CreateDrawNode(&nodehead);
 		entry->plane = plane;
 		// note: no seg is set, for what should be obvious reasons
-		PolyObjects[i].visplane = NULL;
 	}
 
 	if (visspritecount == 0)
@@ -2631,7 +2651,7 @@ static drawnode_t *R_CreateDrawNode(drawnode_t *link)
 	node->ffloor = NULL;
 	node->sprite = NULL;
 	
-	ps_numdrawnodes.value.i++;
+	viewstats.numdrawnodes++;
 	return node;
 }
 
@@ -44,14 +44,14 @@ extern INT16 negonearray[MAXVIDWIDTH];
 extern INT16 screenheightarray[MAXVIDWIDTH];
 
 // vars for R_DrawMaskedColumn
-extern INT16 *mfloorclip;
-extern INT16 *mceilingclip;
-extern fixed_t spryscale;
-extern fixed_t sprtopscreen;
-extern fixed_t sprbotscreen;
-extern fixed_t windowtop;
-extern fixed_t windowbottom;
-extern INT32 lengthcol;
+extern ATTRTHREAD INT16 *mfloorclip;
+extern ATTRTHREAD INT16 *mceilingclip;
+extern ATTRTHREAD fixed_t spryscale;
+extern ATTRTHREAD fixed_t sprtopscreen;
+extern ATTRTHREAD fixed_t sprbotscreen;
+extern ATTRTHREAD fixed_t windowtop;
+extern ATTRTHREAD fixed_t windowbottom;
+extern ATTRTHREAD INT32 lengthcol;
 
 fixed_t R_GetShadowZ(mobj_t *thing, pslope_t **shadowslope);
 
@@ -67,6 +67,7 @@ void R_AddSprites(sector_t *sec, INT32 lightlevel);
 void R_AddPrecipitationSprites(void);
 void R_InitSprites(void);
 void R_ClearSprites(void);
+void R_NewSpriteMarks(void);
 void R_DrawMasked(void);
 
 boolean R_ThingVisible (mobj_t *thing);
@@ -258,7 +259,7 @@ typedef struct vissprite_s
 	INT32 dispoffset; // copy of info->dispoffset, affects ordering but not drawing
 } vissprite_t;
 
-extern UINT32 visspritecount, numvisiblesprites;
+extern ATTRTHREAD UINT32 visspritecount, numvisiblesprites;
 
 void R_ClipSprites(void);
 
@@ -36,14 +36,14 @@
 // --------------------------------------------
 // assembly or c drawer routines for 8bpp/16bpp
 // --------------------------------------------
-void (*wallcolfunc)(void); // new wall column drawer to draw posts >128 high
-void (*colfunc)(void); // standard column, up to 128 high posts
+ATTRTHREAD void (*wallcolfunc)(void); // new wall column drawer to draw posts >128 high
+ATTRTHREAD void (*colfunc)(void); // standard column, up to 128 high posts
 
 void (*basecolfunc)(void);
 void (*fuzzcolfunc)(void); // standard fuzzy effect column drawer
 void (*transcolfunc)(void); // translation column drawer
 void (*shadecolfunc)(void); // smokie test..
-void (*spanfunc)(void); // span drawer, use a 64x64 tile
+ATTRTHREAD void (*spanfunc)(void); // span drawer, use a 64x64 tile
 void (*splatfunc)(void); // span drawer w/ transparency
 void (*basespanfunc)(void); // default span func for color mode
 void (*transtransfunc)(void); // translucent translated column drawer
@@ -105,6 +105,10 @@ void SCR_SetMode(void)
 	if (!setmodeneeded || WipeInAction)
 		return; // should never happen and don't change it during a wipe, BAD!
 
+	// The movie encoder may still be working on frames of the old size
+	if (moviemode == MM_GIF || moviemode == MM_APNG)
+		M_StopMovie();
+
 	VID_SetMode(--setmodeneeded);
 
 	V_SetPalette(0);
@@ -126,6 +130,21 @@ void SCR_SetMode(void)
 		twosmultipatchfunc = R_Draw2sMultiPatchColumn_8;
 		twosmultipatchtransfunc = R_Draw2sMultiPatchTranslucentColumn_8;
 		dropshadowcolfunc = R_DrawDropShadowColumn_8;
+
+#ifdef SIMD_DRAWERS
+		// Opaque columns are held up by their stores down the screen, so
+		// the SIMD column drawers are no faster there; see drawerbench.
+		if (R_CPUHasAVX2())
+		{
+			spanfunc = basespanfunc = R_DrawSpan_8_AVX2;
+			fuzzcolfunc = R_DrawTranslucentColumn_8_AVX2;
+		}
+		else
+		{
+			spanfunc = basespanfunc = R_DrawSpan_8_SSE2;
+			fuzzcolfunc = R_DrawTranslucentColumn_8_SSE2;
+		}
+#endif
 	}
 /*	else if (vid.bpp > 1)
 	{
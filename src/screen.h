@@ -121,13 +121,13 @@ extern vmode_t specialmodes[NUMSPECIALMODES];
 // color mode dependent drawer function pointers
 // ---------------------------------------------
 
-extern void (*wallcolfunc)(void);
-extern void (*colfunc)(void);
+extern ATTRTHREAD void (*wallcolfunc)(void);
+extern ATTRTHREAD void (*colfunc)(void);
 extern void (*basecolfunc)(void);
 extern void (*fuzzcolfunc)(void);
 extern void (*transcolfunc)(void);
 extern void (*shadecolfunc)(void);
-extern void (*spanfunc)(void);
+extern ATTRTHREAD void (*spanfunc)(void);
 extern void (*basespanfunc)(void);
 extern void (*splatfunc)(void);
 extern void (*transtransfunc)(void);
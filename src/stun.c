@@ -25,6 +25,7 @@
 #include "d_clisrv.h"
 #include "command.h"
 #include "i_net.h"
+#include "d_net.h"
 #include "stun.h"
 
 /* https://gist.github.com/zziuni/3741933 */
@@ -36,6 +37,10 @@ consvar_t cv_stunserver = {
 
 static stun_callback_t stun_callback;
 
+/* The response may arrive on the network thread, so the callback waits for STUN_dispatch */
+static stun_callback_t stun_result;
+static UINT32          stun_address;
+
 /* 18.4 STUN UDP and TCP Port Numbers */
 
 #define STUN_PORT "3478"
@@ -114,7 +119,11 @@ STUN_bind (stun_callback_t callback)
 
 	const UINT16 type = MSBF_SHORT (BIND_REQUEST);
 
-	const SINT8 node = STUN_node();
+	SINT8 node;
+
+	Net_LockDriver();
+
+	node = STUN_node();
 
 	doomcom->remotenode = node;
 	doomcom->datalength = 20;
@@ -130,6 +139,8 @@ STUN_bind (stun_callback_t callback)
 
 	I_NetSend();
 	Net_CloseConnection(node);/* will handle response at I_NetGet */
+
+	Net_UnlockDriver();
 }
 
 static size_t
@@ -138,7 +149,8 @@ STUN_xor_mapped_address (const char * const value)
 	const UINT32 xaddr = *(const UINT32 *)&value[4];
 	const UINT32  addr = xaddr ^ MAGIC_COOKIE;
 
-	(*stun_callback)(addr);
+	stun_result  = stun_callback;
+	stun_address = addr;
 
 	return 0U;
 }
@@ -234,3 +246,23 @@ STUN_got_response
 
 	return false;
 }
+
+void
+STUN_dispatch (void)
+{
+	stun_callback_t callback;
+	UINT32          address;
+
+	Net_LockDriver();
+
+	callback     = stun_result;
+	address      = stun_address;
+	stun_result  = NULL;
+
+	Net_UnlockDriver();
+
+	if (callback != NULL)
+	{
+		(*callback)(address);
+	}
+}
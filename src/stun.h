@@ -16,5 +16,6 @@ typedef void (*stun_callback_t)(UINT32 address);
 
 void    STUN_bind (stun_callback_t);
 boolean STUN_got_response (const char * const buffer, const size_t size);
+void    STUN_dispatch (void);/* runs the callback of a response got since */
 
 #endif/*KART_STUN_H*/
@@ -26,6 +26,7 @@
 #define _FILE_OFFSET_BITS 0
 #endif
 
+#define ZLIB_CONST // inflate straight from mapped files
 #include "zlib.h"
 #endif
 
@@ -33,6 +34,16 @@
 #include <unistd.h>
 #endif
 
+#if defined (UNIXCOMMON) || defined (__APPLE__)
+#include <sys/mman.h>
+#define MAPWADFILES
+#elif defined (_WIN32)
+#define RPC_NO_WINDOWS_H
+#include <windows.h>
+#include <io.h> // _get_osfhandle
+#define MAPWADFILES
+#endif
+
 #define ZWAD
 
 #ifdef ZWAD
@@ -64,6 +75,7 @@
 #include "st_stuff.h"
 #include "m_misc.h" // M_MapNumber
 #include "p_setup.h" // P_PartialAddFile mayb
+#include "m_argv.h" // -nommap
 
 #ifdef HWRENDER
 #include "r_data.h"
@@ -82,17 +94,18 @@ typedef struct
 	size_t len;
 } lumpchecklist_t;
 
-// Must be a power of two
-#define LUMPNUMCACHESIZE 64
-
-typedef struct lumpnum_cache_s
-{
-	char lumpname[32];
-	lumpnum_t lumpnum;
-} lumpnum_cache_t;
+// Open addressed tables from lump names to the lumpnum that
+// W_CheckNumForName and W_CheckNumForLongName should return for them,
+// with later files already taking precedence. See W_InvalidateLumpnumCache.
+static lumpnum_t *lumpnameindex = NULL;
+static lumpnum_t *longnameindex = NULL;
+static UINT32 lumpindexsize = 0; // power of two, for both tables
+static UINT16 indexedwads = 0; // wads 0 to indexedwads-1 are in the tables
 
-static lumpnum_cache_t lumpnumcache[LUMPNUMCACHESIZE];
-static UINT16 lumpnumcacheindex = 0;
+// for W_LogLumpReads, under the zone lock since the prefetch workers read too
+static precise_t lumpreadtime = 0;
+static size_t lumpreadbytes = 0;
+static size_t lumpreads = 0;
 
 //===========================================================================
 //                                                                    GLOBALS
@@ -100,6 +113,58 @@ static UINT16 lumpnumcacheindex = 0;
 UINT16 numwadfiles = 0; // number of active wadfiles
 wadfile_t *wadfiles[MAX_WADFILES]; // 0 to numwadfiles-1 are valid
 
+// W_MapFile
+// Maps a whole wad file into memory, so uncompressed lumps can be read
+// without seeking and reading the file every time. If it can't be mapped,
+// lumps are just read through the file handle as before.
+static void W_MapFile(wadfile_t *wad)
+{
+	wad->mapped = NULL;
+
+#ifdef MAPWADFILES
+	if (M_CheckParm("-nommap") || !wad->filesize)
+		return;
+
+#if defined (_WIN32)
+	{
+		HANDLE map = CreateFileMapping((HANDLE)_get_osfhandle(_fileno(wad->handle)), NULL, PAGE_READONLY, 0, 0, NULL);
+
+		if (map)
+		{
+			wad->mapped = MapViewOfFile(map, FILE_MAP_READ, 0, 0, 0);
+			CloseHandle(map); // the view keeps it open
+		}
+	}
+#else
+	{
+		void *map = mmap(NULL, wad->filesize, PROT_READ, MAP_SHARED, fileno(wad->handle), 0);
+
+		if (map != MAP_FAILED)
+			wad->mapped = map;
+	}
+#endif
+
+	if (!wad->mapped)
+		CONS_Debug(DBG_SETUP, "W_MapFile: couldn't map %s, reading it instead\n", wad->filename);
+#endif
+}
+
+static void W_UnmapFile(wadfile_t *wad)
+{
+#ifdef MAPWADFILES
+	if (!wad->mapped)
+		return;
+
+#if defined (_WIN32)
+	UnmapViewOfFile(wad->mapped);
+#else
+	munmap(wad->mapped, wad->filesize);
+#endif
+#endif
+
+	wad->mapped = NULL;
+}
+
 // W_Shutdown
 // Closes all of the WAD files before quitting
 // If not done on a Mac then open wad files
@@ -111,6 +176,7 @@ void W_Shutdown(void)
 	{
 		wadfile_t *wad = wadfiles[numwadfiles];
 
+		W_UnmapFile(wad);
 		if (wad->handle)
 			fclose(wad->handle);
 		Z_Free(wad->filename);
@@ -120,8 +186,15 @@ void W_Shutdown(void)
 			Z_Free(wad->lumpinfo[wad->numlumps].fullname);
 		}
 		Z_Free(wad->lumpinfo);
+		Z_Free(wad->namehash);
 		Z_Free(wad);
 	}
+
+	Z_Free(lumpnameindex);
+	Z_Free(longnameindex);
+	lumpnameindex = longnameindex = NULL;
+	lumpindexsize = 0;
+	indexedwads = 0;
 }
 
 //===========================================================================
@@ -325,10 +398,140 @@ static inline INT32 W_MakeFileMD5(const char *filename, void *resblock)
 	return 1;
 }
 
-// Invalidates the cache of lump numbers. Call this whenever a wad is added.
+/** Hashes a lump name, FNV-1a style.
+  * Names are hashed exactly as stored; lookups uppercase their query first,
+  * the same way the name comparisons always have.
+  *
+  * \param name Lump name, may not be terminated if it's a short name.
+  * \param len  Maximum number of characters to hash.
+  * \return The hash of the name.
+  */
+static UINT32 W_HashLumpName(const char *name, size_t len)
+{
+	UINT32 hash = 2166136261u;
+
+	while (len-- && *name)
+	{
+		hash ^= (UINT8)*name++;
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
+/** Links every lump of a wad into its per-file name hash chains.
+  * Lumps are pushed in reverse, so each chain runs in ascending lump order
+  * and the first match at or after a start lump is the one a forward scan
+  * would have found.
+  *
+  * \param wad The wad file to index.
+  */
+static void W_HashWadLumps(wadfile_t *wad)
+{
+	UINT32 buckets = 1;
+	UINT16 i;
+
+	while (buckets < wad->numlumps)
+		buckets <<= 1;
+
+	wad->namehashmask = buckets - 1;
+	wad->namehash = Z_Malloc((buckets * 2 + wad->numlumps * 2) * sizeof (UINT16), PU_STATIC, NULL);
+	wad->longnamehash = wad->namehash + buckets;
+	wad->namenext = wad->longnamehash + buckets;
+	wad->longnamenext = wad->namenext + wad->numlumps;
+	memset(wad->namehash, 0xFF, buckets * 2 * sizeof (UINT16));
+
+	for (i = wad->numlumps; i-- > 0;)
+	{
+		const lumpinfo_t *lump_p = &wad->lumpinfo[i];
+		UINT32 h;
+
+		h = W_HashLumpName(lump_p->name, 8) & wad->namehashmask;
+		wad->namenext[i] = wad->namehash[h];
+		wad->namehash[h] = i;
+
+		h = W_HashLumpName(lump_p->longname, SIZE_MAX) & wad->namehashmask;
+		wad->longnamenext[i] = wad->longnamehash[h];
+		wad->longnamehash[h] = i;
+	}
+}
+
+static inline lumpinfo_t *W_IndexedLump(lumpnum_t lumpnum)
+{
+	return &wadfiles[WADFILENUM(lumpnum)]->lumpinfo[LUMPNUM(lumpnum)];
+}
+
+/** Adds a wad's lumps to one of the global name tables.
+  * An entry from an earlier file is replaced, but one from this same file
+  * is kept, since the first lump of a name in a file is the one found.
+  *
+  * \param table    ::lumpnameindex or ::longnameindex.
+  * \param wadnum   The wad to add, which must be later than every wad
+  *                 already in the table.
+  * \param longname Index long names instead of short names.
+  */
+static void W_IndexLumpNames(lumpnum_t *table, UINT16 wadnum, boolean longname)
+{
+	const UINT32 mask = lumpindexsize - 1;
+	const wadfile_t *wad = wadfiles[wadnum];
+	UINT16 i;
+
+	for (i = 0; i < wad->numlumps; i++)
+	{
+		const lumpinfo_t *lump_p = &wad->lumpinfo[i];
+		UINT32 h;
+
+		if (longname)
+		{
+			h = W_HashLumpName(lump_p->longname, SIZE_MAX) & mask;
+			while (table[h] != LUMPERROR && strcmp(W_IndexedLump(table[h])->longname, lump_p->longname))
+				h = (h + 1) & mask;
+		}
+		else
+		{
+			h = W_HashLumpName(lump_p->name, 8) & mask;
+			while (table[h] != LUMPERROR && memcmp(W_IndexedLump(table[h])->name, lump_p->name, 8))
+				h = (h + 1) & mask;
+		}
+
+		if (table[h] == LUMPERROR || WADFILENUM(table[h]) != wadnum)
+			table[h] = ((lumpnum_t)wadnum << 16) + i;
+	}
+}
+
+// Brings the global lump name tables up to date with the loaded wad files.
+// Call this whenever a wad is added, before anything looks up its lumps.
 static void W_InvalidateLumpnumCache(void)
 {
-	memset(lumpnumcache, 0, sizeof (lumpnumcache));
+	UINT32 total = 0;
+	UINT16 i;
+
+	for (i = 0; i < numwadfiles; i++)
+		total += wadfiles[i]->numlumps;
+
+	// Keep the tables at most half full, rebuilding them bigger when needed.
+	if (indexedwads > numwadfiles || total * 2 > lumpindexsize)
+	{
+		UINT32 size = 1024;
+
+		while (size < total * 4)
+			size <<= 1;
+
+		Z_Free(lumpnameindex);
+		Z_Free(longnameindex);
+		lumpnameindex = Z_Malloc(size * sizeof (lumpnum_t), PU_STATIC, NULL);
+		longnameindex = Z_Malloc(size * sizeof (lumpnum_t), PU_STATIC, NULL);
+		memset(lumpnameindex, 0xFF, size * sizeof (lumpnum_t));
+		memset(longnameindex, 0xFF, size * sizeof (lumpnum_t));
+		lumpindexsize = size;
+		indexedwads = 0;
+	}
+
+	for (; indexedwads < numwadfiles; indexedwads++)
+	{
+		W_IndexLumpNames(lumpnameindex, indexedwads, false);
+		W_IndexLumpNames(longnameindex, indexedwads, true);
+	}
 }
 
 /** Detect a file type.
@@ -808,6 +1011,8 @@ UINT16 W_InitFile(const char *filename, boolean local)
 	fseek(handle, 0, SEEK_END);
 	wadfile->filesize = (unsigned)ftell(handle);
 	wadfile->type = type;
+	W_MapFile(wadfile);
+	W_HashWadLumps(wadfile);
 
 	// already generated, just copy it over
 	M_Memcpy(&wadfile->md5sum, &md5sum, 16);
@@ -828,6 +1033,7 @@ UINT16 W_InitFile(const char *filename, boolean local)
 	CONS_Printf(M_GetText("Added file %s (%u lumps)\n"), filename, numlumps);
 	wadfiles[numwadfiles] = wadfile;
 	numwadfiles++; // must come BEFORE W_LoadDehackedLumps, so any addfile called by COM_BufInsertText called by Lua doesn't overwrite what we just loaded
+	W_InvalidateLumpnumCache(); // and so must this, so the new lumps can be found
 
 #ifdef HWRENDER
 	// Read shaders from file
@@ -859,7 +1065,6 @@ UINT16 W_InitFile(const char *filename, boolean local)
 		G_LoadGameData();
 	DEH_UpdateMaxFreeslots();
 
-	W_InvalidateLumpnumCache();
 	return wadfile->numlumps;
 }
 
@@ -961,7 +1166,7 @@ const char *W_CheckNameForNum(lumpnum_t lumpnum)
 UINT16 W_CheckNumForNamePwad(const char *name, UINT16 wad, UINT16 startlump)
 {
 	UINT16 i;
-	static char uname[9];
+	char uname[9];
 
 	if (!TestValidLump(wad,0))
 		return INT16_MAX;
@@ -971,15 +1176,15 @@ UINT16 W_CheckNumForNamePwad(const char *name, UINT16 wad, UINT16 startlump)
 	strupr(uname);
 
 	//
-	// scan forward
+	// walk the name's hash chain, which is in ascending order
 	// start at 'startlump', useful parameter when there are multiple
 	//                       resources with the same name
 	//
 	if (startlump < wadfiles[wad]->numlumps)
 	{
-		lumpinfo_t *lump_p = wadfiles[wad]->lumpinfo + startlump;
-		for (i = startlump; i < wadfiles[wad]->numlumps; i++, lump_p++)
-			if (memcmp(lump_p->name, uname, sizeof(uname) - 1) == 0)
+		const wadfile_t *wad_p = wadfiles[wad];
+		for (i = wad_p->namehash[W_HashLumpName(uname, 8) & wad_p->namehashmask]; i != UINT16_MAX; i = wad_p->namenext[i])
+			if (i >= startlump && memcmp(wad_p->lumpinfo[i].name, uname, sizeof(uname) - 1) == 0)
 				return i;
 	}
 
@@ -996,7 +1201,7 @@ UINT16 W_CheckNumForNamePwad(const char *name, UINT16 wad, UINT16 startlump)
 UINT16 W_CheckNumForLongNamePwad(const char *name, UINT16 wad, UINT16 startlump)
 {
 	UINT16 i;
-	static char uname[256 + 1];
+	char uname[256 + 1]; // not static, the prefetch workers look names up too
 
 	if (!TestValidLump(wad,0))
 		return INT16_MAX;
@@ -1005,15 +1210,15 @@ UINT16 W_CheckNumForLongNamePwad(const char *name, UINT16 wad, UINT16 startlump)
 	strupr(uname);
 
 	//
-	// scan forward
+	// walk the name's hash chain, which is in ascending order
 	// start at 'startlump', useful parameter when there are multiple
 	//                       resources with the same name
 	//
 	if (startlump < wadfiles[wad]->numlumps)
 	{
-		lumpinfo_t *lump_p = wadfiles[wad]->lumpinfo + startlump;
-		for (i = startlump; i < wadfiles[wad]->numlumps; i++, lump_p++)
-			if (!strcmp(lump_p->longname, uname))
+		const wadfile_t *wad_p = wadfiles[wad];
+		for (i = wad_p->longnamehash[W_HashLumpName(uname, SIZE_MAX) & wad_p->namehashmask]; i != UINT16_MAX; i = wad_p->longnamenext[i])
+			if (i >= startlump && !strcmp(wad_p->lumpinfo[i].longname, uname))
 				return i;
 	}
 
@@ -1091,42 +1296,25 @@ UINT16 W_CheckNumForFullNamePK3(const char *name, UINT16 wad, UINT16 startlump)
 //
 lumpnum_t W_CheckNumForName(const char *name)
 {
-	INT32 i;
-	lumpnum_t check = INT16_MAX;
+	char uname[9];
+	UINT32 h;
 
 	if (!*name) // some doofus gave us an empty string?
 		return LUMPERROR;
 
-	// Check the lumpnumcache first. Loop backwards so that we check
-	// most recent entries first
-	for (i = lumpnumcacheindex + LUMPNUMCACHESIZE; i > lumpnumcacheindex; i--)
-	{
-		if (!lumpnumcache[i & (LUMPNUMCACHESIZE - 1)].lumpname[8]
-			&& strncmp(lumpnumcache[i & (LUMPNUMCACHESIZE - 1)].lumpname, name, 8) == 0)
-		{
-			lumpnumcacheindex = i & (LUMPNUMCACHESIZE - 1);
-			return lumpnumcache[lumpnumcacheindex].lumpnum;
-		}
-	}
+	if (!lumpindexsize)
+		return LUMPERROR;
 
-	// scan wad files backwards so patch lump files take precedence
-	for (i = numwadfiles - 1; i >= 0; i--)
-	{
-		check = W_CheckNumForNamePwad(name,(UINT16)i,0);
-		if (check != INT16_MAX)
-			break; //found it
-	}
+	memset(uname, 0, sizeof uname);
+	strncpy(uname, name, sizeof(uname)-1);
+	strupr(uname);
 
-	if (check == INT16_MAX) return LUMPERROR;
-	else
+	// the index already lets patch lump files take precedence
+	for (h = W_HashLumpName(uname, 8);; h++)
 	{
-		// Update the cache.
-		lumpnumcacheindex = (lumpnumcacheindex + 1) & (LUMPNUMCACHESIZE - 1);
-		memset(lumpnumcache[lumpnumcacheindex].lumpname, '\0', 32);
-		strncpy(lumpnumcache[lumpnumcacheindex].lumpname, name, 8);
-		lumpnumcache[lumpnumcacheindex].lumpnum = (i<<16)+check;
-
-		return lumpnumcache[lumpnumcacheindex].lumpnum;
+		lumpnum_t check = lumpnameindex[h & (lumpindexsize - 1)];
+		if (check == LUMPERROR || memcmp(W_IndexedLump(check)->name, uname, sizeof(uname) - 1) == 0)
+			return check;
 	}
 }
 
@@ -1138,47 +1326,24 @@ lumpnum_t W_CheckNumForName(const char *name)
 //
 lumpnum_t W_CheckNumForLongName(const char *name)
 {
-	INT32 i;
-	lumpnum_t check = INT16_MAX;
+	char uname[256 + 1]; // not static, the prefetch workers look names up too
+	UINT32 h;
 
 	if (!*name) // some doofus gave us an empty string?
 		return LUMPERROR;
 
-	// Check the lumpnumcache first. Loop backwards so that we check
-	// most recent entries first
-	for (i = lumpnumcacheindex + LUMPNUMCACHESIZE; i > lumpnumcacheindex; i--)
-	{
-		if (strcmp(lumpnumcache[i & (LUMPNUMCACHESIZE - 1)].lumpname, name) == 0)
-		{
-			lumpnumcacheindex = i & (LUMPNUMCACHESIZE - 1);
-			return lumpnumcache[lumpnumcacheindex].lumpnum;
-		}
-	}
+	if (!lumpindexsize)
+		return LUMPERROR;
 
-	if (check == INT16_MAX)
-	{
-		// scan wad files backwards so patch lump files take precedence
-		for (i = numwadfiles - 1; i >= 0; i--)
-		{
-			check = W_CheckNumForLongNamePwad(name,(UINT16)i,0);
-			if (check != INT16_MAX)
-				break; //found it
-		}
-	}
+	strlcpy(uname, name, sizeof uname);
+	strupr(uname);
 
-	if (check == INT16_MAX) return LUMPERROR;
-	else
+	// the index already lets patch lump files take precedence
+	for (h = W_HashLumpName(uname, SIZE_MAX);; h++)
 	{
-		if (strlen(name) < 32)
-		{
-			// Update the cache.
-			lumpnumcacheindex = (lumpnumcacheindex + 1) & (LUMPNUMCACHESIZE - 1);
-			memset(lumpnumcache[lumpnumcacheindex].lumpname, '\0', 32);
-			strlcpy(lumpnumcache[lumpnumcacheindex].lumpname, name, 32);
-			lumpnumcache[lumpnumcacheindex].lumpnum = (i << 16) + check;
-		}
-
-		return (i << 16) + check;
+		lumpnum_t check = longnameindex[h & (lumpindexsize - 1)];
+		if (check == LUMPERROR || !strcmp(W_IndexedLump(check)->longname, uname))
+			return check;
 	}
 }
 
@@ -1421,13 +1586,15 @@ static void ErrorIfPNG(UINT8 *d, size_t s, char *f, char *l)
   * \param size Number of bytes to read.
   * \param offest Number of bytes to offset.
   * \return Number of bytes read (should equal size).
+  * \note May run on a worker thread, so scratch buffers are freed without Lua.
   * \sa W_ReadLump, W_RawReadLumpHeader
   */
-size_t W_ReadLumpHeaderPwad(UINT16 wad, UINT16 lump, void *dest, size_t size, size_t offset)
+static size_t W_ReadLumpData(UINT16 wad, UINT16 lump, void *dest, size_t size, size_t offset)
 {
 	size_t lumpsize;
 	lumpinfo_t *l;
 	FILE *handle;
+	const UINT8 *mapped;
 
 	if (!TestValidLump(wad,lump))
 		return 0;
@@ -1445,33 +1612,61 @@ size_t W_ReadLumpHeaderPwad(UINT16 wad, UINT16 lump, void *dest, size_t size, si
 	// We setup the desired file handle to read the lump data.
 	l = wadfiles[wad]->lumpinfo + lump;
 	handle = wadfiles[wad]->handle;
-	fseek(handle, (long)(l->position + offset), SEEK_SET);
+
+	// If the file is mapped, the data is already right there.
+	// Otherwise the handle is shared with the prefetch workers, so each
+	// seek and read below happens under the zone lock.
+	mapped = NULL;
+	if (wadfiles[wad]->mapped && (size_t)l->position + l->disksize <= wadfiles[wad]->filesize)
+		mapped = wadfiles[wad]->mapped + l->position;
 
 	// But let's not copy it yet. We support different compression formats on lumps, so we need to take that into account.
 	switch(wadfiles[wad]->lumpinfo[lump].compression)
 	{
 	case CM_NOCOMPRESSION:		// If it's uncompressed, we directly write the data into our destination, and return the bytes read.
-#ifdef NO_PNG_LUMPS
 		{
-			size_t bytesread = fread(dest, 1, size, handle);
+			size_t bytesread;
+
+			if (mapped)
+			{
+				M_Memcpy(dest, mapped + offset, size);
+				bytesread = size;
+			}
+			else
+			{
+				Z_Lock();
+				fseek(handle, (long)(l->position + offset), SEEK_SET);
+				bytesread = fread(dest, 1, size, handle);
+				Z_Unlock();
+			}
+#ifdef NO_PNG_LUMPS
 			ErrorIfPNG(dest, bytesread, wadfiles[wad]->filename, l->fullname);
+#endif
 			return bytesread;
 		}
-#else
-		return fread(dest, 1, size, handle);
-#endif
 	case CM_LZF:		// Is it LZF compressed? Used by ZWADs.
 		{
 #ifdef ZWAD
-			char *rawData; // The lump's raw data.
+			const char *rawData; // The lump's raw data.
+			char *readData = NULL; // Where it was read into, if not mapped.
 			char *decData; // Lump's decompressed real data.
 			size_t retval; // Helper var, lzf_decompress returns 0 when an error occurs.
 
-			rawData = Z_Malloc(l->disksize, PU_STATIC, NULL);
 			decData = Z_Malloc(l->size, PU_STATIC, NULL);
 
-			if (fread(rawData, 1, l->disksize, handle) < l->disksize)
-				I_Error("wad %d, lump %d: cannot read compressed data", wad, lump);
+			if (mapped)
+				rawData = (const char *)mapped;
+			else
+			{
+				// The whole lump is decompressed, whatever the offset.
+				readData = Z_Malloc(l->disksize, PU_STATIC, NULL);
+				Z_Lock();
+				fseek(handle, (long)l->position, SEEK_SET);
+				if (fread(readData, 1, l->disksize, handle) < l->disksize)
+					I_Error("wad %d, lump %d: cannot read compressed data", wad, lump);
+				Z_Unlock();
+				rawData = readData;
+			}
 			retval = lzf_decompress(rawData, l->disksize, decData, l->size);
 #ifndef AVOID_ERRNO
 			if (retval == 0) // If this was returned, check if errno was set
@@ -1492,8 +1687,9 @@ size_t W_ReadLumpHeaderPwad(UINT16 wad, UINT16 lump, void *dest, size_t size, si
 			if (!decData) // Did we get no data at all?
 				return 0;
 			M_Memcpy(dest, decData + offset, size);
-			Z_Free(rawData);
-			Z_Free(decData);
+			if (readData)
+				Z_FreeNoLua(readData);
+			Z_FreeNoLua(decData);
 #ifdef NO_PNG_LUMPS
 			ErrorIfPNG(dest, size, wadfiles[wad]->filename, l->fullname);
 #endif
@@ -1507,7 +1703,8 @@ size_t W_ReadLumpHeaderPwad(UINT16 wad, UINT16 lump, void *dest, size_t size, si
 #ifdef HAVE_ZLIB
 	case CM_DEFLATE: // Is it compressed via DEFLATE? Very common in ZIPs/PK3s, also what most doom-related editors support.
 		{
-			UINT8 *rawData; // The lump's raw data.
+			const UINT8 *rawData; // The lump's raw data.
+			UINT8 *readData = NULL; // Where it was read into, if not mapped.
 			UINT8 *decData; // Lump's decompressed real data.
 
 			int zErr; // Helper var.
@@ -1515,11 +1712,21 @@ size_t W_ReadLumpHeaderPwad(UINT16 wad, UINT16 lump, void *dest, size_t size, si
 			unsigned long rawSize = l->disksize;
 			unsigned long decSize = l->size;
 
-			rawData = Z_Malloc(rawSize, PU_STATIC, NULL);
 			decData = Z_Malloc(decSize, PU_STATIC, NULL);
 
-			if (fread(rawData, 1, rawSize, handle) < rawSize)
-				I_Error("wad %d, lump %d: cannot read compressed data", wad, lump);
+			if (mapped)
+				rawData = mapped;
+			else
+			{
+				// The whole lump is inflated, whatever the offset.
+				readData = Z_Malloc(rawSize, PU_STATIC, NULL);
+				Z_Lock();
+				fseek(handle, (long)l->position, SEEK_SET);
+				if (fread(readData, 1, rawSize, handle) < rawSize)
+					I_Error("wad %d, lump %d: cannot read compressed data", wad, lump);
+				Z_Unlock();
+				rawData = readData;
+			}
 
 			strm.zalloc = Z_NULL;
 			strm.zfree = Z_NULL;
@@ -1537,7 +1744,7 @@ size_t W_ReadLumpHeaderPwad(UINT16 wad, UINT16 lump, void *dest, size_t size, si
 				zErr = inflate(&strm, Z_FINISH);
 				if (zErr == Z_STREAM_END)
 				{
-					M_Memcpy(dest, decData, size);
+					M_Memcpy(dest, decData + offset, size);
 				}
 				else
 				{
@@ -1553,8 +1760,9 @@ size_t W_ReadLumpHeaderPwad(UINT16 wad, UINT16 lump, void *dest, size_t size, si
 				zerr(zErr);
 			}
 
-			Z_Free(rawData);
-			Z_Free(decData);
+			if (readData)
+				Z_FreeNoLua(readData);
+			Z_FreeNoLua(decData);
 
 #ifdef NO_PNG_LUMPS
 			ErrorIfPNG(dest, size, wadfiles[wad]->filename, l->fullname);
@@ -1568,6 +1776,74 @@ size_t W_ReadLumpHeaderPwad(UINT16 wad, UINT16 lump, void *dest, size_t size, si
 	return -1;
 }
 
+size_t W_ReadLumpHeaderPwad(UINT16 wad, UINT16 lump, void *dest, size_t size, size_t offset)
+{
+	precise_t start = I_GetPreciseTime();
+	size_t bytesread = W_ReadLumpData(wad, lump, dest, size, offset);
+
+	Z_Lock();
+	lumpreadtime += I_GetPreciseTime() - start;
+	lumpreadbytes += bytesread;
+	lumpreads++;
+	Z_Unlock();
+	return bytesread;
+}
+
+/** Gets an uncompressed lump's data straight from its mapped file, without
+  * copying it anywhere. The data must not be written to or freed.
+  *
+  * \param wad Wad file number.
+  * \param lump Lump number in that wad.
+  * \return The lump's data, or NULL if it is empty, compressed, or its file
+  *         isn't mapped.
+  * \sa W_CacheLumpNumPwad
+  */
+const void *W_GetMappedLumpPwad(UINT16 wad, UINT16 lump)
+{
+	lumpinfo_t *l;
+
+	if (!TestValidLump(wad, lump) || !wadfiles[wad]->mapped)
+		return NULL;
+
+	l = wadfiles[wad]->lumpinfo + lump;
+	if (!l->size || l->compression != CM_NOCOMPRESSION
+		|| (size_t)l->position + l->size > wadfiles[wad]->filesize)
+		return NULL;
+
+	return wadfiles[wad]->mapped + l->position;
+}
+
+const void *W_GetMappedLump(lumpnum_t lumpnum)
+{
+	return W_GetMappedLumpPwad(WADFILENUM(lumpnum), LUMPNUM(lumpnum));
+}
+
+/** Prints how much lump data has been read, and how long it took, since the
+  * last call. Run with -nommap to compare against reading the files.
+  *
+  * \param what What the reads were for.
+  * \param debug Only print with the setup debug flag on.
+  */
+void W_LogLumpReads(const char *what, boolean debug)
+{
+	const char *how = M_CheckParm("-nommap") ? "read" : "mapped";
+	size_t reads, bytes;
+	double ms;
+
+	Z_Lock();
+	ms = (double)lumpreadtime * 1000.0 / I_GetPrecisePrecision();
+	reads = lumpreads;
+	bytes = lumpreadbytes;
+	lumpreadtime = 0;
+	lumpreadbytes = lumpreads = 0;
+	Z_Unlock();
+
+	if (debug)
+		CONS_Debug(DBG_SETUP, "%s: %s lumps (%s bytes) %s in %.2f ms\n", what, sizeu1(reads), sizeu2(bytes), how, ms);
+	else
+		CONS_Printf("%s: %s lumps (%s bytes) %s in %.2f ms\n", what, sizeu1(reads), sizeu2(bytes), how, ms);
+}
+
 size_t W_ReadLumpHeader(lumpnum_t lumpnum, void *dest, size_t size, size_t offset)
 {
 	return W_ReadLumpHeaderPwad(WADFILENUM(lumpnum), LUMPNUM(lumpnum), dest, size, offset);
@@ -1596,20 +1872,29 @@ void W_ReadLumpPwad(UINT16 wad, UINT16 lump, void *dest)
 void *W_CacheLumpNumPwad(UINT16 wad, UINT16 lump, INT32 tag)
 {
 	lumpcache_t *lumpcache;
+	void *ptr;
 
 	if (!TestValidLump(wad,lump))
 		return NULL;
 
+	// The cache entry is set before the lump is read in, and the
+	// file handle is shared, so threaded views have to queue up here.
+	Z_Lock();
+
 	lumpcache = wadfiles[wad]->lumpcache;
 	if (!lumpcache[lump])
 	{
-		void *ptr = Z_Malloc(W_LumpLengthPwad(wad, lump), tag, &lumpcache[lump]);
+		ptr = Z_Malloc(W_LumpLengthPwad(wad, lump), tag, &lumpcache[lump]);
 		W_ReadLumpHeaderPwad(wad, lump, ptr, 0, 0);  // read the lump in full
 	}
 	else
-		Z_ChangeTag(lumpcache[lump], tag);
+	{
+		ptr = lumpcache[lump];
+		Z_ChangeTag(ptr, tag);
+	}
 
-	return lumpcache[lump];
+	Z_Unlock();
+	return ptr;
 }
 
 void *W_CacheLumpNum(lumpnum_t lumpnum, INT32 tag)
@@ -1634,8 +1919,10 @@ void *W_CacheLumpNumForce(lumpnum_t lumpnum, INT32 tag)
 	if (!TestValidLump(wad,lump))
 		return NULL;
 
+	Z_Lock();
 	ptr = Z_Malloc(W_LumpLengthPwad(wad, lump), tag, NULL);
 	W_ReadLumpHeaderPwad(wad, lump, ptr, 0, 0);  // read the lump in full
+	Z_Unlock();
 
 	return ptr;
 }
@@ -2145,15 +2432,18 @@ virtres_t* vres_GetMap(lumpnum_t lumpnum)
 		size_t *vsizecache;
 
 		// Remember that we're assuming that the WAD will have a specific set of lumps in a specific order.
-		UINT8 *wadData = (UINT8*)(W_CacheLumpNum(lumpnum, PU_LEVEL));
-		filelump_t *fileinfo = (filelump_t *)(wadData + LONG(((wadinfo_t *)wadData)->infotableofs));
+		// Read it right out of the mapped file if possible, instead of caching a copy first.
+		const UINT8 *mappedData = W_GetMappedLump(lumpnum);
+		UINT8 *cachedData = mappedData ? NULL : (UINT8*)(W_CacheLumpNum(lumpnum, PU_LEVEL));
+		const UINT8 *wadData = mappedData ? mappedData : cachedData;
+		const filelump_t *fileinfo = (const filelump_t *)(wadData + LONG(((const wadinfo_t *)wadData)->infotableofs));
 
-		i = LONG(((wadinfo_t *)wadData)->numlumps);
+		i = LONG(((const wadinfo_t *)wadData)->numlumps);
 		vsizecache = (size_t*)(Z_Malloc(sizeof(size_t)*i, PU_LEVEL, NULL));
 
 		for (realentry = 0; realentry < i; realentry++)
 		{
-			vsizecache[realentry] = (size_t)(LONG(((filelump_t *)(fileinfo + realentry))->size));
+			vsizecache[realentry] = (size_t)(LONG((fileinfo + realentry)->size));
 
 			if (!vsizecache[realentry])
 				continue;
@@ -2187,8 +2477,9 @@ virtres_t* vres_GetMap(lumpnum_t lumpnum)
 			i++;
 		}
 
-		Z_Free(vsizecache);
-		Z_Free(wadData);
+		Z_FreeNoLua(vsizecache);
+		if (cachedData)
+			Z_FreeNoLua(cachedData);
 	}
 	else
 	{
@@ -2229,6 +2520,7 @@ virtres_t* vres_GetMap(lumpnum_t lumpnum)
 }
 
 /** \brief Frees zone memory for a given virtual resource.
+ * Safe off the main thread: Lua never sees these blocks, so it isn't told.
  *
  * \param Virtual resource
  */
@@ -2244,12 +2536,12 @@ void vres_Free(virtres_t* vres)
 	{
 		if (vres->vlumps[vres->numlumps].data)
 		{
-			Z_Free(vres->vlumps[vres->numlumps].data);
+			Z_FreeNoLua(vres->vlumps[vres->numlumps].data);
 		}
 	}
 
-	Z_Free(vres->vlumps);
-	Z_Free(vres);
+	Z_FreeNoLua(vres->vlumps);
+	Z_FreeNoLua(vres);
 }
 
 /** (Debug) Prints lumps from a virtual resource into console.
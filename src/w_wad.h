@@ -131,7 +131,11 @@ typedef struct wadfile_s
 	aatree_t *hwrcache; // patches are cached in renderer's native format
 #endif
 	UINT16 numlumps; // this wad's number of resources
+	UINT16 *namehash, *longnamehash; // first lump of each name hash bucket, UINT16_MAX if none
+	UINT16 *namenext, *longnamenext; // next lump in the same bucket, per lump
+	UINT16 namehashmask; // number of buckets - 1
 	FILE *handle;
+	UINT8 *mapped; // the whole file mapped into memory, or NULL to read through handle
 	UINT32 filesize; // for network
 	UINT8 md5sum[16];
 	boolean important;
@@ -203,6 +207,13 @@ size_t W_ReadLumpHeader(lumpnum_t lump, void *dest, size_t size, size_t offest);
 void W_ReadLumpPwad(UINT16 wad, UINT16 lump, void *dest);
 void W_ReadLump(lumpnum_t lump, void *dest);
 
+// Where an uncompressed lump sits in its mapped file, or NULL. Read-only!
+const void *W_GetMappedLumpPwad(UINT16 wad, UINT16 lump);
+const void *W_GetMappedLump(lumpnum_t lumpnum);
+
+// Print how long lump reads have taken since the last call, then start over
+void W_LogLumpReads(const char *what, boolean debug);
+
 void *W_CacheLumpNumPwad(UINT16 wad, UINT16 lump, INT32 tag);
 void *W_CacheLumpNum(lumpnum_t lump, INT32 tag);
 void *W_CacheLumpNumForce(lumpnum_t lumpnum, INT32 tag);
@@ -1509,6 +1509,9 @@ static void Y_VoteStops(SINT8 pick, SINT8 level)
 	}
 
 	deferencoremode = (levelinfo[level].encore);
+
+	// The roulette still has to finish, get the map ready meanwhile
+	R_PrefetchLevel(nextmap);
 }
 
 //
@@ -36,11 +36,17 @@
 #include "z_zone.h"
 #include "m_misc.h" // M_Memcpy
 #include "lua_script.h"
+#include "lua_alloc.h" // LUA_PrintHeapStats
+#include "p_mobj.h" // mobj_t, precipmobj_t, actioncache_t for the slab pools
 
 #ifdef HWRENDER
 #include "hardware/hw_main.h" // For hardware memory info
 #endif
 
+#ifdef HAVE_THREADS
+#include "i_threads.h"
+#endif
+
 #ifdef HAVE_VALGRIND
 #include "valgrind.h"
 static boolean Z_calloc = false;
@@ -62,6 +68,8 @@ typedef struct memblock_s
 	size_t size; // including the header and blocks
 	size_t realsize; // size of real data only
 
+	struct zslab_s *slab; // slab this block was carved from, NULL if malloc'd
+
 #ifdef ZDEBUG
 	const char *ownerfile;
 	INT32 ownerline;
@@ -77,6 +85,56 @@ typedef struct memblock_s
 // both the head and tail of the zone memory block list
 static memblock_t head;
 
+#ifdef HAVE_THREADS
+static I_mutex zone_mutex;
+static INT32 zone_locking = 0;
+#endif
+
+// -----------------
+// Slab pools
+// -----------------
+//
+// Small, frequently churned level objects (mobjs, precipitation, cached
+// actions) are carved out of fixed-size slabs instead of being malloc'd one
+// at a time. Every chunk still carries a full memblock_t and sits in the
+// zone list, so tags, users and Z_CheckHeap behave exactly as before; only
+// the backing storage differs. Slabs that become empty are kept around for
+// reuse and handed back to the system in one sweep by Z_FreeTags.
+
+#define ZSLABCHUNKS 128 // chunks per slab
+
+#define ZALIGN(x) (((x) + (alignof (max_align_t) - 1)) & ~(alignof (max_align_t) - 1))
+
+typedef struct zslab_s
+{
+	struct zslabpool_s *pool;
+	struct zslab_s *next, *prev; // slabs with free chunks are kept at the front
+	memblock_t *freelist; // chunks are linked through their memblock's next
+	UINT32 used;
+} zslab_t;
+
+#define ZSLABHEADER ZALIGN(sizeof (zslab_t))
+
+typedef struct zslabpool_s
+{
+	const char *name;
+	size_t size; // requested allocation size served by this pool
+	size_t chunksize; // memblock_t + padding + data, rounded for alignment
+	zslab_t slabs; // both the head and tail of the slab list
+	UINT32 numslabs;
+	UINT32 used; // live chunks across all slabs
+	UINT32 peak;
+} zslabpool_t;
+
+static zslabpool_t slabpools[] =
+{
+	{"Mobjs",         sizeof (mobj_t),        0, {NULL, NULL, NULL, NULL, 0}, 0, 0, 0},
+	{"Precipitation", sizeof (precipmobj_t),  0, {NULL, NULL, NULL, NULL, 0}, 0, 0, 0},
+	{"Action cache",  sizeof (actioncache_t), 0, {NULL, NULL, NULL, NULL, 0}, 0, 0, 0},
+};
+
+#define NUMSLABPOOLS (sizeof slabpools / sizeof *slabpools)
+
 //
 // Function prototypes
 //
@@ -97,11 +155,19 @@ static void Command_Memdump_f(void);
 void Z_Init(void)
 {
 	size_t total, memfree;
+	size_t i;
 
 	memset(&head, 0x00, sizeof(head));
 
 	head.next = head.prev = &head;
 
+	for (i = 0; i < NUMSLABPOOLS; i++)
+	{
+		zslabpool_t *pool = &slabpools[i];
+		pool->chunksize = ZALIGN(sizeof (memblock_t) + ALIGNPAD + pool->size);
+		pool->slabs.next = pool->slabs.prev = &pool->slabs;
+	}
+
 	memfree = I_GetFreeMem(&total)>>20;
 	CONS_Printf("System memory: %sMB - Free: %sMB\n", sizeu1(total>>20), sizeu2(memfree));
 
@@ -118,16 +184,161 @@ void Z_Init(void)
 // Zone memory allocation
 // ----------------------
 
-/** Frees allocated memory.
+static void *xm(size_t size);
+
+/** Finds the slab pool that serves allocations of a given size and tag.
+  *
+  * \param size Amount of memory to be allocated, in bytes.
+  * \param tag Purge tag.
+  * \return The matching pool, or NULL if the block should be malloc'd.
+  */
+static zslabpool_t *Z_SlabPoolFor(size_t size, INT32 tag)
+{
+	size_t i;
+
+#ifdef HAVE_VALGRIND
+	// Let memcheck see every block individually.
+	(void)size;
+	(void)tag;
+	return NULL;
+#else
+	if (tag < PU_LEVEL || tag >= PU_PURGELEVEL)
+		return NULL;
+
+	for (i = 0; i < NUMSLABPOOLS; i++)
+		if (slabpools[i].size == size)
+			return &slabpools[i];
+
+	return NULL;
+#endif
+}
+
+/** Takes a chunk out of a slab pool, allocating a new slab if needed.
+  *
+  * \param pool The pool to allocate from.
+  * \return An uninitialised memblock_t with its slab set.
+  */
+static memblock_t *Z_SlabAlloc(zslabpool_t *pool)
+{
+	zslab_t *slab = pool->slabs.next;
+	memblock_t *block;
+
+	if (slab == &pool->slabs || slab->freelist == NULL)
+	{
+		UINT8 *chunk;
+		UINT32 i;
+
+		// Every slab is full; carve out a new one.
+		slab = xm(ZSLABHEADER + ZSLABCHUNKS * pool->chunksize);
+		slab->pool = pool;
+		slab->used = 0;
+		slab->freelist = NULL;
+
+		chunk = (UINT8 *)slab + ZSLABHEADER + (ZSLABCHUNKS - 1) * pool->chunksize;
+		for (i = 0; i < ZSLABCHUNKS; i++, chunk -= pool->chunksize)
+		{
+			block = (memblock_t *)chunk;
+			block->next = slab->freelist;
+			slab->freelist = block;
+		}
+
+		slab->next = pool->slabs.next;
+		slab->prev = &pool->slabs;
+		pool->slabs.next = slab;
+		slab->next->prev = slab;
+		pool->numslabs++;
+	}
+
+	block = slab->freelist;
+	slab->freelist = block->next;
+	block->slab = slab;
+
+	if (++slab->used == ZSLABCHUNKS)
+	{
+		// Full, so move it behind every slab that still has room.
+		slab->prev->next = slab->next;
+		slab->next->prev = slab->prev;
+		slab->prev = pool->slabs.prev;
+		slab->next = &pool->slabs;
+		pool->slabs.prev = slab;
+		slab->prev->next = slab;
+	}
+
+	if (++pool->used > pool->peak)
+		pool->peak = pool->used;
+
+	return block;
+}
+
+/** Returns a chunk to its slab.
+  * Empty slabs are not released here; see Z_ReleaseEmptySlabs.
+  *
+  * \param block The memblock_t to give back, already unlinked from the zone list.
+  */
+static void Z_SlabFree(memblock_t *block)
+{
+	zslab_t *slab = block->slab;
+	zslabpool_t *pool = slab->pool;
+
+	block->id = 0;
+	block->slab = NULL;
+	block->next = slab->freelist;
+	slab->freelist = block;
+
+	if (slab->used-- == ZSLABCHUNKS)
+	{
+		// Has room again, so bring it to the front.
+		slab->prev->next = slab->next;
+		slab->next->prev = slab->prev;
+		slab->next = pool->slabs.next;
+		slab->prev = &pool->slabs;
+		pool->slabs.next = slab;
+		slab->next->prev = slab;
+	}
+
+	pool->used--;
+}
+
+/** Gives every slab without live chunks back to the system.
+  * This is one pass over the slabs, not the chunks inside them.
+  */
+static void Z_ReleaseEmptySlabs(void)
+{
+	size_t i;
+
+	for (i = 0; i < NUMSLABPOOLS; i++)
+	{
+		zslabpool_t *pool = &slabpools[i];
+		zslab_t *slab, *next;
+
+		for (slab = pool->slabs.next; slab != &pool->slabs; slab = next)
+		{
+			next = slab->next;
+
+			if (slab->freelist == NULL)
+				break; // full slabs are at the back, nothing empty past here
+
+			if (slab->used)
+				continue;
+
+			slab->prev->next = slab->next;
+			slab->next->prev = slab->prev;
+			free(slab);
+			pool->numslabs--;
+		}
+	}
+}
+
+/** Frees allocated memory, for Z_Free and Z_FreeNoLua.
   *
   * \param ptr A pointer to allocated memory,
   *             assumed to have been allocated with Z_Malloc/Z_Calloc.
-  * \sa Z_FreeTags
+  * \param lua Whether Lua might have a userdata for ptr that needs invalidating.
   */
 #ifdef ZDEBUG
-void Z_Free2(void *ptr, const char *file, INT32 line)
+static void Z_DoFree(void *ptr, boolean lua, const char *file, INT32 line)
 #else
-void Z_Free(void *ptr)
+static void Z_DoFree(void *ptr, boolean lua)
 #endif
 {
 	memblock_t *block;
@@ -139,6 +350,8 @@ void Z_Free(void *ptr)
 	CONS_Debug(DBG_MEMORY, "Z_Free %s:%d\n", file, line);
 #endif
 
+	Z_Lock();
+
 	block = MEMBLOCK(ptr);
 #ifdef PARANOIA
 	if (block->id != ZONEID)
@@ -155,7 +368,7 @@ void Z_Free(void *ptr)
 #endif
 
 	// anything that isn't by lua gets passed to lua just in case.
-	if (block->tag != PU_LUA)
+	if (lua && block->tag != PU_LUA)
 		LUA_InvalidateUserdata(ptr);
 
 	// TODO: if zdebugging, make sure no other block has a user
@@ -170,9 +383,53 @@ void Z_Free(void *ptr)
 #endif
 	block->prev->next = block->next;
 	block->next->prev = block->prev;
-	free(block);
+
+	if (block->slab != NULL)
+		Z_SlabFree(block);
+	else
+		free(block);
+
+	Z_Unlock();
 }
 
+/** Frees allocated memory.
+  *
+  * \param ptr A pointer to allocated memory,
+  *             assumed to have been allocated with Z_Malloc/Z_Calloc.
+  * \sa Z_FreeTags, Z_FreeNoLua
+  */
+#ifdef ZDEBUG
+void Z_Free2(void *ptr, const char *file, INT32 line)
+{
+	Z_DoFree(ptr, true, file, line);
+}
+#else
+void Z_Free(void *ptr)
+{
+	Z_DoFree(ptr, true);
+}
+#endif
+
+/** Frees allocated memory without asking Lua about it.
+  * For blocks whose owner keeps track of their Lua userdata itself,
+  * like thinkers with thinker_t::luaref.
+  *
+  * \param ptr A pointer to allocated memory,
+  *             assumed to have been allocated with Z_Malloc/Z_Calloc.
+  * \sa Z_Free
+  */
+#ifdef ZDEBUG
+void Z_FreeNoLua2(void *ptr, const char *file, INT32 line)
+{
+	Z_DoFree(ptr, false, file, line);
+}
+#else
+void Z_FreeNoLua(void *ptr)
+{
+	Z_DoFree(ptr, false);
+}
+#endif
+
 /** malloc() that doesn't accept failure.
   *
   * \param size Amount of memory to be allocated, in bytes.
@@ -222,6 +479,7 @@ void *Z_MallocAlign(size_t size, INT32 tag, void *user, INT32 alignbits)
 #endif
 {
 	memblock_t *block;
+	zslabpool_t *pool;
 	void *ptr;
 
 	(void)(alignbits); // no longer used, so silence warnings. TODO we should figure out a solution for this
@@ -230,7 +488,16 @@ void *Z_MallocAlign(size_t size, INT32 tag, void *user, INT32 alignbits)
 	CONS_Debug(DBG_MEMORY, "Z_Malloc %s:%d\n", file, line);
 #endif
 
-	block = xm(sizeof (memblock_t) + ALIGNPAD + size);
+	Z_Lock();
+
+	pool = Z_SlabPoolFor(size, tag);
+	if (pool != NULL)
+		block = Z_SlabAlloc(pool);
+	else
+	{
+		block = xm(sizeof (memblock_t) + ALIGNPAD + size);
+		block->slab = NULL;
+	}
 	ptr = MEMORY(block);
 	I_Assert((intptr_t)ptr % alignof (max_align_t) == 0);
 
@@ -267,6 +534,7 @@ void *Z_MallocAlign(size_t size, INT32 tag, void *user, INT32 alignbits)
 		I_Error("Z_Malloc: attempted to allocate purgable block "
 			"(size %s) with no user", sizeu1(size));
 
+	Z_Unlock();
 	return ptr;
 }
 
@@ -398,6 +666,7 @@ void Z_FreeTags(INT32 lowtag, INT32 hightag)
 {
 	memblock_t *block, *next;
 
+	Z_Lock();
 	Z_CheckHeap(420);
 	for (block = head.next; block != &head; block = next)
 	{
@@ -405,6 +674,11 @@ void Z_FreeTags(INT32 lowtag, INT32 hightag)
 		if (block->tag >= lowtag && block->tag <= hightag)
 			Z_Free(MEMORY(block));
 	}
+
+	// Pooled tags were just freed, so whole slabs can go back at once.
+	if (lowtag < PU_PURGELEVEL && hightag >= PU_LEVEL)
+		Z_ReleaseEmptySlabs();
+	Z_Unlock();
 }
 
 /** Iterates through all memory for a given set of tags.
@@ -582,7 +856,9 @@ void Z_ChangeTag(void *ptr, INT32 tag)
 	// No, please, don't make my PU_STATIC patch NULL! It supposed to be always valid!
 	if (block->tag < 10) return;
 
+	Z_Lock();
 	block->tag = tag;
+	Z_Unlock();
 }
 
 /** Changes a memory block's user.
@@ -613,10 +889,48 @@ void Z_SetUser(void *ptr, void **newuser)
 		I_Error("Internal memory management error: "
 			"tried to make block purgable but it has no owner");
 
+	Z_Lock();
 	block->user = (void*)newuser;
 	*newuser = ptr;
+	Z_Unlock();
+}
+
+#ifdef HAVE_THREADS
+/** Turns zone locking on or off.
+  * Calls nest, locking stays on until every caller that turned it on has
+  * turned it off again. Only call this while no other thread can be
+  * touching the zone.
+  *
+  * \param enable Whether Z_Lock should actually lock from now on.
+  * \sa Z_Lock, Z_Unlock
+  */
+void Z_SetLocking(boolean enable)
+{
+	zone_locking += enable ? 1 : -1;
 }
 
+/** Takes the zone lock, if locking is on.
+  * The lock is recursive, so zone functions can be called while holding it.
+  *
+  * \sa Z_Unlock, Z_SetLocking
+  */
+void Z_Lock(void)
+{
+	if (zone_locking)
+		I_lock_mutex(&zone_mutex);
+}
+
+/** Releases the zone lock taken by Z_Lock.
+  *
+  * \sa Z_Lock, Z_SetLocking
+  */
+void Z_Unlock(void)
+{
+	if (zone_locking)
+		I_unlock_mutex(zone_mutex);
+}
+#endif
+
 // -----------------
 // Zone memory usage
 // -----------------
@@ -653,6 +967,7 @@ size_t Z_TagsUsage(INT32 lowtag, INT32 hightag)
 static void Command_Memfree_f(void)
 {
 	size_t freebytes, totalbytes;
+	size_t i;
 
 	Z_CheckHeap(-1);
 	CONS_Printf("\x82%s", M_GetText("Memory Info\n"));
@@ -667,6 +982,17 @@ static void Command_Memfree_f(void)
 	CONS_Printf(M_GetText("All purgable      : %7s KB\n"),
 		sizeu1(Z_TagsUsage(PU_PURGELEVEL, INT32_MAX)>>10));
 
+	CONS_Printf("\x82%s", M_GetText("Slab Pools\n"));
+	for (i = 0; i < NUMSLABPOOLS; i++)
+	{
+		const zslabpool_t *pool = &slabpools[i];
+		CONS_Printf(M_GetText("%-18s: %7s KB, %u/%u used (peak %u), %u slabs\n"), pool->name,
+			sizeu1((pool->numslabs * (ZSLABHEADER + ZSLABCHUNKS * pool->chunksize))>>10),
+			pool->used, pool->numslabs * ZSLABCHUNKS, pool->peak, pool->numslabs);
+	}
+
+	LUA_PrintHeapStats();
+
 #ifdef HWRENDER
 	if (rendermode != render_soft && rendermode != render_none)
 	{
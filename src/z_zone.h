@@ -80,15 +80,18 @@ void Z_Init(void);
 // Z_Free and alloc with alignment
 #ifdef ZDEBUG
 #define Z_Free(p)                 Z_Free2(p, __FILE__, __LINE__)
+#define Z_FreeNoLua(p)            Z_FreeNoLua2(p, __FILE__, __LINE__)
 #define Z_MallocAlign(s,t,u,a)    Z_Malloc2(s, t, u, a, __FILE__, __LINE__)
 #define Z_CallocAlign(s,t,u,a)    Z_Calloc2(s, t, u, a, __FILE__, __LINE__)
 #define Z_ReallocAlign(p,s,t,u,a) Z_Realloc2(p,s, t, u, a, __FILE__, __LINE__)
 void Z_Free2(void *ptr, const char *file, INT32 line);
+void Z_FreeNoLua2(void *ptr, const char *file, INT32 line);
 void *Z_Malloc2(size_t size, INT32 tag, void *user, INT32 alignbits, const char *file, INT32 line) FUNCALLOC(1);
 void *Z_Calloc2(size_t size, INT32 tag, void *user, INT32 alignbits, const char *file, INT32 line) FUNCALLOC(1);
 void *Z_Realloc2(void *ptr, size_t size, INT32 tag, void *user, INT32 alignbits, const char *file, INT32 line) FUNCALLOC(2);
 #else
 void Z_Free(void *ptr);
+void Z_FreeNoLua(void *ptr);
 void *Z_MallocAlign(size_t size, INT32 tag, void *user, INT32 alignbits) FUNCALLOC(1);
 void *Z_CallocAlign(size_t size, INT32 tag, void *user, INT32 alignbits) FUNCALLOC(1);
 void *Z_ReallocAlign(void *ptr, size_t size, INT32 tag, void *user, INT32 alignbits) FUNCALLOC(2);
@@ -130,6 +133,24 @@ void Z_ChangeTag(void *ptr, INT32 tag);
 void Z_SetUser(void *ptr, void **newuser);
 #endif
 
+//
+// Locking
+//
+// Only does anything while Z_SetLocking is on, which the renderer does
+// for as long as it has views drawing on more than one thread, and the
+// level prefetch for as long as its workers run.
+// Lazy caches that publish through a zone user pointer take it too.
+//
+#ifdef HAVE_THREADS
+void Z_SetLocking(boolean enable);
+void Z_Lock(void);
+void Z_Unlock(void);
+#else
+#define Z_SetLocking(enable) (void)(enable)
+#define Z_Lock()
+#define Z_Unlock()
+#endif
+
 //
 // Zone memory usage
 //